@@ -446,6 +446,8 @@ let package = Package(
         "connections/implementation/internal_payload_factory_test.cc",
         "connections/implementation/client_proxy_test.cc",
         "connections/implementation/payload_manager_test.cc",
+        "connections/implementation/chunk_size_controller_test.cc",
+        "connections/implementation/payload_scheduler_test.cc",
         "connections/implementation/offline_frames_validator_test.cc",
         "connections/implementation/service_controller_router_test.cc",
         "connections/implementation/bluetooth_bwu_test.cc",
@@ -453,6 +455,7 @@ let package = Package(
         "connections/implementation/wifi_hotspot_test.cc",
         "connections/implementation/analytics/analytics_recorder_test.cc",
         "connections/implementation/analytics/throughput_recorder_test.cc",
+        "connections/implementation/analytics/latency_histogram_test.cc",
         "connections/implementation/mediums/ble_v2_test.cc",
         "connections/implementation/mediums/ble_v2/bloom_filter_test.cc",
         "connections/implementation/mediums/ble_v2/ble_packet_test.cc",
@@ -485,6 +488,7 @@ let package = Package(
         "connections/implementation/ble_advertisement_test.cc",
         "connections/implementation/base_endpoint_channel_test.cc",
         "connections/implementation/reconnect_manager_test.cc",
+        "connections/implementation/ukey2_session_cache_test.cc",
         "connections/v3/connections_device_test.cc",
         "connections/v3/connections_device_provider_test.cc",
         "connections/implementation/connections_authentication_transport_test.cc",
@@ -519,6 +523,7 @@ let package = Package(
         "internal/platform/count_down_latch_test.cc",
         "internal/platform/pipe_test.cc",
         "internal/platform/timer_impl_test.cc",
+        "internal/platform/timer_wheel_test.cc",
         "internal/platform/task_runner_impl_test.cc",
         "internal/platform/uuid_test.cc",
         "internal/platform/wifi_lan_connection_info_test.cc",
@@ -87,7 +87,8 @@ constexpr ConnectionResponseFrame::ConnectionResponseFrame(
 
   , multiplex_socket_bitmask_(0)
   , nearby_connections_version_(0)
-  , safe_to_disconnect_version_(0){}
+  , safe_to_disconnect_version_(0)
+  , feature_bitmask_(0){}
 struct ConnectionResponseFrameDefaultTypeInternal {
   constexpr ConnectionResponseFrameDefaultTypeInternal()
     : _instance(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized{}) {}
@@ -3682,6 +3683,9 @@ class ConnectionResponseFrame::_Internal {
   static void set_has_safe_to_disconnect_version(HasBits* has_bits) {
     (*has_bits)[0] |= 64u;
   }
+  static void set_has_feature_bitmask(HasBits* has_bits) {
+    (*has_bits)[0] |= 128u;
+  }
 };
 
 const ::location::nearby::connections::OsInfo&
@@ -3715,8 +3719,8 @@ ConnectionResponseFrame::ConnectionResponseFrame(const ConnectionResponseFrame&
     os_info_ = nullptr;
   }
   ::memcpy(&status_, &from.status_,
-    static_cast<size_t>(reinterpret_cast<char*>(&safe_to_disconnect_version_) -
-    reinterpret_cast<char*>(&status_)) + sizeof(safe_to_disconnect_version_));
+    static_cast<size_t>(reinterpret_cast<char*>(&feature_bitmask_) -
+    reinterpret_cast<char*>(&status_)) + sizeof(feature_bitmask_));
   // @@protoc_insertion_point(copy_constructor:location.nearby.connections.ConnectionResponseFrame)
 }
 
@@ -3727,8 +3731,8 @@ handshake_data_.UnsafeSetDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStr
 #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
 ::memset(reinterpret_cast<char*>(this) + static_cast<size_t>(
     reinterpret_cast<char*>(&os_info_) - reinterpret_cast<char*>(this)),
-    0, static_cast<size_t>(reinterpret_cast<char*>(&safe_to_disconnect_version_) -
-    reinterpret_cast<char*>(&os_info_)) + sizeof(safe_to_disconnect_version_));
+    0, static_cast<size_t>(reinterpret_cast<char*>(&feature_bitmask_) -
+    reinterpret_cast<char*>(&os_info_)) + sizeof(feature_bitmask_));
 }
 
 ConnectionResponseFrame::~ConnectionResponseFrame() {
@@ -3770,10 +3774,10 @@ void ConnectionResponseFrame::Clear() {
       os_info_->Clear();
     }
   }
-  if (cached_has_bits & 0x0000007cu) {
+  if (cached_has_bits & 0x000000fcu) {
     ::memset(&status_, 0, static_cast<size_t>(
-        reinterpret_cast<char*>(&safe_to_disconnect_version_) -
-        reinterpret_cast<char*>(&status_)) + sizeof(safe_to_disconnect_version_));
+        reinterpret_cast<char*>(&feature_bitmask_) -
+        reinterpret_cast<char*>(&status_)) + sizeof(feature_bitmask_));
   }
   _has_bits_.Clear();
   _internal_metadata_.Clear<std::string>();
@@ -3852,6 +3856,15 @@ const char* ConnectionResponseFrame::_InternalParse(const char* ptr, ::PROTOBUF_
         } else
           goto handle_unusual;
         continue;
+      // optional int32 feature_bitmask = 8;
+      case 8:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 64)) {
+          _Internal::set_has_feature_bitmask(&has_bits);
+          feature_bitmask_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -3928,6 +3941,12 @@ uint8_t* ConnectionResponseFrame::_InternalSerialize(
     target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32ToArray(7, this->_internal_safe_to_disconnect_version(), target);
   }
 
+  // optional int32 feature_bitmask = 8;
+  if (cached_has_bits & 0x00000080u) {
+    target = stream->EnsureSpace(target);
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32ToArray(8, this->_internal_feature_bitmask(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = stream->WriteRaw(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).data(),
         static_cast<int>(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size()), target);
@@ -3945,7 +3964,7 @@ size_t ConnectionResponseFrame::ByteSizeLong() const {
   (void) cached_has_bits;
 
   cached_has_bits = _has_bits_[0];
-  if (cached_has_bits & 0x0000007fu) {
+  if (cached_has_bits & 0x000000ffu) {
     // optional bytes handshake_data = 2;
     if (cached_has_bits & 0x00000001u) {
       total_size += 1 +
@@ -3986,6 +4005,11 @@ size_t ConnectionResponseFrame::ByteSizeLong() const {
       total_size += ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::Int32SizePlusOne(this->_internal_safe_to_disconnect_version());
     }
 
+    // optional int32 feature_bitmask = 8;
+    if (cached_has_bits & 0x00000080u) {
+      total_size += ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::Int32SizePlusOne(this->_internal_feature_bitmask());
+    }
+
   }
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     total_size += _internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size();
@@ -4008,7 +4032,7 @@ void ConnectionResponseFrame::MergeFrom(const ConnectionResponseFrame& from) {
   (void) cached_has_bits;
 
   cached_has_bits = from._has_bits_[0];
-  if (cached_has_bits & 0x0000007fu) {
+  if (cached_has_bits & 0x000000ffu) {
     if (cached_has_bits & 0x00000001u) {
       _internal_set_handshake_data(from._internal_handshake_data());
     }
@@ -4030,6 +4054,9 @@ void ConnectionResponseFrame::MergeFrom(const ConnectionResponseFrame& from) {
     if (cached_has_bits & 0x00000040u) {
       safe_to_disconnect_version_ = from.safe_to_disconnect_version_;
     }
+    if (cached_has_bits & 0x00000080u) {
+      feature_bitmask_ = from.feature_bitmask_;
+    }
     _has_bits_[0] |= cached_has_bits;
   }
   _internal_metadata_.MergeFrom<std::string>(from._internal_metadata_);
@@ -4058,8 +4085,8 @@ void ConnectionResponseFrame::InternalSwap(ConnectionResponseFrame* other) {
       &other->handshake_data_, rhs_arena
   );
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(ConnectionResponseFrame, safe_to_disconnect_version_)
-      + sizeof(ConnectionResponseFrame::safe_to_disconnect_version_)
+      PROTOBUF_FIELD_OFFSET(ConnectionResponseFrame, feature_bitmask_)
+      + sizeof(ConnectionResponseFrame::feature_bitmask_)
       - PROTOBUF_FIELD_OFFSET(ConnectionResponseFrame, os_info_)>(
           reinterpret_cast<char*>(&os_info_),
           reinterpret_cast<char*>(&other->os_info_));
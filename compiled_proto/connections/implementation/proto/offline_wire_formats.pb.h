@@ -1796,6 +1796,7 @@ class ConnectionResponseFrame final :
     kMultiplexSocketBitmaskFieldNumber = 5,
     kNearbyConnectionsVersionFieldNumber = 6,
     kSafeToDisconnectVersionFieldNumber = 7,
+    kFeatureBitmaskFieldNumber = 8,
   };
   // optional bytes handshake_data = 2;
   bool has_handshake_data() const;
@@ -1898,6 +1899,19 @@ class ConnectionResponseFrame final :
   void _internal_set_safe_to_disconnect_version(int32_t value);
   public:
 
+  // optional int32 feature_bitmask = 8;
+  bool has_feature_bitmask() const;
+  private:
+  bool _internal_has_feature_bitmask() const;
+  public:
+  void clear_feature_bitmask();
+  int32_t feature_bitmask() const;
+  void set_feature_bitmask(int32_t value);
+  private:
+  int32_t _internal_feature_bitmask() const;
+  void _internal_set_feature_bitmask(int32_t value);
+  public:
+
   // @@protoc_insertion_point(class_scope:location.nearby.connections.ConnectionResponseFrame)
  private:
   class _Internal;
@@ -1914,6 +1928,7 @@ class ConnectionResponseFrame final :
   int32_t multiplex_socket_bitmask_;
   int32_t nearby_connections_version_;
   int32_t safe_to_disconnect_version_;
+  int32_t feature_bitmask_;
   friend struct ::TableStruct_connections_2fimplementation_2fproto_2foffline_5fwire_5fformats_2eproto;
 };
 // -------------------------------------------------------------------
@@ -10599,6 +10614,34 @@ inline void ConnectionResponseFrame::set_safe_to_disconnect_version(int32_t valu
   // @@protoc_insertion_point(field_set:location.nearby.connections.ConnectionResponseFrame.safe_to_disconnect_version)
 }
 
+// optional int32 feature_bitmask = 8;
+inline bool ConnectionResponseFrame::_internal_has_feature_bitmask() const {
+  bool value = (_has_bits_[0] & 0x00000080u) != 0;
+  return value;
+}
+inline bool ConnectionResponseFrame::has_feature_bitmask() const {
+  return _internal_has_feature_bitmask();
+}
+inline void ConnectionResponseFrame::clear_feature_bitmask() {
+  feature_bitmask_ = 0;
+  _has_bits_[0] &= ~0x00000080u;
+}
+inline int32_t ConnectionResponseFrame::_internal_feature_bitmask() const {
+  return feature_bitmask_;
+}
+inline int32_t ConnectionResponseFrame::feature_bitmask() const {
+  // @@protoc_insertion_point(field_get:location.nearby.connections.ConnectionResponseFrame.feature_bitmask)
+  return _internal_feature_bitmask();
+}
+inline void ConnectionResponseFrame::_internal_set_feature_bitmask(int32_t value) {
+  _has_bits_[0] |= 0x00000080u;
+  feature_bitmask_ = value;
+}
+inline void ConnectionResponseFrame::set_feature_bitmask(int32_t value) {
+  _internal_set_feature_bitmask(value);
+  // @@protoc_insertion_point(field_set:location.nearby.connections.ConnectionResponseFrame.feature_bitmask)
+}
+
 // -------------------------------------------------------------------
 
 // PayloadTransferFrame_PayloadHeader
@@ -255,7 +255,8 @@ constexpr ConnectionsLog_BandwidthUpgradeAttempt::ConnectionsLog_BandwidthUpgrad
 
   , client_flow_id_(int64_t{0})
   , error_stage_(0)
-{}
+
+  , raced_medium_count_(0){}
 struct ConnectionsLog_BandwidthUpgradeAttemptDefaultTypeInternal {
   constexpr ConnectionsLog_BandwidthUpgradeAttemptDefaultTypeInternal()
     : _instance(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized{}) {}
@@ -5069,6 +5070,9 @@ class ConnectionsLog_BandwidthUpgradeAttempt::_Internal {
   static void set_has_operation_result(HasBits* has_bits) {
     (*has_bits)[0] |= 2u;
   }
+  static void set_has_raced_medium_count(HasBits* has_bits) {
+    (*has_bits)[0] |= 512u;
+  }
 };
 
 const ::location::nearby::analytics::proto::ConnectionsLog_OperationResult&
@@ -5102,8 +5106,8 @@ ConnectionsLog_BandwidthUpgradeAttempt::ConnectionsLog_BandwidthUpgradeAttempt(c
     operation_result_ = nullptr;
   }
   ::memcpy(&duration_millis_, &from.duration_millis_,
-    static_cast<size_t>(reinterpret_cast<char*>(&error_stage_) -
-    reinterpret_cast<char*>(&duration_millis_)) + sizeof(error_stage_));
+    static_cast<size_t>(reinterpret_cast<char*>(&raced_medium_count_) -
+    reinterpret_cast<char*>(&duration_millis_)) + sizeof(raced_medium_count_));
   // @@protoc_insertion_point(copy_constructor:location.nearby.analytics.proto.ConnectionsLog.BandwidthUpgradeAttempt)
 }
 
@@ -5114,8 +5118,8 @@ connection_token_.UnsafeSetDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyS
 #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
 ::memset(reinterpret_cast<char*>(this) + static_cast<size_t>(
     reinterpret_cast<char*>(&operation_result_) - reinterpret_cast<char*>(this)),
-    0, static_cast<size_t>(reinterpret_cast<char*>(&error_stage_) -
-    reinterpret_cast<char*>(&operation_result_)) + sizeof(error_stage_));
+    0, static_cast<size_t>(reinterpret_cast<char*>(&raced_medium_count_) -
+    reinterpret_cast<char*>(&operation_result_)) + sizeof(raced_medium_count_));
 }
 
 ConnectionsLog_BandwidthUpgradeAttempt::~ConnectionsLog_BandwidthUpgradeAttempt() {
@@ -5162,7 +5166,11 @@ void ConnectionsLog_BandwidthUpgradeAttempt::Clear() {
         reinterpret_cast<char*>(&client_flow_id_) -
         reinterpret_cast<char*>(&duration_millis_)) + sizeof(client_flow_id_));
   }
-  error_stage_ = 0;
+  if (cached_has_bits & 0x00000300u) {
+    ::memset(&error_stage_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&raced_medium_count_) -
+        reinterpret_cast<char*>(&error_stage_)) + sizeof(raced_medium_count_));
+  }
   _has_bits_.Clear();
   _internal_metadata_.Clear<std::string>();
 }
@@ -5274,6 +5282,15 @@ const char* ConnectionsLog_BandwidthUpgradeAttempt::_InternalParse(const char* p
         } else
           goto handle_unusual;
         continue;
+      // optional int32 raced_medium_count = 10;
+      case 10:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 80)) {
+          _Internal::set_has_raced_medium_count(&has_bits);
+          raced_medium_count_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
       default:
         goto handle_unusual;
     }  // switch
@@ -5366,6 +5383,12 @@ uint8_t* ConnectionsLog_BandwidthUpgradeAttempt::_InternalSerialize(
         9, _Internal::operation_result(this), target, stream);
   }
 
+  // optional int32 raced_medium_count = 10;
+  if (cached_has_bits & 0x00000200u) {
+    target = stream->EnsureSpace(target);
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32ToArray(10, this->_internal_raced_medium_count(), target);
+  }
+
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     target = stream->WriteRaw(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).data(),
         static_cast<int>(_internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size()), target);
@@ -5433,12 +5456,19 @@ size_t ConnectionsLog_BandwidthUpgradeAttempt::ByteSizeLong() const {
     }
 
   }
-  // optional .location.nearby.proto.connections.BandwidthUpgradeErrorStage error_stage = 6;
-  if (cached_has_bits & 0x00000100u) {
-    total_size += 1 +
-      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::EnumSize(this->_internal_error_stage());
-  }
+  if (cached_has_bits & 0x00000300u) {
+    // optional .location.nearby.proto.connections.BandwidthUpgradeErrorStage error_stage = 6;
+    if (cached_has_bits & 0x00000100u) {
+      total_size += 1 +
+        ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::EnumSize(this->_internal_error_stage());
+    }
+
+    // optional int32 raced_medium_count = 10;
+    if (cached_has_bits & 0x00000200u) {
+      total_size += ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::Int32SizePlusOne(this->_internal_raced_medium_count());
+    }
 
+  }
   if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
     total_size += _internal_metadata_.unknown_fields<std::string>(::PROTOBUF_NAMESPACE_ID::internal::GetEmptyString).size();
   }
@@ -5487,8 +5517,14 @@ void ConnectionsLog_BandwidthUpgradeAttempt::MergeFrom(const ConnectionsLog_Band
     }
     _has_bits_[0] |= cached_has_bits;
   }
-  if (cached_has_bits & 0x00000100u) {
-    _internal_set_error_stage(from._internal_error_stage());
+  if (cached_has_bits & 0x00000300u) {
+    if (cached_has_bits & 0x00000100u) {
+      error_stage_ = from.error_stage_;
+    }
+    if (cached_has_bits & 0x00000200u) {
+      raced_medium_count_ = from.raced_medium_count_;
+    }
+    _has_bits_[0] |= cached_has_bits;
   }
   _internal_metadata_.MergeFrom<std::string>(from._internal_metadata_);
 }
@@ -5516,8 +5552,8 @@ void ConnectionsLog_BandwidthUpgradeAttempt::InternalSwap(ConnectionsLog_Bandwid
       &other->connection_token_, rhs_arena
   );
   ::PROTOBUF_NAMESPACE_ID::internal::memswap<
-      PROTOBUF_FIELD_OFFSET(ConnectionsLog_BandwidthUpgradeAttempt, error_stage_)
-      + sizeof(ConnectionsLog_BandwidthUpgradeAttempt::error_stage_)
+      PROTOBUF_FIELD_OFFSET(ConnectionsLog_BandwidthUpgradeAttempt, raced_medium_count_)
+      + sizeof(ConnectionsLog_BandwidthUpgradeAttempt::raced_medium_count_)
       - PROTOBUF_FIELD_OFFSET(ConnectionsLog_BandwidthUpgradeAttempt, operation_result_)>(
           reinterpret_cast<char*>(&operation_result_),
           reinterpret_cast<char*>(&other->operation_result_));
@@ -3088,6 +3088,7 @@ class ConnectionsLog_BandwidthUpgradeAttempt final :
     kUpgradeResultFieldNumber = 5,
     kClientFlowIdFieldNumber = 7,
     kErrorStageFieldNumber = 6,
+    kRacedMediumCountFieldNumber = 10,
   };
   // optional string connection_token = 8;
   bool has_connection_token() const;
@@ -3216,6 +3217,19 @@ class ConnectionsLog_BandwidthUpgradeAttempt final :
   void _internal_set_error_stage(::location::nearby::proto::connections::BandwidthUpgradeErrorStage value);
   public:
 
+  // optional int32 raced_medium_count = 10;
+  bool has_raced_medium_count() const;
+  private:
+  bool _internal_has_raced_medium_count() const;
+  public:
+  void clear_raced_medium_count();
+  int32_t raced_medium_count() const;
+  void set_raced_medium_count(int32_t value);
+  private:
+  int32_t _internal_raced_medium_count() const;
+  void _internal_set_raced_medium_count(int32_t value);
+  public:
+
   // @@protoc_insertion_point(class_scope:location.nearby.analytics.proto.ConnectionsLog.BandwidthUpgradeAttempt)
  private:
   class _Internal;
@@ -3234,6 +3248,7 @@ class ConnectionsLog_BandwidthUpgradeAttempt final :
   int upgrade_result_;
   int64_t client_flow_id_;
   int error_stage_;
+  int32_t raced_medium_count_;
   friend struct ::TableStruct_internal_2fproto_2fanalytics_2fconnections_5flog_2eproto;
 };
 // -------------------------------------------------------------------
@@ -8030,6 +8045,34 @@ inline void ConnectionsLog_BandwidthUpgradeAttempt::set_allocated_operation_resu
   // @@protoc_insertion_point(field_set_allocated:location.nearby.analytics.proto.ConnectionsLog.BandwidthUpgradeAttempt.operation_result)
 }
 
+// optional int32 raced_medium_count = 10;
+inline bool ConnectionsLog_BandwidthUpgradeAttempt::_internal_has_raced_medium_count() const {
+  bool value = (_has_bits_[0] & 0x00000200u) != 0;
+  return value;
+}
+inline bool ConnectionsLog_BandwidthUpgradeAttempt::has_raced_medium_count() const {
+  return _internal_has_raced_medium_count();
+}
+inline void ConnectionsLog_BandwidthUpgradeAttempt::clear_raced_medium_count() {
+  raced_medium_count_ = 0;
+  _has_bits_[0] &= ~0x00000200u;
+}
+inline int32_t ConnectionsLog_BandwidthUpgradeAttempt::_internal_raced_medium_count() const {
+  return raced_medium_count_;
+}
+inline int32_t ConnectionsLog_BandwidthUpgradeAttempt::raced_medium_count() const {
+  // @@protoc_insertion_point(field_get:location.nearby.analytics.proto.ConnectionsLog.BandwidthUpgradeAttempt.raced_medium_count)
+  return _internal_raced_medium_count();
+}
+inline void ConnectionsLog_BandwidthUpgradeAttempt::_internal_set_raced_medium_count(int32_t value) {
+  _has_bits_[0] |= 0x00000200u;
+  raced_medium_count_ = value;
+}
+inline void ConnectionsLog_BandwidthUpgradeAttempt::set_raced_medium_count(int32_t value) {
+  _internal_set_raced_medium_count(value);
+  // @@protoc_insertion_point(field_set:location.nearby.analytics.proto.ConnectionsLog.BandwidthUpgradeAttempt.raced_medium_count)
+}
+
 // -------------------------------------------------------------------
 
 // ConnectionsLog_ErrorCode
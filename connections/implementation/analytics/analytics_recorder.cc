@@ -646,6 +646,22 @@ void AnalyticsRecorder::OnBandwidthUpgradeSuccess(
                              UPGRADE_SUCCESS);
 }
 
+void AnalyticsRecorder::OnBandwidthUpgradeRaceFinished(
+    const std::string &endpoint_id, Medium to_medium, int raced_medium_count) {
+  MutexLock lock(&mutex_);
+  if (!CanRecordAnalyticsLocked("OnBandwidthUpgradeRaceFinished")) {
+    return;
+  }
+  auto it = bandwidth_upgrade_attempts_.find(endpoint_id);
+  if (it == bandwidth_upgrade_attempts_.end()) {
+    NEARBY_LOGS(INFO) << "Ignoring race result for endpoint " << endpoint_id
+                      << " without a bandwidth upgrade attempt.";
+    return;
+  }
+  it->second->set_to_medium(to_medium);
+  it->second->set_raced_medium_count(raced_medium_count);
+}
+
 void AnalyticsRecorder::OnErrorCode(const ErrorCodeParams &params) {
   MutexLock lock(&mutex_);
   if (!CanRecordAnalyticsLocked("OnErrorCode")) {
@@ -173,6 +173,12 @@ class AnalyticsRecorder {
           error_stage) ABSL_LOCKS_EXCLUDED(mutex_);
   void OnBandwidthUpgradeSuccess(const std::string &endpoint_id)
       ABSL_LOCKS_EXCLUDED(mutex_);
+  // Records the medium that won a race between |raced_medium_count| upgrade
+  // mediums for the upgrade attempt started by OnBandwidthUpgradeStarted.
+  void OnBandwidthUpgradeRaceFinished(
+      const std::string &endpoint_id,
+      location::nearby::proto::connections::Medium to_medium,
+      int raced_medium_count) ABSL_LOCKS_EXCLUDED(mutex_);
 
   // Error Code
   void OnErrorCode(const ErrorCodeParams &params);
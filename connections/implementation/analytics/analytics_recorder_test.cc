@@ -919,6 +919,46 @@ TEST(AnalyticsRecorderTest, UpgradeAttemptWorks) {
               Partially(EqualsProto(strategy_session_proto)));
 }
 
+TEST(AnalyticsRecorderTest, UpgradeAttemptRecordsRaceWinner) {
+  std::string endpoint_id = "endpoint_id";
+  std::string connection_token = "connection_token";
+
+  CountDownLatch client_session_done_latch(1);
+  FakeEventLogger event_logger(client_session_done_latch);
+  AnalyticsRecorder analytics_recorder(&event_logger);
+
+  analytics_recorder.OnStartAdvertising(connections::Strategy::kP2pStar,
+                                        /*mediums=*/{BLUETOOTH});
+
+  analytics_recorder.OnBandwidthUpgradeStarted(
+      endpoint_id, BLUETOOTH, WIFI_LAN, INCOMING, connection_token);
+  analytics_recorder.OnBandwidthUpgradeRaceFinished(endpoint_id, WEB_RTC,
+                                                    /*raced_medium_count=*/2);
+  analytics_recorder.OnBandwidthUpgradeSuccess(endpoint_id);
+
+  analytics_recorder.LogSession();
+  ASSERT_TRUE(client_session_done_latch.Await(kDefaultTimeout).result());
+
+  ConnectionsLog::ClientSession strategy_session_proto =
+      ParseTextProtoOrDie(R"pb(
+        strategy_session <
+          strategy: P2P_STAR
+          role: ADVERTISER
+          upgrade_attempt <
+            direction: INCOMING
+            from_medium: BLUETOOTH
+            to_medium: WEB_RTC
+            upgrade_result: UPGRADE_RESULT_SUCCESS
+            error_stage: UPGRADE_SUCCESS
+            connection_token: "connection_token"
+            raced_medium_count: 2
+          >
+        >)pb");
+
+  EXPECT_THAT(event_logger.GetLoggedClientSession(),
+              Partially(EqualsProto(strategy_session_proto)));
+}
+
 TEST(AnalyticsRecorderTest, StartListeningForIncomingConnectionsWorks) {
   std::string endpoint_id = "endpoint_id";
   std::string endpoint_id_1 = "endpoint_id_1";
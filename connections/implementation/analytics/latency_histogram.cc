@@ -0,0 +1,57 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/analytics/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace analytics {
+
+void LatencyHistogram::Record(absl::Duration latency) {
+  int64_t micros = absl::ToInt64Microseconds(latency);
+  int bucket = 0;
+  while (micros > 0 && bucket < kBucketCount - 1) {
+    micros >>= 1;
+    ++bucket;
+  }
+  ++buckets_[bucket];
+  ++count_;
+}
+
+absl::Duration LatencyHistogram::GetPercentile(double percentile) const {
+  if (count_ == 0) return absl::ZeroDuration();
+  percentile = std::clamp(percentile, 0.0, 100.0);
+  // The rank of the requested sample, counting from 1.
+  int64_t rank = std::max<int64_t>(
+      1, static_cast<int64_t>(std::ceil(percentile / 100.0 * count_)));
+  int64_t seen = 0;
+  for (int bucket = 0; bucket < kBucketCount; ++bucket) {
+    seen += buckets_[bucket];
+    if (seen >= rank) return BucketUpperBound(bucket);
+  }
+  return BucketUpperBound(kBucketCount - 1);
+}
+
+// static
+absl::Duration LatencyHistogram::BucketUpperBound(int bucket) {
+  return absl::Microseconds(int64_t{1} << bucket);
+}
+
+}  // namespace analytics
+}  // namespace nearby
@@ -0,0 +1,55 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_LATENCY_HISTOGRAM_H_
+#define NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace analytics {
+
+// A fixed size histogram of latencies with power of two microsecond buckets.
+// Bucket 0 holds samples below 1us, bucket i holds samples in
+// [2^(i-1), 2^i) microseconds and the last bucket holds everything above.
+// Recording is a couple of integer operations and never allocates, so it is
+// cheap enough to call once per frame.
+//
+// This class is not thread-safe.
+class LatencyHistogram {
+ public:
+  static constexpr int kBucketCount = 32;
+
+  void Record(absl::Duration latency);
+
+  // Returns the upper bound of the bucket containing the |percentile|
+  // (0..100) sample, or absl::ZeroDuration() if nothing has been recorded.
+  absl::Duration GetPercentile(double percentile) const;
+
+  int64_t count() const { return count_; }
+
+ private:
+  static absl::Duration BucketUpperBound(int bucket);
+
+  std::array<int64_t, kBucketCount> buckets_ = {};
+  int64_t count_ = 0;
+};
+
+}  // namespace analytics
+}  // namespace nearby
+
+#endif  // NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,60 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/analytics/latency_histogram.h"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace analytics {
+namespace {
+
+TEST(LatencyHistogram, EmptyHistogramReturnsZero) {
+  LatencyHistogram histogram;
+
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.GetPercentile(50), absl::ZeroDuration());
+}
+
+TEST(LatencyHistogram, PercentilesUseBucketUpperBounds) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 98; ++i) {
+    histogram.Record(absl::Microseconds(100));
+  }
+  histogram.Record(absl::Milliseconds(3));
+  histogram.Record(absl::Milliseconds(3));
+
+  EXPECT_EQ(histogram.count(), 100);
+  // 100us falls into [64us, 128us).
+  EXPECT_EQ(histogram.GetPercentile(50), absl::Microseconds(128));
+  // 3000us falls into [2048us, 4096us).
+  EXPECT_EQ(histogram.GetPercentile(99), absl::Microseconds(4096));
+}
+
+TEST(LatencyHistogram, SubMicrosecondAndHugeSamples) {
+  LatencyHistogram histogram;
+  histogram.Record(absl::Nanoseconds(10));
+  histogram.Record(absl::Hours(10));
+
+  EXPECT_EQ(histogram.GetPercentile(0), absl::Microseconds(1));
+  EXPECT_EQ(histogram.GetPercentile(100),
+            absl::Microseconds(int64_t{1} << 31));
+}
+
+}  // namespace
+}  // namespace analytics
+}  // namespace nearby
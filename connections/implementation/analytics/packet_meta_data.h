@@ -72,27 +72,39 @@ struct PacketMetaData {
     socket_io_end_time = SystemClock::ElapsedRealtime();
   }
 
+  // The durations below keep the full resolution of
+  // SystemClock::ElapsedRealtime(); small chunks often take well under a
+  // millisecond per stage.
+  absl::Duration GetEncryptionTime() const {
+    return GetElapsed(encryption_start_time, encryption_end_time);
+  }
+
+  absl::Duration GetFileIoTime() const {
+    return GetElapsed(file_io_start_time, file_io_end_time);
+  }
+
+  absl::Duration GetSocketIoTime() const {
+    return GetElapsed(socket_io_start_time, socket_io_end_time);
+  }
+
   int64_t GetEncryptionTimeInMillis() {
-    if (encryption_end_time > encryption_start_time) {
-      return absl::ToInt64Milliseconds(encryption_end_time -
-                                       encryption_start_time);
-    }
-    return 0L;
+    return absl::ToInt64Milliseconds(GetEncryptionTime());
   }
 
   int64_t GetFileIoTimeInMillis() {
-    if (file_io_end_time > file_io_start_time) {
-      return absl::ToInt64Milliseconds(file_io_end_time - file_io_start_time);
-    }
-    return 0L;
+    return absl::ToInt64Milliseconds(GetFileIoTime());
   }
 
   int64_t GetSocketIoTimeInMillis() {
-    if (socket_io_end_time > socket_io_start_time) {
-      return absl::ToInt64Milliseconds(socket_io_end_time -
-                                       socket_io_start_time);
+    return absl::ToInt64Milliseconds(GetSocketIoTime());
+  }
+
+ private:
+  static absl::Duration GetElapsed(absl::Time start, absl::Time end) {
+    if (end > start) {
+      return end - start;
     }
-    return 0L;
+    return absl::ZeroDuration();
   }
 };
 
@@ -16,6 +16,8 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <new>
 #include <ostream>
 #include <string>
@@ -23,6 +25,7 @@
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/meta/type_traits.h"
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
@@ -99,6 +102,13 @@ bool ThroughputRecorder::Stop() {
       }
     }
 
+    if (max_chunk_size_ > 0) {
+      NEARBY_LOGS(INFO) << "Payload " << payload_id_ << " chunk size: last "
+                        << last_chunk_size_ << " bytes, max " << max_chunk_size_
+                        << " bytes, changed " << chunk_size_changes_
+                        << " times";
+    }
+
     // calculate throughput by medium
     for (auto& tp : throughputs_) {
       tp.second.dump();
@@ -118,19 +128,20 @@ bool ThroughputRecorder::Stop() {
         std::string dump_content = absl::StrFormat(
             "%s %s data(%d bytes) %s, overall used %d milliseconds, "
             "throughput "
-            "is %d MB/s (%d KB/s), File IO takes %d ms, %s takes %d "
+            "is %d MB/s (%d KB/s), File IO takes %.3f ms, %s takes %.3f "
             "ms, "
-            "Socket IO takes %d ms",
+            "Socket IO takes %.3f ms",
             (payload_direction_ == PayloadDirection::INCOMING_PAYLOAD)
                 ? "Received"
                 : "Sent",
             ToString(payload_type_), total_byte_size,
             success_ ? "SUCCEEDED" : "FAILED", total_millis, throughput_mbps,
-            throughput_kbps_, file_io_time_,
+            throughput_kbps_, absl::ToDoubleMilliseconds(file_io_time_),
             (payload_direction_ == PayloadDirection::INCOMING_PAYLOAD)
                 ? "Decryption"
                 : "Encryption",
-            encryption_time_, socket_io_time_);
+            absl::ToDoubleMilliseconds(encryption_time_),
+            absl::ToDoubleMilliseconds(socket_io_time_));
         NEARBY_LOGS(INFO) << dump_content;
       }
     }
@@ -155,15 +166,17 @@ int ThroughputRecorder::CalculateThroughputMBps(int throughputKBps) {
   return throughputKBps / kKbInBytes;
 }
 
-void ThroughputRecorder::Throughput::Add(int frame_size, int64_t file_io_time,
-                                         int64_t encryption_time,
-                                         int64_t socket_io_time) {
+void ThroughputRecorder::Throughput::Add(int frame_size,
+                                         absl::Duration file_io_time,
+                                         absl::Duration encryption_time,
+                                         absl::Duration socket_io_time) {
   total_byte_size_ += frame_size;
   // reset the last timestamp
   last_timestamp_ = SystemClock::ElapsedRealtime();
   file_io_time_ += file_io_time;
   encryption_time_ += encryption_time;
   socket_io_time_ += socket_io_time;
+  frame_latencies_.Record(file_io_time + encryption_time + socket_io_time);
 }
 
 bool ThroughputRecorder::Throughput::dump() {
@@ -174,21 +187,27 @@ bool ThroughputRecorder::Throughput::dump() {
     return false;
   }
   int throughpu_mbps = CalculateThroughputMBps(throughput_kbps);
-  int64_t other =
-      total_millis - file_io_time_ - encryption_time_ - socket_io_time_;
+  absl::Duration other = last_timestamp_ - start_timestamp_ - file_io_time_ -
+                         encryption_time_ - socket_io_time_;
   std::string dump_content = absl::StrFormat(
       "%s %s data(%ld bytes) via %s used %ld milliseconds, throughput is %d "
-      "MB/s (%d KB/s), File IO takes %ld ms, %s takes %ld ms, "
-      "Socket IO takes %ld ms, "
-      "Other takes %ld ms",
+      "MB/s (%d KB/s), File IO takes %.3f ms, %s takes %.3f ms, "
+      "Socket IO takes %.3f ms, "
+      "Other takes %.3f ms, "
+      "%ld frames took p50 %ld us, p99 %ld us",
       (payload_direction_ == PayloadDirection::INCOMING_PAYLOAD) ? "Received"
                                                                  : "Sent",
       ToString(payload_type_), total_byte_size_,
       location::nearby::proto::connections::Medium_Name(medium_), total_millis,
-      throughpu_mbps, throughput_kbps, file_io_time_,
+      throughpu_mbps, throughput_kbps,
+      absl::ToDoubleMilliseconds(file_io_time_),
       (payload_direction_ == PayloadDirection::INCOMING_PAYLOAD) ? "Decryption"
                                                                  : "Encryption",
-      encryption_time_, socket_io_time_, other);
+      absl::ToDoubleMilliseconds(encryption_time_),
+      absl::ToDoubleMilliseconds(socket_io_time_),
+      absl::ToDoubleMilliseconds(other), frame_latencies_.count(),
+      absl::ToInt64Microseconds(frame_latencies_.GetPercentile(50)),
+      absl::ToInt64Microseconds(frame_latencies_.GetPercentile(99)));
   NEARBY_LOGS(INFO) << dump_content;
   return true;
 }
@@ -229,9 +248,9 @@ void ThroughputRecorder::OnFrameSent(Medium medium,
                      packetMetaData.GetFileIoTimeInMillis() +
                      packetMetaData.GetSocketIoTimeInMillis();
   GetThroughput(medium, duration_millis_)
-      .Add(packetMetaData.packet_size, packetMetaData.GetFileIoTimeInMillis(),
-           packetMetaData.GetEncryptionTimeInMillis(),
-           packetMetaData.GetSocketIoTimeInMillis());
+      .Add(packetMetaData.packet_size, packetMetaData.GetFileIoTime(),
+           packetMetaData.GetEncryptionTime(),
+           packetMetaData.GetSocketIoTime());
   CalculateDurationTimes(packetMetaData);
 }
 
@@ -248,16 +267,39 @@ void ThroughputRecorder::OnFrameReceived(Medium medium,
                      packetMetaData.GetFileIoTimeInMillis() +
                      packetMetaData.GetSocketIoTimeInMillis();
   GetThroughput(medium, duration_millis_)
-      .Add(packetMetaData.packet_size, packetMetaData.GetFileIoTimeInMillis(),
-           packetMetaData.GetEncryptionTimeInMillis(),
-           packetMetaData.GetSocketIoTimeInMillis());
+      .Add(packetMetaData.packet_size, packetMetaData.GetFileIoTime(),
+           packetMetaData.GetEncryptionTime(),
+           packetMetaData.GetSocketIoTime());
   CalculateDurationTimes(packetMetaData);
 }
 
+void ThroughputRecorder::OnChunkSizeSelected(int chunk_size) {
+  MutexLock lock(&mutex_);
+  if (chunk_size == last_chunk_size_) return;
+  if (last_chunk_size_ != 0) ++chunk_size_changes_;
+  last_chunk_size_ = chunk_size;
+  max_chunk_size_ = std::max(max_chunk_size_, chunk_size);
+}
+
+int ThroughputRecorder::GetLastChunkSize() {
+  MutexLock lock(&mutex_);
+  return last_chunk_size_;
+}
+
+int ThroughputRecorder::GetMaxChunkSize() {
+  MutexLock lock(&mutex_);
+  return max_chunk_size_;
+}
+
+int ThroughputRecorder::GetChunkSizeChanges() {
+  MutexLock lock(&mutex_);
+  return chunk_size_changes_;
+}
+
 void ThroughputRecorder::CalculateDurationTimes(PacketMetaData packetMetaData) {
-  encryption_time_ += packetMetaData.GetEncryptionTimeInMillis();
-  socket_io_time_ += packetMetaData.GetSocketIoTimeInMillis();
-  file_io_time_ += packetMetaData.GetFileIoTimeInMillis();
+  encryption_time_ += packetMetaData.GetEncryptionTime();
+  socket_io_time_ += packetMetaData.GetSocketIoTime();
+  file_io_time_ += packetMetaData.GetFileIoTime();
 }
 
 std::string ThroughputRecorder::ToString(PayloadType type) {
@@ -276,30 +318,34 @@ std::string ThroughputRecorder::ToString(PayloadType type) {
 // Inplementation for ThroughputRecorderContainer
 
 void ThroughputRecorderContainer::Shutdown() {
-  MutexLock lock(&mutex_);
-  NEARBY_LOGS(INFO) << __func__
-                    << ".  Num of Instance:" << throughput_recorders_.size();
-  for (auto& throughput_recorder : throughput_recorders_) {
-    NEARBY_LOGS(INFO) << "Stop instance: " << throughput_recorder.second;
-    throughput_recorder.second->Stop();
-    delete throughput_recorder.second;
+  int size = 0;
+  for (Shard& shard : shards_) {
+    MutexLock lock(&shard.mutex);
+    size += shard.throughput_recorders.size();
+    for (auto& throughput_recorder : shard.throughput_recorders) {
+      NEARBY_LOGS(INFO) << "Stop instance: " << throughput_recorder.second;
+      throughput_recorder.second->Stop();
+      delete throughput_recorder.second;
+    }
+    shard.throughput_recorders.clear();
   }
-  throughput_recorders_.clear();
+  NEARBY_LOGS(INFO) << __func__ << ".  Num of Instance:" << size;
 }
 
 ThroughputRecorder* ThroughputRecorderContainer::GetTPRecorder(
     const int64_t payload_id, PayloadDirection payload_direction) {
-  MutexLock lock(&mutex_);
-  auto it = throughput_recorders_.find(
+  Shard& shard = GetShard(payload_id, payload_direction);
+  MutexLock lock(&shard.mutex);
+  auto it = shard.throughput_recorders.find(
       std::pair<int64_t, PayloadDirection>(payload_id, payload_direction));
-  if (it == throughput_recorders_.end()) {
+  if (it == shard.throughput_recorders.end()) {
     auto instance = new ThroughputRecorder(payload_id);
     std::string direction =
         (payload_direction == PayloadDirection::INCOMING_PAYLOAD) ? "; Receive"
                                                                   : "; Send";
     NEARBY_LOGS(INFO) << "Add ThroughputRecorder instance : " << instance
                       << " for payload_id:" << payload_id << direction;
-    throughput_recorders_.emplace(
+    shard.throughput_recorders.emplace(
         std::pair<int64_t, PayloadDirection>(payload_id, payload_direction),
         instance);
     return instance;
@@ -310,28 +356,39 @@ ThroughputRecorder* ThroughputRecorderContainer::GetTPRecorder(
 
 void ThroughputRecorderContainer::StopTPRecorder(
     const int64_t payload_id, PayloadDirection payload_direction) {
-  MutexLock lock(&mutex_);
+  Shard& shard = GetShard(payload_id, payload_direction);
+  MutexLock lock(&shard.mutex);
   std::string direction =
       (payload_direction == PayloadDirection::INCOMING_PAYLOAD) ? "; Receive"
                                                                 : "; Send";
-  auto it = throughput_recorders_.find(
+  auto it = shard.throughput_recorders.find(
       std::pair<int64_t, PayloadDirection>(payload_id, payload_direction));
-  if (it != throughput_recorders_.end()) {
+  if (it != shard.throughput_recorders.end()) {
     NEARBY_LOGS(INFO) << "Found and stop/delete ThroughputRecorder instance : "
                       << &(it->second) << " for payload_id:" << payload_id
                       << direction;
     it->second->Stop();
     delete it->second;
-    throughput_recorders_.erase(
-        std::pair<int64_t, PayloadDirection>(payload_id, payload_direction));
+    shard.throughput_recorders.erase(it);
     return;
   }
   NEARBY_LOGS(INFO) << "No ThroughputRecorder found for :" << payload_id;
 }
 
 int ThroughputRecorderContainer::GetSize() {
-  MutexLock lock(&mutex_);
-  return throughput_recorders_.size();
+  int size = 0;
+  for (Shard& shard : shards_) {
+    MutexLock lock(&shard.mutex);
+    size += shard.throughput_recorders.size();
+  }
+  return size;
+}
+
+ThroughputRecorderContainer::Shard& ThroughputRecorderContainer::GetShard(
+    int64_t payload_id, PayloadDirection payload_direction) {
+  size_t hash = absl::Hash<std::pair<int64_t, PayloadDirection>>()(
+      std::pair<int64_t, PayloadDirection>(payload_id, payload_direction));
+  return shards_[hash % kShardCount];
 }
 
 }  // namespace analytics
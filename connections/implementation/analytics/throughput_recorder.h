@@ -15,6 +15,7 @@
 #ifndef NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_THROUGHPUT_RECORDER_H_
 #define NEARBY_CONNECTIONS_IMPLEMENTATION_ANALYTICS_THROUGHPUT_RECORDER_H_
 
+#include <array>
 #include <cstdint>
 #include <string>
 #include <utility>
@@ -22,6 +23,7 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/time/time.h"
+#include "connections/implementation/analytics/latency_histogram.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
 #include "connections/payload_type.h"
 #include "internal/platform/mutex.h"
@@ -58,8 +60,8 @@ class ThroughputRecorder {
           payload_type_(payload_type),
           payload_direction_(payload_direction) {}
 
-    void Add(int frame_size, int64_t file_io_time, int64_t encryption_time,
-             int64_t socket_io_time);
+    void Add(int frame_size, absl::Duration file_io_time,
+             absl::Duration encryption_time, absl::Duration socket_io_time);
 
     void SetLastTimestamp(absl::Time time_stamp) {
       last_timestamp_ = time_stamp;
@@ -67,6 +69,11 @@ class ThroughputRecorder {
 
     int64_t GetTotalByteSize() { return total_byte_size_; }
 
+    // Per frame time spent in file IO, encryption and socket IO.
+    const LatencyHistogram& GetFrameLatencies() const {
+      return frame_latencies_;
+    }
+
     bool dump();
 
    private:
@@ -76,9 +83,10 @@ class ThroughputRecorder {
     int64_t total_byte_size_ = 0;
     absl::Time last_timestamp_;
     PayloadDirection payload_direction_ = PayloadDirection::INCOMING_PAYLOAD;
-    int64_t file_io_time_ = 0;
-    int64_t encryption_time_ = 0;
-    int64_t socket_io_time_ = 0;
+    absl::Duration file_io_time_;
+    absl::Duration encryption_time_;
+    absl::Duration socket_io_time_;
+    LatencyHistogram frame_latencies_;
   };
 
   Throughput& GetThroughput(Medium medium, int64_t duration_millis);
@@ -87,6 +95,11 @@ class ThroughputRecorder {
   int64_t GetDurationMillis();
   void OnFrameSent(Medium medium, PacketMetaData& packetMetaData);
   void OnFrameReceived(Medium medium, PacketMetaData& packetMetaData);
+  // Records the chunk size picked for the next outgoing chunk.
+  void OnChunkSizeSelected(int chunk_size) ABSL_LOCKS_EXCLUDED(mutex_);
+  int GetLastChunkSize() ABSL_LOCKS_EXCLUDED(mutex_);
+  int GetMaxChunkSize() ABSL_LOCKS_EXCLUDED(mutex_);
+  int GetChunkSizeChanges() ABSL_LOCKS_EXCLUDED(mutex_);
   void MarkAsSuccess();
 
  private:
@@ -101,11 +114,14 @@ class ThroughputRecorder {
   absl::flat_hash_map<Medium, Throughput> throughputs_;
   bool success_ = false;
 
-  int64_t file_io_time_ = 0;
-  int64_t encryption_time_ = 0;
-  int64_t socket_io_time_ = 0;
+  absl::Duration file_io_time_;
+  absl::Duration encryption_time_;
+  absl::Duration socket_io_time_;
   int64_t duration_millis_ = 0;
   int throughput_kbps_ = 0;
+  int last_chunk_size_ = 0;
+  int max_chunk_size_ = 0;
+  int chunk_size_changes_ = 0;
 };
 
 class ThroughputRecorderContainer {
@@ -115,14 +131,12 @@ class ThroughputRecorderContainer {
       delete;
 
   static ThroughputRecorderContainer& GetInstance();
-  void Shutdown() ABSL_LOCKS_EXCLUDED(mutex_);
+  void Shutdown();
 
   ThroughputRecorder* GetTPRecorder(int64_t payload_id,
-                                    PayloadDirection payload_direction)
-      ABSL_LOCKS_EXCLUDED(mutex_);
-  void StopTPRecorder(int64_t payload_id, PayloadDirection payload_direction)
-      ABSL_LOCKS_EXCLUDED(mutex_);
-  int GetSize() ABSL_LOCKS_EXCLUDED(mutex_);
+                                    PayloadDirection payload_direction);
+  void StopTPRecorder(int64_t payload_id, PayloadDirection payload_direction);
+  int GetSize();
 
  private:
   // This is a singleton object, for which destructor will never be called.
@@ -132,10 +146,22 @@ class ThroughputRecorderContainer {
   ThroughputRecorderContainer() = default;
   ~ThroughputRecorderContainer() = default;
 
-  Mutex mutex_;
-  // std::pair<int64_t, PayloadDirection> for <payload id, payload direction>
-  absl::flat_hash_map<std::pair<int64_t, PayloadDirection>, ThroughputRecorder*>
-      throughput_recorders_ ABSL_GUARDED_BY(mutex_);
+  // GetTPRecorder() runs for every chunk of every transfer, so the recorders
+  // are spread over shards with their own locks. Concurrent transfers then
+  // rarely wait on each other just to find their recorder.
+  static constexpr int kShardCount = 16;
+
+  struct Shard {
+    Mutex mutex;
+    // std::pair<int64_t, PayloadDirection> for <payload id, payload direction>
+    absl::flat_hash_map<std::pair<int64_t, PayloadDirection>,
+                        ThroughputRecorder*>
+        throughput_recorders ABSL_GUARDED_BY(mutex);
+  };
+
+  Shard& GetShard(int64_t payload_id, PayloadDirection payload_direction);
+
+  std::array<Shard, kShardCount> shards_;
 };
 
 }  // namespace analytics
@@ -98,6 +98,30 @@ TEST_F(ThroughputRecorderTest, OnFrameSentSaveTransferredSize) {
   EXPECT_EQ(throughput.GetTotalByteSize(), kFrameSize * 3);
 }
 
+TEST_F(ThroughputRecorderTest, OnFrameSentRecordsSubMillisecondLatencies) {
+  auto TPRecorder = tp_recorder_container_.GetTPRecorder(
+      kPayloadIdA, PayloadDirection::OUTGOING_PAYLOAD);
+  TPRecorder->Start(PayloadType::kBytes, PayloadDirection::OUTGOING_PAYLOAD);
+
+  PacketMetaData packet_meta_data;
+  packet_meta_data.SetPacketSize(kFrameSize);
+  packet_meta_data.encryption_start_time = absl::UnixEpoch();
+  packet_meta_data.encryption_end_time =
+      absl::UnixEpoch() + absl::Microseconds(300);
+  EXPECT_EQ(packet_meta_data.GetEncryptionTimeInMillis(), 0);
+  EXPECT_EQ(packet_meta_data.GetEncryptionTime(), absl::Microseconds(300));
+  for (int i = 0; i < 3; ++i) {
+    TPRecorder->OnFrameSent(location::nearby::proto::connections::BLE,
+                            packet_meta_data);
+  }
+
+  const LatencyHistogram& frame_latencies =
+      TPRecorder->GetThroughput(location::nearby::proto::connections::BLE, 0)
+          .GetFrameLatencies();
+  EXPECT_EQ(frame_latencies.count(), 3);
+  EXPECT_EQ(frame_latencies.GetPercentile(50), absl::Microseconds(512));
+}
+
 TEST_F(ThroughputRecorderTest, OnIgnoreUnkownPaylaodType) {
   auto TPRecorder = tp_recorder_container_.GetTPRecorder(
       kPayloadIdA, PayloadDirection::OUTGOING_PAYLOAD);
@@ -220,6 +244,21 @@ TEST_F(ThroughputRecorderTest, OnFrameReceivedCheckDurationMillis) {
                 packet_meta_data.GetSocketIoTimeInMillis());
 }
 
+TEST_F(ThroughputRecorderTest, OnChunkSizeSelectedTracksChanges) {
+  auto TPRecorder = tp_recorder_container_.GetTPRecorder(
+      kPayloadIdA, PayloadDirection::OUTGOING_PAYLOAD);
+  TPRecorder->Start(PayloadType::kFile, PayloadDirection::OUTGOING_PAYLOAD);
+
+  TPRecorder->OnChunkSizeSelected(65536);
+  TPRecorder->OnChunkSizeSelected(65536);
+  TPRecorder->OnChunkSizeSelected(131072);
+  TPRecorder->OnChunkSizeSelected(65536);
+
+  EXPECT_EQ(TPRecorder->GetLastChunkSize(), 65536);
+  EXPECT_EQ(TPRecorder->GetMaxChunkSize(), 131072);
+  EXPECT_EQ(TPRecorder->GetChunkSizeChanges(), 2);
+}
+
 TEST_F(ThroughputRecorderTest, OnTPRecorderNotStarted) {
   auto TPRecorder = tp_recorder_container_.GetTPRecorder(
       kPayloadIdA, PayloadDirection::OUTGOING_PAYLOAD);
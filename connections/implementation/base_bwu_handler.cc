@@ -16,9 +16,11 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "connections/implementation/service_id_constants.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
 
 namespace nearby {
 namespace connections {
@@ -37,6 +39,7 @@ ByteArray BaseBwuHandler::InitializeUpgradedMediumForEndpoint(
       HandleInitializeUpgradedMediumForEndpoint(client, upgrade_service_id,
                                                 endpoint_id);
   if (!upgrade_path_available_frame.Empty()) {
+    MutexLock lock(&mutex_);
     upgrade_service_id_to_active_endpoint_ids_[upgrade_service_id].insert(
         endpoint_id);
   }
@@ -45,10 +48,17 @@ ByteArray BaseBwuHandler::InitializeUpgradedMediumForEndpoint(
 }
 
 void BaseBwuHandler::RevertInitiatorState() {
-  for (const auto& pair : upgrade_service_id_to_active_endpoint_ids_) {
-    HandleRevertInitiatorStateForService(pair.first);
+  std::vector<std::string> upgrade_service_ids;
+  {
+    MutexLock lock(&mutex_);
+    for (const auto& pair : upgrade_service_id_to_active_endpoint_ids_) {
+      upgrade_service_ids.push_back(pair.first);
+    }
+    upgrade_service_id_to_active_endpoint_ids_.clear();
+  }
+  for (const std::string& upgrade_service_id : upgrade_service_ids) {
+    HandleRevertInitiatorStateForService(upgrade_service_id);
   }
-  upgrade_service_id_to_active_endpoint_ids_.clear();
 }
 
 void BaseBwuHandler::RevertInitiatorState(const std::string& upgrade_service_id,
@@ -60,19 +70,23 @@ void BaseBwuHandler::RevertInitiatorState(const std::string& upgrade_service_id,
     return;
   }
 
-  auto it = upgrade_service_id_to_active_endpoint_ids_.find(upgrade_service_id);
-  if (it == upgrade_service_id_to_active_endpoint_ids_.end() ||
-      it->second.empty()) {
-    return;
-  }
+  {
+    MutexLock lock(&mutex_);
+    auto it =
+        upgrade_service_id_to_active_endpoint_ids_.find(upgrade_service_id);
+    if (it == upgrade_service_id_to_active_endpoint_ids_.end() ||
+        it->second.empty()) {
+      return;
+    }
 
-  // If the last endpoint for the service has been reverted, alert the specific
-  // medium handler (child class) to perform any clean-up .
-  it->second.erase(endpoint_id);
-  if (it->second.empty()) {
+    it->second.erase(endpoint_id);
+    if (!it->second.empty()) return;
     upgrade_service_id_to_active_endpoint_ids_.erase(it);
-    HandleRevertInitiatorStateForService(upgrade_service_id);
   }
+
+  // The last endpoint for the service has been reverted, alert the specific
+  // medium handler (child class) to perform any clean-up .
+  HandleRevertInitiatorStateForService(upgrade_service_id);
 }
 
 void BaseBwuHandler::RevertResponderState(const std::string& service_id) {
@@ -22,6 +22,7 @@
 #include "absl/strings/string_view.h"
 #include "connections/implementation/bwu_handler.h"
 #include "connections/implementation/endpoint_channel_manager.h"
+#include "internal/platform/mutex.h"
 
 namespace nearby {
 namespace connections {
@@ -36,10 +37,11 @@ class BaseBwuHandler : public BwuHandler {
   // BwuHandler implementation:
   ByteArray InitializeUpgradedMediumForEndpoint(
       ClientProxy* client, const std::string& service_id,
-      const std::string& endpoint_id) final;
-  void RevertInitiatorState() final;
+      const std::string& endpoint_id) final ABSL_LOCKS_EXCLUDED(mutex_);
+  void RevertInitiatorState() final ABSL_LOCKS_EXCLUDED(mutex_);
   void RevertInitiatorState(const std::string& upgrade_service_id,
-                            const std::string& endpoint_id) final;
+                            const std::string& endpoint_id) final
+      ABSL_LOCKS_EXCLUDED(mutex_);
   // If BWU Medium is Hotspot. The client needs to disconnect from Hotspot, then
   // it can restore the previous AP connection right away. The following method
   // is only for Hotspot Client
@@ -63,11 +65,14 @@ class BaseBwuHandler : public BwuHandler {
 
  private:
   IncomingConnectionCallback incoming_connection_callback_;
+  // Guards the bookkeeping below. A raced upgrade sets up the path off the
+  // BwuManager thread.
+  Mutex mutex_;
   // Map from the (wrapped) service ID to endpoint IDs that are initiating a
   // bandwidth upgrade. Not used for endpoints that respond to bandwidth upgrade
   // requests from another device.
   absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>
-      upgrade_service_id_to_active_endpoint_ids_;
+      upgrade_service_id_to_active_endpoint_ids_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace connections
@@ -18,8 +18,10 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "connections/implementation/offline_frames.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
@@ -62,10 +64,6 @@ ExceptionOr<std::int32_t> ReadInt(InputStream* reader) {
   return ExceptionOr<std::int32_t>(BytesToInt(std::move(read_bytes.result())));
 }
 
-Exception WriteInt(OutputStream* writer, std::int32_t value) {
-  return writer->Write(IntToBytes(value));
-}
-
 }  // namespace
 
 BaseEndpointChannel::BaseEndpointChannel(const std::string& service_id,
@@ -198,67 +196,118 @@ Exception BaseEndpointChannel::Write(const ByteArray& data,
     }
   }
 
-  ByteArray encrypted_data;
-  const ByteArray* data_to_write = &data;
+  PendingWrite write{&data, &packet_meta_data};
   {
-    // Holding both mutexes is necessary to prevent the keep alive and payload
-    // threads from writing encrypted messages out of order which causes a
-    // failure to decrypt on the reader side. However we need to release the
-    // crypto lock after encrypting to ensure read decryption is not blocked.
+    MutexLock lock(&pending_writes_mutex_);
+    pending_writes_.push_back(&write);
+    active_writes_++;
+  }
+  {
+    // Holding the writer mutex while encrypting is necessary to prevent the
+    // keep alive and payload threads from writing encrypted messages out of
+    // order which causes a failure to decrypt on the reader side.
     MutexLock lock(&writer_mutex_);
-    {
-      MutexLock crypto_lock(&crypto_mutex_);
-      if (IsEncryptionEnabledLocked()) {
+    if (!write.done) {
+      // Nobody picked our frame up while we waited, so we write it along with
+      // everything queued behind it.
+      std::vector<PendingWrite*> batch;
+      {
+        MutexLock pending_lock(&pending_writes_mutex_);
+        batch.swap(pending_writes_);
+      }
+      WriteBatchLocked(batch);
+    }
+  }
+  {
+    MutexLock lock(&pending_writes_mutex_);
+    active_writes_--;
+  }
+  if (write.result.Raised()) return write.result;
+
+  {
+    MutexLock lock(&last_write_mutex_);
+    last_write_timestamp_ = SystemClock::ElapsedRealtime();
+  }
+  return {Exception::kSuccess};
+}
+
+bool BaseEndpointChannel::IsWriting() const {
+  MutexLock lock(&pending_writes_mutex_);
+  return active_writes_ > 0;
+}
+
+void BaseEndpointChannel::WriteBatchLocked(
+    absl::Span<PendingWrite* const> batch) {
+  // Length prefixes and encrypted frames, kept alive until written.
+  std::vector<ByteArray> headers;
+  std::vector<ByteArray> encrypted_data;
+  std::vector<const ByteArray*> buffers;
+  std::vector<PendingWrite*> written;
+  headers.reserve(batch.size());
+  encrypted_data.reserve(batch.size());
+  buffers.reserve(2 * batch.size());
+  written.reserve(batch.size());
+  {
+    // We release the crypto lock after encrypting to ensure read decryption
+    // is not blocked.
+    MutexLock crypto_lock(&crypto_mutex_);
+    bool encrypt = IsEncryptionEnabledLocked();
+    for (PendingWrite* write : batch) {
+      write->done = true;
+      const ByteArray* data_to_write = write->data;
+      if (encrypt) {
         // If encryption is enabled, encode the message.
-        packet_meta_data.StartEncryption();
+        write->packet_meta_data->StartEncryption();
         std::unique_ptr<std::string> encrypted =
-            crypto_context_->EncodeMessageToPeer(std::string(data));
-        packet_meta_data.StopEncryption();
+            crypto_context_->EncodeMessageToPeer(write->data->AsString());
+        write->packet_meta_data->StopEncryption();
         if (!encrypted) {
           NEARBY_LOGS(WARNING) << __func__ << ": Failed to encrypt data.";
-          return {Exception::kIo};
+          write->result = {Exception::kIo};
+          continue;
         }
-        encrypted_data = ByteArray(std::move(*encrypted));
-        data_to_write = &encrypted_data;
+        encrypted_data.emplace_back(std::move(*encrypted));
+        data_to_write = &encrypted_data.back();
       }
-    }
 
-    size_t data_size = data_to_write->size();
-    if (data_size < 0 || data_size > kMaxAllowedReadBytes) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Write an invalid number of bytes: "
-                           << data_size;
-      return {Exception::kIo};
+      size_t data_size = data_to_write->size();
+      if (data_size > kMaxAllowedReadBytes) {
+        NEARBY_LOGS(WARNING) << __func__
+                             << ": Write an invalid number of bytes: "
+                             << data_size;
+        write->result = {Exception::kIo};
+        continue;
+      }
+      // Send each length prefix and frame in the same gathered write, so
+      // streams that support it don't pay a separate write per buffer.
+      headers.push_back(IntToBytes(static_cast<std::int32_t>(data_size)));
+      buffers.push_back(&headers.back());
+      buffers.push_back(data_to_write);
+      write->packet_meta_data->SetPacketSize(data_size +
+                                             sizeof(std::uint32_t));
+      written.push_back(write);
     }
+  }
+  if (written.empty()) return;
 
-    packet_meta_data.StartSocketIo();
-    Exception write_exception =
-        WriteInt(writer_, static_cast<std::int32_t>(data_size));
-    if (write_exception.Raised()) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Failed to write header: "
-                           << write_exception.value;
-      return write_exception;
-    }
-    write_exception = writer_->Write(*data_to_write);
-    if (write_exception.Raised()) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Failed to write data: "
-                           << write_exception.value;
-      return write_exception;
-    }
-    Exception flush_exception = writer_->Flush();
-    if (flush_exception.Raised()) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Failed to flush writer: "
-                           << flush_exception.value;
-      return flush_exception;
+  for (PendingWrite* write : written) {
+    write->packet_meta_data->StartSocketIo();
+  }
+  Exception exception = writer_->WriteGathered(buffers);
+  if (exception.Raised()) {
+    NEARBY_LOGS(WARNING) << __func__
+                         << ": Failed to write data: " << exception.value;
+  } else {
+    exception = writer_->Flush();
+    if (exception.Raised()) {
+      NEARBY_LOGS(WARNING) << __func__
+                           << ": Failed to flush writer: " << exception.value;
     }
-    packet_meta_data.StopSocketIo();
-    packet_meta_data.SetPacketSize(data_size + sizeof(std::uint32_t));
   }
-
-  {
-    MutexLock lock(&last_write_mutex_);
-    last_write_timestamp_ = SystemClock::ElapsedRealtime();
+  for (PendingWrite* write : written) {
+    write->packet_meta_data->StopSocketIo();
+    write->result = exception;
   }
-  return {Exception::kSuccess};
 }
 
 void BaseEndpointChannel::Close() {
@@ -364,7 +413,7 @@ ExceptionOr<ByteArray> BaseEndpointChannel::TryDecrypt(const ByteArray& data) {
     return Exception::kFailed;
   }
   std::unique_ptr<std::string> decrypted_data =
-      crypto_context_->DecodeMessageFromPeer(data.string_data());
+      crypto_context_->DecodeMessageFromPeer(data.AsString());
   if (decrypted_data) {
     return ExceptionOr<ByteArray>(ByteArray(std::move(*decrypted_data)));
   }
@@ -18,8 +18,10 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/types/span.h"
 #include "connections/implementation/analytics/analytics_recorder.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
 #include "connections/implementation/endpoint_channel.h"
@@ -54,8 +56,13 @@ class BaseEndpointChannel : public EndpointChannel {
       ABSL_LOCKS_EXCLUDED(reader_mutex_, crypto_mutex_,
                           last_read_mutex_) override;
   Exception Write(const ByteArray& data) override;
+  // Concurrent writes are coalesced: whichever writer gets to the stream
+  // first encrypts and sends every frame queued up behind it, in order, in a
+  // single gathered write and flush.
   Exception Write(const ByteArray& data, PacketMetaData& packet_meta_data)
-      ABSL_LOCKS_EXCLUDED(writer_mutex_, crypto_mutex_) override;
+      ABSL_LOCKS_EXCLUDED(writer_mutex_, crypto_mutex_,
+                          pending_writes_mutex_) override;
+  bool IsWriting() const ABSL_LOCKS_EXCLUDED(pending_writes_mutex_) override;
   void Close() ABSL_LOCKS_EXCLUDED(is_paused_mutex_) override;
   void Close(location::nearby::proto::connections::DisconnectionReason reason)
       override;
@@ -88,6 +95,15 @@ class BaseEndpointChannel : public EndpointChannel {
   std::unique_ptr<std::string> EncodeMessageForTests(absl::string_view data);
 
  private:
+  // A frame waiting to be written by Write().
+  struct PendingWrite {
+    const ByteArray* data;
+    PacketMetaData* packet_meta_data;
+    // Set by the writer that sent the frame, under writer_mutex_.
+    bool done = false;
+    Exception result = {Exception::kSuccess};
+  };
+
   // Used to sanity check that our frame sizes are reasonable.
   static constexpr std::int32_t kMaxAllowedReadBytes = 1048576;  // 1MB
 
@@ -99,6 +115,10 @@ class BaseEndpointChannel : public EndpointChannel {
   void UnblockPausedWriter() ABSL_EXCLUSIVE_LOCKS_REQUIRED(is_paused_mutex_);
   void BlockUntilUnpaused() ABSL_EXCLUSIVE_LOCKS_REQUIRED(is_paused_mutex_);
   void CloseIo() ABSL_NO_THREAD_SAFETY_ANALYSIS;
+  // Encrypts and writes `batch` in order, recording each frame's result.
+  void WriteBatchLocked(absl::Span<PendingWrite* const> batch)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(writer_mutex_)
+          ABSL_LOCKS_EXCLUDED(crypto_mutex_);
 
   // We need a separate mutex to protect read timestamp, because if a read
   // blocks on IO, we don't want timestamp read access to block too.
@@ -122,6 +142,12 @@ class BaseEndpointChannel : public EndpointChannel {
 
   Mutex writer_mutex_;
   OutputStream* writer_ ABSL_PT_GUARDED_BY(writer_mutex_);
+  // Frames queued by Write() callers waiting on writer_mutex_.
+  mutable Mutex pending_writes_mutex_;
+  std::vector<PendingWrite*> pending_writes_
+      ABSL_GUARDED_BY(pending_writes_mutex_);
+  // Write() calls that haven't returned yet.
+  int active_writes_ ABSL_GUARDED_BY(pending_writes_mutex_) = 0;
 
   // An encryptor/decryptor. May be null.
   mutable Mutex crypto_mutex_;
@@ -24,6 +24,8 @@
 #include "gmock/gmock.h"
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
@@ -214,6 +216,43 @@ TEST(BaseEndpointChannelTest, TryDecrypt) {
   EXPECT_EQ(decrypted_message.result().AsStringView(), kMessage);
 }
 
+TEST(BaseEndpointChannelTest, ConcurrentEncryptedWritesStayInOrder) {
+  constexpr int kWriters = 4;
+  constexpr int kMessagesPerWriter = 50;
+  auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
+  auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
+  TestEndpointChannel channel_a(pipe_b.first.get(), pipe_a.second.get());
+  TestEndpointChannel channel_b(pipe_a.first.get(), pipe_b.second.get());
+  auto [context_a, context_b] = DoDhKeyExchange(&channel_a, &channel_b);
+  ASSERT_NE(context_a, nullptr);
+  ASSERT_NE(context_b, nullptr);
+  channel_a.EnableEncryption(context_a);
+  channel_b.EnableEncryption(context_b);
+
+  {
+    MultiThreadExecutor executor(kWriters);
+    for (int writer = 0; writer < kWriters; ++writer) {
+      executor.Execute([&channel_a, writer]() {
+        for (int i = 0; i < kMessagesPerWriter; ++i) {
+          EXPECT_TRUE(
+              channel_a.Write(ByteArray(absl::StrCat(writer, ":", i))).Ok());
+        }
+      });
+    }
+  }
+
+  // Every frame decrypts, and each writer's frames arrive in order.
+  int next_message[kWriters] = {};
+  for (int i = 0; i < kWriters * kMessagesPerWriter; ++i) {
+    ExceptionOr<ByteArray> rx_message = channel_b.Read();
+    ASSERT_TRUE(rx_message.ok());
+    std::pair<std::string, std::string> parts =
+        absl::StrSplit(rx_message.result().AsStringView(), ':');
+    int writer = std::stoi(parts.first);
+    EXPECT_EQ(std::stoi(parts.second), next_message[writer]++);
+  }
+}
+
 TEST(BaseEndpointChannelTest, TryDecryptFailsWhenDecryptionFails) {
   auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
   auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
@@ -66,6 +66,9 @@
 #include "internal/platform/bluetooth_utils.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/cancelable_alarm.h"
+#include "internal/platform/cancellation_flag.h"
+#include "internal/platform/cancellation_flag_listener.h"
+#include "internal/platform/condition_variable.h"
 #include "internal/platform/connection_info.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
@@ -137,6 +140,7 @@ void BasePcpHandler::Shutdown() {
                     << ") is bringing down executors.";
   serial_executor_.Shutdown();
   alarm_executor_.Shutdown();
+  connect_executor_.Shutdown();
   NEARBY_LOGS(INFO) << "BasePcpHandler(" << strategy_.GetName()
                     << ") has shut down.";
 }
@@ -832,20 +836,11 @@ Status BasePcpHandler::RequestConnection(
         if (AppendWebRTCEndpoint(endpoint_id, client->GetDiscoveryOptions()))
           NEARBY_LOGS(INFO) << "Appended Web RTC endpoint.";
 
-        auto discovered_endpoints = GetDiscoveredEndpoints(endpoint_id);
-        std::unique_ptr<EndpointChannel> channel;
-        ConnectImplResult connect_impl_result;
-
-        for (auto connect_endpoint : discovered_endpoints) {
-          if (!MediumSupportedByClientOptions(connect_endpoint->medium,
-                                              connection_options))
-            continue;
-          connect_impl_result = ConnectImpl(client, connect_endpoint);
-          if (connect_impl_result.status.Ok()) {
-            channel = std::move(connect_impl_result.endpoint_channel);
-            break;
-          }
-        }
+        ConnectImplResult connect_impl_result =
+            ConnectToDiscoveredEndpoints(client, endpoint_id,
+                                         connection_options);
+        std::unique_ptr<EndpointChannel> channel =
+            std::move(connect_impl_result.endpoint_channel);
 
         Medium channel_medium =
             channel ? channel->GetMedium() : Medium::UNKNOWN_MEDIUM;
@@ -970,25 +965,11 @@ Status BasePcpHandler::RequestConnectionV3(
         if (AppendWebRTCEndpoint(endpoint_id, client->GetDiscoveryOptions()))
           NEARBY_LOGS(INFO) << "Appended Web RTC endpoint.";
 
-        auto discovered_endpoints = GetDiscoveredEndpoints(endpoint_id);
-        std::unique_ptr<EndpointChannel> channel;
-        ConnectImplResult connect_impl_result;
-
-        for (auto connect_endpoint : discovered_endpoints) {
-          if (!MediumSupportedByClientOptions(connect_endpoint->medium,
-                                              connection_options))
-            continue;
-          NEARBY_LOGS(INFO)
-              << "Try to connect with endpoint(id=" << endpoint_id
-              << ") by Medium: "
-              << location::nearby::proto::connections::Medium_Name(
-                     connect_endpoint->medium);
-          connect_impl_result = ConnectImpl(client, connect_endpoint);
-          if (connect_impl_result.status.Ok()) {
-            channel = std::move(connect_impl_result.endpoint_channel);
-            break;
-          }
-        }
+        ConnectImplResult connect_impl_result =
+            ConnectToDiscoveredEndpoints(client, endpoint_id,
+                                         connection_options);
+        std::unique_ptr<EndpointChannel> channel =
+            std::move(connect_impl_result.endpoint_channel);
 
         Medium channel_medium =
             channel ? channel->GetMedium() : Medium::UNKNOWN_MEDIUM;
@@ -1077,6 +1058,140 @@ Status BasePcpHandler::RequestConnectionV3(
   return status;
 }
 
+BasePcpHandler::ConnectImplResult BasePcpHandler::ConnectToDiscoveredEndpoints(
+    ClientProxy* client, const std::string& endpoint_id,
+    const ConnectionOptions& connection_options) {
+  std::vector<std::shared_ptr<DiscoveredEndpoint>> endpoints;
+  for (auto& endpoint : GetSharedDiscoveredEndpoints(endpoint_id)) {
+    if (MediumSupportedByClientOptions(endpoint->medium, connection_options)) {
+      endpoints.push_back(std::move(endpoint));
+    }
+  }
+
+  const FeatureFlags::Flags& flags = FeatureFlags::GetInstance().GetFlags();
+  if (flags.enable_staggered_connect && endpoints.size() > 1) {
+    return StaggeredConnectImpl(client, endpoints,
+                                flags.staggered_connect_delay,
+                                client->GetCancellationFlag(endpoint_id));
+  }
+
+  ConnectImplResult connect_impl_result;
+  for (const auto& connect_endpoint : endpoints) {
+    NEARBY_LOGS(INFO) << "Try to connect with endpoint(id=" << endpoint_id
+                      << ") by Medium: "
+                      << location::nearby::proto::connections::Medium_Name(
+                             connect_endpoint->medium);
+    connect_impl_result =
+        ConnectImpl(client, connect_endpoint.get(),
+                    client->GetCancellationFlag(endpoint_id));
+    if (connect_impl_result.status.Ok()) break;
+  }
+  return connect_impl_result;
+}
+
+BasePcpHandler::ConnectImplResult BasePcpHandler::StaggeredConnectImpl(
+    ClientProxy* client,
+    const std::vector<std::shared_ptr<DiscoveredEndpoint>>& endpoints,
+    absl::Duration delay, CancellationFlag* cancellation_flag) {
+  struct Attempts {
+    Mutex mutex;
+    ConditionVariable cond{&mutex};
+    // One per started attempt, in start order.
+    std::vector<std::shared_ptr<CancellationFlag>> cancellation_flags
+        ABSL_GUARDED_BY(mutex);
+    size_t failed ABSL_GUARDED_BY(mutex) = 0;
+    // Set once the PCP handler thread stops waiting; later channels are
+    // closed by the attempt that created them.
+    bool abandoned ABSL_GUARDED_BY(mutex) = false;
+    ConnectImplResult winner ABSL_GUARDED_BY(mutex);
+    std::shared_ptr<CancellationFlag> winner_cancellation_flag
+        ABSL_GUARDED_BY(mutex);
+    ConnectImplResult last_failure ABSL_GUARDED_BY(mutex);
+  };
+  auto attempts = std::make_shared<Attempts>();
+  std::vector<std::shared_ptr<CancellationFlag>> losers;
+  ConnectImplResult connect_impl_result;
+  {
+    // Cancelling the connection cancels every attempt started so far; later
+    // attempts start cancelled.
+    CancellationFlagListener cancellation_listener(
+        cancellation_flag, [attempts]() {
+          std::vector<std::shared_ptr<CancellationFlag>> flags;
+          {
+            MutexLock lock(&attempts->mutex);
+            flags = attempts->cancellation_flags;
+          }
+          for (const auto& flag : flags) flag->Cancel();
+        });
+    MutexLock lock(&attempts->mutex);
+    size_t started = 0;
+    absl::Time next_start = SystemClock::ElapsedRealtime();
+    while (attempts->winner.endpoint_channel == nullptr) {
+      bool all_failed = attempts->failed == started;
+      if (started == endpoints.size()) {
+        if (all_failed) break;
+        attempts->cond.Wait();
+        continue;
+      }
+      absl::Time now = SystemClock::ElapsedRealtime();
+      if (!all_failed && now < next_start) {
+        attempts->cond.Wait(next_start - now);
+        continue;
+      }
+
+      std::shared_ptr<DiscoveredEndpoint> endpoint = endpoints[started++];
+      auto attempt_cancellation_flag =
+          std::make_shared<CancellationFlag>(cancellation_flag->Cancelled());
+      attempts->cancellation_flags.push_back(attempt_cancellation_flag);
+      next_start = now + delay;
+      NEARBY_LOGS(INFO) << "Try to connect with endpoint(id="
+                        << endpoint->endpoint_id << ") by Medium: "
+                        << location::nearby::proto::connections::Medium_Name(
+                               endpoint->medium)
+                        << " (attempt " << started << " of "
+                        << endpoints.size() << ")";
+      connect_executor_.Execute(
+          "staggered-connect",
+          [this, client, endpoint, attempts, attempt_cancellation_flag]() {
+            ConnectImplResult result = ConnectImpl(
+                client, endpoint.get(), attempt_cancellation_flag.get());
+            MutexLock lock(&attempts->mutex);
+            if (!result.status.Ok()) {
+              attempts->failed++;
+              attempts->last_failure = std::move(result);
+            } else if (attempts->abandoned ||
+                       attempts->winner.endpoint_channel != nullptr) {
+              NEARBY_LOGS(INFO)
+                  << "Closing redundant "
+                  << location::nearby::proto::connections::Medium_Name(
+                         endpoint->medium)
+                  << " channel to endpoint(id=" << endpoint->endpoint_id
+                  << ")";
+              if (result.endpoint_channel) result.endpoint_channel->Close();
+            } else {
+              attempts->winner = std::move(result);
+              attempts->winner_cancellation_flag = attempt_cancellation_flag;
+            }
+            attempts->cond.Notify();
+          });
+    }
+    attempts->abandoned = true;
+    for (const auto& flag : attempts->cancellation_flags) {
+      if (flag != attempts->winner_cancellation_flag) losers.push_back(flag);
+    }
+    if (attempts->winner.endpoint_channel != nullptr) {
+      connect_impl_result = std::move(attempts->winner);
+    } else {
+      connect_impl_result = std::move(attempts->last_failure);
+    }
+  }
+
+  // Give up on the attempts that are still connecting. Cancel() runs the
+  // medium listeners, so it is called without holding attempts->mutex.
+  for (const auto& flag : losers) flag->Cancel();
+  return connect_impl_result;
+}
+
 bool BasePcpHandler::MediumSupportedByClientOptions(
     const location::nearby::proto::connections::Medium& medium,
     const ConnectionOptions& connection_options) const {
@@ -1178,13 +1293,23 @@ BasePcpHandler::DiscoveredEndpoint* BasePcpHandler::GetDiscoveredEndpoint(
 std::vector<BasePcpHandler::DiscoveredEndpoint*>
 BasePcpHandler::GetDiscoveredEndpoints(const std::string& endpoint_id) {
   std::vector<BasePcpHandler::DiscoveredEndpoint*> result;
+  for (const auto& endpoint : GetSharedDiscoveredEndpoints(endpoint_id)) {
+    result.push_back(endpoint.get());
+  }
+  return result;
+}
+
+std::vector<std::shared_ptr<BasePcpHandler::DiscoveredEndpoint>>
+BasePcpHandler::GetSharedDiscoveredEndpoints(const std::string& endpoint_id) {
+  std::vector<std::shared_ptr<BasePcpHandler::DiscoveredEndpoint>> result;
   MutexLock lock(&discovered_endpoint_mutex_);
   auto it = discovered_endpoints_.equal_range(endpoint_id);
   for (auto item = it.first; item != it.second; item++) {
-    result.push_back(item->second.get());
+    result.push_back(item->second);
   }
   std::sort(result.begin(), result.end(),
-            [this](DiscoveredEndpoint* a, DiscoveredEndpoint* b) -> bool {
+            [this](const std::shared_ptr<DiscoveredEndpoint>& a,
+                   const std::shared_ptr<DiscoveredEndpoint>& b) -> bool {
               return IsPreferred(*a, *b);
             });
 
@@ -1380,7 +1505,8 @@ Status BasePcpHandler::AcceptConnection(ClientProxy* client,
         Exception write_exception =
             channel->Write(parser::ForConnectionResponse(
                 Status::kSuccess, client->GetLocalOsInfo(),
-                client->GetLocalMultiplexSocketBitmask()));
+                client->GetLocalMultiplexSocketBitmask(),
+                client->GetLocalFeatureBitmask()));
         if (!write_exception.Ok()) {
           NEARBY_LOGS(INFO)
               << "AcceptConnection: failed to send response: endpoint_id="
@@ -1443,7 +1569,8 @@ Status BasePcpHandler::RejectConnection(ClientProxy* client,
         Exception write_exception =
             channel->Write(parser::ForConnectionResponse(
                 Status::kConnectionRejected, client->GetLocalOsInfo(),
-                client->GetLocalMultiplexSocketBitmask()));
+                client->GetLocalMultiplexSocketBitmask(),
+                client->GetLocalFeatureBitmask()));
         if (!write_exception.Ok()) {
           NEARBY_LOGS(INFO)
               << "RejectConnection: failed to send response: endpoint_id="
@@ -1519,6 +1646,11 @@ void BasePcpHandler::OnIncomingFrame(
               endpoint_id, connection_response.multiplex_socket_bitmask());
         }
 
+        if (connection_response.has_feature_bitmask()) {
+          client->SetRemoteFeatureBitmask(
+              endpoint_id, connection_response.feature_bitmask());
+        }
+
         if (connection_response.has_safe_to_disconnect_version()) {
           NEARBY_LOGS(INFO)
               << "[safe-to-disconnect]: endpoint_id=" << endpoint_id
@@ -58,10 +58,12 @@
 #include "internal/platform/bluetooth_adapter.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/cancelable_alarm.h"
+#include "internal/platform/cancellation_flag.h"
 #include "internal/platform/connection_info.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/future.h"
+#include "internal/platform/multi_thread_executor.h"
 #include "internal/platform/mutex.h"
 #include "internal/platform/nsd_service_info.h"
 #include "internal/platform/runnable.h"
@@ -335,9 +337,14 @@ class BasePcpHandler : public PcpHandler,
                                     const OutOfBandConnectionMetadata& metadata)
       RUN_ON_PCP_HANDLER_THREAD() = 0;
 
-  virtual ConnectImplResult ConnectImpl(ClientProxy* client,
-                                        DiscoveredEndpoint* endpoint)
-      RUN_ON_PCP_HANDLER_THREAD() = 0;
+  // Runs on the PCP handler thread, or on connect_executor_ when connects are
+  // staggered, possibly while other attempts and the PCP handler thread run.
+  // Implementations may only use the mediums, |client|, |endpoint| and
+  // |cancellation_flag|, which the caller keeps alive until this returns. The
+  // medium connect must give up once |cancellation_flag| is cancelled.
+  virtual ConnectImplResult ConnectImpl(
+      ClientProxy* client, DiscoveredEndpoint* endpoint,
+      CancellationFlag* cancellation_flag) = 0;
 
   virtual StartOperationResult UpdateAdvertisingOptionsImpl(
       ClientProxy* client, absl::string_view service_id,
@@ -377,6 +384,12 @@ class BasePcpHandler : public PcpHandler,
       const std::string& endpoint_id)
       ABSL_LOCKS_EXCLUDED(discovered_endpoint_mutex_);
 
+  // Same as above, but shares ownership of the endpoints so they stay valid
+  // if the endpoint is lost while a connection attempt is still running.
+  std::vector<std::shared_ptr<BasePcpHandler::DiscoveredEndpoint>>
+  GetSharedDiscoveredEndpoints(const std::string& endpoint_id)
+      ABSL_LOCKS_EXCLUDED(discovered_endpoint_mutex_);
+
   // Returns a vector of discovered endpoints that share a given Medium.
   std::vector<BasePcpHandler::DiscoveredEndpoint*> GetDiscoveredEndpoints(
       const location::nearby::proto::connections::Medium medium)
@@ -607,6 +620,25 @@ class BasePcpHandler : public PcpHandler,
   bool MediumSupportedByClientOptions(
       const location::nearby::proto::connections::Medium& medium,
       const ConnectionOptions& connection_options) const;
+
+  // Connects to the discovered endpoints of |endpoint_id| in order of
+  // preference and returns the first channel to connect, or the last failure.
+  ConnectImplResult ConnectToDiscoveredEndpoints(
+      ClientProxy* client, const std::string& endpoint_id,
+      const ConnectionOptions& connection_options) RUN_ON_PCP_HANDLER_THREAD();
+
+  // Starts ConnectImpl() on the most preferred endpoint, then on the next one
+  // whenever |delay| passes or every attempt started so far has failed. The
+  // first channel to connect wins; channels that connect later are closed.
+  // Each attempt has its own CancellationFlag, which is cancelled along with
+  // |cancellation_flag| and, for every attempt but the winner, as soon as a
+  // channel connects. Attempts run on connect_executor_; those still running
+  // when this returns finish there.
+  ConnectImplResult StaggeredConnectImpl(
+      ClientProxy* client,
+      const std::vector<std::shared_ptr<DiscoveredEndpoint>>& endpoints,
+      absl::Duration delay, CancellationFlag* cancellation_flag)
+      RUN_ON_PCP_HANDLER_THREAD();
   std::vector<location::nearby::proto::connections::Medium>
   GetSupportedConnectionMediumsByPriority(
       const ConnectionOptions& local_connection_option);
@@ -641,8 +673,12 @@ class BasePcpHandler : public PcpHandler,
   void OptionsAllowed(const BooleanMediumSelector& allowed,
                       std::ostringstream& result) const;
 
+  // The number of staggered connection attempts that may run at once.
+  static constexpr int kMaxConcurrentConnectAttempts = 4;
+
   ScheduledExecutor alarm_executor_;
   SingleThreadExecutor serial_executor_;
+  MultiThreadExecutor connect_executor_{kMaxConcurrentConnectAttempts};
   Mutex discovered_endpoint_mutex_;
 
   // A map of endpoint id -> PendingConnectionInfo. Entries in this map imply
@@ -39,9 +39,11 @@
 #include "connections/implementation/wifi_lan_bwu_handler.h"
 #include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
+#include "internal/platform/condition_variable.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/feature_flags.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/mutex.h"
 #include "proto/connections_enums.pb.h"
 
 namespace nearby {
@@ -54,6 +56,18 @@ using ::location::nearby::proto::connections::DisconnectionReason;
 
 // Required for C++ 14 support in Chrome
 constexpr absl::Duration BwuManager::kReadClientIntroductionFrameTimeout;
+constexpr int BwuManager::kMaxRacedUpgradeMediums;
+
+namespace {
+
+// Whether setting up an upgrade path over |medium| reconfigures the Wi-Fi
+// radio.
+bool SharesWifiRadio(Medium medium) {
+  return medium == Medium::WIFI_LAN || medium == Medium::WIFI_HOTSPOT ||
+         medium == Medium::WIFI_DIRECT || medium == Medium::WIFI_AWARE;
+}
+
+}  // namespace
 
 BwuManager::BwuManager(
     Mediums& mediums, EndpointManager& endpoint_manager,
@@ -187,6 +201,9 @@ void BwuManager::InvokeOnIncomingConnectionForTesting(
 void BwuManager::ShutdownExecutors() {
   alarm_executor_.Shutdown();
   serial_executor_.Shutdown();
+  // Shut down last: a bwu-init task on |serial_executor_| may be waiting for
+  // a race to finish.
+  race_executor_.Shutdown();
 }
 
 void BwuManager::InitiateBwuForEndpoint(ClientProxy* client,
@@ -201,7 +218,9 @@ void BwuManager::InitiateBwuForEndpoint(ClientProxy* client,
           : new_medium;
 
   RunOnBwuManagerThread("bwu-init", [this, client, endpoint_id,
-                                     proposed_medium]() {
+                                     first_upgrade =
+                                         new_medium == Medium::UNKNOWN_MEDIUM,
+                                     proposed_medium]() mutable {
     NEARBY_LOGS(INFO) << "InitiateBwuForEndpoint for endpoint " << endpoint_id
                       << " with medium "
                       << location::nearby::proto::connections::Medium_Name(
@@ -217,6 +236,9 @@ void BwuManager::InitiateBwuForEndpoint(ClientProxy* client,
       return;
     }
 
+    // Only race mediums when nothing has been tried for the endpoint yet.
+    first_upgrade &= GetBwuMediumForEndpoint(endpoint_id) ==
+                     Medium::UNKNOWN_MEDIUM;
     SetBwuMediumForEndpoint(endpoint_id, proposed_medium);
     BwuHandler* handler = GetHandlerForMedium(proposed_medium);
     if (!handler) {
@@ -274,8 +296,25 @@ void BwuManager::InitiateBwuForEndpoint(ClientProxy* client,
     }
 
     std::string service_id = channel->GetServiceId();
-    ByteArray bytes = handler->InitializeUpgradedMediumForEndpoint(
-        client, service_id, endpoint_id);
+    ByteArray bytes;
+    std::vector<Medium> race_mediums =
+        first_upgrade
+            ? ChooseUpgradeMediumsToRace(client, endpoint_id,
+                                         channel->GetMedium())
+            : std::vector<Medium>();
+    if (race_mediums.size() > 1) {
+      Medium winner = RaceUpgradeMediums(client, service_id, endpoint_id,
+                                         race_mediums, bytes);
+      // On failure, continue with the mediums after the last raced one.
+      proposed_medium =
+          winner != Medium::UNKNOWN_MEDIUM ? winner : race_mediums.back();
+      SetBwuMediumForEndpoint(endpoint_id, proposed_medium);
+      client->GetAnalyticsRecorder().OnBandwidthUpgradeRaceFinished(
+          endpoint_id, winner, static_cast<int>(race_mediums.size()));
+    } else {
+      bytes = handler->InitializeUpgradedMediumForEndpoint(client, service_id,
+                                                           endpoint_id);
+    }
 
     // Because we grab the endpointChannel first thing, it is possible the
     // endpointChannel is stale by the time we attempt to write over it.
@@ -1168,13 +1207,27 @@ void BwuManager::ProcessSafeToClosePriorChannelEvent(
   // the full SAFE_TO_CLOSE_PRIOR_CHANNEL message before we actually close the
   // channel. See b/172380349 for more context.
   previous_endpoint_channel->Read();
-  previous_endpoint_channel->Close(DisconnectionReason::UPGRADED);
+  if (FeatureFlags::GetInstance()
+          .GetFlags()
+          .enable_auto_reconnect_warm_standby) {
+    // The drained channel is still connected and idle; keep it so that auto
+    // reconnect can fail over to it if the upgraded channel drops.
+    NEARBY_LOGS(VERBOSE)
+        << "BwuManager keeps prior " << previous_endpoint_channel->GetType()
+        << " EndpointChannel as standby to conclude upgrade protocol for "
+           "endpoint "
+        << endpoint_id;
+    channel_manager_->SetStandbyChannelForEndpoint(
+        endpoint_id, std::move(previous_endpoint_channel));
+  } else {
+    previous_endpoint_channel->Close(DisconnectionReason::UPGRADED);
 
-  NEARBY_LOGS(VERBOSE)
-      << "BwuManager cleanly shut down prior "
-      << previous_endpoint_channel->GetType()
-      << " EndpointChannel to conclude upgrade protocol for endpoint "
-      << endpoint_id;
+    NEARBY_LOGS(VERBOSE)
+        << "BwuManager cleanly shut down prior "
+        << previous_endpoint_channel->GetType()
+        << " EndpointChannel to conclude upgrade protocol for endpoint "
+        << endpoint_id;
+  }
 
   // Now the upgrade protocol has completed, record analytics for this new
   // upgraded bandwidth connection...
@@ -1397,6 +1450,160 @@ Medium BwuManager::ChooseBestUpgradeMedium(
   return Medium::UNKNOWN_MEDIUM;
 }
 
+std::vector<Medium> BwuManager::ChooseUpgradeMediumsToRace(
+    ClientProxy* client, const std::string& endpoint_id,
+    Medium channel_medium) const {
+  int race_medium_count = std::min(
+      FeatureFlags::GetInstance().GetFlags().bwu_race_medium_count,
+      kMaxRacedUpgradeMediums);
+  // Without per-endpoint mediums, losing handlers could not be reverted
+  // without disrupting other endpoints.
+  if (race_medium_count <= 1 ||
+      !FeatureFlags::GetInstance().GetFlags().support_multiple_bwu_mediums) {
+    return {};
+  }
+
+  std::vector<Medium> mediums;
+  for (Medium medium : StripOutUnavailableMediums(
+           client->GetUpgradeMediums(endpoint_id).GetMediums(true))) {
+    if (static_cast<int>(mediums.size()) == race_medium_count) break;
+    if (medium == channel_medium) continue;
+    // See InitiateBwuForEndpoint(); STA connecting to WIFI_HOTSPOT would
+    // destroy WIFI_LAN.
+    if (medium == Medium::WIFI_HOTSPOT &&
+        channel_manager_->isWifiLanConnected()) {
+      continue;
+    }
+    mediums.push_back(medium);
+  }
+  return mediums;
+}
+
+Medium BwuManager::RaceUpgradeMediums(ClientProxy* client,
+                                      const std::string& service_id,
+                                      const std::string& endpoint_id,
+                                      const std::vector<Medium>& mediums,
+                                      ByteArray& upgrade_path_available_frame) {
+  struct Race {
+    Mutex mutex;
+    ConditionVariable finished{&mutex};
+    Medium winner ABSL_GUARDED_BY(mutex) = Medium::UNKNOWN_MEDIUM;
+    ByteArray frame ABSL_GUARDED_BY(mutex);
+    int pending ABSL_GUARDED_BY(mutex) = 0;
+  };
+  using Lane = std::vector<std::pair<Medium, BwuHandler*>>;
+
+  // Handlers that share the Wi-Fi radio would reconfigure it under each other,
+  // so they set up their paths one after another on a single lane. Every other
+  // medium gets a lane of its own.
+  std::vector<Lane> lanes;
+  int wifi_lane = -1;
+  for (Medium medium : mediums) {
+    std::pair<Medium, BwuHandler*> entry(medium, GetHandlerForMedium(medium));
+    if (!SharesWifiRadio(medium)) {
+      lanes.push_back({entry});
+      continue;
+    }
+    if (wifi_lane < 0) {
+      wifi_lane = static_cast<int>(lanes.size());
+      lanes.emplace_back();
+    }
+    lanes[wifi_lane].push_back(entry);
+  }
+
+  auto race = std::make_shared<Race>();
+  {
+    MutexLock lock(&race->mutex);
+    race->pending = static_cast<int>(lanes.size());
+  }
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+
+  for (Lane& lane : lanes) {
+    Runnable runnable = [this, race, lane = std::move(lane), client, service_id,
+                         endpoint_id]() {
+      for (const auto& [medium, handler] : lane) {
+        bool decided;
+        {
+          MutexLock lock(&race->mutex);
+          decided = race->winner != Medium::UNKNOWN_MEDIUM;
+        }
+        // Once the race is decided, the rest of the lane is not set up.
+        ByteArray frame;
+        if (!decided) {
+          frame = handler->InitializeUpgradedMediumForEndpoint(
+              client, service_id, endpoint_id);
+        }
+        bool set_up = !frame.Empty();
+        {
+          MutexLock lock(&race->mutex);
+          if (set_up && race->winner == Medium::UNKNOWN_MEDIUM) {
+            race->winner = medium;
+            race->frame = std::move(frame);
+            race->finished.Notify();
+            continue;
+          }
+        }
+        // A lost, failed or skipped path setup. Only a lost one left state
+        // behind.
+        if (set_up) {
+          NEARBY_LOGS(INFO)
+              << "BwuManager reverting medium "
+              << location::nearby::proto::connections::Medium_Name(medium)
+              << " which lost the upgrade race for endpoint " << endpoint_id;
+          handler->RevertInitiatorState(
+              WrapInitiatorUpgradeServiceId(service_id), endpoint_id);
+        }
+      }
+      MutexLock lock(&race->mutex);
+      --race->pending;
+      race->finished.Notify();
+    };
+    if (is_single_threaded_for_testing_) {
+      runnable();
+    } else {
+      race_executor_.Execute("bwu-race", std::move(runnable));
+    }
+  }
+
+  // Wait for every lane, not just the winner. The handlers are only safe to
+  // call from one thread at a time, so none may still be setting up or
+  // reverting a path once the BwuManager thread moves on.
+  MutexLock lock(&race->mutex);
+  while (race->pending > 0) {
+    race->finished.Wait();
+  }
+  if (race->winner != Medium::UNKNOWN_MEDIUM) {
+    upgrade_path_available_frame = race->frame;
+  }
+  NEARBY_LOGS(INFO) << "BwuManager raced " << mediums.size()
+                    << " upgrade mediums for endpoint " << endpoint_id
+                    << ", winner "
+                    << location::nearby::proto::connections::Medium_Name(
+                           race->winner)
+                    << " after "
+                    << absl::FormatDuration(SystemClock::ElapsedRealtime() -
+                                            start_time);
+  return race->winner;
+}
+
+Medium BwuManager::RaceUpgradeMediumsForTesting(
+    ClientProxy* client, const std::string& endpoint_id,
+    const std::vector<Medium>& mediums) {
+  Medium winner = Medium::UNKNOWN_MEDIUM;
+  CountDownLatch latch(1);
+  RunOnBwuManagerThread("bwu-race-for-testing", [&]() {
+    auto channel = channel_manager_->GetChannelForEndpoint(endpoint_id);
+    if (channel != nullptr) {
+      ByteArray bytes;
+      winner = RaceUpgradeMediums(client, channel->GetServiceId(), endpoint_id,
+                                  mediums, bytes);
+    }
+    latch.CountDown();
+  });
+  latch.Await();
+  return winner;
+}
+
 void BwuManager::RetryUpgradesAfterDelay(ClientProxy* client,
                                          const std::string& endpoint_id) {
   absl::Duration delay = CalculateNextRetryDelay(endpoint_id);
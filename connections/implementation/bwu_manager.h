@@ -28,6 +28,7 @@
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_manager.h"
 #include "connections/implementation/mediums/mediums.h"
+#include "internal/platform/multi_thread_executor.h"
 #include "internal/platform/scheduled_executor.h"
 
 namespace nearby {
@@ -110,6 +111,13 @@ class BwuManager : public EndpointManager::FrameProcessor {
       ClientProxy* client,
       std::unique_ptr<BwuHandler::IncomingSocketConnection> mutable_connection);
 
+  // Races the upgrade path setup of |mediums| for |endpoint_id| on the
+  // BwuManager thread, as the first upgrade attempt for an endpoint does, and
+  // returns the winning medium.
+  Medium RaceUpgradeMediumsForTesting(ClientProxy* client,
+                                      const std::string& endpoint_id,
+                                      const std::vector<Medium>& mediums);
+
   // Shutdown the executors during Nearby Connections shutdown process before
   // Core objects destruction so that no task will be run/posted after
   // ClientProxy objects are deleted.
@@ -121,6 +129,8 @@ class BwuManager : public EndpointManager::FrameProcessor {
  private:
   static constexpr absl::Duration kReadClientIntroductionFrameTimeout =
       absl::Seconds(5);
+  // Upper bound for FeatureFlags::Flags::bwu_race_medium_count.
+  static constexpr int kMaxRacedUpgradeMediums = 4;
 
   void InitBwuHandlers();
   void RunOnBwuManagerThread(const std::string& name, Runnable runnable);
@@ -128,6 +138,21 @@ class BwuManager : public EndpointManager::FrameProcessor {
       const std::vector<Medium>& mediums) const;
   Medium ChooseBestUpgradeMedium(const std::string& endpoint_id,
                                  const std::vector<Medium>& mediums) const;
+  // Returns the best available upgrade mediums for |endpoint_id|, at most
+  // bwu_race_medium_count of them, or an empty list if racing is disabled.
+  std::vector<Medium> ChooseUpgradeMediumsToRace(ClientProxy* client,
+                                                 const std::string& endpoint_id,
+                                                 Medium channel_medium) const;
+  // Sets up the upgrade path for all |mediums| concurrently and returns the
+  // medium whose path became available first, with its UPGRADE_PATH_AVAILABLE
+  // frame in |upgrade_path_available_frame|. The paths set up by the other
+  // mediums are reverted once they finish, before this returns. Mediums
+  // sharing the Wi-Fi radio are set up one after another. Returns
+  // UNKNOWN_MEDIUM if no path could be set up.
+  Medium RaceUpgradeMediums(ClientProxy* client, const std::string& service_id,
+                            const std::string& endpoint_id,
+                            const std::vector<Medium>& mediums,
+                            ByteArray& upgrade_path_available_frame);
 
   // BaseBwuHandler
   using ClientIntroduction = BwuNegotiationFrame::ClientIntroduction;
@@ -216,6 +241,8 @@ class BwuManager : public EndpointManager::FrameProcessor {
   EndpointChannelManager* channel_manager_;
   ScheduledExecutor alarm_executor_;
   SingleThreadExecutor serial_executor_;
+  // Runs the path setup of raced upgrade mediums in RaceUpgradeMediums().
+  MultiThreadExecutor race_executor_{kMaxRacedUpgradeMediums};
   // Stores each upgraded endpoint's previous EndpointChannel (that was
   // displaced in favor of a new EndpointChannel) temporarily, until it can
   // safely be shut down for good in processLastWriteToPriorChannelEvent().
@@ -19,7 +19,9 @@
 #include <utility>
 
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "connections/connection_options.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
@@ -33,8 +35,10 @@
 #include "connections/implementation/service_id_constants.h"
 #include "connections/listeners.h"
 #include "internal/flags/nearby_flags.h"
+#include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/feature_flags.h"
+#include "internal/platform/single_thread_executor.h"
 #include "internal/proto/analytics/connections_log.pb.h"
 #include "proto/connections_enums.pb.h"
 
@@ -56,6 +60,7 @@ constexpr absl::string_view kEndpointId2 = "Endpoint2";
 constexpr absl::string_view kEndpointId3 = "Endpoint3";
 constexpr absl::string_view kEndpointId4 = "Endpoint4";
 constexpr absl::string_view kEndpointId5 = "Endpoint5";
+constexpr absl::Duration kDefaultTimeout = absl::Seconds(1);
 
 class BwuManagerTest : public ::testing::Test {
  protected:
@@ -925,6 +930,106 @@ TEST_F(BwuManagerTest, InitiateBwu_Revert_OnDisconnect_Wlan) {
   UnRegisterChannelForEndpoint(kEndpointId1);
 }
 
+TEST_F(BwuManagerTest, RaceUpgradeMediums_FirstPathSetUpWins) {
+  CreateInitialEndpoint(kServiceIdA, kEndpointId1, Medium::BLUETOOTH);
+  fake_web_rtc_bwu_handler_->set_initialize_fails(true);
+
+  EXPECT_EQ(bwu_manager_->RaceUpgradeMediumsForTesting(
+                &client_, std::string(kEndpointId1),
+                {Medium::WEB_RTC, Medium::WIFI_LAN}),
+            Medium::WIFI_LAN);
+  EXPECT_EQ(fake_web_rtc_bwu_handler_->handle_initialize_calls().size(), 1u);
+  EXPECT_EQ(fake_wifi_lan_bwu_handler_->handle_initialize_calls().size(), 1u);
+  // The failed path setup left nothing to revert.
+  EXPECT_TRUE(fake_web_rtc_bwu_handler_->handle_revert_calls().empty());
+  UnRegisterChannelForEndpoint(kEndpointId1);
+}
+
+TEST_F(BwuManagerTest, RaceUpgradeMediums_SetsUpWifiMediumsOneAtATime) {
+  CreateInitialEndpoint(kServiceIdA, kEndpointId1, Medium::BLUETOOTH);
+  fake_wifi_hotspot_bwu_handler_->set_initialize_fails(true);
+
+  // Wi-Fi Direct is only tried after the hotspot failed, and Wi-Fi LAN not at
+  // all once Wi-Fi Direct is set up.
+  EXPECT_EQ(bwu_manager_->RaceUpgradeMediumsForTesting(
+                &client_, std::string(kEndpointId1),
+                {Medium::WIFI_HOTSPOT, Medium::WIFI_DIRECT, Medium::WIFI_LAN}),
+            Medium::WIFI_DIRECT);
+  EXPECT_EQ(fake_wifi_hotspot_bwu_handler_->handle_initialize_calls().size(),
+            1u);
+  EXPECT_EQ(fake_wifi_direct_bwu_handler_->handle_initialize_calls().size(),
+            1u);
+  EXPECT_TRUE(fake_wifi_lan_bwu_handler_->handle_initialize_calls().empty());
+  UnRegisterChannelForEndpoint(kEndpointId1);
+}
+
+TEST_F(BwuManagerTest, RaceUpgradeMediums_NoPathSetUp) {
+  CreateInitialEndpoint(kServiceIdA, kEndpointId1, Medium::BLUETOOTH);
+  fake_web_rtc_bwu_handler_->set_initialize_fails(true);
+  fake_wifi_lan_bwu_handler_->set_initialize_fails(true);
+
+  EXPECT_EQ(bwu_manager_->RaceUpgradeMediumsForTesting(
+                &client_, std::string(kEndpointId1),
+                {Medium::WEB_RTC, Medium::WIFI_LAN}),
+            Medium::UNKNOWN_MEDIUM);
+  UnRegisterChannelForEndpoint(kEndpointId1);
+}
+
+TEST_F(BwuManagerTest, RaceUpgradeMediums_RevertsLosingMediumBeforeReturning) {
+  // The race only runs concurrently without MakeSingleThreadedForTesting().
+  auto wifi_lan = std::make_unique<FakeBwuHandler>(Medium::WIFI_LAN);
+  auto web_rtc = std::make_unique<FakeBwuHandler>(Medium::WEB_RTC);
+  FakeBwuHandler* wifi_lan_handler = wifi_lan.get();
+  CountDownLatch wifi_lan_started(1);
+  CountDownLatch wifi_lan_release(1);
+  CountDownLatch web_rtc_release(1);
+  wifi_lan_handler->set_initialize_latches(&wifi_lan_started,
+                                           &wifi_lan_release);
+  web_rtc->set_initialize_latches(nullptr, &web_rtc_release);
+  absl::flat_hash_map<Medium, std::unique_ptr<BwuHandler>> handlers;
+  handlers.emplace(Medium::WIFI_LAN, std::move(wifi_lan));
+  handlers.emplace(Medium::WEB_RTC, std::move(web_rtc));
+  BwuManager::Config config;
+  config.allow_upgrade_to =
+      BooleanMediumSelector{.web_rtc = true, .wifi_lan = true};
+  EndpointChannelManager ecm;
+  EndpointManager em{&ecm};
+  BwuManager bwu_manager(mediums_, em, ecm, std::move(handlers), config);
+  ecm.RegisterChannelForEndpoint(
+      &client_, std::string(kEndpointId1),
+      std::make_unique<FakeEndpointChannel>(Medium::BLUETOOTH,
+                                            std::string(kServiceIdA)));
+
+  // WebRTC wins while Wi-Fi LAN is still setting up its path.
+  SingleThreadExecutor executor;
+  CountDownLatch race_finished(1);
+  Medium winner = Medium::UNKNOWN_MEDIUM;
+  size_t revert_calls_on_return = 0;
+  executor.Execute([&]() {
+    winner = bwu_manager.RaceUpgradeMediumsForTesting(
+        &client_, std::string(kEndpointId1),
+        {Medium::WIFI_LAN, Medium::WEB_RTC});
+    revert_calls_on_return = wifi_lan_handler->handle_revert_calls().size();
+    race_finished.CountDown();
+  });
+  ASSERT_TRUE(wifi_lan_started.Await(kDefaultTimeout).result());
+  web_rtc_release.CountDown();
+
+  // The race does not return while Wi-Fi LAN is still busy.
+  EXPECT_FALSE(race_finished.Await(absl::Milliseconds(100)).result());
+
+  // Its path is reverted before the race returns.
+  wifi_lan_release.CountDown();
+  ASSERT_TRUE(race_finished.Await(kDefaultTimeout).result());
+  EXPECT_EQ(winner, Medium::WEB_RTC);
+  EXPECT_EQ(revert_calls_on_return, 1u);
+
+  bwu_manager.Shutdown();
+  ecm.UnregisterChannelForEndpoint(
+      std::string(kEndpointId1), DisconnectionReason::LOCAL_DISCONNECTION,
+      ConnectionsLog::EstablishedConnection::SAFE_DISCONNECTION);
+}
+
 TEST_F(BwuManagerTest, OnReceiveBwuEvent) {
   // TODO(b/235109434): Add more unit tests coverage for BWU module
 }
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/chunk_size_controller.h"
+
+#include <algorithm>
+
+#include "absl/time/time.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace connections {
+
+int ChunkSizeController::GetChunkSize(int medium_chunk_size) {
+  if (medium_chunk_size <= 0) return 0;
+  if (medium_chunk_size != medium_chunk_size_) Reset(medium_chunk_size);
+  return chunk_size_;
+}
+
+void ChunkSizeController::OnChunkWritten(int chunk_size,
+                                         absl::Duration write_latency) {
+  if (chunk_size_ == 0 || chunk_size <= 0) return;
+
+  if (write_latency > GetWriteLatencyBudget()) {
+    if (chunk_size_ > medium_chunk_size_) {
+      ceiling_ = std::max(medium_chunk_size_, chunk_size_ / 2);
+      chunk_size_ = ceiling_;
+      NEARBY_LOGS(INFO) << "Chunk write took "
+                        << absl::FormatDuration(write_latency)
+                        << ", shrinking chunk size to " << chunk_size_;
+    }
+    ResetSamples();
+    return;
+  }
+
+  // Tail chunks are shorter than requested and say little about the channel.
+  if (chunk_size < chunk_size_) return;
+
+  ++samples_;
+  sample_bytes_ += chunk_size;
+  sample_time_ += write_latency;
+  if (samples_ < kSamplesPerStep) return;
+
+  double seconds = absl::ToDoubleSeconds(sample_time_);
+  double throughput = seconds > 0 ? sample_bytes_ / seconds : 0;
+  bool improved = previous_throughput_ == 0 || seconds == 0 ||
+                  throughput >= previous_throughput_ * kMinGrowthGain;
+  if (improved && chunk_size_ < ceiling_) {
+    previous_throughput_ = throughput;
+    chunk_size_ = std::min(chunk_size_ * 2, ceiling_);
+    NEARBY_LOGS(VERBOSE) << "Growing chunk size to " << chunk_size_;
+  }
+  ResetSamples();
+}
+
+void ChunkSizeController::OnReceivedAck(absl::Duration round_trip_time) {
+  if (smoothed_round_trip_time_ == absl::ZeroDuration()) {
+    smoothed_round_trip_time_ = round_trip_time;
+  } else {
+    smoothed_round_trip_time_ =
+        (smoothed_round_trip_time_ * 7 + round_trip_time) / 8;
+  }
+}
+
+absl::Duration ChunkSizeController::GetWriteLatencyBudget() const {
+  if (smoothed_round_trip_time_ == absl::ZeroDuration()) {
+    return kDefaultWriteLatencyBudget;
+  }
+  return std::clamp(smoothed_round_trip_time_ * 2, kMinWriteLatencyBudget,
+                    kMaxWriteLatencyBudget);
+}
+
+void ChunkSizeController::Reset(int medium_chunk_size) {
+  medium_chunk_size_ = medium_chunk_size;
+  chunk_size_ = medium_chunk_size;
+  ceiling_ = std::max(kMaxChunkSize, medium_chunk_size);
+  previous_throughput_ = 0;
+  ResetSamples();
+}
+
+void ChunkSizeController::ResetSamples() {
+  samples_ = 0;
+  sample_bytes_ = 0;
+  sample_time_ = absl::ZeroDuration();
+}
+
+}  // namespace connections
+}  // namespace nearby
@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_CHUNK_SIZE_CONTROLLER_H_
+#define CORE_INTERNAL_CHUNK_SIZE_CONTROLLER_H_
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace connections {
+
+// Picks the payload chunk size for one endpoint from what its channel has
+// actually delivered, starting from the medium's fixed packet size.
+//
+// The size doubles after every kSamplesPerStep full-size chunks as long as
+// doubling keeps buying at least kMinGrowthGain more throughput, and halves
+// (lowering the ceiling for the rest of the session) whenever a single write
+// takes longer than the latency budget. The budget is twice the smoothed
+// PAYLOAD_RECEIVED_ACK round trip once one has been seen. Any change of the
+// medium's packet size, e.g. after a bandwidth upgrade, starts over.
+//
+// Not thread-safe; callers serialize access.
+class ChunkSizeController {
+ public:
+  // Keeps a full data frame, with headers and encryption overhead, well under
+  // BaseEndpointChannel::kMaxAllowedReadBytes on the receiving side.
+  static constexpr int kMaxChunkSize = 512 * 1024;
+  static constexpr int kSamplesPerStep = 4;
+  static constexpr double kMinGrowthGain = 1.1;
+  static constexpr absl::Duration kDefaultWriteLatencyBudget =
+      absl::Milliseconds(100);
+  static constexpr absl::Duration kMinWriteLatencyBudget =
+      absl::Milliseconds(20);
+  static constexpr absl::Duration kMaxWriteLatencyBudget =
+      absl::Milliseconds(500);
+
+  // Returns the chunk size to use next, given the medium's current packet
+  // size. Returns 0 if `medium_chunk_size` is 0 (no channel).
+  int GetChunkSize(int medium_chunk_size);
+
+  // Records that a chunk of `chunk_size` bytes took `write_latency` to write.
+  void OnChunkWritten(int chunk_size, absl::Duration write_latency);
+
+  // Records the time between writing a last chunk and its
+  // PAYLOAD_RECEIVED_ACK.
+  void OnReceivedAck(absl::Duration round_trip_time);
+
+  absl::Duration GetWriteLatencyBudget() const;
+
+ private:
+  void Reset(int medium_chunk_size);
+  void ResetSamples();
+
+  int medium_chunk_size_ = 0;
+  int chunk_size_ = 0;
+  int ceiling_ = kMaxChunkSize;
+  int samples_ = 0;
+  std::int64_t sample_bytes_ = 0;
+  absl::Duration sample_time_ = absl::ZeroDuration();
+  // Bytes per second measured at the previous (smaller) chunk size.
+  double previous_throughput_ = 0;
+  absl::Duration smoothed_round_trip_time_ = absl::ZeroDuration();
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_CHUNK_SIZE_CONTROLLER_H_
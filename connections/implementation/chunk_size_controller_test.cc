@@ -0,0 +1,136 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/chunk_size_controller.h"
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+constexpr int kMediumChunkSize = 64 * 1024;
+
+// Writes a full step of chunks at the controller's current size, each taking
+// `latency`.
+void WriteStep(ChunkSizeController& controller, absl::Duration latency) {
+  int chunk_size = controller.GetChunkSize(kMediumChunkSize);
+  for (int i = 0; i < ChunkSizeController::kSamplesPerStep; ++i) {
+    controller.OnChunkWritten(chunk_size, latency);
+  }
+}
+
+TEST(ChunkSizeControllerTest, StartsAtMediumChunkSize) {
+  ChunkSizeController controller;
+
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), kMediumChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, NoChannelMeansNoChunk) {
+  ChunkSizeController controller;
+
+  EXPECT_EQ(controller.GetChunkSize(0), 0);
+}
+
+TEST(ChunkSizeControllerTest, GrowsWhileThroughputImproves) {
+  ChunkSizeController controller;
+
+  // Write latency stays flat while chunks double, so throughput doubles too.
+  WriteStep(controller, absl::Milliseconds(5));
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), 2 * kMediumChunkSize);
+  WriteStep(controller, absl::Milliseconds(5));
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), 4 * kMediumChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, NeverExceedsMaxChunkSize) {
+  ChunkSizeController controller;
+
+  for (int i = 0; i < 10; ++i) {
+    WriteStep(controller, absl::Milliseconds(1));
+  }
+
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize),
+            ChunkSizeController::kMaxChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, HoldsWhenThroughputPlateaus) {
+  ChunkSizeController controller;
+
+  WriteStep(controller, absl::Milliseconds(5));
+  ASSERT_EQ(controller.GetChunkSize(kMediumChunkSize), 2 * kMediumChunkSize);
+  // Twice the bytes take twice as long: the link is saturated.
+  WriteStep(controller, absl::Milliseconds(10));
+
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), 2 * kMediumChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, ShrinksOnSlowWrite) {
+  ChunkSizeController controller;
+  WriteStep(controller, absl::Milliseconds(5));
+  WriteStep(controller, absl::Milliseconds(5));
+  ASSERT_EQ(controller.GetChunkSize(kMediumChunkSize), 4 * kMediumChunkSize);
+
+  controller.OnChunkWritten(4 * kMediumChunkSize, absl::Seconds(1));
+
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), 2 * kMediumChunkSize);
+  // The lowered ceiling holds even if writes speed up again.
+  WriteStep(controller, absl::Milliseconds(1));
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), 2 * kMediumChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, NeverShrinksBelowMediumChunkSize) {
+  ChunkSizeController controller;
+  controller.GetChunkSize(kMediumChunkSize);
+
+  controller.OnChunkWritten(kMediumChunkSize, absl::Seconds(1));
+
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), kMediumChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, IgnoresShortTailChunks) {
+  ChunkSizeController controller;
+  controller.GetChunkSize(kMediumChunkSize);
+
+  for (int i = 0; i < 2 * ChunkSizeController::kSamplesPerStep; ++i) {
+    controller.OnChunkWritten(100, absl::Milliseconds(1));
+  }
+
+  EXPECT_EQ(controller.GetChunkSize(kMediumChunkSize), kMediumChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, MediumChangeStartsOver) {
+  ChunkSizeController controller;
+  WriteStep(controller, absl::Milliseconds(5));
+  ASSERT_EQ(controller.GetChunkSize(kMediumChunkSize), 2 * kMediumChunkSize);
+
+  EXPECT_EQ(controller.GetChunkSize(512), 512);
+}
+
+TEST(ChunkSizeControllerTest, LatencyBudgetFollowsRoundTripTime) {
+  ChunkSizeController controller;
+  EXPECT_EQ(controller.GetWriteLatencyBudget(),
+            ChunkSizeController::kDefaultWriteLatencyBudget);
+
+  controller.OnReceivedAck(absl::Milliseconds(40));
+  EXPECT_EQ(controller.GetWriteLatencyBudget(), absl::Milliseconds(80));
+
+  controller.OnReceivedAck(absl::Seconds(10));
+  EXPECT_EQ(controller.GetWriteLatencyBudget(),
+            ChunkSizeController::kMaxWriteLatencyBudget);
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
@@ -14,6 +14,7 @@
 
 #include "connections/implementation/client_proxy.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <ios>
@@ -28,6 +29,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
@@ -158,6 +160,7 @@ std::string ClientProxy::GetConnectionToken(const std::string& endpoint_id) {
 
 std::optional<std::string> ClientProxy::GetBluetoothMacAddress(
     const std::string& endpoint_id) {
+  MutexLock lock(&bluetooth_mac_addresses_mutex_);
   auto item = bluetooth_mac_addresses_.find(endpoint_id);
   if (item != bluetooth_mac_addresses_.end()) return item->second;
   return std::nullopt;
@@ -165,6 +168,7 @@ std::optional<std::string> ClientProxy::GetBluetoothMacAddress(
 
 void ClientProxy::SetBluetoothMacAddress(
     const std::string& endpoint_id, const std::string& bluetooth_mac_address) {
+  MutexLock lock(&bluetooth_mac_addresses_mutex_);
   bluetooth_mac_addresses_[endpoint_id] = bluetooth_mac_address;
 }
 
@@ -200,15 +204,21 @@ std::string ClientProxy::GenerateLocalEndpointId() {
 }
 
 void ClientProxy::Reset() {
-  MutexLock lock(&mutex_);
-
-  StoppedAdvertising();
-  StoppedDiscovery();
-  RemoveAllEndpoints();
-  if (IsFeatureUseStableEndpointIdEnabled()) {
-    ExitStableEndpointIdMode();
-  } else {
-    ExitHighVisibilityMode();
+  std::vector<std::shared_ptr<PayloadEndpoint>> payload_endpoints;
+  {
+    MutexLock lock(&mutex_);
+
+    StoppedAdvertising();
+    StoppedDiscovery();
+    payload_endpoints = RemoveAllEndpoints();
+    if (IsFeatureUseStableEndpointIdEnabled()) {
+      ExitStableEndpointIdMode();
+    } else {
+      ExitHighVisibilityMode();
+    }
+  }
+  for (const auto& payload_endpoint : payload_endpoints) {
+    DisconnectPayloadEndpoint(payload_endpoint.get());
   }
 }
 
@@ -485,11 +495,7 @@ void ClientProxy::OnConnectionInitiated(
                            .connection_options = connection_options,
                            .connection_token = connection_token,
                        },
-                       PayloadListener{
-                           .payload_cb = [](absl::string_view, Payload) {},
-                           .payload_progress_cb = [](absl::string_view,
-                                                     PayloadProgressInfo) {},
-                       }));
+                       std::make_shared<PayloadEndpoint>()));
   // Instead of using structured binding which is nice, but banned
   // (can not use c++17 features, until chromium does) we unpack manually.
   auto& pair_iter = result.first;
@@ -531,6 +537,7 @@ void ClientProxy::OnConnectionAccepted(const std::string& endpoint_id) {
   if (item != nullptr) {
     item->first.connection_listener.accepted_cb(endpoint_id);
     item->first.status = Connection::kConnected;
+    PublishPayloadEndpoint(endpoint_id, item->second);
   }
 }
 
@@ -570,8 +577,19 @@ void ClientProxy::OnBandwidthChanged(const std::string& endpoint_id,
 
 void ClientProxy::OnDisconnected(const std::string& endpoint_id, bool notify) {
   NEARBY_LOGS(INFO) << "ClientProxy [OnDisconnected]: id=" << endpoint_id;
-  MutexLock lock(&mutex_);
+  // No payload callbacks are made for the endpoint once it is disconnected. A
+  // callback still running may call back into ClientProxy, so it is waited for
+  // without holding |mutex_|.
+  std::shared_ptr<PayloadEndpoint> payload_endpoint;
+  {
+    MutexLock lock(&mutex_);
+    if (LookupConnection(endpoint_id) != nullptr) {
+      payload_endpoint = UnpublishPayloadEndpoint(endpoint_id);
+    }
+  }
+  DisconnectPayloadEndpoint(payload_endpoint.get());
 
+  MutexLock lock(&mutex_);
   const ConnectionPair* item = LookupConnection(endpoint_id);
   if (item != nullptr) {
     if (notify) {
@@ -767,7 +785,8 @@ void ClientProxy::LocalEndpointAcceptedConnection(
   NEARBY_LOGS(INFO) << "ClientProxy [Local Accepted]: id=" << endpoint_id;
   ConnectionPair* item = LookupConnection(endpoint_id);
   if (item != nullptr) {
-    item->second = std::move(listener);
+    MutexLock payload_lock(&item->second->mutex);
+    item->second->listener = std::move(listener);
   }
   analytics_recorder_->OnLocalEndpointAccepted(endpoint_id);
 }
@@ -880,6 +899,7 @@ void ClientProxy::AddCancellationFlag(const std::string& endpoint_id) {
     return;
   }
 
+  MutexLock lock(&cancellation_flags_mutex_);
   auto item = cancellation_flags_.find(endpoint_id);
   if (item != cancellation_flags_.end()) {
     // A new flag may be added to the map with the same endpoint, even if a
@@ -899,6 +919,7 @@ void ClientProxy::AddCancellationFlag(const std::string& endpoint_id) {
 
 CancellationFlag* ClientProxy::GetCancellationFlag(
     const std::string& endpoint_id) {
+  MutexLock lock(&cancellation_flags_mutex_);
   const auto item = cancellation_flags_.find(endpoint_id);
   if (item == cancellation_flags_.end()) {
     return default_cancellation_flag_.get();
@@ -907,10 +928,14 @@ CancellationFlag* ClientProxy::GetCancellationFlag(
 }
 
 void ClientProxy::CancelEndpoint(const std::string& endpoint_id) {
-  const auto item = cancellation_flags_.find(endpoint_id);
-  if (item != cancellation_flags_.end()) {
-    item->second->Cancel();
+  CancellationFlag* cancellation_flag = nullptr;
+  {
+    MutexLock lock(&cancellation_flags_mutex_);
+    const auto item = cancellation_flags_.find(endpoint_id);
+    if (item == cancellation_flags_.end()) return;
+    cancellation_flag = item->second.get();
   }
+  cancellation_flag->Cancel();
 }
 
 const OsInfo& ClientProxy::GetLocalOsInfo() const { return local_os_info_; }
@@ -979,9 +1004,24 @@ bool ClientProxy::IsPayloadReceivedAckEnabled(absl::string_view endpoint_id) {
               .min_nc_version_supports_payload_received_ack);
 }
 
+bool ClientProxy::IsWindowedPayloadAckEnabled(absl::string_view endpoint_id) {
+  return IsPayloadReceivedAckEnabled(endpoint_id) &&
+         IsFeatureSupported(endpoint_id, kWindowedPayloadAck);
+}
+
+bool ClientProxy::IsUkey2ResumptionEnabled(absl::string_view endpoint_id) {
+  return IsFeatureSupported(endpoint_id, kUkey2Resumption);
+}
+
 void ClientProxy::CancelAllEndpoints() {
-  for (const auto& item : cancellation_flags_) {
-    CancellationFlag* cancellation_flag = item.second.get();
+  std::vector<CancellationFlag*> cancellation_flags;
+  {
+    MutexLock lock(&cancellation_flags_mutex_);
+    for (const auto& item : cancellation_flags_) {
+      cancellation_flags.push_back(item.second.get());
+    }
+  }
+  for (CancellationFlag* cancellation_flag : cancellation_flags) {
     if (cancellation_flag->Cancelled()) {
       continue;
     }
@@ -990,18 +1030,16 @@ void ClientProxy::CancelAllEndpoints() {
 }
 
 void ClientProxy::OnPayload(const std::string& endpoint_id, Payload payload) {
-  MutexLock lock(&mutex_);
+  std::shared_ptr<PayloadEndpoint> endpoint =
+      LookupPayloadEndpoint(endpoint_id);
+  if (endpoint == nullptr) return;
 
-  if (IsConnectedToEndpoint(endpoint_id)) {
-    const std::pair<ClientProxy::Connection, PayloadListener>* item =
-        LookupConnection(endpoint_id);
-    if (item != nullptr) {
-      NEARBY_LOGS(INFO) << "ClientProxy [reporting onPayloadReceived]: client="
-                        << GetClientId() << "; endpoint_id=" << endpoint_id
-                        << " ; payload_id=" << payload.GetId();
-      item->second.payload_cb(endpoint_id, std::move(payload));
-    }
-  }
+  MutexLock lock(&endpoint->mutex);
+  if (!endpoint->connected) return;
+  NEARBY_LOGS(INFO) << "ClientProxy [reporting onPayloadReceived]: client="
+                    << GetClientId() << "; endpoint_id=" << endpoint_id
+                    << " ; payload_id=" << payload.GetId();
+  endpoint->listener.payload_cb(endpoint_id, std::move(payload));
 }
 
 const ClientProxy::ConnectionPair* ClientProxy::LookupConnection(
@@ -1016,44 +1054,100 @@ ClientProxy::ConnectionPair* ClientProxy::LookupConnection(
   return item != connections_.end() ? &item->second : nullptr;
 }
 
+ClientProxy::PayloadShard& ClientProxy::GetPayloadShard(
+    absl::string_view endpoint_id) const {
+  size_t hash = absl::Hash<absl::string_view>()(endpoint_id);
+  return payload_shards_[hash % kPayloadShardCount];
+}
+
+std::shared_ptr<ClientProxy::PayloadEndpoint>
+ClientProxy::LookupPayloadEndpoint(absl::string_view endpoint_id) const {
+  PayloadShard& shard = GetPayloadShard(endpoint_id);
+  MutexLock lock(&shard.mutex);
+  auto item = shard.endpoints.find(endpoint_id);
+  return item != shard.endpoints.end() ? item->second : nullptr;
+}
+
+void ClientProxy::PublishPayloadEndpoint(
+    const std::string& endpoint_id, std::shared_ptr<PayloadEndpoint> endpoint) {
+  {
+    MutexLock lock(&endpoint->mutex);
+    endpoint->connected = true;
+  }
+  PayloadShard& shard = GetPayloadShard(endpoint_id);
+  MutexLock lock(&shard.mutex);
+  shard.endpoints[endpoint_id] = std::move(endpoint);
+}
+
+std::shared_ptr<ClientProxy::PayloadEndpoint>
+ClientProxy::UnpublishPayloadEndpoint(const std::string& endpoint_id) {
+  PayloadShard& shard = GetPayloadShard(endpoint_id);
+  MutexLock lock(&shard.mutex);
+  auto item = shard.endpoints.find(endpoint_id);
+  if (item == shard.endpoints.end()) return nullptr;
+  std::shared_ptr<PayloadEndpoint> endpoint = std::move(item->second);
+  shard.endpoints.erase(item);
+  return endpoint;
+}
+
+void ClientProxy::DisconnectPayloadEndpoint(PayloadEndpoint* endpoint) {
+  if (endpoint == nullptr) return;
+  // Callers that looked the endpoint up before it was unpublished are either
+  // still in their callback, which this waits for, or see |connected| cleared.
+  MutexLock lock(&endpoint->mutex);
+  endpoint->connected = false;
+}
+
 void ClientProxy::OnPayloadProgress(const std::string& endpoint_id,
                                     const PayloadProgressInfo& info) {
-  MutexLock lock(&mutex_);
-
-  if (IsConnectedToEndpoint(endpoint_id)) {
-    std::pair<ClientProxy::Connection, PayloadListener>* item =
-        LookupConnection(endpoint_id);
-    if (item != nullptr) {
-      item->second.payload_progress_cb(endpoint_id, info);
-
-      if (info.status == PayloadProgressInfo::Status::kInProgress) {
-        NEARBY_LOGS(VERBOSE)
-            << "ClientProxy [reporting onPayloadProgress]: client="
-            << GetClientId() << "; endpoint_id=" << endpoint_id
-            << "; payload_id=" << info.payload_id
-            << ", payload_status=" << ToString(info.status);
-      } else {
-        NEARBY_LOGS(INFO)
-            << "ClientProxy [reporting onPayloadProgress]: client="
-            << GetClientId() << "; endpoint_id=" << endpoint_id
-            << "; payload_id=" << info.payload_id
-            << ", payload_status=" << ToString(info.status);
-      }
-    }
+  std::shared_ptr<PayloadEndpoint> endpoint =
+      LookupPayloadEndpoint(endpoint_id);
+  if (endpoint == nullptr) return;
+
+  MutexLock lock(&endpoint->mutex);
+  if (!endpoint->connected) return;
+  endpoint->listener.payload_progress_cb(endpoint_id, info);
+
+  if (info.status == PayloadProgressInfo::Status::kInProgress) {
+    NEARBY_LOGS(VERBOSE) << "ClientProxy [reporting onPayloadProgress]: client="
+                         << GetClientId() << "; endpoint_id=" << endpoint_id
+                         << "; payload_id=" << info.payload_id
+                         << ", payload_status=" << ToString(info.status);
+  } else {
+    NEARBY_LOGS(INFO) << "ClientProxy [reporting onPayloadProgress]: client="
+                      << GetClientId() << "; endpoint_id=" << endpoint_id
+                      << "; payload_id=" << info.payload_id
+                      << ", payload_status=" << ToString(info.status);
   }
 }
 
-void ClientProxy::RemoveAllEndpoints() {
+std::vector<std::shared_ptr<ClientProxy::PayloadEndpoint>>
+ClientProxy::RemoveAllEndpoints() {
   MutexLock lock(&mutex_);
 
   // Note: we may want to notify the client of onDisconnected() for each
   // endpoint, in the case when this is called from stopAllEndpoints(). For now,
   // just remove without notifying.
+  std::vector<std::shared_ptr<PayloadEndpoint>> payload_endpoints;
+  for (const auto& item : connections_) {
+    std::shared_ptr<PayloadEndpoint> payload_endpoint =
+        UnpublishPayloadEndpoint(item.first);
+    if (payload_endpoint != nullptr) {
+      payload_endpoints.push_back(std::move(payload_endpoint));
+    }
+  }
   connections_.clear();
-  cancellation_flags_.clear();
-  bluetooth_mac_addresses_.clear();
+  {
+    MutexLock cancellation_flags_lock(&cancellation_flags_mutex_);
+    cancellation_flags_.clear();
+  }
+  {
+    MutexLock bluetooth_mac_addresses_lock(&bluetooth_mac_addresses_mutex_);
+    bluetooth_mac_addresses_.clear();
+  }
 
   OnSessionComplete();
+  return payload_endpoints;
 }
 
 void ClientProxy::OnSessionComplete() {
@@ -1255,6 +1349,43 @@ bool ClientProxy::IsMultiplexSocketSupported(absl::string_view endpoint_id,
   }
 }
 
+std::int32_t ClientProxy::GetLocalFeatureBitmask() const {
+  std::int32_t bitmask = 0;
+  if (NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableWindowedPayloadAck)) {
+    bitmask |= kWindowedPayloadAck;
+  }
+  if (NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableUkey2Resumption)) {
+    bitmask |= kUkey2Resumption;
+  }
+  return bitmask;
+}
+
+void ClientProxy::SetRemoteFeatureBitmask(absl::string_view endpoint_id,
+                                          std::int32_t remote_feature_bitmask) {
+  MutexLock lock(&mutex_);
+  ConnectionPair* item = LookupConnection(endpoint_id);
+  if (item != nullptr) {
+    item->first.remote_feature_bitmask = remote_feature_bitmask;
+    NEARBY_LOGS(INFO) << "ClientProxy [SetRemoteFeatureBitmask]: "
+                      << remote_feature_bitmask;
+  }
+}
+
+bool ClientProxy::IsFeatureSupported(absl::string_view endpoint_id,
+                                     std::int32_t feature) const {
+  MutexLock lock(&mutex_);
+  const ConnectionPair* item = LookupConnection(endpoint_id);
+  if (item == nullptr) {
+    return false;
+  }
+  return (GetLocalFeatureBitmask() & item->first.remote_feature_bitmask &
+          feature) != 0;
+}
+
 std::string ClientProxy::ToString(PayloadProgressInfo::Status status) const {
   switch (status) {
     case PayloadProgressInfo::Status::kSuccess:
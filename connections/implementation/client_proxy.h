@@ -15,6 +15,7 @@
 #ifndef CORE_INTERNAL_CLIENT_PROXY_H_
 #define CORE_INTERNAL_CLIENT_PROXY_H_
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -22,6 +23,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
@@ -308,6 +310,12 @@ class ClientProxy final {
   bool IsSafeToDisconnectEnabled(absl::string_view endpoint_id);
   bool IsAutoReconnectEnabled(absl::string_view endpoint_id);
   bool IsPayloadReceivedAckEnabled(absl::string_view endpoint_id);
+  // True if payload-received-ack is enabled and both sides advertised
+  // kWindowedPayloadAck; otherwise payload acks stay one per payload.
+  bool IsWindowedPayloadAckEnabled(absl::string_view endpoint_id);
+  // True if both sides advertised kUkey2Resumption, so a UKEY2 session can be
+  // resumed when a channel to the endpoint is replaced.
+  bool IsUkey2ResumptionEnabled(absl::string_view endpoint_id);
 
   // Returns the multiplex socket supports status for local device.
   std::int32_t GetLocalMultiplexSocketBitmask() const;
@@ -323,6 +331,22 @@ class ClientProxy final {
   // Returns true if the multiplex socket is supported for the given medium.
   bool IsMultiplexSocketSupported(absl::string_view endpoint_id, Medium medium);
 
+  // Returns the optional features the local device advertises in its
+  // connection response, as a FeatureBitmask.
+  std::int32_t GetLocalFeatureBitmask() const;
+  // Sets the optional features the remote device advertised.
+  void SetRemoteFeatureBitmask(absl::string_view endpoint_id,
+                               std::int32_t remote_feature_bitmask);
+  // Returns true if both devices advertised |feature|.
+  bool IsFeatureSupported(absl::string_view endpoint_id,
+                          std::int32_t feature) const;
+
+  /** Bitmask for optional features negotiated in the connection response. */
+  enum FeatureBitmask : uint32_t {
+    kWindowedPayloadAck = 1 << 0,
+    kUkey2Resumption = 1 << 1,
+  };
+
   /** Bitmask for bt multiplex connection support. */
   // Note. Deprecates the first and second bit of BT_MULTIPLEX_ENABLED and
   // WIFI_LAN_MULTIPLEX_ENABLED and shift them to the third and the forth bit.
@@ -366,8 +390,34 @@ class ClientProxy final {
     std::optional<location::nearby::connections::OsInfo> os_info;
     std::int32_t safe_to_disconnect_version;
     std::int32_t remote_multiplex_socket_bitmask;
+    std::int32_t remote_feature_bitmask = 0;
+  };
+
+  // Payload delivery state of one endpoint. OnPayload() and
+  // OnPayloadProgress() only take the lock of their endpoint, so callbacks for
+  // one endpoint don't contend with discovery or connection changes for
+  // other endpoints.
+  struct PayloadEndpoint {
+    // Held while the listener runs. Recursive, like |mutex_|, so a listener
+    // may call back into ClientProxy for the same endpoint.
+    RecursiveMutex mutex;
+    PayloadListener listener ABSL_GUARDED_BY(mutex);
+    // Set while the connection is CONNECTED. Cleared under |mutex| on
+    // disconnection, which waits for a running callback to return.
+    bool connected ABSL_GUARDED_BY(mutex) = false;
+  };
+
+  // Connected endpoints, sharded by endpoint ID so that lookups for different
+  // endpoints rarely share a lock.
+  struct PayloadShard {
+    Mutex mutex;
+    absl::flat_hash_map<std::string, std::shared_ptr<PayloadEndpoint>>
+        endpoints ABSL_GUARDED_BY(mutex);
   };
-  using ConnectionPair = std::pair<Connection, PayloadListener>;
+  static constexpr int kPayloadShardCount = 16;
+
+  using ConnectionPair =
+      std::pair<Connection, std::shared_ptr<PayloadEndpoint>>;
 
   struct AdvertisingInfo {
     std::string service_id;
@@ -394,8 +444,9 @@ class ClientProxy final {
   // ClientProxy via `ClientProxy::Reset`, which makes destroying
   // CancellationFlags safe here since we are destroying ClientProxy. Do not
   // use CancellationFlags after `RemoveAllEndpoints` is called, since all
-  // flags now are referencing garbage memory.
-  void RemoveAllEndpoints();
+  // flags now are referencing garbage memory. Returns the unpublished payload
+  // endpoints, for the caller to disconnect once |mutex_| is released.
+  std::vector<std::shared_ptr<PayloadEndpoint>> RemoveAllEndpoints();
 
   void OnSessionComplete();
   bool ConnectionStatusesContains(const std::string& endpoint_id,
@@ -411,6 +462,22 @@ class ClientProxy final {
       absl::AnyInvocable<bool(const Connection&)> pred) const;
   std::string GenerateLocalEndpointId();
 
+  PayloadShard& GetPayloadShard(absl::string_view endpoint_id) const;
+  std::shared_ptr<PayloadEndpoint> LookupPayloadEndpoint(
+      absl::string_view endpoint_id) const;
+  // Makes payloads deliverable to the connected |endpoint_id|.
+  void PublishPayloadEndpoint(const std::string& endpoint_id,
+                              std::shared_ptr<PayloadEndpoint> endpoint);
+  // Stops payload lookups for |endpoint_id| and returns its endpoint, or
+  // nullptr if it was not published. Pass the endpoint to
+  // DisconnectPayloadEndpoint() once |mutex_| is released.
+  std::shared_ptr<PayloadEndpoint> UnpublishPayloadEndpoint(
+      const std::string& endpoint_id);
+  // Stops payload delivery to |endpoint|. Returns after any payload callback
+  // already running for it has returned. Must not be called with |mutex_|
+  // held: the callback may call back into ClientProxy.
+  static void DisconnectPayloadEndpoint(PayloadEndpoint* endpoint);
+
   void ScheduleClearCachedEndpointIdAlarm();
   void CancelClearCachedEndpointIdAlarm();
 
@@ -469,8 +536,18 @@ class ClientProxy final {
   // Maps endpoint_id to endpoint connection state.
   absl::flat_hash_map<std::string, ConnectionPair> connections_;
 
+  // Connected endpoints for payload delivery. Lock order: a shard lock is
+  // taken last and only held for the lookup. A PayloadEndpoint lock is held
+  // while the payload listener runs, and the listener may call back into
+  // ClientProxy and take |mutex_|, so it comes before |mutex_|. Code holding
+  // |mutex_| only takes a PayloadEndpoint lock before the endpoint is
+  // published here, when no listener can be holding it.
+  mutable std::array<PayloadShard, kPayloadShardCount> payload_shards_;
+
   // Maps endpoint_id to Bluetooth Mac Addresses.
-  absl::flat_hash_map<std::string, std::string> bluetooth_mac_addresses_;
+  mutable Mutex bluetooth_mac_addresses_mutex_;
+  absl::flat_hash_map<std::string, std::string> bluetooth_mac_addresses_
+      ABSL_GUARDED_BY(bluetooth_mac_addresses_mutex_);
 
   // A cache of endpoint ids that we've already notified the discoverer of. We
   // check this cache before calling onEndpointFound() so that we don't notify
@@ -482,8 +559,10 @@ class ClientProxy final {
   // Maps endpoint_id to CancellationFlag. CancellationFlags are passed around
   // as raw pointers to other classes in Nearby Connections, so it is important
   // that objects in this map are not cleared, even if they are cancelled.
+  // Flags are cancelled outside of the lock since cancellation runs listeners.
+  mutable Mutex cancellation_flags_mutex_;
   absl::flat_hash_map<std::string, std::unique_ptr<CancellationFlag>>
-      cancellation_flags_;
+      cancellation_flags_ ABSL_GUARDED_BY(cancellation_flags_mutex_);
   // A default cancellation flag with isCancelled set be true.
   std::unique_ptr<CancellationFlag> default_cancellation_flag_ =
       std::make_unique<CancellationFlag>(true);
@@ -54,6 +54,7 @@
 #include "internal/platform/medium_environment.h"
 #include "internal/platform/mutex.h"
 #include "internal/platform/mutex_lock.h"
+#include "internal/platform/single_thread_executor.h"
 #include "proto/connections_enums.pb.h"
 
 namespace nearby {
@@ -727,6 +728,87 @@ TEST_F(ClientProxyTest, OnPayloadProgressChangesState) {
   OnPayloadProgress(client2(), advertising_endpoint);
 }
 
+TEST_F(ClientProxyTest, OnPayloadProgressDoesNotWaitForOtherEndpoints) {
+  Endpoint slow_endpoint{.info = ByteArray{"slow endpoint"}, .id = "SLOW"};
+  Endpoint fast_endpoint{.info = ByteArray{"fast endpoint"}, .id = "FAST"};
+  Endpoint new_endpoint{.info = ByteArray{"new endpoint"}, .id = "NEW1"};
+  StartDiscovery(client2(), GetDiscoveryListener());
+  OnDiscoveryConnectionInitiated(client2(), slow_endpoint);
+  CountDownLatch callback_entered(1);
+  CountDownLatch release_callback(1);
+  client2()->LocalEndpointAcceptedConnection(
+      slow_endpoint.id,
+      {.payload_progress_cb =
+           [&](absl::string_view, const PayloadProgressInfo&) {
+             callback_entered.CountDown();
+             release_callback.Await();
+           }});
+  OnDiscoveryConnectionRemoteAccepted(client2(), slow_endpoint);
+  OnDiscoveryConnectionAccepted(client2(), slow_endpoint);
+  OnDiscoveryConnectionInitiated(client2(), fast_endpoint);
+  OnDiscoveryConnectionLocalAccepted(client2(), fast_endpoint);
+  OnDiscoveryConnectionRemoteAccepted(client2(), fast_endpoint);
+  OnDiscoveryConnectionAccepted(client2(), fast_endpoint);
+
+  SingleThreadExecutor executor;
+  executor.Execute(
+      [&]() { client2()->OnPayloadProgress(slow_endpoint.id, {}); });
+  ASSERT_TRUE(callback_entered.Await(absl::Seconds(1)).result());
+
+  // Neither payload callbacks for another endpoint nor discovery wait for the
+  // callback that is still running.
+  OnPayloadProgress(client2(), fast_endpoint);
+  OnDiscoveryEndpointFound(client2(), new_endpoint);
+
+  release_callback.CountDown();
+  executor.Shutdown();
+}
+
+TEST_F(ClientProxyTest, NoPayloadProgressAfterDisconnection) {
+  Endpoint advertising_endpoint =
+      StartAdvertising(client1(), advertising_connection_listener_);
+  StartDiscovery(client2(), GetDiscoveryListener());
+  OnDiscoveryEndpointFound(client2(), advertising_endpoint);
+  OnDiscoveryConnectionInitiated(client2(), advertising_endpoint);
+  OnDiscoveryConnectionLocalAccepted(client2(), advertising_endpoint);
+  OnDiscoveryConnectionRemoteAccepted(client2(), advertising_endpoint);
+  OnDiscoveryConnectionAccepted(client2(), advertising_endpoint);
+  OnDiscoveryConnectionDisconnected(client2(), advertising_endpoint);
+
+  // The payload listener is a StrictMock without expectations.
+  client2()->OnPayloadProgress(advertising_endpoint.id, {});
+  client2()->OnPayload(advertising_endpoint.id, Payload(payload_bytes_));
+}
+
+TEST_F(ClientProxyTest, DisconnectionDoesNotBlockCallbackCallingBack) {
+  Endpoint endpoint{.info = ByteArray{"endpoint"}, .id = "ABCD"};
+  StartDiscovery(client2(), GetDiscoveryListener());
+  OnDiscoveryConnectionInitiated(client2(), endpoint);
+  CountDownLatch callback_entered(1);
+  CountDownLatch disconnecting(1);
+  client2()->LocalEndpointAcceptedConnection(
+      endpoint.id,
+      {.payload_progress_cb =
+           [&](absl::string_view endpoint_id, const PayloadProgressInfo&) {
+             callback_entered.CountDown();
+             disconnecting.Await();
+             // Calls back into ClientProxy while OnDisconnected() waits for
+             // this callback to return.
+             client2()->IsConnectedToEndpoint(std::string(endpoint_id));
+           }});
+  OnDiscoveryConnectionRemoteAccepted(client2(), endpoint);
+  OnDiscoveryConnectionAccepted(client2(), endpoint);
+
+  SingleThreadExecutor executor;
+  executor.Execute([&]() { client2()->OnPayloadProgress(endpoint.id, {}); });
+  ASSERT_TRUE(callback_entered.Await(absl::Seconds(1)).result());
+
+  disconnecting.CountDown();
+  client2()->OnDisconnected(endpoint.id, /*notify=*/false);
+  EXPECT_FALSE(client2()->IsConnectedToEndpoint(endpoint.id));
+  executor.Shutdown();
+}
+
 TEST_F(ClientProxyTest,
        EndpointIdCacheWhenHighVizAdvertisementAgainImmediately) {
   BooleanMediumSelector booleanMediumSelector;
@@ -1594,6 +1676,52 @@ TEST_F(ClientProxyTest, TestRemoteMultiplexSocketBitmask) {
       false);
 }
 
+TEST_F(ClientProxyTest, TestFeatureBitmask) {
+  EXPECT_EQ(client1()->GetLocalFeatureBitmask(), 0);
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableWindowedPayloadAck,
+      true);
+  EXPECT_EQ(client1()->GetLocalFeatureBitmask(),
+            ClientProxy::kWindowedPayloadAck);
+  Endpoint advertising_endpoint =
+      StartAdvertising(client1(), advertising_connection_listener_);
+  OnAdvertisingConnectionInitiated(client1(), advertising_endpoint);
+  EXPECT_FALSE(client1()->IsFeatureSupported(advertising_endpoint.id,
+                                             ClientProxy::kWindowedPayloadAck));
+  client1()->SetRemoteFeatureBitmask(advertising_endpoint.id,
+                                     ClientProxy::kWindowedPayloadAck);
+  EXPECT_TRUE(client1()->IsFeatureSupported(advertising_endpoint.id,
+                                            ClientProxy::kWindowedPayloadAck));
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableWindowedPayloadAck,
+      false);
+  EXPECT_FALSE(client1()->IsFeatureSupported(advertising_endpoint.id,
+                                             ClientProxy::kWindowedPayloadAck));
+}
+
+TEST_F(ClientProxyTest, Ukey2ResumptionNeedsBothSides) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableUkey2Resumption,
+      true);
+  Endpoint advertising_endpoint =
+      StartAdvertising(client1(), advertising_connection_listener_);
+  OnAdvertisingConnectionInitiated(client1(), advertising_endpoint);
+  client1()->SetRemoteFeatureBitmask(advertising_endpoint.id,
+                                     ClientProxy::kWindowedPayloadAck);
+  EXPECT_FALSE(client1()->IsUkey2ResumptionEnabled(advertising_endpoint.id));
+  client1()->SetRemoteFeatureBitmask(advertising_endpoint.id,
+                                     ClientProxy::kUkey2Resumption);
+  EXPECT_TRUE(client1()->IsUkey2ResumptionEnabled(advertising_endpoint.id));
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableUkey2Resumption,
+      false);
+  EXPECT_FALSE(client1()->IsUkey2ResumptionEnabled(advertising_endpoint.id));
+}
+
 }  // namespace
 }  // namespace connections
 }  // namespace nearby
@@ -15,20 +15,30 @@
 #include "connections/implementation/encryption_runner.h"
 
 #include <cinttypes>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
+#include "securegcm/d2d_connection_context_v1.h"
 #include "securegcm/ukey2_handshake.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
+#include "connections/implementation/ukey2_session_cache.h"
+#include "internal/crypto_cros/hkdf.h"
+#include "internal/crypto_cros/hmac.h"
 #include "internal/platform/base64_utils.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/cancelable_alarm.h"
+#include "internal/platform/crypto.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/logging.h"
 
@@ -69,6 +79,77 @@ bool HandleEncryptionSuccess(const std::string& endpoint_id,
   return true;
 }
 
+// Session resumption, tried before a full UKEY2 handshake when the client has
+// a ticket for the endpoint:
+//   client: magic | ticket id | client nonce | MAC("client", id, client nonce)
+//   server: magic | kResumeAccepted | server nonce |
+//           MAC("server", client nonce, server nonce)
+//       or: magic | kResumeRejected, and the client falls back to a full
+//           UKEY2 handshake on the same channel.
+// MACs are HMAC-SHA256 keyed with the ticket secret, and the new session keys
+// are derived from the secret and both nonces. UKEY2 messages are protobufs,
+// which never start with the magic.
+constexpr absl::string_view kResumeMagic = "NCR1";
+constexpr char kResumeAccepted = 1;
+constexpr char kResumeRejected = 0;
+constexpr size_t kResumeNonceLength = 32;
+constexpr size_t kResumeMacLength = 32;
+constexpr size_t kResumeRequestLength = kResumeMagic.size() +
+                                        Ukey2SessionCache::kTicketIdLength +
+                                        kResumeNonceLength + kResumeMacLength;
+constexpr size_t kResumeAcceptLength =
+    kResumeMagic.size() + 1 + kResumeNonceLength + kResumeMacLength;
+constexpr char kResumeKeysInfo[] = "UKEY2 resumed session keys";
+// D2DConnectionContextV1 key length, and its saved session protocol version.
+constexpr size_t kAesKeyLength = 32;
+constexpr char kSavedSessionVersion = 1;
+
+std::string RandomNonce() {
+  std::string nonce(kResumeNonceLength, 0);
+  RandBytes(nonce.data(), nonce.size());
+  return nonce;
+}
+
+std::string ResumeMac(const Ukey2SessionCache::Ticket& ticket,
+                      absl::string_view label, absl::string_view first,
+                      absl::string_view second) {
+  crypto::HMAC hmac(crypto::HMAC::HashAlgorithm::SHA256);
+  std::string mac(kResumeMacLength, 0);
+  if (!hmac.Init(ticket.secret) ||
+      !hmac.Sign(absl::StrCat(label, first, second),
+                 reinterpret_cast<unsigned char*>(mac.data()), mac.size())) {
+    return "";
+  }
+  return mac;
+}
+
+bool VerifyResumeMac(const Ukey2SessionCache::Ticket& ticket,
+                     absl::string_view label, absl::string_view first,
+                     absl::string_view second, absl::string_view mac) {
+  crypto::HMAC hmac(crypto::HMAC::HashAlgorithm::SHA256);
+  return hmac.Init(ticket.secret) &&
+         hmac.Verify(absl::StrCat(label, first, second), mac);
+}
+
+// Derives the keys of a resumed session, oriented for the client or the
+// server side.
+std::unique_ptr<securegcm::D2DConnectionContextV1> ResumedContext(
+    const Ukey2SessionCache::Ticket& ticket, absl::string_view client_nonce,
+    absl::string_view server_nonce, bool is_client) {
+  std::string keys = crypto::HkdfSha256(
+      ticket.secret, absl::StrCat(client_nonce, server_nonce), kResumeKeysInfo,
+      2 * kAesKeyLength);
+  absl::string_view client_key =
+      absl::string_view(keys).substr(0, kAesKeyLength);
+  absl::string_view server_key = absl::string_view(keys).substr(kAesKeyLength);
+  // Saved session layout: version | encode sequence number | decode sequence
+  // number | encode key | decode key. Both sequence numbers start at 0.
+  return securegcm::D2DConnectionContextV1::FromSavedSession(
+      absl::StrCat(std::string(1, kSavedSessionVersion), std::string(8, '\0'),
+                   is_client ? client_key : server_key,
+                   is_client ? server_key : client_key));
+}
+
 void CancelableAlarmRunnable(ClientProxy* client,
                              const std::string& endpoint_id,
                              EndpointChannel* endpoint_channel) {
@@ -82,10 +163,12 @@ void CancelableAlarmRunnable(ClientProxy* client,
 class ServerRunnable final {
  public:
   ServerRunnable(ClientProxy* client, ScheduledExecutor* alarm_executor,
+                 Ukey2SessionCache* session_cache,
                  const std::string& endpoint_id, EndpointChannel* channel,
                  EncryptionRunner::ResultListener listener)
       : client_(client),
         alarm_executor_(alarm_executor),
+        session_cache_(session_cache),
         endpoint_id_(endpoint_id),
         channel_(channel),
         listener_(std::move(listener)) {}
@@ -104,13 +187,40 @@ class ServerRunnable final {
       return;
     }
 
-    // Message 1 (Client Init)
+    // Message 1 (Client Init), unless the client asks to resume instead.
     ExceptionOr<ByteArray> client_init = channel_->Read();
     if (!client_init.ok()) {
       LogException();
       HandleHandshakeOrIoException(&timeout_alarm);
       return;
     }
+    if (absl::StartsWith(client_init.result().AsStringView(), kResumeMagic)) {
+      std::string reply;
+      std::unique_ptr<securegcm::D2DConnectionContextV1> context =
+          AnswerResumeRequest(client_init.result().AsStringView(), reply);
+      if (!channel_->Write(ByteArray(std::move(reply))).Ok()) {
+        LogException();
+        HandleHandshakeOrIoException(&timeout_alarm);
+        return;
+      }
+      if (context != nullptr) {
+        NEARBY_LOGS(INFO)
+            << "In StartServer(), resumed session with endpoint(id="
+            << endpoint_id_ << ").";
+        timeout_alarm.Cancel();
+        listener_.CallResumeCallback(endpoint_id_, std::move(context));
+        return;
+      }
+      NEARBY_LOGS(INFO) << "In StartServer(), rejected session resumption "
+                           "from endpoint(id="
+                        << endpoint_id_ << "), expecting a full handshake.";
+      client_init = channel_->Read();
+      if (!client_init.ok()) {
+        LogException();
+        HandleHandshakeOrIoException(&timeout_alarm);
+        return;
+      }
+    }
 
     securegcm::UKey2Handshake::ParseResult parse_result =
         server->ParseHandshakeMessage(std::string(client_init.result()));
@@ -193,6 +303,41 @@ class ServerRunnable final {
                        << endpoint_id_ << ").";
   }
 
+  // Checks a resume request against our ticket for the endpoint. Returns the
+  // resumed session and sets `reply` to accept it, or returns nullptr and sets
+  // `reply` to reject it.
+  std::unique_ptr<securegcm::D2DConnectionContextV1> AnswerResumeRequest(
+      absl::string_view request, std::string& reply) {
+    reply = absl::StrCat(kResumeMagic, std::string(1, kResumeRejected));
+    if (session_cache_ == nullptr || !listener_.on_resume_cb ||
+        request.size() != kResumeRequestLength) {
+      return nullptr;
+    }
+    std::optional<Ukey2SessionCache::Ticket> ticket =
+        session_cache_->Get(endpoint_id_);
+    request.remove_prefix(kResumeMagic.size());
+    absl::string_view ticket_id =
+        request.substr(0, Ukey2SessionCache::kTicketIdLength);
+    request.remove_prefix(Ukey2SessionCache::kTicketIdLength);
+    absl::string_view client_nonce = request.substr(0, kResumeNonceLength);
+    absl::string_view mac = request.substr(kResumeNonceLength);
+    if (!ticket.has_value() || ticket->id != ticket_id ||
+        !VerifyResumeMac(*ticket, "client", ticket_id, client_nonce, mac)) {
+      return nullptr;
+    }
+
+    std::string server_nonce = RandomNonce();
+    std::string server_mac =
+        ResumeMac(*ticket, "server", client_nonce, server_nonce);
+    std::unique_ptr<securegcm::D2DConnectionContextV1> context =
+        ResumedContext(*ticket, client_nonce, server_nonce,
+                       /*is_client=*/false);
+    if (server_mac.empty() || context == nullptr) return nullptr;
+    reply = absl::StrCat(kResumeMagic, std::string(1, kResumeAccepted),
+                         server_nonce, server_mac);
+    return context;
+  }
+
   void HandleHandshakeOrIoException(CancelableAlarm* timeout_alarm) {
     timeout_alarm->Cancel();
     listener_.CallFailureCallback(endpoint_id_, channel_);
@@ -212,6 +357,7 @@ class ServerRunnable final {
 
   ClientProxy* client_;
   ScheduledExecutor* alarm_executor_;
+  Ukey2SessionCache* session_cache_;
   const std::string endpoint_id_;
   EndpointChannel* channel_;
   EncryptionRunner::ResultListener listener_;
@@ -220,10 +366,12 @@ class ServerRunnable final {
 class ClientRunnable final {
  public:
   ClientRunnable(ClientProxy* client, ScheduledExecutor* alarm_executor,
+                 Ukey2SessionCache* session_cache,
                  const std::string& endpoint_id, EndpointChannel* channel,
                  EncryptionRunner::ResultListener listener)
       : client_(client),
         alarm_executor_(alarm_executor),
+        session_cache_(session_cache),
         endpoint_id_(endpoint_id),
         channel_(channel),
         listener_(std::move(listener)) {}
@@ -234,6 +382,31 @@ class ClientRunnable final {
         [this]() { CancelableAlarmRunnable(client_, endpoint_id_, channel_); },
         kTimeout, alarm_executor_);
 
+    std::optional<Ukey2SessionCache::Ticket> ticket;
+    if (session_cache_ != nullptr && listener_.on_resume_cb) {
+      ticket = session_cache_->Get(endpoint_id_);
+    }
+    if (ticket.has_value()) {
+      std::unique_ptr<securegcm::D2DConnectionContextV1> context;
+      if (!Resume(*ticket, context)) {
+        LogException();
+        HandleHandshakeOrIoException(&timeout_alarm);
+        return;
+      }
+      if (context != nullptr) {
+        NEARBY_LOGS(INFO)
+            << "In StartClient(), resumed session with endpoint(id="
+            << endpoint_id_ << ").";
+        timeout_alarm.Cancel();
+        listener_.CallResumeCallback(endpoint_id_, std::move(context));
+        return;
+      }
+      NEARBY_LOGS(INFO) << "In StartClient(), endpoint(id=" << endpoint_id_
+                        << ") rejected session resumption, falling back to a "
+                           "full handshake.";
+      session_cache_->Remove(endpoint_id_);
+    }
+
     std::unique_ptr<securegcm::UKey2Handshake> crypto =
         securegcm::UKey2Handshake::ForInitiator(kCipher);
 
@@ -330,6 +503,43 @@ class ClientRunnable final {
                        << endpoint_id_ << ").";
   }
 
+  // Asks the server to resume the session named by `ticket`. Returns false on
+  // I/O or protocol errors. Otherwise sets `context` to the resumed session,
+  // or leaves it null if the server rejected the ticket.
+  bool Resume(const Ukey2SessionCache::Ticket& ticket,
+              std::unique_ptr<securegcm::D2DConnectionContextV1>& context) {
+    std::string client_nonce = RandomNonce();
+    std::string client_mac =
+        ResumeMac(ticket, "client", ticket.id, client_nonce);
+    if (client_mac.empty()) return false;
+    Exception write_exception = channel_->Write(ByteArray(
+        absl::StrCat(kResumeMagic, ticket.id, client_nonce, client_mac)));
+    if (!write_exception.Ok()) return false;
+
+    ExceptionOr<ByteArray> reply_bytes = channel_->Read();
+    if (!reply_bytes.ok()) return false;
+    absl::string_view reply = reply_bytes.result().AsStringView();
+    if (!absl::StartsWith(reply, kResumeMagic) ||
+        reply.size() <= kResumeMagic.size()) {
+      return false;
+    }
+    if (reply[kResumeMagic.size()] == kResumeRejected) return true;
+    if (reply.size() != kResumeAcceptLength ||
+        reply[kResumeMagic.size()] != kResumeAccepted) {
+      return false;
+    }
+    reply.remove_prefix(kResumeMagic.size() + 1);
+    absl::string_view server_nonce = reply.substr(0, kResumeNonceLength);
+    absl::string_view server_mac = reply.substr(kResumeNonceLength);
+    if (!VerifyResumeMac(ticket, "server", client_nonce, server_nonce,
+                         server_mac)) {
+      return false;
+    }
+    context = ResumedContext(ticket, client_nonce, server_nonce,
+                             /*is_client=*/true);
+    return context != nullptr;
+  }
+
   void HandleHandshakeOrIoException(CancelableAlarm* timeout_alarm) {
     timeout_alarm->Cancel();
     listener_.CallFailureCallback(endpoint_id_, channel_);
@@ -349,6 +559,7 @@ class ClientRunnable final {
 
   ClientProxy* client_;
   ScheduledExecutor* alarm_executor_;
+  Ukey2SessionCache* session_cache_;
   const std::string endpoint_id_;
   EndpointChannel* channel_;
   EncryptionRunner::ResultListener listener_;
@@ -367,7 +578,7 @@ void EncryptionRunner::StartServer(ClientProxy* client,
                                    const std::string& endpoint_id,
                                    EndpointChannel* endpoint_channel,
                                    EncryptionRunner::ResultListener listener) {
-  ServerRunnable runnable(client, &alarm_executor_, endpoint_id,
+  ServerRunnable runnable(client, &alarm_executor_, session_cache_, endpoint_id,
                           endpoint_channel, std::move(listener));
   server_executor_.Execute("encryption-server", std::move(runnable));
 }
@@ -376,7 +587,7 @@ void EncryptionRunner::StartClient(ClientProxy* client,
                                    const std::string& endpoint_id,
                                    EndpointChannel* endpoint_channel,
                                    EncryptionRunner::ResultListener listener) {
-  ClientRunnable runnable(client, &alarm_executor_, endpoint_id,
+  ClientRunnable runnable(client, &alarm_executor_, session_cache_, endpoint_id,
                           endpoint_channel, std::move(listener));
   client_executor_.Execute("encryption-client", std::move(runnable));
 }
@@ -392,6 +603,15 @@ void EncryptionRunner::ResultListener::CallSuccessCallback(
   Reset();
 }
 
+void EncryptionRunner::ResultListener::CallResumeCallback(
+    const std::string& endpoint_id,
+    std::unique_ptr<securegcm::D2DConnectionContextV1> context) {
+  if (on_resume_cb) {
+    std::move(on_resume_cb)(endpoint_id, std::move(context));
+  }
+  Reset();
+}
+
 void EncryptionRunner::ResultListener::CallFailureCallback(
     const std::string& endpoint_id, EndpointChannel* channel) {
   if (on_failure_cb) {
@@ -402,6 +622,7 @@ void EncryptionRunner::ResultListener::CallFailureCallback(
 
 void EncryptionRunner::ResultListener::Reset() {
   on_success_cb = nullptr;
+  on_resume_cb = nullptr;
   on_failure_cb = nullptr;
 }
 
@@ -15,12 +15,15 @@
 #ifndef CORE_INTERNAL_ENCRYPTION_RUNNER_H_
 #define CORE_INTERNAL_ENCRYPTION_RUNNER_H_
 
+#include <memory>
 #include <string>
 
+#include "securegcm/d2d_connection_context_v1.h"
 #include "securegcm/ukey2_handshake.h"
 #include "absl/functional/any_invocable.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
+#include "connections/implementation/ukey2_session_cache.h"
 #include "connections/listeners.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/scheduled_executor.h"
@@ -31,12 +34,18 @@ namespace connections {
 
 // Encrypts a connection over UKEY2.
 //
+// Given a Ukey2SessionCache, a channel to an endpoint that was encrypted before
+// may instead be resumed from the cached ticket in one round trip, falling
+// back to a full UKEY2 handshake if the other side no longer has the ticket.
+//
 // NOTE: Stalled EndpointChannels will be disconnected after kTimeout.
 // This is to prevent unverified endpoints from maintaining an
 // indefinite connection to us.
 class EncryptionRunner {
  public:
   EncryptionRunner() = default;
+  explicit EncryptionRunner(Ukey2SessionCache* session_cache)
+      : session_cache_(session_cache) {}
   ~EncryptionRunner();
 
   struct ResultListener {
@@ -44,6 +53,9 @@ class EncryptionRunner {
                              std::unique_ptr<securegcm::UKey2Handshake> ukey2,
                              const std::string& auth_token,
                              const ByteArray& raw_auth_token);
+    void CallResumeCallback(
+        const std::string& endpoint_id,
+        std::unique_ptr<securegcm::D2DConnectionContextV1> context);
     void CallFailureCallback(const std::string& endpoint_id,
                              EndpointChannel* channel);
     void Reset();
@@ -55,6 +67,16 @@ class EncryptionRunner {
                             const ByteArray& raw_auth_token) &&>
         on_success_cb;
 
+    // The channel was encrypted by resuming an earlier session with the same
+    // endpoint, so there is no handshake to verify. Resumption is only tried
+    // when this is set, i.e. by callers whose peers were already verified.
+    //
+    // @EncryptionRunnerThread
+    absl::AnyInvocable<void(
+        const std::string& endpoint_id,
+        std::unique_ptr<securegcm::D2DConnectionContextV1> context) &&>
+        on_resume_cb = nullptr;
+
     // Encryption has failed. The remote_endpoint_id and channel are given so
     // that any pending state can be cleaned up.
     //
@@ -79,6 +101,7 @@ class EncryptionRunner {
                    ResultListener result_listener);
 
  private:
+  Ukey2SessionCache* const session_cache_ = nullptr;
   ScheduledExecutor alarm_executor_;
   SingleThreadExecutor server_executor_;
   SingleThreadExecutor client_executor_;
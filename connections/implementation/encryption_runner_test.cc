@@ -15,13 +15,16 @@
 #include "connections/implementation/encryption_runner.h"
 
 #include <cstddef>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "gtest/gtest.h"
 #include "absl/time/time.h"
 #include "connections/implementation/analytics/analytics_recorder.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
+#include "connections/implementation/ukey2_session_cache.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
@@ -30,6 +33,7 @@
 #include "internal/platform/pipe.h"
 #include "internal/platform/system_clock.h"
 #include "proto/connections_enums.pb.h"
+#include "securegcm/d2d_connection_context_v1.h"
 #include "third_party/ukey2/src/main/cpp/include/securegcm/ukey2_handshake.h"
 
 namespace nearby {
@@ -120,6 +124,7 @@ struct Response {
     kUnknown = 0,
     kDone = 1,
     kFailed = 2,
+    kResumed = 3,
   };
 
   CountDownLatch latch{2};
@@ -179,6 +184,119 @@ TEST(EncryptionRunnerTest, ReadWrite) {
   EXPECT_EQ(response.client_status, Response::Status::kDone);
 }
 
+// Caches the same session on both sides, as if A and B had connected before.
+void PrimeSessionCaches(Ukey2SessionCache& cache_a,
+                        Ukey2SessionCache& cache_b) {
+  auto initiator = securegcm::UKey2Handshake::ForInitiator(
+      securegcm::UKey2Handshake::HandshakeCipher::P256_SHA512);
+  auto responder = securegcm::UKey2Handshake::ForResponder(
+      securegcm::UKey2Handshake::HandshakeCipher::P256_SHA512);
+  responder->ParseHandshakeMessage(*initiator->GetNextHandshakeMessage());
+  initiator->ParseHandshakeMessage(*responder->GetNextHandshakeMessage());
+  responder->ParseHandshakeMessage(*initiator->GetNextHandshakeMessage());
+  initiator->GetVerificationString(32);
+  responder->GetVerificationString(32);
+  ASSERT_TRUE(initiator->VerifyHandshake());
+  ASSERT_TRUE(responder->VerifyHandshake());
+  cache_a.Put("endpoint_id", *responder->ToConnectionContext());
+  cache_b.Put("endpoint_id", *initiator->ToConnectionContext());
+}
+
+EncryptionRunner::ResultListener RecordResult(
+    Response& response, Response::Status& status,
+    std::unique_ptr<securegcm::D2DConnectionContextV1>& resumed_context) {
+  return {
+      .on_success_cb =
+          [&response, &status](const std::string& endpoint_id,
+                               std::unique_ptr<securegcm::UKey2Handshake> ukey2,
+                               const std::string& auth_token,
+                               const ByteArray& raw_auth_token) {
+            status = Response::Status::kDone;
+            response.latch.CountDown();
+          },
+      .on_resume_cb =
+          [&response, &status, &resumed_context](
+              const std::string& endpoint_id,
+              std::unique_ptr<securegcm::D2DConnectionContextV1> context) {
+            resumed_context = std::move(context);
+            status = Response::Status::kResumed;
+            response.latch.CountDown();
+          },
+      .on_failure_cb =
+          [&response, &status](const std::string& endpoint_id,
+                               EndpointChannel* channel) {
+            status = Response::Status::kFailed;
+            response.latch.CountDown();
+          },
+  };
+}
+
+TEST(EncryptionRunnerTest, ResumesCachedSession) {
+  auto from_a_to_b = CreatePipe();
+  auto from_b_to_a = CreatePipe();
+  User user_a(/*reader=*/from_b_to_a.first.get(),
+              /*writer=*/from_a_to_b.second.get());
+  User user_b(/*reader=*/from_a_to_b.first.get(),
+              /*writer=*/from_b_to_a.second.get());
+  Ukey2SessionCache cache_a(/*max_entries=*/4, absl::Minutes(1));
+  Ukey2SessionCache cache_b(/*max_entries=*/4, absl::Minutes(1));
+  PrimeSessionCaches(cache_a, cache_b);
+  EncryptionRunner crypto_a(&cache_a);
+  EncryptionRunner crypto_b(&cache_b);
+  Response response;
+  std::unique_ptr<securegcm::D2DConnectionContextV1> context_a;
+  std::unique_ptr<securegcm::D2DConnectionContextV1> context_b;
+
+  crypto_a.StartServer(
+      &user_a.client, "endpoint_id", &user_a.channel,
+      RecordResult(response, response.server_status, context_a));
+  crypto_b.StartClient(
+      &user_b.client, "endpoint_id", &user_b.channel,
+      RecordResult(response, response.client_status, context_b));
+
+  EXPECT_TRUE(response.latch.Await(absl::Milliseconds(5000)).result());
+  ASSERT_EQ(response.server_status, Response::Status::kResumed);
+  ASSERT_EQ(response.client_status, Response::Status::kResumed);
+  std::unique_ptr<std::string> message =
+      context_b->EncodeMessageToPeer("client to server");
+  ASSERT_NE(message, nullptr);
+  std::unique_ptr<std::string> decoded =
+      context_a->DecodeMessageFromPeer(*message);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_EQ(*decoded, "client to server");
+}
+
+TEST(EncryptionRunnerTest, FallsBackToHandshakeWhenServerHasNoTicket) {
+  auto from_a_to_b = CreatePipe();
+  auto from_b_to_a = CreatePipe();
+  User user_a(/*reader=*/from_b_to_a.first.get(),
+              /*writer=*/from_a_to_b.second.get());
+  User user_b(/*reader=*/from_a_to_b.first.get(),
+              /*writer=*/from_b_to_a.second.get());
+  Ukey2SessionCache cache_a(/*max_entries=*/4, absl::Minutes(1));
+  Ukey2SessionCache cache_b(/*max_entries=*/4, absl::Minutes(1));
+  PrimeSessionCaches(cache_a, cache_b);
+  cache_a.Remove("endpoint_id");
+  EncryptionRunner crypto_a(&cache_a);
+  EncryptionRunner crypto_b(&cache_b);
+  Response response;
+  std::unique_ptr<securegcm::D2DConnectionContextV1> context_a;
+  std::unique_ptr<securegcm::D2DConnectionContextV1> context_b;
+
+  crypto_a.StartServer(
+      &user_a.client, "endpoint_id", &user_a.channel,
+      RecordResult(response, response.server_status, context_a));
+  crypto_b.StartClient(
+      &user_b.client, "endpoint_id", &user_b.channel,
+      RecordResult(response, response.client_status, context_b));
+
+  EXPECT_TRUE(response.latch.Await(absl::Milliseconds(5000)).result());
+  EXPECT_EQ(response.server_status, Response::Status::kDone);
+  EXPECT_EQ(response.client_status, Response::Status::kDone);
+  // The stale ticket is not offered again.
+  EXPECT_FALSE(cache_b.Get("endpoint_id").has_value());
+}
+
 }  // namespace
 }  // namespace connections
 }  // namespace nearby
@@ -122,6 +122,10 @@ class EndpointChannel {
 
   // Enables the multiplex socket on the EndpointChannel.
   virtual bool EnableMultiplexSocket() {return false;}
+
+  // True if a Write() on this EndpointChannel is in progress or waiting to
+  // get to the stream.
+  virtual bool IsWriting() const { return false; }
 };
 
 inline bool operator==(const EndpointChannel& lhs, const EndpointChannel& rhs) {
@@ -73,6 +73,9 @@ void EndpointChannelManager::ReplaceChannelForEndpoint(
 bool EndpointChannelManager::EncryptChannelForEndpoint(
     const std::string& endpoint_id,
     std::unique_ptr<EncryptionContext> context) {
+  if (context != nullptr) {
+    session_cache_.Put(endpoint_id, *context);
+  }
   MutexLock lock(&mutex_);
 
   channel_state_.UpdateEncryptionContextForEndpoint(endpoint_id,
@@ -81,6 +84,86 @@ bool EndpointChannelManager::EncryptChannelForEndpoint(
   return channel_state_.EncryptChannel(endpoint);
 }
 
+void EndpointChannelManager::SetStandbyChannelForEndpoint(
+    const std::string& endpoint_id, std::shared_ptr<EndpointChannel> channel) {
+  MutexLock lock(&mutex_);
+
+  auto* endpoint = channel_state_.LookupEndpointData(endpoint_id);
+  if (endpoint == nullptr) {
+    NEARBY_LOGS(INFO) << "No channel info for endpoint " << endpoint_id
+                      << ", closing its standby channel.";
+    channel->Close(DisconnectionReason::UPGRADED);
+    return;
+  }
+  if (endpoint->standby_channel != nullptr) {
+    endpoint->standby_channel->Close(DisconnectionReason::UPGRADED);
+  }
+  // The standby is re-keyed before it carries traffic again, so it must not
+  // keep the sequence numbers of the active channel's context.
+  channel->DisableEncryption();
+  NEARBY_LOGS(INFO) << "EndpointChannelManager keeps channel of type "
+                    << channel->GetType() << " as standby for endpoint "
+                    << endpoint_id;
+  endpoint->standby_channel = std::move(channel);
+}
+
+std::shared_ptr<EndpointChannel>
+EndpointChannelManager::GetStandbyChannelForEndpoint(
+    const std::string& endpoint_id) {
+  MutexLock lock(&mutex_);
+
+  auto* endpoint = channel_state_.LookupEndpointData(endpoint_id);
+  if (endpoint == nullptr) return {};
+  return endpoint->standby_channel;
+}
+
+void EndpointChannelManager::DropStandbyChannelForEndpoint(
+    const std::string& endpoint_id) {
+  MutexLock lock(&mutex_);
+
+  auto* endpoint = channel_state_.LookupEndpointData(endpoint_id);
+  if (endpoint == nullptr || endpoint->standby_channel == nullptr) return;
+  endpoint->standby_channel->Close(
+      DisconnectionReason::PREV_CHANNEL_DISCONNECTION_IN_RECONNECT);
+  endpoint->standby_channel.reset();
+}
+
+bool EndpointChannelManager::FailOverToStandbyChannel(
+    ClientProxy* client, const std::string& endpoint_id,
+    std::unique_ptr<EncryptionContext> context) {
+  MutexLock lock(&mutex_);
+
+  auto* endpoint = channel_state_.LookupEndpointData(endpoint_id);
+  if (endpoint == nullptr || endpoint->standby_channel == nullptr) {
+    NEARBY_LOGS(INFO) << "No standby channel to fail over to for endpoint "
+                      << endpoint_id;
+    return false;
+  }
+  if (context == nullptr && endpoint->IsEncrypted()) {
+    NEARBY_LOGS(INFO) << "No fresh encryption context to fail over to the "
+                         "standby channel of endpoint "
+                      << endpoint_id;
+    return false;
+  }
+  if (endpoint->channel != nullptr) {
+    endpoint->channel->Close(
+        DisconnectionReason::PREV_CHANNEL_DISCONNECTION_IN_RECONNECT);
+  }
+  std::shared_ptr<EndpointChannel> standby_channel =
+      std::move(endpoint->standby_channel);
+  NEARBY_LOGS(INFO) << "EndpointChannelManager failed over to channel of type "
+                    << standby_channel->GetType() << " for endpoint "
+                    << endpoint_id;
+  if (context != nullptr) {
+    session_cache_.Put(endpoint_id, *context);
+    channel_state_.UpdateEncryptionContextForEndpoint(endpoint_id,
+                                                      std::move(context));
+  }
+  SetActiveEndpointChannel(client, endpoint_id, std::move(standby_channel),
+                           /*enable_encryption=*/true);
+  return true;
+}
+
 std::shared_ptr<EndpointChannel> EndpointChannelManager::GetChannelForEndpoint(
     const std::string& endpoint_id) {
   MutexLock lock(&mutex_);
@@ -96,7 +179,7 @@ std::shared_ptr<EndpointChannel> EndpointChannelManager::GetChannelForEndpoint(
 
 void EndpointChannelManager::SetActiveEndpointChannel(
     ClientProxy* client, const std::string& endpoint_id,
-    std::unique_ptr<EndpointChannel> channel, bool enable_encryption) {
+    std::shared_ptr<EndpointChannel> channel, bool enable_encryption) {
   // Update the channel first, then encrypt this new channel, if
   // crypto context is present.
   channel->SetAnalyticsRecorder(&client->GetAnalyticsRecorder(), endpoint_id);
@@ -180,7 +263,7 @@ void EndpointChannelManager::ChannelState::DestroyAll() {
 }
 
 void EndpointChannelManager::ChannelState::UpdateChannelForEndpoint(
-    const std::string& endpoint_id, std::unique_ptr<EndpointChannel> channel) {
+    const std::string& endpoint_id, std::shared_ptr<EndpointChannel> channel) {
   // Create EndpointData instance, if necessary, and populate channel.
   endpoints_[endpoint_id].channel = std::move(channel);
 }
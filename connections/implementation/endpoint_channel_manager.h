@@ -25,6 +25,7 @@
 #include "absl/time/time.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
+#include "connections/implementation/ukey2_session_cache.h"
 #include "internal/platform/feature_flags.h"
 #include "internal/platform/mutex.h"
 #include "internal/proto/analytics/connections_log.pb.h"
@@ -74,10 +75,40 @@ class EndpointChannelManager final {
                                  bool enable_encryption)
       ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // Also remembers a resumption ticket for the new session, see
+  // GetUkey2SessionCache().
   bool EncryptChannelForEndpoint(const std::string& endpoint_id,
                                  std::unique_ptr<EncryptionContext> context)
       ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // Tickets for resuming the sessions of recently encrypted endpoints.
+  Ukey2SessionCache& GetUkey2SessionCache() { return session_cache_; }
+
+  // Keeps |channel| as an idle, already connected standby for the endpoint,
+  // closing any earlier standby. The standby is kept unencrypted, and nothing
+  // reads from or writes to it until FailOverToStandbyChannel() makes it the
+  // active channel.
+  void SetStandbyChannelForEndpoint(const std::string& endpoint_id,
+                                    std::shared_ptr<EndpointChannel> channel)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the standby channel for the endpoint, or nullptr if it has none.
+  std::shared_ptr<EndpointChannel> GetStandbyChannelForEndpoint(
+      const std::string& endpoint_id) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Closes and forgets the standby channel for the endpoint, if any.
+  void DropStandbyChannelForEndpoint(const std::string& endpoint_id)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Closes the active channel of the endpoint and makes its standby channel
+  // the active one, encrypted with |context|, a context freshly negotiated over
+  // the standby. Returns false, and changes nothing, if the endpoint has no
+  // standby channel, or is encrypted and |context| is null.
+  bool FailOverToStandbyChannel(ClientProxy* client,
+                                const std::string& endpoint_id,
+                                std::unique_ptr<EncryptionContext> context)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
   // NOTE(shared_ptr<> usage):
   //
   // EndpointChannelManager is holding an EndpointChannel instance;
@@ -138,12 +169,17 @@ class EndpointChannelManager final {
         if (channel != nullptr) {
           channel->Close(disconnect_reason);
         }
+        if (standby_channel != nullptr) {
+          standby_channel->Close(disconnect_reason);
+        }
       }
 
       // True if we have a 'context' for the endpoint.
       bool IsEncrypted() const { return context != nullptr; }
 
       std::shared_ptr<EndpointChannel> channel;
+      // An idle channel to fail over to if |channel| drops.
+      std::shared_ptr<EndpointChannel> standby_channel;
       std::shared_ptr<EncryptionContext> context;
       DisconnectionReason disconnect_reason =
           DisconnectionReason::UNKNOWN_DISCONNECTION_REASON;
@@ -171,7 +207,7 @@ class EndpointChannelManager final {
     // Stores a new EndpointChannel for the endpoint.
     // Prevoius one is destroyed, if it existed.
     void UpdateChannelForEndpoint(const std::string& endpoint_id,
-                                  std::unique_ptr<EndpointChannel> channel);
+                                  std::shared_ptr<EndpointChannel> channel);
 
     // Stores a new EncryptionContext for the endpoint.
     // Prevoius one is destroyed, if it existed.
@@ -209,12 +245,15 @@ class EndpointChannelManager final {
 
   void SetActiveEndpointChannel(ClientProxy* client,
                                 const std::string& endpoint_id,
-                                std::unique_ptr<EndpointChannel> channel,
+                                std::shared_ptr<EndpointChannel> channel,
                                 bool enable_encryption)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   mutable Mutex mutex_;
   ChannelState channel_state_;
+  Ukey2SessionCache session_cache_{
+      FeatureFlags::GetInstance().GetFlags().max_ukey2_session_tickets,
+      FeatureFlags::GetInstance().GetFlags().ukey2_session_ticket_lifetime};
 };
 
 }  // namespace connections
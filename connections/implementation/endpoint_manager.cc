@@ -27,10 +27,12 @@
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
 #include "connections/implementation/endpoint_channel_manager.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames.h"
 #include "connections/implementation/payload_manager.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/implementation/service_id_constants.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
@@ -352,6 +354,29 @@ ExceptionOr<bool> EndpointManager::HandleKeepAlive(
     EndpointChannel* endpoint_channel, absl::Duration keep_alive_interval,
     absl::Duration keep_alive_timeout, Mutex* keep_alive_waiter_mutex,
     ConditionVariable* keep_alive_waiter) {
+  ExceptionOr<absl::Duration> wait_for = SendKeepAliveIfDue(
+      endpoint_channel, keep_alive_interval, keep_alive_timeout);
+  if (!wait_for.ok()) {
+    return ExceptionOr<bool>(wait_for.GetException());
+  }
+  if (wait_for.result() <= absl::ZeroDuration()) {
+    return ExceptionOr<bool>(false);
+  }
+
+  {
+    MutexLock lock(keep_alive_waiter_mutex);
+    Exception wait_exception = keep_alive_waiter->Wait(wait_for.result());
+    if (!wait_exception.Ok()) {
+      return ExceptionOr<bool>(wait_exception);
+    }
+  }
+
+  return ExceptionOr<bool>(true);
+}
+
+absl::Duration EndpointManager::GetKeepAliveDeadlines(
+    EndpointChannel* endpoint_channel, absl::Duration keep_alive_interval,
+    absl::Duration keep_alive_timeout, absl::Duration* until_keep_alive) {
   // Check if it has been too long since we received a frame from our endpoint.
   absl::Time last_read_time = endpoint_channel->GetLastReadTimestamp();
   absl::Duration duration_until_timeout =
@@ -360,38 +385,144 @@ ExceptionOr<bool> EndpointManager::HandleKeepAlive(
           : last_read_time + keep_alive_timeout -
                 SystemClock::ElapsedRealtime();
   if (duration_until_timeout <= absl::ZeroDuration()) {
-    return ExceptionOr<bool>(false);
+    return absl::ZeroDuration();
+  }
+
+  absl::Time last_write_time = endpoint_channel->GetLastWriteTimestamp();
+  *until_keep_alive = last_write_time == kInvalidTimestamp
+                          ? keep_alive_interval
+                          : last_write_time + keep_alive_interval -
+                                SystemClock::ElapsedRealtime();
+  return duration_until_timeout;
+}
+
+ExceptionOr<absl::Duration> EndpointManager::SendKeepAliveIfDue(
+    EndpointChannel* endpoint_channel, absl::Duration keep_alive_interval,
+    absl::Duration keep_alive_timeout) {
+  absl::Duration duration_until_write_keep_alive;
+  absl::Duration duration_until_timeout =
+      GetKeepAliveDeadlines(endpoint_channel, keep_alive_interval,
+                            keep_alive_timeout, &duration_until_write_keep_alive);
+  if (duration_until_timeout <= absl::ZeroDuration()) {
+    return ExceptionOr<absl::Duration>(absl::ZeroDuration());
   }
 
   // If we haven't written anything to the endpoint for a while, attempt to
   // send the KeepAlive frame over the endpoint channel. If the write fails,
   // our super class will loop back around and try our luck again in case
   // there's been a replacement for this endpoint.
-  absl::Time last_write_time = endpoint_channel->GetLastWriteTimestamp();
-  absl::Duration duration_until_write_keep_alive =
-      last_write_time == kInvalidTimestamp
-          ? keep_alive_interval
-          : last_write_time + keep_alive_interval -
-                SystemClock::ElapsedRealtime();
   if (duration_until_write_keep_alive <= absl::ZeroDuration()) {
     Exception write_exception = endpoint_channel->Write(parser::ForKeepAlive());
     if (!write_exception.Ok()) {
-      return ExceptionOr<bool>(write_exception);
+      return ExceptionOr<absl::Duration>(write_exception);
     }
     duration_until_write_keep_alive = keep_alive_interval;
   }
 
-  absl::Duration wait_for =
-      std::min(duration_until_timeout, duration_until_write_keep_alive);
+  return ExceptionOr<absl::Duration>(
+      std::min(duration_until_timeout, duration_until_write_keep_alive));
+}
+
+void EndpointManager::ScheduleKeepAliveTick(
+    std::shared_ptr<KeepAliveTimer> timer, ClientProxy* client,
+    const std::string& endpoint_id, absl::Duration keep_alive_interval,
+    absl::Duration keep_alive_timeout, absl::Duration delay) {
+  MutexLock lock(&timer->mutex);
+  if (timer->stopped) return;
+  timer->pending_tick = keep_alive_scheduler_->Schedule(
+      [this, timer, client, endpoint_id, keep_alive_interval,
+       keep_alive_timeout]() {
+        RunKeepAliveTick(timer, client, endpoint_id, keep_alive_interval,
+                         keep_alive_timeout);
+      },
+      delay);
+}
+
+// Mirrors one iteration of EndpointChannelLoopRunnable() running
+// HandleKeepAlive(), except that waiting happens on the scheduler instead of
+// on a condition variable owned by a dedicated thread. Runs on
+// |keep_alive_scheduler_| and never blocks on a write: the KeepAlive frame
+// goes out on |keep_alive_writers_|, and a failed write is picked up by the
+// next tick.
+void EndpointManager::RunKeepAliveTick(std::shared_ptr<KeepAliveTimer> timer,
+                                       ClientProxy* client,
+                                       const std::string& endpoint_id,
+                                       absl::Duration keep_alive_interval,
+                                       absl::Duration keep_alive_timeout) {
+  Medium last_failed_medium;
   {
-    MutexLock lock(keep_alive_waiter_mutex);
-    Exception wait_exception = keep_alive_waiter->Wait(wait_for);
-    if (!wait_exception.Ok()) {
-      return ExceptionOr<bool>(wait_exception);
+    MutexLock lock(&timer->mutex);
+    if (timer->stopped) return;
+    last_failed_medium =
+        std::exchange(timer->last_failed_medium, Medium::UNKNOWN_MEDIUM);
+  }
+
+  std::shared_ptr<EndpointChannel> channel =
+      channel_manager_->GetChannelForEndpoint(endpoint_id);
+  if (channel == nullptr) {
+    NEARBY_LOG(INFO, "Endpoint channel is nullptr, bail out.");
+  } else if (last_failed_medium != Medium::UNKNOWN_MEDIUM &&
+             channel->GetMedium() == last_failed_medium) {
+    NEARBY_LOG(INFO,
+               "No new endpoint channel is found after a failure, exit loop.");
+  } else {
+    absl::Duration until_keep_alive;
+    absl::Duration until_timeout =
+        GetKeepAliveDeadlines(channel.get(), keep_alive_interval,
+                              keep_alive_timeout, &until_keep_alive);
+    if (until_timeout > absl::ZeroDuration()) {
+      if (until_keep_alive <= absl::ZeroDuration()) {
+        StartKeepAliveWrite(timer, channel);
+        until_keep_alive = keep_alive_interval;
+      }
+      ScheduleKeepAliveTick(std::move(timer), client, endpoint_id,
+                            keep_alive_interval, keep_alive_timeout,
+                            std::min(until_timeout, until_keep_alive));
+      return;
+    }
+    NEARBY_LOGS(INFO) << "Dropping current channel: last medium="
+                      << location::nearby::proto::connections::Medium_Name(
+                             last_failed_medium);
+    if (client->IsSafeToDisconnectEnabled(endpoint_id)) {
+      channel_manager_->MarkEndpointStopWaitToDisconnect(
+          endpoint_id, /* is_safe_to_disconnect */ false,
+          /* notify_stop_waiting */ true);
     }
   }
 
-  return ExceptionOr<bool>(true);
+  NEARBY_LOGS(INFO) << "Keep-alive timer going down; endpoint_id="
+                    << endpoint_id;
+  DiscardEndpoint(client, endpoint_id, DisconnectionReason::IO_ERROR);
+}
+
+void EndpointManager::StartKeepAliveWrite(
+    const std::shared_ptr<KeepAliveTimer>& timer,
+    std::shared_ptr<EndpointChannel> channel) {
+  {
+    MutexLock lock(&timer->mutex);
+    // A write that is still in flight or already queued on the channel will
+    // refresh the write timestamp once it gets through; queueing a KeepAlive
+    // behind it would only tie up a shared writer on a stalled channel.
+    if (timer->write_in_flight || channel->IsWriting()) {
+      NEARBY_LOGS(VERBOSE) << "Channel busy, skipping KeepAlive write.";
+      return;
+    }
+    timer->write_in_flight = true;
+  }
+  keep_alive_writers_->Execute(
+      "keep-alive", [timer, channel = std::move(channel)]() {
+        Exception write_exception = channel->Write(parser::ForKeepAlive());
+        MutexLock lock(&timer->mutex);
+        if (!write_exception.Ok()) {
+          NEARBY_LOGS(INFO)
+              << "Endpoint channel IO exception; last_failed_medium="
+              << location::nearby::proto::connections::Medium_Name(
+                     channel->GetMedium());
+          timer->last_failed_medium = channel->GetMedium();
+        }
+        timer->write_in_flight = false;
+        timer->write_done.Notify();
+      });
 }
 
 bool operator==(const EndpointManager::FrameProcessor& lhs,
@@ -414,7 +545,15 @@ EndpointManager::EndpointManager(EndpointChannelManager* manager)
 EndpointManager::EndpointManager(
     EndpointChannelManager* manager,
     std::unique_ptr<SingleThreadExecutor> serial_executor)
-    : channel_manager_(manager), serial_executor_(std::move(serial_executor)) {}
+    : channel_manager_(manager), serial_executor_(std::move(serial_executor)) {
+  if (NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableEndpointReactor)) {
+    keep_alive_scheduler_ = std::make_unique<ScheduledExecutor>();
+    keep_alive_writers_ =
+        std::make_unique<MultiThreadExecutor>(kKeepAliveWriterThreads);
+  }
+}
 
 EndpointManager::~EndpointManager() {
   NEARBY_LOG(INFO, "Initiating shutdown of EndpointManager.");
@@ -433,6 +572,10 @@ EndpointManager::~EndpointManager() {
 
   NEARBY_LOG(INFO, "Bringing down control thread");
   serial_executor_->Shutdown();
+  if (keep_alive_scheduler_) {
+    keep_alive_scheduler_->Shutdown();
+    keep_alive_writers_->Shutdown();
+  }
   NEARBY_LOG(INFO, "EndpointManager is down");
 }
 
@@ -587,20 +730,28 @@ void EndpointManager::RegisterEndpoint(
     // listen for the pong.
     NEARBY_LOGS(VERBOSE) << "EndpointManager enabling KeepAlive for endpoint "
                          << endpoint_id;
-    endpoint_state.StartEndpointKeepAliveManager(
-        [this, client, endpoint_id, keep_alive_interval, keep_alive_timeout](
-            Mutex* keep_alive_waiter_mutex,
-            ConditionVariable* keep_alive_waiter) {
-          EndpointChannelLoopRunnable(
-              "KeepAliveManager", client, endpoint_id,
-              [this, keep_alive_interval, keep_alive_timeout,
-               keep_alive_waiter_mutex,
-               keep_alive_waiter](EndpointChannel* channel) {
-                return HandleKeepAlive(
-                    channel, keep_alive_interval, keep_alive_timeout,
-                    keep_alive_waiter_mutex, keep_alive_waiter);
-              });
-        });
+    if (keep_alive_scheduler_) {
+      auto timer = std::make_shared<KeepAliveTimer>();
+      endpoint_state.StartEndpointKeepAliveTimer(timer);
+      ScheduleKeepAliveTick(std::move(timer), client, endpoint_id,
+                            keep_alive_interval, keep_alive_timeout,
+                            absl::ZeroDuration());
+    } else {
+      endpoint_state.StartEndpointKeepAliveManager(
+          [this, client, endpoint_id, keep_alive_interval, keep_alive_timeout](
+              Mutex* keep_alive_waiter_mutex,
+              ConditionVariable* keep_alive_waiter) {
+            EndpointChannelLoopRunnable(
+                "KeepAliveManager", client, endpoint_id,
+                [this, keep_alive_interval, keep_alive_timeout,
+                 keep_alive_waiter_mutex,
+                 keep_alive_waiter](EndpointChannel* channel) {
+                  return HandleKeepAlive(
+                      channel, keep_alive_interval, keep_alive_timeout,
+                      keep_alive_waiter_mutex, keep_alive_waiter);
+                });
+          });
+    }
     NEARBY_LOGS(INFO) << "Registering endpoint " << endpoint_id
                       << ", workers started and notifying client.";
 
@@ -639,18 +790,19 @@ int EndpointManager::GetMaxTransmitPacketSize(const std::string& endpoint_id) {
 
 std::vector<std::string> EndpointManager::SendPayloadChunk(
     const PayloadTransferFrame::PayloadHeader& payload_header,
-    const PayloadTransferFrame::PayloadChunk& payload_chunk,
+    PayloadTransferFrame::PayloadChunk payload_chunk,
     const std::vector<std::string>& endpoint_ids,
-    PacketMetaData& packet_meta_data) {
+    PacketMetaData& packet_meta_data,
+    absl::flat_hash_map<std::string, absl::Duration>* write_latencies) {
+  std::int64_t offset = payload_chunk.offset();
   ByteArray bytes =
-      parser::ForDataPayloadTransfer(payload_header, payload_chunk);
+      parser::ForDataPayloadTransfer(payload_header, std::move(payload_chunk));
 
   return SendTransferFrameBytes(
-      endpoint_ids, bytes, payload_header.id(),
-      /*offset=*/payload_chunk.offset(),
+      endpoint_ids, bytes, payload_header.id(), offset,
       /*packet_type=*/
       PayloadTransferFrame::PacketType_Name(PayloadTransferFrame::DATA),
-      packet_meta_data);
+      packet_meta_data, write_latencies);
 }
 
 // Designed to run asynchronously. It is called from IO thread pools, and
@@ -919,11 +1071,26 @@ std::int64_t payload_id,
       packet_meta_data);
 }
 
+std::vector<std::string> EndpointManager::SendPayloadAck(
+    std::int64_t payload_id, std::int64_t received_offset,
+    const std::vector<std::string>& endpoint_ids) {
+  ByteArray bytes =
+      parser::ForPayloadAckPayloadTransfer(payload_id, received_offset);
+  PacketMetaData packet_meta_data;
+
+  return SendTransferFrameBytes(
+      endpoint_ids, bytes, payload_id, received_offset,
+      /*packet_type=*/
+      PayloadTransferFrame::PacketType_Name(PayloadTransferFrame::PAYLOAD_ACK),
+      packet_meta_data);
+}
+
 
 std::vector<std::string> EndpointManager::SendTransferFrameBytes(
     const std::vector<std::string>& endpoint_ids, const ByteArray& bytes,
     std::int64_t payload_id, std::int64_t offset,
-    const std::string& packet_type, PacketMetaData& packet_meta_data) {
+    const std::string& packet_type, PacketMetaData& packet_meta_data,
+    absl::flat_hash_map<std::string, absl::Duration>* write_latencies) {
   std::vector<std::string> failed_endpoint_ids;
   for (const std::string& endpoint_id : endpoint_ids) {
     std::shared_ptr<EndpointChannel> channel =
@@ -943,7 +1110,12 @@ std::vector<std::string> EndpointManager::SendTransferFrameBytes(
       continue;
     }
 
+    absl::Time write_start_time = SystemClock::ElapsedRealtime();
     Exception write_exception = channel->Write(bytes, packet_meta_data);
+    if (write_latencies != nullptr) {
+      (*write_latencies)[endpoint_id] =
+          SystemClock::ElapsedRealtime() - write_start_time;
+    }
     if (!write_exception.Ok()) {
       failed_endpoint_ids.push_back(endpoint_id);
       NEARBY_LOGS(INFO) << "Failed to send packet; endpoint_id=" << endpoint_id;
@@ -975,6 +1147,25 @@ EndpointManager::EndpointState::~EndpointState() {
     MutexLock lock(keep_alive_waiter_mutex_.get());
     keep_alive_waiter_->Notify();
   }
+
+  // Stop the keep-alive timer. Cancel() waits for a tick that is already
+  // running, so it must be called without holding the timer mutex. A write
+  // already handed to the writer pool is then waited for, as the dedicated
+  // keep-alive thread would be; the channel is closed by now, so it can't
+  // stay blocked.
+  if (keep_alive_timer_) {
+    Cancelable pending_tick;
+    {
+      MutexLock lock(&keep_alive_timer_->mutex);
+      keep_alive_timer_->stopped = true;
+      pending_tick = keep_alive_timer_->pending_tick;
+    }
+    pending_tick.Cancel();
+    MutexLock lock(&keep_alive_timer_->mutex);
+    while (keep_alive_timer_->write_in_flight) {
+      keep_alive_timer_->write_done.Wait();
+    }
+  }
 }
 
 void EndpointManager::EndpointState::StartEndpointReader(Runnable&& runnable) {
@@ -983,7 +1174,8 @@ void EndpointManager::EndpointState::StartEndpointReader(Runnable&& runnable) {
 
 void EndpointManager::EndpointState::StartEndpointKeepAliveManager(
     absl::AnyInvocable<void(Mutex*, ConditionVariable*)> runnable) {
-  keep_alive_thread_.Execute(
+  keep_alive_thread_ = std::make_unique<SingleThreadExecutor>();
+  keep_alive_thread_->Execute(
       "keep-alive", [runnable = std::move(runnable),
                      keep_alive_waiter_mutex = keep_alive_waiter_mutex_.get(),
                      keep_alive_waiter = keep_alive_waiter_.get()]() mutable {
@@ -991,6 +1183,11 @@ void EndpointManager::EndpointState::StartEndpointKeepAliveManager(
       });
 }
 
+void EndpointManager::EndpointState::StartEndpointKeepAliveTimer(
+    std::shared_ptr<KeepAliveTimer> timer) {
+  keep_alive_timer_ = std::move(timer);
+}
+
 void EndpointManager::RunOnEndpointManagerThread(const std::string& name,
                                                  Runnable runnable) {
   serial_executor_->Execute(name, std::move(runnable));
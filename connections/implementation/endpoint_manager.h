@@ -34,9 +34,13 @@
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/listeners.h"
 #include "internal/platform/byte_array.h"
+#include "internal/platform/cancelable.h"
 #include "internal/platform/condition_variable.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/multi_thread_executor.h"
+#include "internal/platform/mutex.h"
 #include "internal/platform/runnable.h"
+#include "internal/platform/scheduled_executor.h"
 #include "internal/platform/single_thread_executor.h"
 
 namespace nearby {
@@ -59,11 +63,24 @@ namespace connections {
 // chunks) originates on one of those threads before control is transferred over
 // to PayloadManager::ProcessFrame() (still running on that
 // same dedicated reader thread).
+//
+// Keep-alive is normally handled by a second dedicated thread per endpoint.
+// When the endpoint reactor is enabled (kEnableEndpointReactor), keep-alive for
+// all endpoints is instead driven by timers on a single shared scheduler, and
+// due KeepAlive frames are written out by a fixed pool of
+// kKeepAliveWriterThreads threads, so keep-alive no longer adds a thread per
+// endpoint. Timeouts are checked on the scheduler, so a stalled write never
+// delays them. An endpoint has at most one KeepAlive write in flight, and no
+// write is handed to the pool while its channel is already busy writing, so a
+// stalled channel doesn't tie up the writers the other endpoints rely on.
 
 class EndpointManager {
  public:
   using OfflineFrame = ::location::nearby::connections::OfflineFrame;
 
+  // Threads shared by all endpoints for reactor mode keep-alive writes.
+  static constexpr int kKeepAliveWriterThreads = 4;
+
   class FrameProcessor {
    public:
     virtual ~FrameProcessor() = default;
@@ -127,14 +144,19 @@ class EndpointManager {
 
   // Returns the list of endpoints to which sending this chunk failed.
   //
-  // Invoked from the PayloadManager's sendPayload() method.
+  // Invoked from the PayloadManager's sendPayload() method. The chunk body is
+  // moved into the outgoing frame, so callers should std::move() the chunk in.
+  // If |write_latencies| is set, it receives how long the write to each
+  // endpoint took.
   std::vector<std::string> SendPayloadChunk(
       const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
           payload_header,
-      const location::nearby::connections::PayloadTransferFrame::PayloadChunk&
+      location::nearby::connections::PayloadTransferFrame::PayloadChunk
           payload_chunk,
       const std::vector<std::string>& endpoint_ids,
-      analytics::PacketMetaData& packet_meta_data);
+      analytics::PacketMetaData& packet_meta_data,
+      absl::flat_hash_map<std::string, absl::Duration>* write_latencies =
+          nullptr);
   std::vector<std::string> SendControlMessage(
       const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
           payload_header,
@@ -145,6 +167,11 @@ class EndpointManager {
   // list of endpoints to which sending this frame failed.
   std::vector<std::string> SendPayloadAck(
       std::int64_t payload_id, const std::vector<std::string>& endpoint_ids);
+  // Receiver sends this frame every few chunks when windowed payload acks are
+  // enabled, carrying the number of payload bytes received so far.
+  std::vector<std::string> SendPayloadAck(
+      std::int64_t payload_id, std::int64_t received_offset,
+      const std::vector<std::string>& endpoint_ids);
   // Called when we internally want to get rid of the endpoint, without the
   // client directly telling us to. For example...
   //    a) We failed to read from the endpoint in its dedicated reader thread.
@@ -167,6 +194,24 @@ class EndpointManager {
                   std::unique_ptr<SingleThreadExecutor> serial_executor);
 
  private:
+  // Keep-alive timer shared between an EndpointState and the ticks it
+  // schedules on |keep_alive_scheduler_|. Ticks hold a reference, so the timer
+  // outlives the EndpointState if a tick is still running when it goes away.
+  struct KeepAliveTimer {
+    Mutex mutex;
+    bool stopped ABSL_GUARDED_BY(mutex) = false;
+    Cancelable pending_tick ABSL_GUARDED_BY(mutex);
+    // True while a KeepAlive write handed to |keep_alive_writers_| hasn't
+    // finished. The EndpointState waits for it before going away.
+    bool write_in_flight ABSL_GUARDED_BY(mutex) = false;
+    ConditionVariable write_done{&mutex};
+    // Medium of the channel the last KeepAlive write failed on, checked by the
+    // next tick in case the channel has been replaced since.
+    location::nearby::proto::connections::Medium last_failed_medium
+        ABSL_GUARDED_BY(mutex) =
+            location::nearby::proto::connections::UNKNOWN_MEDIUM;
+  };
+
   class EndpointState {
    public:
     EndpointState(const std::string& endpoint_id,
@@ -188,7 +233,8 @@ class EndpointManager {
           keep_alive_waiter_mutex_{
               std::exchange(other.keep_alive_waiter_mutex_, nullptr)},
           keep_alive_waiter_{std::exchange(other.keep_alive_waiter_, nullptr)},
-          keep_alive_thread_{std::move(other.keep_alive_thread_)} {}
+          keep_alive_thread_{std::move(other.keep_alive_thread_)},
+          keep_alive_timer_{std::move(other.keep_alive_timer_)} {}
     EndpointState& operator=(const EndpointState&) = delete;
     EndpointState&& operator=(EndpointState&&) = delete;
     ~EndpointState();
@@ -196,6 +242,9 @@ class EndpointManager {
     void StartEndpointReader(Runnable&& runnable);
     void StartEndpointKeepAliveManager(
         absl::AnyInvocable<void(Mutex*, ConditionVariable*)> runnable);
+    // Reactor mode replacement for StartEndpointKeepAliveManager(). The timer
+    // is stopped when this EndpointState is destroyed.
+    void StartEndpointKeepAliveTimer(std::shared_ptr<KeepAliveTimer> timer);
 
    private:
     const std::string endpoint_id_;
@@ -209,7 +258,9 @@ class EndpointManager {
     // std::move operations.
     mutable std::unique_ptr<Mutex> keep_alive_waiter_mutex_;
     std::unique_ptr<ConditionVariable> keep_alive_waiter_;
-    SingleThreadExecutor keep_alive_thread_;
+    // Only created when keep-alive runs on a dedicated thread.
+    std::unique_ptr<SingleThreadExecutor> keep_alive_thread_;
+    std::shared_ptr<KeepAliveTimer> keep_alive_timer_;
   };
 
   // RAII accessor for FrameProcessor
@@ -241,6 +292,40 @@ class EndpointManager {
                                     Mutex* keep_alive_waiter_mutex,
                                     ConditionVariable* keep_alive_waiter);
 
+  // Returns how long until |endpoint_channel| times out, or a zero duration if
+  // it has been silent for longer than |keep_alive_timeout|. Sets
+  // |until_keep_alive| to how long until a KeepAlive frame is due.
+  absl::Duration GetKeepAliveDeadlines(EndpointChannel* endpoint_channel,
+                                       absl::Duration keep_alive_interval,
+                                       absl::Duration keep_alive_timeout,
+                                       absl::Duration* until_keep_alive);
+
+  // Sends a KeepAlive frame if one is due and returns how long to wait before
+  // the next check. Returns a zero duration if the endpoint has been silent
+  // for longer than |keep_alive_timeout|.
+  ExceptionOr<absl::Duration> SendKeepAliveIfDue(
+      EndpointChannel* endpoint_channel, absl::Duration keep_alive_interval,
+      absl::Duration keep_alive_timeout);
+
+  // Reactor mode counterpart of the KeepAliveManager EndpointChannelLoopRunnable:
+  // runs one keep-alive check on |keep_alive_scheduler_| after |delay| and
+  // either schedules the next one or discards the endpoint. Due KeepAlive
+  // frames are written on |keep_alive_writers_|.
+  void ScheduleKeepAliveTick(std::shared_ptr<KeepAliveTimer> timer,
+                             ClientProxy* client,
+                             const std::string& endpoint_id,
+                             absl::Duration keep_alive_interval,
+                             absl::Duration keep_alive_timeout,
+                             absl::Duration delay);
+  void RunKeepAliveTick(std::shared_ptr<KeepAliveTimer> timer,
+                        ClientProxy* client, const std::string& endpoint_id,
+                        absl::Duration keep_alive_interval,
+                        absl::Duration keep_alive_timeout);
+  // Hands a KeepAlive write for |channel| to |keep_alive_writers_|, unless one
+  // is still in flight or the channel is already busy writing.
+  void StartKeepAliveWrite(const std::shared_ptr<KeepAliveTimer>& timer,
+                           std::shared_ptr<EndpointChannel> channel);
+
   // Waits for a given endpoint EndpointChannelLoopRunnable() workers to
   // terminate.
   // Is called from RegisterEndpoint to avoid races; also called from
@@ -285,7 +370,9 @@ class EndpointManager {
       const std::vector<std::string>& endpoint_ids,
       const ByteArray& payload_transfer_frame_bytes, std::int64_t payload_id,
       std::int64_t offset, const std::string& packet_type,
-      analytics::PacketMetaData& packet_meta_data);
+      analytics::PacketMetaData& packet_meta_data,
+      absl::flat_hash_map<std::string, absl::Duration>* write_latencies =
+          nullptr);
 
   // Executes all jobs sequentially, on a serial_executor_.
   void RunOnEndpointManagerThread(const std::string& name, Runnable runnable);
@@ -315,6 +402,13 @@ class EndpointManager {
   bool is_shutdown_ ABSL_GUARDED_BY(mutex_) = false;
 
   std::unique_ptr<SingleThreadExecutor> serial_executor_;
+
+  // Drives keep-alive for every endpoint when the endpoint reactor is enabled;
+  // null otherwise. The scheduler only waits; checks that may block on a write
+  // run on |keep_alive_writers_|, so a stalled endpoint holds up at most one
+  // writer rather than every endpoint's timer.
+  std::unique_ptr<ScheduledExecutor> keep_alive_scheduler_;
+  std::unique_ptr<MultiThreadExecutor> keep_alive_writers_;
 };
 
 // Operator overloads when comparing FrameProcessor*.
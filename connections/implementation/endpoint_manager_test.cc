@@ -16,6 +16,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,6 +25,8 @@
 #include "gmock/gmock.h"
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -92,6 +95,7 @@ class MockEndpointChannel : public EndpointChannel {
   MOCK_METHOD(void, Resume, (), (override));
   MOCK_METHOD(absl::Time, GetLastReadTimestamp, (), (const override));
   MOCK_METHOD(absl::Time, GetLastWriteTimestamp, (), (const override));
+  MOCK_METHOD(bool, IsWriting, (), (const override));
   MOCK_METHOD(void, SetAnalyticsRecorder,
               (analytics::AnalyticsRecorder*, const std::string&), (override));
 
@@ -156,6 +160,8 @@ class TestEndpointManager : public EndpointManager {
 
 class EndpointManagerTest : public ::testing::Test {
  protected:
+  void TearDown() override { NearbyFlags::GetInstance().ResetOverridedValues(); }
+
   void RegisterEndpoint(std::unique_ptr<MockEndpointChannel> channel,
                         bool should_close = true) {
     CountDownLatch done(1);
@@ -177,6 +183,30 @@ class EndpointManagerTest : public ::testing::Test {
       EXPECT_TRUE(done.Await(absl::Milliseconds(1000)).result());
     }
   }
+  // Returns a channel that never receives data and calls |write| for every
+  // frame written to it.
+  std::unique_ptr<MockEndpointChannel> MakeIdleChannel(
+      std::function<Exception()> write) {
+    auto channel = std::make_unique<MockEndpointChannel>();
+    ON_CALL(*channel, Read(_)).WillByDefault([channel = channel.get()]() {
+      absl::SleepFor(absl::Milliseconds(10));
+      if (channel->IsClosed()) return ExceptionOr<ByteArray>(Exception::kIo);
+      return ExceptionOr<ByteArray>(ByteArray{});
+    });
+    EXPECT_CALL(*channel, Write(_))
+        .WillRepeatedly([write](const ByteArray& data) { return write(); });
+    ON_CALL(*channel, Close(_))
+        .WillByDefault([channel = channel.get()](DisconnectionReason reason) {
+          channel->DoClose();
+        });
+    EXPECT_CALL(*channel, GetMedium()).WillRepeatedly(Return(Medium::BLE));
+    EXPECT_CALL(*channel, GetLastReadTimestamp())
+        .WillRepeatedly(Return(start_time_));
+    EXPECT_CALL(*channel, GetLastWriteTimestamp())
+        .WillRepeatedly(Return(start_time_));
+    return channel;
+  }
+
   SetSafeToDisconnect set_safe_to_disconnect_{true, false, true, 5};
   std::unique_ptr<ClientProxy> client_ = std::make_unique<ClientProxy>();
   ConnectionOptions connection_options_{
@@ -350,6 +380,55 @@ TEST_F(EndpointManagerTest, SendControlMessageAndPayloadAckWorks) {
   NEARBY_LOG(INFO, "Will call destructors now");
 }
 
+TEST_F(EndpointManagerTest, SendPayloadChunkReportsWriteLatencyPerEndpoint) {
+  auto make_channel = [](absl::Duration write_delay) {
+    auto channel = std::make_unique<MockEndpointChannel>();
+    ON_CALL(*channel, Read(_)).WillByDefault([channel = channel.get()]() {
+      absl::SleepFor(absl::Milliseconds(10));
+      if (channel->IsClosed()) return ExceptionOr<ByteArray>(Exception::kIo);
+      return ExceptionOr<ByteArray>(ByteArray{});
+    });
+    ON_CALL(*channel, Close(_))
+        .WillByDefault([channel = channel.get()](DisconnectionReason reason) {
+          channel->DoClose();
+        });
+    EXPECT_CALL(*channel, Write(_, _))
+        .WillRepeatedly([write_delay](const ByteArray& data,
+                                      PacketMetaData& packet_meta_data) {
+          absl::SleepFor(write_delay);
+          return Exception{Exception::kSuccess};
+        });
+    EXPECT_CALL(*channel, GetMedium()).WillRepeatedly(Return(Medium::BLE));
+    return channel;
+  };
+  EXPECT_CALL(mock_listener_.initiated_cb, Call).Times(2);
+  em_.RegisterEndpoint(client_.get(), "slow", info_, connection_options_,
+                       make_channel(absl::Milliseconds(100)), listener_,
+                       connection_token_);
+  em_.RegisterEndpoint(client_.get(), "fast", info_, connection_options_,
+                       make_channel(absl::ZeroDuration()), listener_,
+                       connection_token_);
+  PayloadTransferFrame::PayloadHeader header;
+  header.set_id(12345);
+  header.set_type(PayloadTransferFrame::PayloadHeader::BYTES);
+  header.set_total_size(4);
+  PayloadTransferFrame::PayloadChunk chunk;
+  chunk.set_offset(0);
+  chunk.set_body("data");
+  PacketMetaData packet_meta_data;
+  absl::flat_hash_map<std::string, absl::Duration> write_latencies;
+
+  // Each endpoint gets the time of its own write, not of both writes.
+  EXPECT_TRUE(em_.SendPayloadChunk(header, chunk,
+                                   std::vector<std::string>{"slow", "fast"},
+                                   packet_meta_data, &write_latencies)
+                  .empty());
+  EXPECT_GE(write_latencies["slow"], absl::Milliseconds(100));
+  EXPECT_LT(write_latencies["fast"], absl::Milliseconds(100));
+  em_.UnregisterEndpoint(client_.get(), "slow");
+  em_.UnregisterEndpoint(client_.get(), "fast");
+}
+
 TEST_F(EndpointManagerTest, SingleReadOnReadError) {
   auto endpoint_channel = std::make_unique<MockEndpointChannel>();
   EXPECT_CALL(*endpoint_channel, Read(_))
@@ -458,6 +537,128 @@ TEST_F(EndpointManagerTest, TryDecrypt) {
   RegisterEndpoint(std::move(endpoint_channel));
 }
 
+TEST_F(EndpointManagerTest, EndpointReactorSendsKeepAliveAndTimesOut) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::kEnableEndpointReactor,
+      true);
+  EndpointChannelManager ecm;
+  EndpointManager em(&ecm);
+  CountDownLatch keep_alive_sent(1);
+  CountDownLatch closed(1);
+  auto endpoint_channel = std::make_unique<MockEndpointChannel>();
+  ON_CALL(*endpoint_channel, Read(_))
+      .WillByDefault([channel = endpoint_channel.get()]() {
+        absl::SleepFor(absl::Milliseconds(10));
+        if (channel->IsClosed()) return ExceptionOr<ByteArray>(Exception::kIo);
+        return ExceptionOr<ByteArray>(ByteArray{});
+      });
+  EXPECT_CALL(*endpoint_channel, Write(_))
+      .WillRepeatedly([&keep_alive_sent](const ByteArray& data) {
+        keep_alive_sent.CountDown();
+        return Exception{Exception::kSuccess};
+      });
+  EXPECT_CALL(*endpoint_channel, Close(_))
+      .WillRepeatedly([&closed, channel = endpoint_channel.get()](
+                          DisconnectionReason reason) {
+        channel->DoClose();
+        closed.CountDown();
+      });
+  EXPECT_CALL(*endpoint_channel, GetMedium())
+      .WillRepeatedly(Return(Medium::BLE));
+  EXPECT_CALL(*endpoint_channel, GetLastReadTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  EXPECT_CALL(*endpoint_channel, GetLastWriteTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  EXPECT_CALL(mock_listener_.initiated_cb, Call).Times(1);
+
+  // No frame is ever read from the peer, so the endpoint must be discarded
+  // once the keep-alive timeout expires.
+  em.RegisterEndpoint(client_.get(), endpoint_id_, info_,
+                      {
+                          .keep_alive_interval_millis = 20,
+                          .keep_alive_timeout_millis = 200,
+                      },
+                      std::move(endpoint_channel), listener_,
+                      connection_token_);
+
+  EXPECT_TRUE(keep_alive_sent.Await(absl::Milliseconds(1000)).result());
+  EXPECT_TRUE(closed.Await(absl::Milliseconds(1000)).result());
+}
+
+TEST_F(EndpointManagerTest, EndpointReactorStalledWriteDoesNotBlockOthers) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::kEnableEndpointReactor,
+      true);
+  EndpointChannelManager ecm;
+  EndpointManager em(&ecm);
+  CountDownLatch stalled_write_started(1);
+  CountDownLatch release_stalled_write(1);
+  CountDownLatch keep_alive_sent(1);
+  EXPECT_CALL(mock_listener_.initiated_cb, Call).Times(2);
+  ConnectionOptions options{
+      .keep_alive_interval_millis = 20,
+      .keep_alive_timeout_millis = 5000,
+  };
+
+  // The first endpoint's keep-alive write never returns until released.
+  em.RegisterEndpoint(
+      client_.get(), "stalled", info_, options,
+      MakeIdleChannel([&stalled_write_started, &release_stalled_write]() {
+        stalled_write_started.CountDown();
+        release_stalled_write.Await();
+        return Exception{Exception::kSuccess};
+      }),
+      listener_, connection_token_);
+  ASSERT_TRUE(stalled_write_started.Await(absl::Milliseconds(1000)).result());
+
+  em.RegisterEndpoint(client_.get(), endpoint_id_, info_, options,
+                      MakeIdleChannel([&keep_alive_sent]() {
+                        keep_alive_sent.CountDown();
+                        return Exception{Exception::kSuccess};
+                      }),
+                      listener_, connection_token_);
+
+  EXPECT_TRUE(keep_alive_sent.Await(absl::Milliseconds(1000)).result());
+  release_stalled_write.CountDown();
+}
+
+TEST_F(EndpointManagerTest, EndpointReactorSkipsKeepAliveOnBusyChannels) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::kEnableEndpointReactor,
+      true);
+  EndpointChannelManager ecm;
+  EndpointManager em(&ecm);
+  constexpr int kBusyEndpoints = EndpointManager::kKeepAliveWriterThreads + 1;
+  CountDownLatch keep_alive_sent(1);
+  EXPECT_CALL(mock_listener_.initiated_cb, Call).Times(kBusyEndpoints + 1);
+  ConnectionOptions options{
+      .keep_alive_interval_millis = 20,
+      .keep_alive_timeout_millis = 5000,
+  };
+
+  // More channels than there are keep-alive writers are stuck in a write of
+  // their own. None of them may take a writer, or the last endpoint would
+  // never get its KeepAlive out.
+  for (int i = 0; i < kBusyEndpoints; ++i) {
+    auto channel = MakeIdleChannel([]() {
+      ADD_FAILURE() << "KeepAlive written to a busy channel";
+      return Exception{Exception::kSuccess};
+    });
+    EXPECT_CALL(*channel, IsWriting()).WillRepeatedly(Return(true));
+    em.RegisterEndpoint(client_.get(), absl::StrCat("busy_", i), info_,
+                        options, std::move(channel), listener_,
+                        connection_token_);
+  }
+  em.RegisterEndpoint(client_.get(), endpoint_id_, info_, options,
+                      MakeIdleChannel([&keep_alive_sent]() {
+                        keep_alive_sent.CountDown();
+                        return Exception{Exception::kSuccess};
+                      }),
+                      listener_, connection_token_);
+
+  EXPECT_TRUE(keep_alive_sent.Await(absl::Milliseconds(1000)).result());
+}
+
 // Regression test for b/278729669.
 //
 // During the destruction of NearbyConnections, Core (which owns ClientProxy)
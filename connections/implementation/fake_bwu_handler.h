@@ -25,6 +25,7 @@
 #include "connections/implementation/bwu_manager.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/fake_endpoint_channel.h"
+#include "internal/platform/count_down_latch.h"
 
 namespace nearby {
 namespace connections {
@@ -61,6 +62,15 @@ class FakeBwuHandler : public BaseBwuHandler {
     return handle_revert_calls_;
   }
 
+  // Makes upgrade path setup fail.
+  void set_initialize_fails(bool fails) { initialize_fails_ = fails; }
+  // Makes upgrade path setup count down |started| and then wait for |release|.
+  void set_initialize_latches(CountDownLatch* started,
+                              CountDownLatch* release) {
+    initialize_started_ = started;
+    initialize_release_ = release;
+  }
+
   // Builds an incoming connection corresponding to
   // handle_initialize_calls()[initialize_call_index], and sends it to the
   // BwuManager. Return a pointer to the upgraded channel.
@@ -111,7 +121,12 @@ class FakeBwuHandler : public BaseBwuHandler {
     create_calls_.push_back({.client = client,
                              .service_id = service_id,
                              .endpoint_id = endpoint_id});
-    return std::make_unique<FakeEndpointChannel>(medium_, service_id);
+    // Simulate the remote device (BWU Initiator) acknowledging our
+    // BANDWIDTH_UPGRADE_NEGOTIATION.CLIENT_INTRODUCTION.
+    auto channel = std::make_unique<FakeEndpointChannel>(medium_, service_id);
+    channel->set_read_output(
+        ExceptionOr<ByteArray>(parser::ForBwuIntroductionAck()));
+    return channel;
   }
 
   Medium GetUpgradeMedium() const final { return medium_; }
@@ -128,6 +143,9 @@ class FakeBwuHandler : public BaseBwuHandler {
     handle_initialize_calls_.push_back({.client = client,
                                         .service_id = upgrade_service_id,
                                         .endpoint_id = endpoint_id});
+    if (initialize_started_ != nullptr) initialize_started_->CountDown();
+    if (initialize_release_ != nullptr) initialize_release_->Await();
+    if (initialize_fails_) return ByteArray{};
     switch (medium_) {
       case location::nearby::proto::connections::BLUETOOTH:
         return parser::ForBwuBluetoothPathAvailable(
@@ -167,6 +185,9 @@ class FakeBwuHandler : public BaseBwuHandler {
   }
 
   Medium medium_;
+  bool initialize_fails_ = false;
+  CountDownLatch* initialize_started_ = nullptr;
+  CountDownLatch* initialize_release_ = nullptr;
   std::vector<InputData> create_calls_;
   std::vector<InputData> disconnect_calls_;
   std::vector<InputData> handle_initialize_calls_;
@@ -90,6 +90,35 @@ constexpr auto kUseStableEndpointId =
 constexpr auto kDisableBluetoothClassicScanning =
     flags::Flag<bool>(kConfigPackage, "45639961", false);
 
+// When true, keep-alive for all endpoints is driven by timers on one shared
+// scheduler instead of a dedicated thread per endpoint.
+constexpr auto kEnableEndpointReactor =
+    flags::Flag<bool>(kConfigPackage, "45640101", false);
+
+// When true, payload chunk size is adapted per endpoint to the measured write
+// latency and throughput of its channel, instead of the medium's fixed size.
+constexpr auto kEnableAdaptiveChunkSize =
+    flags::Flag<bool>(kConfigPackage, "45640102", false);
+
+// When true, outgoing BYTES and FILE payloads to different endpoints are sent
+// concurrently, taking turns chunk by chunk, instead of one at a time per
+// payload type.
+constexpr auto kEnableParallelPayloadScheduler =
+    flags::Flag<bool>(kConfigPackage, "45640103", false);
+
+// When true, advertises windowed payload acks in the connection response:
+// the receiver acks every few chunks with the cumulative received offset,
+// letting the sender keep a window of chunks in flight. Used only if both
+// devices advertise it and payload-received-ack is enabled.
+constexpr auto kEnableWindowedPayloadAck =
+    flags::Flag<bool>(kConfigPackage, "45640104", false);
+
+// When true, advertises UKEY2 session resumption in the connection response,
+// so a reconnected channel can resume the earlier session instead of running
+// a full handshake. Used only if both devices advertise it.
+constexpr auto kEnableUkey2Resumption =
+    flags::Flag<bool>(kConfigPackage, "45640105", false);
+
 }  // namespace nearby_connections_feature
 }  // namespace config_package_nearby
 }  // namespace connections
@@ -14,6 +14,12 @@
 
 #include "connections/implementation/internal_payload.h"
 
+#include <cstdint>
+#include <utility>
+
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+
 namespace nearby {
 namespace connections {
 
@@ -27,5 +33,18 @@ Payload InternalPayload::ReleasePayload() { return std::move(payload_); }
 
 Payload::Id InternalPayload::GetId() const { return payload_id_; }
 
+Exception InternalPayload::AttachChunkAtOffset(std::int64_t offset,
+                                               const ByteArray& chunk,
+                                               bool is_last_chunk) {
+  Exception result = AttachNextChunk(chunk);
+  if (result.Raised()) return result;
+  contiguous_offset_ = offset + chunk.size();
+  if (is_last_chunk) {
+    if (!chunk.Empty()) result = AttachNextChunk(ByteArray());
+    last_chunk_end_ = contiguous_offset_;
+  }
+  return result;
+}
+
 }  // namespace connections
 }  // namespace nearby
@@ -84,6 +84,33 @@ class InternalPayload {
   // cleanup may be required by the concrete implementation.
   virtual Exception AttachNextChunk(const ByteArray& chunk) = 0;
 
+  // Adds the chunk that starts `offset` bytes into the Payload to which this
+  // object is bound.
+  //
+  // <p>Used instead of AttachNextChunk() when chunks may arrive out of order.
+  // Payload types that can reassemble by offset hold chunks that arrive ahead
+  // of a gap until the gap is filled; the rest attach every chunk as the next
+  // one.
+  // PayloadManager still attaches with AttachNextChunk(), as chunks only
+  // arrive out of order once a payload can be sent over several channels.
+  //
+  // @param offset The offset of the chunk, from PayloadChunk::offset.
+  // @param chunk The chunk; empty for the last chunk, as in AttachNextChunk().
+  // @param is_last_chunk Whether the chunk carried the LAST_CHUNK flag.
+  virtual Exception AttachChunkAtOffset(std::int64_t offset,
+                                        const ByteArray& chunk,
+                                        bool is_last_chunk);
+
+  // Returns the offset of the first byte not yet attached; every byte before
+  // it has been attached through AttachChunkAtOffset().
+  std::int64_t GetContiguousOffset() const { return contiguous_offset_; }
+
+  // Returns true once the last chunk has arrived and every byte before it has
+  // been attached through AttachChunkAtOffset().
+  bool IsComplete() const {
+    return last_chunk_end_ >= 0 && contiguous_offset_ == last_chunk_end_;
+  }
+
   // Skips current stream pointer to the offset.
   //
   // Used when this is a resume outgoing transfer, so we want to skip
@@ -102,6 +129,9 @@ class InternalPayload {
   // released to another owner during the lifetime of an incoming
   // InternalPayload.
   Payload::Id payload_id_;
+  std::int64_t contiguous_offset_ = 0;
+  // Offset just past the last chunk, or -1 until the last chunk arrives.
+  std::int64_t last_chunk_end_ = -1;
 };
 
 }  // namespace connections
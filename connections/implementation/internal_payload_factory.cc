@@ -16,6 +16,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -291,6 +292,49 @@ class IncomingFileInternalPayload : public InternalPayload {
     return output_file_.Write(chunk);
   }
 
+  Exception AttachChunkAtOffset(std::int64_t offset, const ByteArray& chunk,
+                                bool is_last_chunk) override {
+    std::int64_t chunk_end = offset + chunk.size();
+    if (offset < contiguous_offset_) {
+      NEARBY_LOGS(WARNING) << "Incoming file Payload " << this
+                           << " got a chunk at offset " << offset
+                           << " that was already written";
+      return {Exception::kIo};
+    }
+    // Nothing may follow the last chunk, nor may it arrive twice.
+    if (last_chunk_end_ >= 0 &&
+        (is_last_chunk || chunk_end > last_chunk_end_)) {
+      return {Exception::kIo};
+    }
+    if (is_last_chunk) {
+      if (!held_chunks_.empty() && held_chunks_.rbegin()->first >= chunk_end) {
+        return {Exception::kIo};
+      }
+      last_chunk_end_ = chunk_end;
+    }
+    if (offset > contiguous_offset_ && !chunk.Empty()) {
+      if (held_bytes_ + chunk.size() > kMaxHeldBytes ||
+          !held_chunks_.emplace(offset, chunk).second) {
+        return {Exception::kIo};
+      }
+      held_bytes_ += chunk.size();
+    } else if (offset == contiguous_offset_) {
+      Exception result = AttachInOrder(chunk);
+      // Write out whatever was waiting on this chunk.
+      for (auto it = held_chunks_.begin();
+           result.Ok() && it != held_chunks_.end() &&
+           it->first == contiguous_offset_;
+           it = held_chunks_.erase(it)) {
+        held_bytes_ -= it->second.size();
+        result = AttachInOrder(it->second);
+      }
+      if (result.Raised()) return result;
+    }
+    // Close the file once the last chunk and everything before it is written.
+    if (IsComplete()) return AttachNextChunk(ByteArray());
+    return {Exception::kSuccess};
+  }
+
   ExceptionOr<size_t> SkipToOffset(size_t offset) override {
     NEARBY_LOGS(WARNING) << "Cannot skip offset for an incoming file Payload "
                          << this;
@@ -300,8 +344,22 @@ class IncomingFileInternalPayload : public InternalPayload {
   void Close() override { output_file_.Close(); }
 
  private:
+  // Bounds the memory spent on chunks that arrived ahead of a gap.
+  static constexpr size_t kMaxHeldBytes = 16 * 1024 * 1024;
+
+  // Writes the chunk at `contiguous_offset_`.
+  Exception AttachInOrder(const ByteArray& chunk) {
+    if (chunk.Empty()) return {Exception::kSuccess};
+    Exception result = AttachNextChunk(chunk);
+    if (result.Ok()) contiguous_offset_ += chunk.size();
+    return result;
+  }
+
   OutputFile output_file_;
   const std::int64_t total_size_;
+  // Chunks that arrived ahead of a gap, keyed by offset.
+  std::map<std::int64_t, ByteArray> held_chunks_;
+  size_t held_bytes_ = 0;
 };
 
 }  // namespace
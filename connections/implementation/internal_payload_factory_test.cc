@@ -210,6 +210,126 @@ TEST(InternalPayloadFactoryTest,
   EXPECT_EQ(contents_after_skip, ByteArray("456789"));
 }
 
+TEST(InternalPayloadFactoryTest,
+     AttachChunkAtOffset_IncomingFilePayload_ReassemblesByOffset) {
+  PayloadTransferFrame frame;
+  frame.set_packet_type(PayloadTransferFrame::DATA);
+  auto& header = *frame.mutable_payload_header();
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_id(Payload::GenerateId());
+  header.set_total_size(10);
+  std::unique_ptr<InternalPayload> internal_payload =
+      CreateIncomingInternalPayload(frame, "");
+  ASSERT_NE(internal_payload, nullptr);
+
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(5, ByteArray("56789"), false)
+          .Ok());
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(10, ByteArray(), true).Ok());
+  EXPECT_FALSE(internal_payload->IsComplete());
+  EXPECT_EQ(internal_payload->GetContiguousOffset(), 0);
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(0, ByteArray("01234"), false)
+          .Ok());
+  EXPECT_TRUE(internal_payload->IsComplete());
+  EXPECT_EQ(internal_payload->GetContiguousOffset(), 10);
+
+  Payload payload = internal_payload->ReleasePayload();
+  ASSERT_NE(payload.AsFile(), nullptr);
+  EXPECT_EQ(payload.AsFile()->Read(10).result(), ByteArray("0123456789"));
+}
+
+TEST(InternalPayloadFactoryTest,
+     AttachChunkAtOffset_IncomingFilePayload_RejectsRewrittenOffset) {
+  PayloadTransferFrame frame;
+  frame.set_packet_type(PayloadTransferFrame::DATA);
+  auto& header = *frame.mutable_payload_header();
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_id(Payload::GenerateId());
+  header.set_total_size(10);
+  std::unique_ptr<InternalPayload> internal_payload =
+      CreateIncomingInternalPayload(frame, "");
+  ASSERT_NE(internal_payload, nullptr);
+
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(0, ByteArray("01234"), false)
+          .Ok());
+
+  EXPECT_TRUE(
+      internal_payload->AttachChunkAtOffset(0, ByteArray("01234"), false)
+          .Raised());
+  internal_payload->Close();
+}
+
+TEST(InternalPayloadFactoryTest,
+     AttachChunkAtOffset_IncomingStreamPayload_CompletesOnLastChunk) {
+  PayloadTransferFrame frame;
+  frame.set_packet_type(PayloadTransferFrame::DATA);
+  auto& header = *frame.mutable_payload_header();
+  header.set_type(PayloadTransferFrame::PayloadHeader::STREAM);
+  header.set_id(12345);
+  std::unique_ptr<InternalPayload> internal_payload =
+      CreateIncomingInternalPayload(frame, "");
+  ASSERT_NE(internal_payload, nullptr);
+
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(0, ByteArray(kText), false).Ok());
+  EXPECT_FALSE(internal_payload->IsComplete());
+  ASSERT_TRUE(internal_payload
+                  ->AttachChunkAtOffset(sizeof(kText) - 1, ByteArray(), true)
+                  .Ok());
+  EXPECT_TRUE(internal_payload->IsComplete());
+  EXPECT_EQ(internal_payload->GetContiguousOffset(), sizeof(kText) - 1);
+}
+
+TEST(InternalPayloadFactoryTest,
+     AttachChunkAtOffset_IncomingFilePayload_WaitsForLastChunk) {
+  PayloadTransferFrame frame;
+  frame.set_packet_type(PayloadTransferFrame::DATA);
+  auto& header = *frame.mutable_payload_header();
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_id(Payload::GenerateId());
+  header.set_total_size(10);
+  std::unique_ptr<InternalPayload> internal_payload =
+      CreateIncomingInternalPayload(frame, "");
+  ASSERT_NE(internal_payload, nullptr);
+
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(0, ByteArray("01234"), false)
+          .Ok());
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(5, ByteArray("56789"), false)
+          .Ok());
+  EXPECT_EQ(internal_payload->GetContiguousOffset(), 10);
+  EXPECT_FALSE(internal_payload->IsComplete());
+
+  ASSERT_TRUE(
+      internal_payload->AttachChunkAtOffset(10, ByteArray(), true).Ok());
+  EXPECT_TRUE(internal_payload->IsComplete());
+}
+
+TEST(InternalPayloadFactoryTest,
+     AttachChunkAtOffset_IncomingFilePayload_RejectsChunkPastLastChunk) {
+  PayloadTransferFrame frame;
+  frame.set_packet_type(PayloadTransferFrame::DATA);
+  auto& header = *frame.mutable_payload_header();
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_id(Payload::GenerateId());
+  header.set_total_size(10);
+  std::unique_ptr<InternalPayload> internal_payload =
+      CreateIncomingInternalPayload(frame, "");
+  ASSERT_NE(internal_payload, nullptr);
+
+  ASSERT_TRUE(internal_payload->AttachChunkAtOffset(5, ByteArray(), true).Ok());
+
+  EXPECT_TRUE(
+      internal_payload->AttachChunkAtOffset(5, ByteArray("56789"), false)
+          .Raised());
+  EXPECT_FALSE(internal_payload->IsComplete());
+  internal_payload->Close();
+}
+
 TEST(InternalPayloadFactoryTest,
      SkipToOffset_StreamPayloadValidOffset_SkipsOffset) {
   ByteArray contents("0123456789");
@@ -21,6 +21,7 @@
 
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "connections/implementation/mediums/multiplex/multiplex_frames.h"
 #include "internal/platform/array_blocking_queue.h"
 #include "internal/platform/atomic_boolean.h"
@@ -233,13 +234,9 @@ void MultiplexOutputStream::MultiplexWriter::StartWriting() {
 void MultiplexOutputStream::MultiplexWriter::Write(
     EnqueuedFrame& enqueued_frame) {
   MutexLock lock(&writer_mutex_);
-  if (!physical_writer_
-           ->Write(Base64Utils::IntToBytes(enqueued_frame.data_.size()))
-           .Ok()) {
-    enqueued_frame.future_->SetException({Exception::kIo});
-    return;
-  };
-  if (!physical_writer_->Write(enqueued_frame.data_).Ok()) {
+  ByteArray header = Base64Utils::IntToBytes(enqueued_frame.data_.size());
+  const ByteArray* buffers[] = {&header, &enqueued_frame.data_};
+  if (!physical_writer_->WriteGathered(buffers).Ok()) {
     enqueued_frame.future_->SetException({Exception::kIo});
     return;
   };
@@ -333,6 +330,32 @@ Exception MultiplexOutputStream::VirtualOutputStream::Write(
   return {Exception::kSuccess};
 }
 
+Exception MultiplexOutputStream::VirtualOutputStream::WriteGathered(
+    absl::Span<const ByteArray* const> buffers) {
+  if (multiplex_output_stream_.is_enabled_.Get()) {
+    // Every Write() turns into its own DATA_FRAME, so join the buffers here.
+    // ForData() copies the data into the frame anyway.
+    std::string data;
+    for (const ByteArray* buffer : buffers) {
+      data.append(buffer->data(), buffer->size());
+    }
+    return Write(ByteArray(std::move(data)));
+  }
+  if (is_closed_.Get()) {
+    NEARBY_LOGS(WARNING)
+        << "Failed to write data because the VirtualOutputStream for "
+        << service_id_ << " closed";
+    return {Exception::kIo};
+  }
+  if (!physical_writer_->WriteGathered(buffers).Ok()) {
+    return {Exception::kIo};
+  };
+  if (!physical_writer_->Flush().Ok()) {
+    return {Exception::kIo};
+  };
+  return {Exception::kSuccess};
+}
+
 Exception MultiplexOutputStream::VirtualOutputStream::Flush() {
   return {Exception::kSuccess};
 }
@@ -20,6 +20,7 @@
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
 #include "internal/platform/array_blocking_queue.h"
 #include "internal/platform/atomic_boolean.h"
 #include "internal/platform/byte_array.h"
@@ -172,6 +173,10 @@ class MultiplexOutputStream {
 
     // Writes the data to the physical output stream.
     Exception Write(const ByteArray& data) override;
+    // Writes the buffers to the physical output stream. When multiplex is
+    // enabled they are sent as a single DATA_FRAME rather than one per buffer.
+    Exception WriteGathered(
+        absl::Span<const ByteArray* const> buffers) override;
     // Flushes the physical output stream.
     Exception Flush() override;
     // Closes the virtual output stream.
@@ -59,7 +59,7 @@ ByteArray ToBytes(OfflineFrame&& frame) {
 ExceptionOrOfflineFrame FromBytes(const ByteArray& bytes) {
   OfflineFrame frame;
 
-  if (frame.ParseFromString(std::string(bytes))) {
+  if (frame.ParseFromArray(bytes.data(), static_cast<int>(bytes.size()))) {
     Exception validation_exception = EnsureValidOfflineFrame(frame);
     if (validation_exception.Raised()) {
       return ExceptionOrOfflineFrame(validation_exception);
@@ -172,7 +172,8 @@ ByteArray ForConnectionRequestPresence(
 }
 
 ByteArray ForConnectionResponse(std::int32_t status, const OsInfo& os_info,
-                                std::int32_t multiplex_socket_bitmask) {
+                                std::int32_t multiplex_socket_bitmask,
+                                std::int32_t feature_bitmask) {
   OfflineFrame frame;
 
   frame.set_version(OfflineFrame::V1);
@@ -193,13 +194,14 @@ ByteArray ForConnectionResponse(std::int32_t status, const OsInfo& os_info,
       NearbyFlags::GetInstance().GetInt64Flag(
           config_package_nearby::nearby_connections_feature::
               kSafeToDisconnectVersion));
+  sub_frame->set_feature_bitmask(feature_bitmask);
 
   return ToBytes(std::move(frame));
 }
 
 ByteArray ForDataPayloadTransfer(
     const PayloadTransferFrame::PayloadHeader& header,
-    const PayloadTransferFrame::PayloadChunk& chunk) {
+    PayloadTransferFrame::PayloadChunk chunk) {
   OfflineFrame frame;
 
   frame.set_version(OfflineFrame::V1);
@@ -208,7 +210,7 @@ ByteArray ForDataPayloadTransfer(
   auto* sub_frame = v1_frame->mutable_payload_transfer();
   sub_frame->set_packet_type(PayloadTransferFrame::DATA);
   *sub_frame->mutable_payload_header() = header;
-  *sub_frame->mutable_payload_chunk() = chunk;
+  *sub_frame->mutable_payload_chunk() = std::move(chunk);
 
   return ToBytes(std::move(frame));
 }
@@ -246,6 +248,25 @@ ByteArray ForPayloadAckPayloadTransfer(std::int64_t payload_id) {
   return ToBytes(std::move(frame));
 }
 
+ByteArray ForPayloadAckPayloadTransfer(std::int64_t payload_id,
+                                       std::int64_t received_offset) {
+  OfflineFrame frame;
+
+  frame.set_version(OfflineFrame::V1);
+  auto* v1_frame = frame.mutable_v1();
+  v1_frame->set_type(V1Frame::PAYLOAD_TRANSFER);
+  auto* sub_frame = v1_frame->mutable_payload_transfer();
+  sub_frame->set_packet_type(PayloadTransferFrame::PAYLOAD_ACK);
+
+  PayloadTransferFrame::PayloadHeader header;
+  header.set_id(payload_id);
+  header.set_total_size(InternalPayload::kIndeterminateSize);
+  *sub_frame->mutable_payload_header() = header;
+  sub_frame->mutable_control_message()->set_offset(received_offset);
+
+  return ToBytes(std::move(frame));
+}
+
 ByteArray ForBwuWifiHotspotPathAvailable(const std::string& ssid,
                                          const std::string& password,
                                          std::int32_t port,
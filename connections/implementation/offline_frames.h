@@ -54,20 +54,25 @@ ByteArray ForConnectionRequestPresence(
     const ConnectionInfo& connection_info);
 ByteArray ForConnectionResponse(
     std::int32_t status, const location::nearby::connections::OsInfo& os_info,
-    std::int32_t multiplex_socket_bitmask);
+    std::int32_t multiplex_socket_bitmask, std::int32_t feature_bitmask);
 
 // Builds Payload transfer messages.
+// The chunk is taken by value so that callers on the data path can move the
+// chunk body into the frame instead of copying it.
 ByteArray ForDataPayloadTransfer(
     const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
         header,
-    const location::nearby::connections::PayloadTransferFrame::PayloadChunk&
-        chunk);
+    location::nearby::connections::PayloadTransferFrame::PayloadChunk chunk);
 ByteArray ForControlPayloadTransfer(
     const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
         header,
     const location::nearby::connections::PayloadTransferFrame::ControlMessage&
         control);
 ByteArray ForPayloadAckPayloadTransfer(std::int64_t payload_id);
+// Cumulative ack for windowed payload acks: `received_offset` is the number of
+// payload bytes received so far, carried in the control message offset.
+ByteArray ForPayloadAckPayloadTransfer(std::int64_t payload_id,
+                                       std::int64_t received_offset);
 
 // Builds Bandwidth Upgrade [BWU] messages.
 ByteArray ForBwuIntroduction(const std::string& endpoint_id,
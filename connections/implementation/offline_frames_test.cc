@@ -272,6 +272,7 @@ TEST(OfflineFramesTest, CanGenerateConnectionResponse) {
         os_info { type: LINUX }
         multiplex_socket_bitmask: 0x01
         safe_to_disconnect_version: 5
+        feature_bitmask: 0x01
       >
     >)pb";
 
@@ -281,8 +282,8 @@ TEST(OfflineFramesTest, CanGenerateConnectionResponse) {
       config_package_nearby::nearby_connections_feature::
           kSafeToDisconnectVersion,
       5);
-  ByteArray bytes =
-      ForConnectionResponse(1, os_info, /*multiplex_socket_bitmask=*/0x01);
+  ByteArray bytes = ForConnectionResponse(
+      1, os_info, /*multiplex_socket_bitmask=*/0x01, /*feature_bitmask=*/0x01);
   auto response = FromBytes(bytes);
   ASSERT_TRUE(response.ok());
   OfflineFrame message = response.result();
@@ -362,6 +363,25 @@ TEST(OfflineFramesTest, CanGeneratePayloadAckPayloadTransfer) {
   EXPECT_THAT(message, EqualsProto(kExpected));
 }
 
+TEST(OfflineFramesTest, CanGenerateCumulativePayloadAck) {
+  constexpr absl::string_view kExpected =
+      R"pb(
+    version: V1
+    v1: <
+      type: PAYLOAD_TRANSFER
+      payload_transfer: <
+        packet_type: PAYLOAD_ACK,
+        payload_header: < id: 12345 total_size: -1 >
+        control_message: < offset: 65536 >
+      >
+    >)pb";
+  ByteArray bytes = ForPayloadAckPayloadTransfer(12345, 65536);
+  auto response = FromBytes(bytes);
+  ASSERT_TRUE(response.ok());
+  OfflineFrame message = response.result();
+  EXPECT_THAT(message, EqualsProto(kExpected));
+}
+
 TEST(OfflineFramesTest, CanGenerateBwuWifiHotspotPathAvailable) {
   constexpr absl::string_view kExpected =
       R"pb(
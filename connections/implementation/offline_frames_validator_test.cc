@@ -175,7 +175,8 @@ TEST(OfflineFramesValidatorTest,
 
   OsInfo os_info;
   ByteArray bytes = ForConnectionResponse(kStatusAccepted, os_info,
-                                          /*multiplex_socket_bitmask=*/0);
+                                          /*multiplex_socket_bitmask=*/0,
+                                          /*feature_bitmask=*/0);
   offline_frame.ParseFromString(std::string(bytes));
 
   auto ret_value = EnsureValidOfflineFrame(offline_frame);
@@ -189,7 +190,8 @@ TEST(OfflineFramesValidatorTest,
 
   OsInfo os_info;
   ByteArray bytes = ForConnectionResponse(kStatusAccepted, os_info,
-                                          /*multiplex_socket_bitmask=*/0);
+                                          /*multiplex_socket_bitmask=*/0,
+                                          /*feature_bitmask=*/0);
   offline_frame.ParseFromString(std::string(bytes));
   auto* v1_frame = offline_frame.mutable_v1();
 
@@ -205,8 +207,8 @@ TEST(OfflineFramesValidatorTest,
   OfflineFrame offline_frame;
 
   OsInfo os_info;
-  ByteArray bytes =
-      ForConnectionResponse(-1, os_info, /*multiplex_socket_bitmask=*/0);
+  ByteArray bytes = ForConnectionResponse(
+      -1, os_info, /*multiplex_socket_bitmask=*/0, /*feature_bitmask=*/0);
   offline_frame.ParseFromString(std::string(bytes));
 
   auto ret_value = EnsureValidOfflineFrame(offline_frame);
@@ -1172,7 +1172,8 @@ Status P2pClusterPcpHandler::InjectEndpointImpl(
 }
 
 BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::ConnectImpl(
-    ClientProxy* client, BasePcpHandler::DiscoveredEndpoint* endpoint) {
+    ClientProxy* client, BasePcpHandler::DiscoveredEndpoint* endpoint,
+    CancellationFlag* cancellation_flag) {
   if (!endpoint) {
     return BasePcpHandler::ConnectImplResult{
         .status = {Status::kError},
@@ -1182,7 +1183,8 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::ConnectImpl(
     case Medium::BLUETOOTH: {
       auto* bluetooth_endpoint = down_cast<BluetoothEndpoint*>(endpoint);
       if (bluetooth_endpoint) {
-        return BluetoothConnectImpl(client, bluetooth_endpoint);
+        return BluetoothConnectImpl(client, bluetooth_endpoint,
+                                    cancellation_flag);
       }
       break;
     }
@@ -1192,13 +1194,13 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::ConnectImpl(
                   kEnableBleV2)) {
         auto* ble_v2_endpoint = down_cast<BleV2Endpoint*>(endpoint);
         if (ble_v2_endpoint) {
-          return BleV2ConnectImpl(client, ble_v2_endpoint);
+          return BleV2ConnectImpl(client, ble_v2_endpoint, cancellation_flag);
         }
 
       } else {
         auto* ble_endpoint = down_cast<BleEndpoint*>(endpoint);
         if (ble_endpoint) {
-          return BleConnectImpl(client, ble_endpoint);
+          return BleConnectImpl(client, ble_endpoint, cancellation_flag);
         }
       }
       break;
@@ -1206,7 +1208,8 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::ConnectImpl(
     case Medium::WIFI_LAN: {
       auto* wifi_lan_endpoint = down_cast<WifiLanEndpoint*>(endpoint);
       if (wifi_lan_endpoint) {
-        return WifiLanConnectImpl(client, wifi_lan_endpoint);
+        return WifiLanConnectImpl(client, wifi_lan_endpoint,
+                                  cancellation_flag);
       }
       break;
     }
@@ -1822,15 +1825,15 @@ void P2pClusterPcpHandler::StartBluetoothDiscoveryWithPause(
 }
 
 BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BluetoothConnectImpl(
-    ClientProxy* client, BluetoothEndpoint* endpoint) {
+    ClientProxy* client, BluetoothEndpoint* endpoint,
+    CancellationFlag* cancellation_flag) {
   NEARBY_LOGS(VERBOSE) << "Client " << client->GetClientId()
                        << " is attempting to connect to endpoint(id="
                        << endpoint->endpoint_id << ") over Bluetooth Classic.";
   BluetoothDevice& device = endpoint->bluetooth_device;
 
   BluetoothSocket bluetooth_socket = bluetooth_medium_.Connect(
-      device, endpoint->service_id,
-      client->GetCancellationFlag(endpoint->endpoint_id));
+      device, endpoint->service_id, cancellation_flag);
   if (!bluetooth_socket.IsValid()) {
     NEARBY_LOGS(ERROR)
         << "In BluetoothConnectImpl(), failed to connect to Bluetooth device "
@@ -2045,7 +2048,8 @@ Medium P2pClusterPcpHandler::StartBleScanning(
 }
 
 BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BleConnectImpl(
-    ClientProxy* client, BleEndpoint* endpoint) {
+    ClientProxy* client, BleEndpoint* endpoint,
+    CancellationFlag* cancellation_flag) {
   NEARBY_LOGS(VERBOSE) << "Client " << client->GetClientId()
                        << " is attempting to connect to endpoint(id="
                        << endpoint->endpoint_id << ") over BLE.";
@@ -2053,8 +2057,7 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BleConnectImpl(
   BlePeripheral& peripheral = endpoint->ble_peripheral;
 
   BleSocket ble_socket =
-      ble_medium_.Connect(peripheral, endpoint->service_id,
-                          client->GetCancellationFlag(endpoint->endpoint_id));
+      ble_medium_.Connect(peripheral, endpoint->service_id, cancellation_flag);
   if (!ble_socket.IsValid()) {
     NEARBY_LOGS(ERROR)
         << "In BleConnectImpl(), failed to connect to BLE device "
@@ -2264,7 +2267,8 @@ Medium P2pClusterPcpHandler::StartBleV2Scanning(
 }
 
 BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BleV2ConnectImpl(
-    ClientProxy* client, BleV2Endpoint* endpoint) {
+    ClientProxy* client, BleV2Endpoint* endpoint,
+    CancellationFlag* cancellation_flag) {
   NEARBY_LOGS(VERBOSE) << "Client " << client->GetClientId()
                        << " is attempting to connect to endpoint(id="
                        << endpoint->endpoint_id << ") over BLE.";
@@ -2272,8 +2276,7 @@ BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::BleV2ConnectImpl(
   BleV2Peripheral& peripheral = endpoint->ble_peripheral;
 
   BleV2Socket ble_socket = ble_v2_medium_.Connect(
-      endpoint->service_id, peripheral,
-      client->GetCancellationFlag(endpoint->endpoint_id));
+      endpoint->service_id, peripheral, cancellation_flag);
   if (!ble_socket.IsValid()) {
     NEARBY_LOGS(ERROR)
         << "In BleV2ConnectImpl(), failed to connect to BLE device "
@@ -2429,13 +2432,13 @@ Medium P2pClusterPcpHandler::StartWifiLanDiscovery(
 }
 
 BasePcpHandler::ConnectImplResult P2pClusterPcpHandler::WifiLanConnectImpl(
-    ClientProxy* client, WifiLanEndpoint* endpoint) {
+    ClientProxy* client, WifiLanEndpoint* endpoint,
+    CancellationFlag* cancellation_flag) {
   NEARBY_LOGS(INFO) << "Client " << client->GetClientId()
                     << " is attempting to connect to endpoint(id="
                     << endpoint->endpoint_id << ") over WifiLan.";
   WifiLanSocket socket = wifi_lan_medium_.Connect(
-      endpoint->service_id, endpoint->service_info,
-      client->GetCancellationFlag(endpoint->endpoint_id));
+      endpoint->service_id, endpoint->service_info, cancellation_flag);
   if (!socket.IsValid()) {
     NEARBY_LOGS(ERROR)
         << "In WifiLanConnectImpl(), failed to connect to service "
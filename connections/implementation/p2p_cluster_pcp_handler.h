@@ -50,6 +50,7 @@
 #include "internal/platform/ble_v2.h"
 #include "internal/platform/bluetooth_adapter.h"
 #include "internal/platform/bluetooth_classic.h"
+#include "internal/platform/cancellation_flag.h"
 #include "internal/platform/nsd_service_info.h"
 #include "internal/platform/wifi_lan.h"
 #ifdef NO_WEBRTC
@@ -110,10 +111,10 @@ class P2pClusterPcpHandler : public BasePcpHandler {
       ClientProxy* client, const std::string& service_id,
       const OutOfBandConnectionMetadata& metadata) override;
 
-  // @PCPHandlerThread
+  // @PCPHandlerThread or @ConnectExecutorThread; uses only the mediums.
   BasePcpHandler::ConnectImplResult ConnectImpl(
-      ClientProxy* client,
-      BasePcpHandler::DiscoveredEndpoint* endpoint) override;
+      ClientProxy* client, BasePcpHandler::DiscoveredEndpoint* endpoint,
+      CancellationFlag* cancellation_flag) override;
 
   // @PCPHandlerThread
   BasePcpHandler::StartOperationResult StartListeningForIncomingConnectionsImpl(
@@ -207,7 +208,8 @@ class P2pClusterPcpHandler : public BasePcpHandler {
       const DiscoveryOptions& discovery_options,
       std::vector<Medium>& mediums_started_successfully);
   BasePcpHandler::ConnectImplResult BluetoothConnectImpl(
-      ClientProxy* client, BluetoothEndpoint* endpoint);
+      ClientProxy* client, BluetoothEndpoint* endpoint,
+      CancellationFlag* cancellation_flag);
 
   // Ble
   bool IsRecognizedBleEndpoint(const std::string& service_id,
@@ -232,8 +234,9 @@ class P2pClusterPcpHandler : public BasePcpHandler {
   location::nearby::proto::connections::Medium StartBleScanning(
       ClientProxy* client, const std::string& service_id,
       const std::string& fast_advertisement_service_uuid);
-  BasePcpHandler::ConnectImplResult BleConnectImpl(ClientProxy* client,
-                                                   BleEndpoint* endpoint);
+  BasePcpHandler::ConnectImplResult BleConnectImpl(
+      ClientProxy* client, BleEndpoint* endpoint,
+      CancellationFlag* cancellation_flag);
 
   // BleV2
   bool IsRecognizedBleV2Endpoint(absl::string_view service_id,
@@ -263,8 +266,9 @@ class P2pClusterPcpHandler : public BasePcpHandler {
   location::nearby::proto::connections::Medium StartBleV2Scanning(
       ClientProxy* client, const std::string& service_id,
       const DiscoveryOptions& discovery_options);
-  BasePcpHandler::ConnectImplResult BleV2ConnectImpl(ClientProxy* client,
-                                                     BleV2Endpoint* endpoint);
+  BasePcpHandler::ConnectImplResult BleV2ConnectImpl(
+      ClientProxy* client, BleV2Endpoint* endpoint,
+      CancellationFlag* cancellation_flag);
 
   // WifiLan
   bool IsRecognizedWifiLanEndpoint(
@@ -289,7 +293,8 @@ class P2pClusterPcpHandler : public BasePcpHandler {
   location::nearby::proto::connections::Medium StartWifiLanDiscovery(
       ClientProxy* client, const std::string& service_id);
   BasePcpHandler::ConnectImplResult WifiLanConnectImpl(
-      ClientProxy* client, WifiLanEndpoint* endpoint);
+      ClientProxy* client, WifiLanEndpoint* endpoint,
+      CancellationFlag* cancellation_flag);
 
   BluetoothRadio& bluetooth_radio_;
   BluetoothClassic& bluetooth_medium_;
@@ -23,10 +23,12 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/functional/bind_front.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
 #include "absl/time/time.h"
 #include "connections/implementation/analytics/throughput_recorder.h"
 #include "connections/implementation/client_proxy.h"
@@ -44,6 +46,7 @@
 #include "internal/platform/logging.h"
 #include "internal/platform/mutex_lock.h"
 #include "internal/platform/single_thread_executor.h"
+#include "internal/platform/system_clock.h"
 #include "proto/connections_enums.pb.h"
 
 namespace nearby {
@@ -107,6 +110,7 @@ bool PayloadManager::SendPayloadLoop(
   // because it's after all payload terminating events are handled, but
   // right before we actually start detaching the next chunk.
   if (next_chunk_offset == 0 && resume_offset > 0) {
+    pending_payload.SetResumeOffset(resume_offset);
     ExceptionOr<size_t> real_offset =
         pending_payload.GetInternalPayload()->SkipToOffset(resume_offset);
     if (!real_offset.ok()) {
@@ -130,7 +134,9 @@ bool PayloadManager::SendPayloadLoop(
 
   // This will block if there is no data to transfer.
   // It will resume when new data arrives, or if Close() is called.
-  int chunk_size = GetOptimalChunkSize(available_endpoint_ids);
+  bool adaptive_chunk_size = IsAdaptiveChunkSizeEnabled();
+  int chunk_size =
+      GetOptimalChunkSize(available_endpoint_ids, adaptive_chunk_size);
   packet_meta_data.StartFileIo();
   ByteArray next_chunk =
       pending_payload.GetInternalPayload()->DetachNextChunk(chunk_size);
@@ -156,8 +162,23 @@ bool PayloadManager::SendPayloadLoop(
   // happened.
   PayloadTransferFrame::PayloadChunk payload_chunk(CreatePayloadChunk(
       next_chunk_offset - resume_offset, std::move(next_chunk), index));
+  if (adaptive_chunk_size) {
+    ThroughputRecorderContainer::GetInstance()
+        .GetTPRecorder(payload_header.id(), PayloadDirection::OUTGOING_PAYLOAD)
+        ->OnChunkSizeSelected(chunk_size);
+  }
+  // The chunk body is moved into the outgoing frame, so keep what we need
+  // from the chunk for bookkeeping after it has been sent.
+  bool is_last_chunk = IsLastChunk(payload_chunk);
+  std::int32_t payload_chunk_flags = payload_chunk.flags();
+  std::int64_t payload_chunk_offset = payload_chunk.offset();
+  // Each endpoint's chunk size follows its own write latency, not the time
+  // spent writing to every endpoint in turn.
+  absl::flat_hash_map<std::string, absl::Duration> write_latencies;
   const EndpointIds& failed_endpoint_ids = endpoint_manager_->SendPayloadChunk(
-      payload_header, payload_chunk, available_endpoint_ids, packet_meta_data);
+      payload_header, std::move(payload_chunk), available_endpoint_ids,
+      packet_meta_data, adaptive_chunk_size ? &write_latencies : nullptr);
+  absl::Time write_end_time = SystemClock::ElapsedRealtime();
   // Check whether at least one endpoint failed.
   if (!failed_endpoint_ids.empty()) {
     NEARBY_LOGS(INFO) << "Payload xfer: endpoints failed: payload_id="
@@ -168,7 +189,6 @@ bool PayloadManager::SendPayloadLoop(
                                       location::nearby::proto::connections::
                                           PayloadStatus::ENDPOINT_IO_ERROR);
   }
-  bool is_last_chunk = IsLastChunk(payload_chunk);
   // Check whether at least one endpoint succeeded -- if they all failed,
   // we'll just go right back to the top of the loop and break out when
   // availableEndpointIds is re-synced and found to be empty at that point.
@@ -176,15 +196,24 @@ bool PayloadManager::SendPayloadLoop(
     for (const auto& endpoint_id : available_endpoint_ids) {
       if (std::find(failed_endpoint_ids.begin(), failed_endpoint_ids.end(),
                     endpoint_id) == failed_endpoint_ids.end()) {
+        if (adaptive_chunk_size) {
+          RecordChunkWritten(endpoint_id, next_chunk_size,
+                             write_latencies[endpoint_id]);
+        }
+        if (!WaitForAckWindow(client, endpoint_id, pending_payload,
+                              payload_header,
+                              next_chunk_offset + next_chunk_size)) {
+          continue;
+        }
         if (!WaitForReceivedAck(client, endpoint_id, pending_payload,
                                 payload_header, next_chunk_offset,
-                                is_last_chunk)) {
+                                is_last_chunk, write_end_time)) {
           continue;
         }
 
-        HandleSuccessfulOutgoingChunk(
-            client, endpoint_id, payload_header, payload_chunk.flags(),
-            payload_chunk.offset(), payload_chunk.body().size());
+        HandleSuccessfulOutgoingChunk(client, endpoint_id, payload_header,
+                                      payload_chunk_flags, payload_chunk_offset,
+                                      next_chunk_size);
       }
     }
     NEARBY_LOGS(VERBOSE) << "PayloadManager done sending chunk at offset "
@@ -353,6 +382,12 @@ PayloadManager::~PayloadManager() {
   bytes_payload_executor_.Shutdown();
   stream_payload_executor_.Shutdown();
   file_payload_executor_.Shutdown();
+  PayloadScheduler* payload_scheduler;
+  {
+    MutexLock lock(&mutex_);
+    payload_scheduler = payload_scheduler_.get();
+  }
+  if (payload_scheduler != nullptr) payload_scheduler->Shutdown();
   send_payload_ack_executor_.Shutdown();
 
   CountDownLatch stop_latch(1);
@@ -424,8 +459,9 @@ void PayloadManager::SendPayload(ClientProxy* client,
 
   // Each payload is sent in FCFS order within each Payload type, blocking any
   // other payload of the same type from even starting until this one is
-  // completely done with. If we ever want to provide isolation across
-  // ClientProxy objects this will need to be significantly re-architected.
+  // completely done with. With kEnableParallelPayloadScheduler, that order is
+  // kept per set of endpoints instead, and BYTES and FILE payloads to
+  // different endpoints are sent concurrently by payload_scheduler_.
   PayloadType payload_type = payload.GetType();
   size_t resume_offset =
       FeatureFlags::GetInstance().GetFlags().enable_send_payload_offset
@@ -434,54 +470,80 @@ void PayloadManager::SendPayload(ClientProxy* client,
 
   Payload::Id payload_id =
       CreateOutgoingPayload(std::move(payload), endpoint_ids);
-  executor->Execute(
-      "send-payload", [this, client, endpoint_ids, payload_id, payload_type,
-                       resume_offset, payload_total_size]() {
-        if (shutdown_.Get()) return;
-        PendingPayloadHandle pending_payload = GetPayload(payload_id);
-        if (!pending_payload) {
-          RecordInvalidPayloadAnalytics(client, endpoint_ids, payload_id,
-                                        payload_type, resume_offset,
-                                        payload_total_size);
-          NEARBY_LOGS(INFO)
-              << "PayloadManager failed to create InternalPayload for outgoing "
-                 "payload_id="
-              << payload_id << ", payload_type=" << ToString(payload_type)
-              << ", aborting sendPayload().";
-          return;
-        }
-        auto* internal_payload = pending_payload->GetInternalPayload();
-        if (!internal_payload) return;
-
-        RecordPayloadStartedAnalytics(client, endpoint_ids, payload_id,
+  // Sends one chunk per call; returns false once the payload is done with.
+  PayloadScheduler::Step send_step =
+      [this, client, endpoint_ids, payload_id, payload_type, resume_offset,
+       payload_total_size, pending_payload = PendingPayloadHandle(),
+       payload_header = PayloadTransferFrame::PayloadHeader(),
+       next_chunk_offset = std::int64_t{0}, index = 0]() mutable -> bool {
+    if (shutdown_.Get()) return false;
+    if (!pending_payload) {
+      pending_payload = GetPayload(payload_id);
+      if (!pending_payload) {
+        RecordInvalidPayloadAnalytics(client, endpoint_ids, payload_id,
                                       payload_type, resume_offset,
-                                      internal_payload->GetTotalSize());
-
-        PayloadTransferFrame::PayloadHeader payload_header{
-            CreatePayloadHeader(*internal_payload, resume_offset,
-                                internal_payload->GetParentFolder(),
-                                internal_payload->GetFileName())};
-
-        bool should_continue = true;
-        std::int64_t next_chunk_offset = 0;
-        int index = 0;
-
-        ThroughputRecorderContainer::GetInstance()
-            .GetTPRecorder(payload_id, PayloadDirection::OUTGOING_PAYLOAD)
-            ->Start(payload_type, PayloadDirection::OUTGOING_PAYLOAD);
-        while (should_continue && !shutdown_.Get()) {
-          should_continue =
-              SendPayloadLoop(client, *pending_payload, payload_header,
-                              next_chunk_offset, resume_offset, index);
-          index++;
-        }
+                                      payload_total_size);
+        NEARBY_LOGS(INFO)
+            << "PayloadManager failed to create InternalPayload for outgoing "
+               "payload_id="
+            << payload_id << ", payload_type=" << ToString(payload_type)
+            << ", aborting sendPayload().";
+        return false;
+      }
+      auto* internal_payload = pending_payload->GetInternalPayload();
+      if (!internal_payload) return false;
 
-        RunOnStatusUpdateThread("destroy-payload",
-                                [this, payload_id]()
-                                    RUN_ON_PAYLOAD_STATUS_UPDATE_THREAD() {
-                                      DestroyPendingPayload(payload_id);
-                                    });
-      });
+      RecordPayloadStartedAnalytics(client, endpoint_ids, payload_id,
+                                    payload_type, resume_offset,
+                                    internal_payload->GetTotalSize());
+
+      payload_header = CreatePayloadHeader(*internal_payload, resume_offset,
+                                           internal_payload->GetParentFolder(),
+                                           internal_payload->GetFileName());
+
+      ThroughputRecorderContainer::GetInstance()
+          .GetTPRecorder(payload_id, PayloadDirection::OUTGOING_PAYLOAD)
+          ->Start(payload_type, PayloadDirection::OUTGOING_PAYLOAD);
+    }
+
+    bool should_continue =
+        SendPayloadLoop(client, *pending_payload, payload_header,
+                        next_chunk_offset, resume_offset, index);
+    index++;
+    if (should_continue && !shutdown_.Get()) return true;
+
+    pending_payload = PendingPayloadHandle();
+    RunOnStatusUpdateThread("destroy-payload",
+                            [this, payload_id]()
+                                RUN_ON_PAYLOAD_STATUS_UPDATE_THREAD() {
+                                  DestroyPendingPayload(payload_id);
+                                });
+    return false;
+  };
+
+  PayloadScheduler* payload_scheduler = nullptr;
+  // Streams keep their own thread: reading the next chunk blocks until the
+  // client writes more data, which would hold a scheduler thread hostage.
+  if (payload_type != PayloadType::kStream &&
+      NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableParallelPayloadScheduler)) {
+    payload_scheduler = GetPayloadScheduler();
+    if (payload_scheduler == nullptr) return;
+  }
+  if (payload_scheduler != nullptr) {
+    payload_scheduler->Schedule(
+        GetPayloadFlow(payload_type, endpoint_ids),
+        payload_type == PayloadType::kBytes ? PayloadScheduler::Priority::kHigh
+                                            : PayloadScheduler::Priority::kNormal,
+        std::move(send_step));
+  } else {
+    executor->Execute("send-payload",
+                      [send_step = std::move(send_step)]() mutable {
+                        while (send_step()) {
+                        }
+                      });
+  }
   NEARBY_LOGS(INFO) << "PayloadManager: xfer scheduled: self=" << this
                     << "; payload_id=" << payload_id
                     << ", payload_type=" << ToString(payload_type);
@@ -537,7 +599,7 @@ void PayloadManager::OnIncomingFrame(
           IsPayloadReceivedAckEnabled(to_client, from_endpoint_id,
                                       *pending_payload)) {
         SendPayloadReceivedAck(to_client, *pending_payload, from_endpoint_id,
-                               is_last);
+                               is_last, frame.payload_chunk().offset());
       }
     }
     NEARBY_LOGS(INFO)
@@ -579,6 +641,10 @@ void PayloadManager::OnEndpointDisconnect(ClientProxy* client,
     barrier.CountDown();
     return;
   }
+  {
+    MutexLock lock(&chunk_size_mutex_);
+    chunk_size_controllers_.erase(endpoint_id);
+  }
   RunOnStatusUpdateThread(
       "payload-manager-on-disconnect",
       [this, client, endpoint_id, barrier,
@@ -590,6 +656,13 @@ void PayloadManager::OnEndpointDisconnect(ClientProxy* client,
           auto endpoint_info = pending_payload->GetEndpoint(endpoint_id);
           if (!endpoint_info) return;
           std::int64_t endpoint_offset = endpoint_info->offset;
+          // With windowed acks, report only what the peer confirmed, so a
+          // resumed transfer restarts from the last acked offset.
+          if (!pending_payload->IsIncoming() &&
+              endpoint_info->GetAckedOffset() >= 0) {
+            endpoint_offset =
+                std::min(endpoint_offset, endpoint_info->GetAckedOffset());
+          }
           // Stop tracking the endpoint for this payload.
           pending_payload->RemoveEndpoints({endpoint_id});
           // |endpoint_info| is longer valid after calling
@@ -698,15 +771,64 @@ SingleThreadExecutor* PayloadManager::GetOutgoingPayloadExecutor(
   }
 }
 
-int PayloadManager::GetOptimalChunkSize(EndpointIds endpoint_ids) {
+PayloadScheduler* PayloadManager::GetPayloadScheduler() {
+  MutexLock lock(&mutex_);
+  // ~PayloadManager() sets |shutdown_| before it looks for a scheduler to shut
+  // down, so none can be created behind its back.
+  if (shutdown_.Get()) return nullptr;
+  if (payload_scheduler_ == nullptr) {
+    payload_scheduler_ = std::make_unique<PayloadScheduler>(
+        FeatureFlags::GetInstance().GetFlags().max_concurrent_outgoing_payloads);
+  }
+  return payload_scheduler_.get();
+}
+
+std::string PayloadManager::GetPayloadFlow(PayloadType payload_type,
+                                           EndpointIds endpoint_ids) {
+  std::sort(endpoint_ids.begin(), endpoint_ids.end());
+  return absl::StrCat(ToString(payload_type), ":",
+                      absl::StrJoin(endpoint_ids, ","));
+}
+
+int PayloadManager::GetOptimalChunkSize(EndpointIds endpoint_ids,
+                                        bool adaptive) {
   int minChunkSize = std::numeric_limits<int>::max();
   for (const auto& endpoint_id : endpoint_ids) {
-    minChunkSize = std::min(
-        minChunkSize, endpoint_manager_->GetMaxTransmitPacketSize(endpoint_id));
+    int chunk_size = endpoint_manager_->GetMaxTransmitPacketSize(endpoint_id);
+    if (adaptive) {
+      MutexLock lock(&chunk_size_mutex_);
+      chunk_size =
+          chunk_size_controllers_[endpoint_id].GetChunkSize(chunk_size);
+    }
+    minChunkSize = std::min(minChunkSize, chunk_size);
   }
   return minChunkSize;
 }
 
+bool PayloadManager::IsAdaptiveChunkSizeEnabled() const {
+  return NearbyFlags::GetInstance().GetBoolFlag(
+      config_package_nearby::nearby_connections_feature::
+          kEnableAdaptiveChunkSize);
+}
+
+void PayloadManager::RecordChunkWritten(const std::string& endpoint_id,
+                                        std::int64_t chunk_size,
+                                        absl::Duration write_latency) {
+  MutexLock lock(&chunk_size_mutex_);
+  auto it = chunk_size_controllers_.find(endpoint_id);
+  if (it == chunk_size_controllers_.end()) return;
+  it->second.OnChunkWritten(chunk_size, write_latency);
+}
+
+void PayloadManager::RecordReceivedAck(const std::string& endpoint_id,
+                                       absl::Duration round_trip_time) {
+  if (!IsAdaptiveChunkSizeEnabled()) return;
+  MutexLock lock(&chunk_size_mutex_);
+  auto it = chunk_size_controllers_.find(endpoint_id);
+  if (it == chunk_size_controllers_.end()) return;
+  it->second.OnReceivedAck(round_trip_time);
+}
+
 PayloadTransferFrame::PayloadHeader PayloadManager::CreatePayloadHeader(
     const InternalPayload& internal_payload, size_t offset,
     const std::string& parent_folder, const std::string& file_name) {
@@ -870,20 +992,39 @@ void PayloadManager::SendControlMessage(
 void PayloadManager::SendPayloadReceivedAck(ClientProxy* client,
                                             PendingPayload& pending_payload,
                                             const std::string& endpoint_id,
-                                            bool is_last_chunk) {
-  if (!is_last_chunk ||
-      !IsPayloadReceivedAckEnabled(client, endpoint_id, pending_payload)) {
+                                            bool is_last_chunk,
+                                            std::int64_t received_offset) {
+  if (!IsPayloadReceivedAckEnabled(client, endpoint_id, pending_payload)) {
+    return;
+  }
+  bool windowed =
+      IsWindowedPayloadAckEnabled(client, endpoint_id, pending_payload);
+  if (windowed) {
+    auto* endpoint_info = pending_payload.GetEndpoint(endpoint_id);
+    if (endpoint_info == nullptr) return;
+    if (!is_last_chunk && received_offset - endpoint_info->last_ack_offset <
+                              kPayloadAckIntervalBytes) {
+      return;
+    }
+    endpoint_info->last_ack_offset = received_offset;
+  } else if (!is_last_chunk) {
     return;
   }
 
   send_payload_ack_executor_.Execute(
-      "send_payload_ack", [this, &pending_payload, endpoint_id]() {
-        endpoint_manager_->SendPayloadAck(pending_payload.GetId(),
-                                          {endpoint_id});
+      "send_payload_ack", [this, payload_id = pending_payload.GetId(),
+                           endpoint_id, windowed, received_offset]() {
+        if (windowed) {
+          endpoint_manager_->SendPayloadAck(payload_id, received_offset,
+                                            {endpoint_id});
+          return;
+        }
+        endpoint_manager_->SendPayloadAck(payload_id, {endpoint_id});
         NEARBY_LOGS(INFO) << "[safe-to-disconnect] Send "
                              "PAYLOAD_RECEIVED_ACK frame to: "
                           << endpoint_id << " done";
       });
+  if (!is_last_chunk) return;
   // Send the PAYLOAD_RECEIVED_ACK to the remote endpoint for the sender asap.
   NEARBY_LOGS(INFO) << "[safe-to-disconnect] [PAYLOAD_RECEIVED_ACK] "
                        "isLastChunk, receiver send payload ack to "
@@ -894,7 +1035,8 @@ bool PayloadManager::WaitForReceivedAck(
     ClientProxy* client, const std::string& endpoint_id,
     PendingPayload& pending_payload,
     const PayloadTransferFrame::PayloadHeader& payload_header,
-    std::int64_t payload_chunk_offset, bool is_last_chunk) {
+    std::int64_t payload_chunk_offset, bool is_last_chunk,
+    absl::Time chunk_written_time) {
   if (!is_last_chunk ||
       !IsPayloadReceivedAckEnabled(client, endpoint_id, pending_payload)) {
     return true;
@@ -903,7 +1045,66 @@ bool PayloadManager::WaitForReceivedAck(
   NEARBY_LOGS(INFO) << "[safe-to-disconnect] Last Chunk, sender wait for "
                        "PAYLOAD_RECEIVED_ACK frame from: "
                     << endpoint_id;
-  while (true) {
+  // With windowed acks the final ack is the cumulative ack covering the whole
+  // payload; the last chunk is empty and sits at the end offset.
+  std::int64_t min_acked_offset =
+      IsWindowedPayloadAckEnabled(client, endpoint_id, pending_payload)
+          ? payload_chunk_offset
+          : -1;
+  if (!WaitForPayloadAck(client, endpoint_id, payload_header,
+                         payload_chunk_offset, min_acked_offset)) {
+    return false;
+  }
+  RecordReceivedAck(endpoint_id,
+                    SystemClock::ElapsedRealtime() - chunk_written_time);
+  return true;
+}
+
+bool PayloadManager::WaitForAckWindow(
+    ClientProxy* client, const std::string& endpoint_id,
+    PendingPayload& pending_payload,
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    std::int64_t sent_offset) {
+  // The receiver acks every kPayloadAckIntervalBytes whatever our window is,
+  // so a window of at least two intervals always leaves room for the next
+  // ack to arrive.
+  std::int64_t window_bytes = std::max<std::int64_t>(
+      FeatureFlags::GetInstance().GetFlags().payload_ack_window_bytes,
+      2 * kPayloadAckIntervalBytes);
+  std::int64_t min_acked_offset = sent_offset - window_bytes;
+  if (min_acked_offset <= pending_payload.GetResumeOffset() ||
+      !IsWindowedPayloadAckEnabled(client, endpoint_id, pending_payload)) {
+    return true;
+  }
+  // Fast path: the window is usually open, so avoid the full wait loop.
+  auto* endpoint_info = pending_payload.GetEndpoint(endpoint_id);
+  if (endpoint_info != nullptr &&
+      endpoint_info->GetAckedOffset() >= min_acked_offset) {
+    return true;
+  }
+  return WaitForPayloadAck(client, endpoint_id, payload_header, sent_offset,
+                           min_acked_offset);
+}
+
+bool PayloadManager::WaitForPayloadAck(
+    ClientProxy* client, const std::string& endpoint_id,
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    std::int64_t payload_chunk_offset, std::int64_t min_acked_offset) {
+  bool windowed = min_acked_offset >= 0;
+  // A full window only means the receiver is slower than the sender, so
+  // windowed waits only give up once the acks stop advancing altogether.
+  absl::Duration timeout =
+      windowed ? FeatureFlags::GetInstance()
+                     .GetFlags()
+                     .payload_ack_window_stall_timeout_millis
+               : FeatureFlags::GetInstance()
+                     .GetFlags()
+                     .wait_payload_received_ack_millis;
+  absl::Time deadline = SystemClock::ElapsedRealtime() + timeout;
+  std::int64_t last_acked_offset = -1;
+  // Set if the endpoint stops acking in time, to the offset it last acked.
+  std::int64_t timed_out_at_offset = -1;
+  while (timed_out_at_offset < 0) {
     PendingPayloadHandle latest_pending_payload =
         GetPayload(payload_header.id());
     // Make sure we're still tracking this payload and its associated endpoint.
@@ -946,14 +1147,32 @@ bool PayloadManager::WaitForReceivedAck(
     }
     {
       MutexLock lock(&endpoint_info->payload_received_ack_mutex);
+      if (windowed) {
+        if (endpoint_info->acked_offset >= min_acked_offset) return true;
+        if (endpoint_info->acked_offset > last_acked_offset) {
+          last_acked_offset = endpoint_info->acked_offset;
+          deadline = SystemClock::ElapsedRealtime() + timeout;
+        }
+        absl::Duration remaining = deadline - SystemClock::ElapsedRealtime();
+        if (remaining <= absl::ZeroDuration() ||
+            !endpoint_info->payload_received_ack_cond.Wait(remaining).Ok()) {
+          NEARBY_LOGS(INFO) << "[PAYLOAD_RECEIVED_ACK] sender timed out "
+                               "waiting for cumulative ack up to "
+                            << min_acked_offset << " from " << endpoint_id
+                            << ", acks stalled at " << last_acked_offset;
+          // Finish the payload outside the lock: it removes |endpoint_info|.
+          timed_out_at_offset =
+              std::max<std::int64_t>(endpoint_info->acked_offset, 0);
+        }
+        // Re-check the payload and endpoint state before waiting again.
+        continue;
+      }
       if (endpoint_info->is_payload_received_ack) {
         endpoint_info->is_payload_received_ack = false;
         return true;
       }
-      Exception wait_exception = endpoint_info->payload_received_ack_cond.Wait(
-          FeatureFlags::GetInstance()
-              .GetFlags()
-              .wait_payload_received_ack_millis);
+      Exception wait_exception =
+          endpoint_info->payload_received_ack_cond.Wait(timeout);
       endpoint_info->is_payload_received_ack = false;
       if (!wait_exception.Ok()) {
         NEARBY_LOGS(INFO)
@@ -968,7 +1187,12 @@ bool PayloadManager::WaitForReceivedAck(
       return true;
     }
   }
-  return true;
+  // An endpoint that stopped acking holds the whole transfer back, so treat it
+  // like a failed write.
+  HandleFinishedOutgoingPayload(
+      client, {endpoint_id}, payload_header, timed_out_at_offset,
+      location::nearby::proto::connections::PayloadStatus::ENDPOINT_IO_ERROR);
+  return false;
 }
 
 bool PayloadManager::IsPayloadReceivedAckEnabled(
@@ -983,6 +1207,13 @@ bool PayloadManager::IsPayloadReceivedAckEnabled(
               PayloadHeader::BYTES);
 }
 
+bool PayloadManager::IsWindowedPayloadAckEnabled(
+    ClientProxy* client, const std::string& endpoint_id,
+    PendingPayload& pending_payload) {
+  return IsPayloadReceivedAckEnabled(client, endpoint_id, pending_payload) &&
+         client->IsWindowedPayloadAckEnabled(endpoint_id);
+}
+
 void PayloadManager::HandleFinishedOutgoingPayload(
     ClientProxy* client, const EndpointIds& finished_endpoint_ids,
     const PayloadTransferFrame::PayloadHeader& payload_header,
@@ -1193,8 +1424,7 @@ void PayloadManager::HandleSuccessfulIncomingChunk(
             is_last_chunk ? PayloadProgressInfo::Status::kSuccess
                           : PayloadProgressInfo::Status::kInProgress,
             payload_header.total_size(),
-            is_last_chunk ? payload_chunk_offset
-                          : payload_chunk_offset + payload_chunk_body_size};
+            payload_chunk_offset + payload_chunk_body_size};
 
         // Notify the client of this update.
         NotifyClientOfIncomingPayloadProgressInfo(client, endpoint_id, update);
@@ -1316,6 +1546,8 @@ void PayloadManager::ProcessDataPacket(
   // Save size of packet before we move it.
   std::int64_t payload_body_size = payload_chunk.body().size();
 
+  // Chunks arrive in order over the single channel to the endpoint, so they
+  // are attached one after another rather than by offset.
   packet_meta_data.StartFileIo();
   if (pending_payload->GetInternalPayload()
           ->AttachNextChunk(ByteArray(std::move(*payload_chunk.mutable_body())))
@@ -1329,10 +1561,10 @@ void PayloadManager::ProcessDataPacket(
     return;
   }
   packet_meta_data.StopFileIo();
-  bool is_last_chunk = (payload_chunk.flags() &
-                        PayloadTransferFrame::PayloadChunk::LAST_CHUNK) != 0;
+  bool is_last_chunk = IsLastChunk(payload_chunk);
   SendPayloadReceivedAck(to_client, *pending_payload, from_endpoint_id,
-                         is_last_chunk);
+                         is_last_chunk,
+                         payload_chunk.offset() + payload_body_size);
 
   HandleSuccessfulIncomingChunk(to_client, from_endpoint_id, payload_header,
                                 payload_chunk.flags(), payload_chunk.offset(),
@@ -1426,6 +1658,15 @@ void PayloadManager::ProcessPayloadAckPacket(
                          "ack for incoming payload "
                       << payload_header.id() << ", ignoring";
   }
+  if (payload_transfer_frame.has_control_message()) {
+    // Cumulative ack. Chunk offsets on the wire, and so the acked offset, are
+    // relative to where the transfer was resumed from.
+    pending_payload->MarkAckedOffsetFromEndpoint(
+        from_endpoint_id,
+        pending_payload->GetResumeOffset() +
+            payload_transfer_frame.control_message().offset());
+    return;
+  }
   NEARBY_LOGS(INFO)
       << "[safe-to-disconnect][PAYLOAD_RECEIVED_ACK] sender received payload "
       << payload_header.id() << " ack from " << from_endpoint_id;
@@ -1514,6 +1755,19 @@ void PayloadManager::EndpointInfo::MarkReceivedAckFromEndpoint() {
   payload_received_ack_cond.Notify();
 }
 
+void PayloadManager::EndpointInfo::MarkAckedOffsetFromEndpoint(
+    std::int64_t offset) {
+  MutexLock lock(&payload_received_ack_mutex);
+  if (offset <= acked_offset) return;
+  acked_offset = offset;
+  payload_received_ack_cond.Notify();
+}
+
+std::int64_t PayloadManager::EndpointInfo::GetAckedOffset() const {
+  MutexLock lock(&payload_received_ack_mutex);
+  return acked_offset;
+}
+
 bool PayloadManager::EndpointInfo::IsEndpointAvailable(
     ClientProxy* clientProxy, EndpointInfo::Status status) {
   // Pending endpointIds would be removed from the payload after
@@ -1572,6 +1826,13 @@ void PayloadManager::PendingPayload::MarkReceivedAckFromEndpoint(
   info->MarkReceivedAckFromEndpoint();
 }
 
+void PayloadManager::PendingPayload::MarkAckedOffsetFromEndpoint(
+    const std::string& from_endpoint_id, std::int64_t acked_offset) {
+  auto info = GetEndpoint(from_endpoint_id);
+  if (!info) return;
+  info->MarkAckedOffsetFromEndpoint(acked_offset);
+}
+
 bool PayloadManager::PendingPayload::IsIncoming() const { return is_incoming_; }
 
 std::vector<const PayloadManager::EndpointInfo*>
@@ -15,6 +15,7 @@
 #ifndef CORE_INTERNAL_PAYLOAD_MANAGER_H_
 #define CORE_INTERNAL_PAYLOAD_MANAGER_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -25,10 +26,13 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/time/time.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
+#include "connections/implementation/chunk_size_controller.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_manager.h"
 #include "connections/implementation/internal_payload.h"
+#include "connections/implementation/payload_scheduler.h"
 #include "connections/listeners.h"
 #include "connections/payload.h"
 #include "connections/payload_type.h"
@@ -55,6 +59,10 @@ class PayloadManager : public EndpointManager::FrameProcessor {
   using EndpointIds = std::vector<std::string>;
   constexpr static const absl::Duration kWaitCloseTimeout =
       absl::Milliseconds(5000);
+  // With windowed payload acks, the receiver sends a cumulative ack once this
+  // many bytes have arrived since its last one. This is part of the protocol,
+  // not a flag, so senders can size their window without asking the peer.
+  constexpr static const std::int64_t kPayloadAckIntervalBytes = 64 * 1024;
 
   explicit PayloadManager(EndpointManager& endpoint_manager);
   ~PayloadManager() override;
@@ -97,6 +105,8 @@ class PayloadManager : public EndpointManager::FrameProcessor {
     static Status ControlMessageEventToEndpointInfoStatus(
         PayloadTransferFrame::ControlMessage::EventType event);
     void MarkReceivedAckFromEndpoint();
+    void MarkAckedOffsetFromEndpoint(std::int64_t acked_offset);
+    std::int64_t GetAckedOffset() const;
     bool IsEndpointAvailable(ClientProxy* clientProxy,
                              EndpointInfo::Status status);
 
@@ -107,6 +117,12 @@ class PayloadManager : public EndpointManager::FrameProcessor {
     ConditionVariable payload_received_ack_cond{&payload_received_ack_mutex};
     bool is_payload_received_ack ABSL_GUARDED_BY(payload_received_ack_mutex) =
         false;
+    // Sender side, windowed acks only: highest payload offset the endpoint has
+    // confirmed receiving, or -1 before the first cumulative ack.
+    std::int64_t acked_offset ABSL_GUARDED_BY(payload_received_ack_mutex) = -1;
+    // Receiver side, windowed acks only: offset sent in the last cumulative
+    // ack. Only touched from the endpoint's reader thread.
+    std::int64_t last_ack_offset = 0;
   };
 
   // Tracks state for an InternalPayload and the endpoints associated with it.
@@ -133,8 +149,17 @@ class PayloadManager : public EndpointManager::FrameProcessor {
     bool IsLocallyCanceled() const;
     void MarkLocallyCanceled();
     void MarkReceivedAckFromEndpoint(const std::string& from_endpoint_id);
+    void MarkAckedOffsetFromEndpoint(const std::string& from_endpoint_id,
+                                     std::int64_t acked_offset);
     bool IsIncoming() const;
 
+    // Offset the outgoing transfer was resumed from. Chunk offsets on the
+    // wire, and so cumulative acks, are relative to it.
+    void SetResumeOffset(std::int64_t resume_offset) {
+      resume_offset_ = resume_offset;
+    }
+    std::int64_t GetResumeOffset() const { return resume_offset_; }
+
     // Gets the EndpointInfo objects for the endpoints (still) associated with
     // this payload.
     std::vector<const EndpointInfo*> GetEndpoints() const
@@ -175,6 +200,7 @@ class PayloadManager : public EndpointManager::FrameProcessor {
     bool is_incoming_;
     AtomicBoolean is_locally_canceled_{false};
     AtomicBoolean is_closed_;
+    std::atomic<std::int64_t> resume_offset_{0};
     std::unique_ptr<InternalPayload> internal_payload_;
     DestroyCallback destroy_callback_;
     absl::flat_hash_map<std::string, EndpointInfo> endpoints_
@@ -294,7 +320,17 @@ class PayloadManager : public EndpointManager::FrameProcessor {
   static PayloadProgressInfo::Status PayloadStatusToTransferUpdateStatus(
       location::nearby::proto::connections::PayloadStatus status);
 
-  int GetOptimalChunkSize(EndpointIds endpoint_ids);
+  // Sizes from the endpoints' ChunkSizeControllers are used if `adaptive`.
+  int GetOptimalChunkSize(EndpointIds endpoint_ids, bool adaptive)
+      ABSL_LOCKS_EXCLUDED(chunk_size_mutex_);
+  bool IsAdaptiveChunkSizeEnabled() const;
+  // Only called when adaptive chunk sizing is enabled.
+  void RecordChunkWritten(const std::string& endpoint_id,
+                          std::int64_t chunk_size, absl::Duration write_latency)
+      ABSL_LOCKS_EXCLUDED(chunk_size_mutex_);
+  void RecordReceivedAck(const std::string& endpoint_id,
+                         absl::Duration round_trip_time)
+      ABSL_LOCKS_EXCLUDED(chunk_size_mutex_);
 
   PayloadTransferFrame::PayloadHeader CreatePayloadHeader(
       const InternalPayload& internal_payload, size_t offset,
@@ -303,7 +339,7 @@ class PayloadManager : public EndpointManager::FrameProcessor {
   PayloadTransferFrame::PayloadChunk CreatePayloadChunk(std::int64_t offset,
                                                         ByteArray body,
                                                         int index);
-  bool IsLastChunk(PayloadTransferFrame::PayloadChunk payload_chunk) {
+  bool IsLastChunk(const PayloadTransferFrame::PayloadChunk& payload_chunk) {
     return ((payload_chunk.flags() &
              PayloadTransferFrame::PayloadChunk::LAST_CHUNK) != 0);
   }
@@ -333,18 +369,41 @@ class PayloadManager : public EndpointManager::FrameProcessor {
       std::int64_t num_bytes_successfully_transferred,
       PayloadTransferFrame::ControlMessage::EventType event_type);
 
+  // Sends the PAYLOAD_ACK for a received chunk when one is due: after the
+  // last chunk, and every half window with windowed acks. `received_offset`
+  // is the payload offset right after the chunk.
   void SendPayloadReceivedAck(
       ClientProxy* client, PendingPayload& pending_payload,
-      const std::string& endpoint_id, bool is_last_chunk);
+      const std::string& endpoint_id, bool is_last_chunk,
+      std::int64_t received_offset);
 
   bool WaitForReceivedAck(
       ClientProxy* client, const std::string& endpoint_id,
       PendingPayload& pending_payload,
       const PayloadTransferFrame::PayloadHeader& payload_header,
-      std::int64_t payload_chunk_offset, bool is_last_chunk);
+      std::int64_t payload_chunk_offset, bool is_last_chunk,
+      absl::Time chunk_written_time);
+  // With windowed acks, blocks until no more than the ack window's worth of
+  // bytes of the payload up to `sent_offset` are unacked by the endpoint.
+  bool WaitForAckWindow(
+      ClientProxy* client, const std::string& endpoint_id,
+      PendingPayload& pending_payload,
+      const PayloadTransferFrame::PayloadHeader& payload_header,
+      std::int64_t sent_offset);
+  // Waits for the endpoint to ack `payload_header`: up to `min_acked_offset`
+  // if it is not negative, or the legacy one-per-payload ack otherwise. If the
+  // cumulative acks stop advancing for the window stall timeout, the payload
+  // is finished for the endpoint with ENDPOINT_IO_ERROR.
+  bool WaitForPayloadAck(
+      ClientProxy* client, const std::string& endpoint_id,
+      const PayloadTransferFrame::PayloadHeader& payload_header,
+      std::int64_t payload_chunk_offset, std::int64_t min_acked_offset);
   bool IsPayloadReceivedAckEnabled(ClientProxy* client,
                                    const std::string& endpoint_id,
                                    PendingPayload& pending_payload);
+  bool IsWindowedPayloadAckEnabled(ClientProxy* client,
+                                   const std::string& endpoint_id,
+                                   PendingPayload& pending_payload);
 
   // Handles a finished outgoing payload for the given endpointIds. All
   // statuses except for SUCCESS are handled here.
@@ -388,6 +447,13 @@ class PayloadManager : public EndpointManager::FrameProcessor {
       RUN_ON_PAYLOAD_STATUS_UPDATE_THREAD();
 
   SingleThreadExecutor* GetOutgoingPayloadExecutor(PayloadType payload_type);
+  // Returns the parallel payload scheduler, creating it on first use, or
+  // nullptr once PayloadManager is shutting down.
+  PayloadScheduler* GetPayloadScheduler() ABSL_LOCKS_EXCLUDED(mutex_);
+  // Returns the PayloadScheduler flow for payloads of `payload_type` sent to
+  // exactly `endpoint_ids`.
+  static std::string GetPayloadFlow(PayloadType payload_type,
+                                    EndpointIds endpoint_ids);
 
   void RunOnStatusUpdateThread(const std::string& name,
                                absl::AnyInvocable<void()> runnable);
@@ -425,6 +491,9 @@ class PayloadManager : public EndpointManager::FrameProcessor {
   SingleThreadExecutor stream_payload_executor_;
   SingleThreadExecutor payload_status_update_executor_;
   SingleThreadExecutor send_payload_ack_executor_;
+  // Sends BYTES and FILE payloads when kEnableParallelPayloadScheduler is on.
+  // Created by the first payload that needs it.
+  std::unique_ptr<PayloadScheduler> payload_scheduler_ ABSL_GUARDED_BY(mutex_);
   PendingPayloads pending_payloads_;
   EndpointManager* endpoint_manager_;
 
@@ -435,6 +504,11 @@ class PayloadManager : public EndpointManager::FrameProcessor {
   mutable Mutex chunk_update_mutex_;
   int outgoing_chunk_update_count_ ABSL_GUARDED_BY(chunk_update_mutex_) = 0;
   int incoming_chunk_update_count_ ABSL_GUARDED_BY(chunk_update_mutex_) = 0;
+
+  // Per-endpoint chunk sizing, used when kEnableAdaptiveChunkSize is on.
+  mutable Mutex chunk_size_mutex_;
+  absl::flat_hash_map<std::string, ChunkSizeController> chunk_size_controllers_
+      ABSL_GUARDED_BY(chunk_size_mutex_);
 };
 
 }  // namespace connections
@@ -33,6 +33,7 @@
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
+#include "internal/platform/feature_flags.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/medium_environment.h"
 #include "internal/platform/pipe.h"
@@ -85,8 +86,10 @@ class PayloadSimulationUser : public SimulationUser {
  public:
   explicit PayloadSimulationUser(
       absl::string_view name,
-      BooleanMediumSelector allowed = BooleanMediumSelector())
-      : SimulationUser(std::string(name), allowed) {}
+      BooleanMediumSelector allowed = BooleanMediumSelector(),
+      SetSafeToDisconnect set_safe_to_disconnect =
+          SetSafeToDisconnect(true, false, true, 5))
+      : SimulationUser(std::string(name), allowed, set_safe_to_disconnect) {}
   ~PayloadSimulationUser() override {
     NEARBY_LOGS(INFO) << "PayloadSimulationUser: [down] name=" << info_.data();
     // SystemClock::Sleep(kDefaultTimeout);
@@ -200,6 +203,26 @@ TEST_P(PayloadManagerTest, CanSendBytePayload) {
   env_.Stop();
 }
 
+TEST_P(PayloadManagerTest, CanSendBytePayloadWithParallelScheduler) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableParallelPayloadScheduler,
+      true);
+  env_.Start();
+  PayloadSimulationUser user_a(kDeviceA, GetParam());
+  PayloadSimulationUser user_b(kDeviceB, GetParam());
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+
+  user_a.ExpectPayload(payload_latch_);
+  user_b.SendPayload(Payload(ByteArray{std::string(kMessage)}));
+  EXPECT_TRUE(payload_latch_.Await(kDefaultTimeout).result());
+  EXPECT_EQ(user_a.GetPayload().AsBytes(), ByteArray(std::string(kMessage)));
+
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+}
+
 TEST_P(PayloadManagerTest, PayloadId0IsError) {
   env_.Start();
   PayloadSimulationUser user_a(kDeviceA, GetParam());
@@ -261,6 +284,97 @@ TEST_P(PayloadManagerTest, CanSendStreamPayload) {
   env_.Stop();
 }
 
+TEST_P(PayloadManagerTest, CanSendStreamPayloadWithWindowedAcks) {
+  // Use the smallest window the sender allows.
+  FeatureFlags::GetMutableFlagsForTesting().payload_ack_window_bytes = 0;
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableWindowedPayloadAck,
+      true);
+  env_.Start();
+  SetSafeToDisconnect windowed_acks(true, false, true, 5);
+  PayloadSimulationUser user_a(kDeviceA, GetParam(), windowed_acks);
+  PayloadSimulationUser user_b(kDeviceB, GetParam(), windowed_acks);
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+
+  auto [input, tx] = CreatePipe();
+  user_a.ExpectPayload(payload_latch_);
+  const ByteArray message{
+      std::string(PayloadManager::kPayloadAckIntervalBytes / 4, 'x')};
+  tx->Write(message);
+  user_b.SendPayload(Payload(std::move(input)));
+  ASSERT_TRUE(payload_latch_.Await(kDefaultTimeout).result());
+  ASSERT_NE(user_a.GetPayload().AsStream(), nullptr);
+  InputStream& rx = *user_a.GetPayload().AsStream();
+
+  // Send more than fits in one ack window, so the sender depends on the
+  // receiver's cumulative acks to keep going.
+  constexpr int kNumChunks = 20;
+  for (int i = 1; i < kNumChunks; ++i) {
+    EXPECT_TRUE(user_a.WaitForProgress(
+        [&message, i](const PayloadProgressInfo& info) {
+          return info.bytes_transferred >= i * message.size();
+        },
+        kProgressTimeout));
+    tx->Write(message);
+  }
+  EXPECT_TRUE(user_a.WaitForProgress(
+      [&message](const PayloadProgressInfo& info) {
+        return info.bytes_transferred >= kNumChunks * message.size();
+      },
+      kProgressTimeout));
+  EXPECT_EQ(rx.ReadExactly(kNumChunks * message.size()).result().size(),
+            kNumChunks * message.size());
+
+  tx->Close();
+  EXPECT_TRUE(user_a.WaitForProgress(
+      [](const PayloadProgressInfo& info) {
+        return info.status == PayloadProgressInfo::Status::kSuccess;
+      },
+      kProgressTimeout));
+  rx.Close();
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+}
+
+TEST_P(PayloadManagerTest, WindowedAckTimeoutFailsPayload) {
+  FeatureFlags::GetMutableFlagsForTesting().payload_ack_window_bytes = 0;
+  FeatureFlags::GetMutableFlagsForTesting()
+      .payload_ack_window_stall_timeout_millis = absl::Milliseconds(200);
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableWindowedPayloadAck,
+      true);
+  env_.Start();
+  SetSafeToDisconnect windowed_acks(true, false, true, 5);
+  PayloadSimulationUser user_a(kDeviceA, GetParam(), windowed_acks);
+  PayloadSimulationUser user_b(kDeviceB, GetParam(), windowed_acks);
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+  // The receiver now believes the sender doesn't support windowed acks, so it
+  // never sends the cumulative acks the sender waits for.
+  user_a.GetClient().SetRemoteFeatureBitmask(
+      user_a.GetDiscovered().endpoint_id, /*remote_feature_bitmask=*/0);
+
+  auto [input, tx] = CreatePipe();
+  const ByteArray message{
+      std::string(PayloadManager::kPayloadAckIntervalBytes, 'x')};
+  for (int i = 0; i < 4; ++i) {
+    tx->Write(message);
+  }
+  user_b.SendPayload(Payload(std::move(input)));
+
+  EXPECT_TRUE(user_b.WaitForProgress(
+      [](const PayloadProgressInfo& info) {
+        return info.status == PayloadProgressInfo::Status::kFailure;
+      },
+      absl::Seconds(5)));
+  tx->Close();
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+}
+
 TEST_P(PayloadManagerTest, CanCancelPayloadOnReceiverSide) {
   env_.Start();
   PayloadSimulationUser user_a(kDeviceA, GetParam());
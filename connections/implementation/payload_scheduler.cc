@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/payload_scheduler.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/mutex_lock.h"
+
+namespace nearby {
+namespace connections {
+
+PayloadScheduler::PayloadScheduler(int max_concurrency)
+    : max_concurrency_(max_concurrency), executor_(max_concurrency) {}
+
+PayloadScheduler::~PayloadScheduler() { Shutdown(); }
+
+void PayloadScheduler::Schedule(absl::string_view flow_name, Priority priority,
+                                Step step) {
+  MutexLock lock(&mutex_);
+  if (shutdown_) return;
+  std::unique_ptr<Flow>& flow = flows_[flow_name];
+  if (flow == nullptr) {
+    flow = std::make_unique<Flow>();
+    flow->priority = priority;
+  }
+  flow->transfers.push_back(std::move(step));
+  if (flow->running || flow->transfers.size() > 1) {
+    // Already queued or running; it will get to this transfer in turn.
+    return;
+  }
+  ready_[static_cast<int>(flow->priority)].emplace_back(flow_name);
+  if (running_workers_ < max_concurrency_) {
+    ++running_workers_;
+    executor_.Execute("payload-scheduler", [this]() { RunSteps(); });
+  }
+}
+
+void PayloadScheduler::Shutdown() {
+  // Queued transfers are released outside the lock.
+  absl::flat_hash_map<std::string, std::unique_ptr<Flow>> flows;
+  {
+    MutexLock lock(&mutex_);
+    shutdown_ = true;
+    flows.swap(flows_);
+    for (std::deque<std::string>& ready : ready_) ready.clear();
+  }
+  executor_.Shutdown();
+}
+
+void PayloadScheduler::RunSteps() {
+  while (true) {
+    std::string flow_name;
+    Step step;
+    {
+      MutexLock lock(&mutex_);
+      Flow* flow = shutdown_ ? nullptr : PickFlow(flow_name);
+      if (flow == nullptr) {
+        --running_workers_;
+        return;
+      }
+      flow->running = true;
+      step = std::move(flow->transfers.front());
+      flow->transfers.pop_front();
+    }
+
+    bool has_more = step();
+
+    MutexLock lock(&mutex_);
+    auto it = flows_.find(flow_name);
+    if (it == flows_.end()) continue;  // Shut down while running.
+    Flow& flow = *it->second;
+    flow.running = false;
+    if (has_more) flow.transfers.push_front(std::move(step));
+    if (flow.transfers.empty()) {
+      flows_.erase(it);
+    } else {
+      // Back of the line, behind every other runnable flow.
+      ready_[static_cast<int>(flow.priority)].push_back(std::move(flow_name));
+    }
+  }
+}
+
+PayloadScheduler::Flow* PayloadScheduler::PickFlow(std::string& flow_name) {
+  std::deque<std::string>& high = ready_[static_cast<int>(Priority::kHigh)];
+  std::deque<std::string>& normal = ready_[static_cast<int>(Priority::kNormal)];
+  std::deque<std::string>* ready;
+  if (!high.empty() &&
+      (normal.empty() || high_priority_steps_in_row_ < kHighPriorityWeight)) {
+    ready = &high;
+    ++high_priority_steps_in_row_;
+  } else if (!normal.empty()) {
+    ready = &normal;
+    high_priority_steps_in_row_ = 0;
+  } else {
+    return nullptr;
+  }
+  flow_name = std::move(ready->front());
+  ready->pop_front();
+  return flows_[flow_name].get();
+}
+
+}  // namespace connections
+}  // namespace nearby
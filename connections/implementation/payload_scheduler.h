@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_PAYLOAD_SCHEDULER_H_
+#define CORE_INTERNAL_PAYLOAD_SCHEDULER_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/multi_thread_executor.h"
+#include "internal/platform/mutex.h"
+
+namespace nearby {
+namespace connections {
+
+// Runs outgoing payload transfers on a bounded pool of threads, one step
+// (normally one chunk) at a time.
+//
+// Transfers are grouped into flows, e.g. all file payloads to one set of
+// endpoints. Transfers within a flow run one after another in the order they
+// were scheduled, so the receiver sees them in order; different flows run
+// concurrently on up to `max_concurrency` threads. Runnable flows take turns
+// step by step, so one large transfer cannot hold back the others. kHigh flows
+// get up to kHighPriorityWeight steps for every kNormal step.
+class PayloadScheduler {
+ public:
+  enum class Priority { kHigh = 0, kNormal = 1 };
+
+  // Runs one step of a transfer. Returns true while the transfer has more
+  // work to do.
+  using Step = absl::AnyInvocable<bool()>;
+
+  static constexpr int kHighPriorityWeight = 4;
+
+  explicit PayloadScheduler(int max_concurrency);
+  ~PayloadScheduler();
+
+  // Queues a transfer at the end of `flow`. `priority` applies to the flow
+  // while it is being created; later transfers in the same flow inherit it.
+  void Schedule(absl::string_view flow, Priority priority, Step step);
+
+  // Drops all queued transfers and waits for running steps to return.
+  void Shutdown();
+
+ private:
+  struct Flow {
+    Priority priority;
+    std::deque<Step> transfers;
+    bool running = false;
+  };
+
+  void RunSteps();
+  // Returns the next runnable flow, or nullptr if there is none.
+  Flow* PickFlow(std::string& flow_name) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int max_concurrency_;
+  Mutex mutex_;
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+  int running_workers_ ABSL_GUARDED_BY(mutex_) = 0;
+  int high_priority_steps_in_row_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::flat_hash_map<std::string, std::unique_ptr<Flow>> flows_
+      ABSL_GUARDED_BY(mutex_);
+  // Names of flows that have transfers and are not running, per priority.
+  std::deque<std::string> ready_[2] ABSL_GUARDED_BY(mutex_);
+  MultiThreadExecutor executor_;
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_PAYLOAD_SCHEDULER_H_
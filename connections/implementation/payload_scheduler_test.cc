@@ -0,0 +1,187 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/payload_scheduler.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/mutex_lock.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr absl::Duration kTimeout = absl::Seconds(5);
+
+// Records the order in which steps run.
+class StepLog {
+ public:
+  // Returns a step that logs `name` and asks to run again `steps - 1` times.
+  PayloadScheduler::Step Transfer(std::string name, int steps,
+                                  CountDownLatch* done = nullptr) {
+    return [this, name, steps, done]() mutable {
+      {
+        MutexLock lock(&mutex_);
+        entries_.push_back(name);
+      }
+      if (--steps > 0) return true;
+      if (done != nullptr) done->CountDown();
+      return false;
+    };
+  }
+
+  std::vector<std::string> entries() {
+    MutexLock lock(&mutex_);
+    return entries_;
+  }
+
+ private:
+  Mutex mutex_;
+  std::vector<std::string> entries_;
+};
+
+// Holds the only scheduler thread until released, so that everything
+// scheduled meanwhile is queued up together.
+PayloadScheduler::Step Gate(CountDownLatch& started, CountDownLatch& release) {
+  return [&started, &release]() {
+    started.CountDown();
+    release.Await(kTimeout);
+    return false;
+  };
+}
+
+TEST(PayloadSchedulerTest, RunsTransfersInFlowInOrder) {
+  PayloadScheduler scheduler(/*max_concurrency=*/4);
+  StepLog log;
+  CountDownLatch done(3);
+
+  scheduler.Schedule("flow", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("a", 2, &done));
+  scheduler.Schedule("flow", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("b", 1, &done));
+  scheduler.Schedule("flow", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("c", 1, &done));
+
+  ASSERT_TRUE(done.Await(kTimeout).result());
+  EXPECT_THAT(log.entries(), ElementsAre("a", "a", "b", "c"));
+}
+
+TEST(PayloadSchedulerTest, FlowsTakeTurns) {
+  PayloadScheduler scheduler(/*max_concurrency=*/1);
+  StepLog log;
+  CountDownLatch started(1);
+  CountDownLatch release(1);
+  CountDownLatch done(2);
+  scheduler.Schedule("gate", PayloadScheduler::Priority::kNormal,
+                     Gate(started, release));
+  ASSERT_TRUE(started.Await(kTimeout).result());
+
+  scheduler.Schedule("large", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("large", 3, &done));
+  scheduler.Schedule("small", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("small", 2, &done));
+  release.CountDown();
+
+  ASSERT_TRUE(done.Await(kTimeout).result());
+  EXPECT_THAT(log.entries(),
+              ElementsAre("large", "small", "large", "small", "large"));
+}
+
+TEST(PayloadSchedulerTest, HighPriorityFlowsGoFirst) {
+  PayloadScheduler scheduler(/*max_concurrency=*/1);
+  StepLog log;
+  CountDownLatch started(1);
+  CountDownLatch release(1);
+  CountDownLatch done(2);
+  scheduler.Schedule("gate", PayloadScheduler::Priority::kNormal,
+                     Gate(started, release));
+  ASSERT_TRUE(started.Await(kTimeout).result());
+
+  scheduler.Schedule("file", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("file", 2, &done));
+  scheduler.Schedule("bytes", PayloadScheduler::Priority::kHigh,
+                     log.Transfer("bytes", 2, &done));
+  release.CountDown();
+
+  ASSERT_TRUE(done.Await(kTimeout).result());
+  EXPECT_THAT(log.entries(), ElementsAre("bytes", "bytes", "file", "file"));
+}
+
+TEST(PayloadSchedulerTest, HighPriorityCannotStarveNormal) {
+  PayloadScheduler scheduler(/*max_concurrency=*/1);
+  StepLog log;
+  CountDownLatch started(1);
+  CountDownLatch release(1);
+  CountDownLatch done(2);
+  scheduler.Schedule("gate", PayloadScheduler::Priority::kNormal,
+                     Gate(started, release));
+  ASSERT_TRUE(started.Await(kTimeout).result());
+
+  scheduler.Schedule("file", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("file", 1, &done));
+  scheduler.Schedule(
+      "bytes", PayloadScheduler::Priority::kHigh,
+      log.Transfer("bytes", PayloadScheduler::kHighPriorityWeight + 1, &done));
+  release.CountDown();
+
+  ASSERT_TRUE(done.Await(kTimeout).result());
+  std::vector<std::string> entries = log.entries();
+  ASSERT_EQ(entries.size(), PayloadScheduler::kHighPriorityWeight + 2);
+  EXPECT_EQ(entries[PayloadScheduler::kHighPriorityWeight], "file");
+}
+
+TEST(PayloadSchedulerTest, RunsFlowsConcurrently) {
+  PayloadScheduler scheduler(/*max_concurrency=*/2);
+  CountDownLatch both_running(2);
+  CountDownLatch done(2);
+  auto transfer = [&both_running, &done]() {
+    both_running.CountDown();
+    // Only counts as done if the other flow is running at the same time.
+    bool concurrent = both_running.Await(kTimeout).result();
+    if (concurrent) done.CountDown();
+    return false;
+  };
+
+  scheduler.Schedule("endpoint-1", PayloadScheduler::Priority::kNormal,
+                     transfer);
+  scheduler.Schedule("endpoint-2", PayloadScheduler::Priority::kNormal,
+                     transfer);
+
+  EXPECT_TRUE(done.Await(kTimeout).result());
+}
+
+TEST(PayloadSchedulerTest, IgnoresTransfersAfterShutdown) {
+  PayloadScheduler scheduler(/*max_concurrency=*/1);
+  StepLog log;
+  CountDownLatch done(1);
+
+  scheduler.Shutdown();
+  scheduler.Schedule("flow", PayloadScheduler::Priority::kNormal,
+                     log.Transfer("late", 1, &done));
+
+  EXPECT_FALSE(done.Await(absl::Milliseconds(100)).result());
+  EXPECT_TRUE(log.entries().empty());
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
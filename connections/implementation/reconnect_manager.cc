@@ -57,7 +57,9 @@ constexpr absl::string_view TAG = "[ReconnectManager]";
 
 ReconnectManager::ReconnectManager(Mediums& mediums,
                                    EndpointChannelManager& channel_manager)
-    : mediums_(&mediums), channel_manager_(&channel_manager) {}
+    : mediums_(&mediums),
+      channel_manager_(&channel_manager),
+      encryption_runner_(&channel_manager.GetUkey2SessionCache()) {}
 
 ReconnectManager::~ReconnectManager() { Shutdown(); }
 
@@ -97,6 +99,16 @@ bool ReconnectManager::AutoReconnect(
         << client->IsOutgoingConnection(endpoint_id);
     return false;
   }
+  if (FeatureFlags::GetInstance()
+          .GetFlags()
+          .enable_auto_reconnect_warm_standby &&
+      FailOverToStandbyChannel(client, endpoint_id, is_incoming)) {
+    if (callback.on_reconnect_success_cb) {
+      callback.on_reconnect_success_cb(client, endpoint_id);
+    }
+    return true;
+  }
+
   std::string reconnect_service_id =
       WrapInitiatorReconnectServiceId(endpoint_channel->GetServiceId());
   endpoint_id_metadata_map_.emplace(
@@ -130,6 +142,78 @@ bool ReconnectManager::AutoReconnect(
   return false;
 }
 
+bool ReconnectManager::FailOverToStandbyChannel(ClientProxy* client,
+                                                const std::string& endpoint_id,
+                                                bool is_incoming) {
+  std::shared_ptr<EndpointChannel> standby_channel =
+      channel_manager_->GetStandbyChannelForEndpoint(endpoint_id);
+  if (standby_channel == nullptr) {
+    return false;
+  }
+  NEARBY_LOGS(INFO) << TAG << " fail over to standby "
+                    << standby_channel->GetType() << " channel for endpoint_id "
+                    << endpoint_id << " started...";
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+
+  // Shared with the encryption callbacks, which may still run after a
+  // timeout.
+  struct EncryptionResult {
+    CountDownLatch latch{1};
+    std::unique_ptr<securegcm::D2DConnectionContextV1> context;
+  };
+  auto result = std::make_shared<EncryptionResult>();
+  EncryptionRunner::ResultListener listener = {
+      .on_success_cb =
+          [result](const std::string& endpoint_id,
+                   std::unique_ptr<securegcm::UKey2Handshake> ukey2,
+                   const std::string& auth_token,
+                   const ByteArray& raw_auth_token) {
+            // The endpoint was verified when it first connected.
+            if (ukey2 != nullptr && ukey2->VerifyHandshake()) {
+              result->context = ukey2->ToConnectionContext();
+            }
+            result->latch.CountDown();
+          },
+      .on_failure_cb =
+          [result](const std::string& endpoint_id, EndpointChannel* channel) {
+            result->latch.CountDown();
+          },
+  };
+  if (client->IsUkey2ResumptionEnabled(endpoint_id)) {
+    listener.on_resume_cb =
+        [result](const std::string& endpoint_id,
+                 std::unique_ptr<securegcm::D2DConnectionContextV1> context) {
+          result->context = std::move(context);
+          result->latch.CountDown();
+        };
+  }
+  if (is_incoming) {
+    encryption_runner_.StartServer(client, endpoint_id, standby_channel.get(),
+                                   std::move(listener));
+  } else {
+    encryption_runner_.StartClient(client, endpoint_id, standby_channel.get(),
+                                   std::move(listener));
+  }
+  bool encrypted =
+      result->latch
+          .Await(FeatureFlags::GetInstance()
+                     .GetFlags()
+                     .auto_reconnect_timeout_millis)
+          .result() &&
+      result->context != nullptr;
+  if (!encrypted || !channel_manager_->FailOverToStandbyChannel(
+                        client, endpoint_id, std::move(result->context))) {
+    NEARBY_LOGS(INFO) << TAG << " fail over to standby channel for endpoint_id "
+                      << endpoint_id << " failed, reconnect instead.";
+    channel_manager_->DropStandbyChannelForEndpoint(endpoint_id);
+    return false;
+  }
+  NEARBY_LOGS(INFO) << TAG << " fail over to standby channel for endpoint_id "
+                    << endpoint_id << " took "
+                    << SystemClock::ElapsedRealtime() - start_time;
+  return true;
+}
+
 bool ReconnectManager::Start(bool is_incoming, ClientProxy* client,
                              const std::string& endpoint_id,
                              const std::string& reconnect_service_id,
@@ -566,7 +650,7 @@ bool ReconnectManager::BaseMediumImpl::ReplaceChannelForEndpoint(
 
 EncryptionRunner::ResultListener
 ReconnectManager::BaseMediumImpl::GetResultListener() {
-  return {
+  EncryptionRunner::ResultListener listener = {
       .on_success_cb =
           [this](const std::string& endpoint_id,
                  std::unique_ptr<securegcm::UKey2Handshake> ukey2,
@@ -597,20 +681,27 @@ ReconnectManager::BaseMediumImpl::GetResultListener() {
                 });
           },
   };
+  // The endpoint was verified when it first connected, so the channel may be
+  // encrypted by resuming that session instead of a fresh handshake.
+  if (client_->IsUkey2ResumptionEnabled(endpoint_id_)) {
+    listener.on_resume_cb =
+        [this](const std::string& endpoint_id,
+               std::unique_ptr<securegcm::D2DConnectionContextV1> context) {
+          reconnect_manager_.encryption_cb_executor_.Execute(
+              "encryption-resumed",
+              [this, endpoint_id, context = std::move(context)]() mutable {
+                OnChannelEncrypted(endpoint_id, std::move(context));
+                wait_encryption_to_finish_->CountDown();
+              });
+        };
+  }
+  return listener;
 }
 
 void ReconnectManager::BaseMediumImpl::OnEncryptionSuccessRunnable(
     const std::string& endpoint_id,
     std::unique_ptr<securegcm::UKey2Handshake> ukey2,
     const std::string& auth_token, const ByteArray& raw_auth_token) {
-  auto item = reconnect_manager_.new_endpoint_channels_.find(endpoint_id);
-  if (item == reconnect_manager_.new_endpoint_channels_.end()) {
-    NEARBY_LOGS(INFO) << "TAG"
-                      << "OnEncryptionSuccess failed, new_endpoint_channel is "
-                         "null for Endpoint:"
-                      << endpoint_id;
-    return;
-  }
   if (!ukey2) {
     NEARBY_LOGS(INFO)
         << "TAG"
@@ -626,6 +717,20 @@ void ReconnectManager::BaseMediumImpl::OnEncryptionSuccessRunnable(
   auto context = ukey2->ToConnectionContext();
   CHECK(context);  // there is no way how this can fail, if Verify succeeded.
   // If it did, it's a UKEY2 protocol bug.
+  OnChannelEncrypted(endpoint_id, std::move(context));
+}
+
+void ReconnectManager::BaseMediumImpl::OnChannelEncrypted(
+    const std::string& endpoint_id,
+    std::unique_ptr<securegcm::D2DConnectionContextV1> context) {
+  auto item = reconnect_manager_.new_endpoint_channels_.find(endpoint_id);
+  if (item == reconnect_manager_.new_endpoint_channels_.end()) {
+    NEARBY_LOGS(INFO) << "TAG"
+                      << "OnEncryptionSuccess failed, new_endpoint_channel is "
+                         "null for Endpoint:"
+                      << endpoint_id;
+    return;
+  }
 
   if (!reconnect_manager_.channel_manager_->EncryptChannelForEndpoint(
           endpoint_id, std::move(context))) {
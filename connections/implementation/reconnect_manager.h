@@ -19,6 +19,7 @@
 #include <string>
 #include <utility>
 
+#include "securegcm/d2d_connection_context_v1.h"
 #include "securegcm/ukey2_handshake.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
@@ -152,6 +153,10 @@ class ReconnectManager {
         const std::string& endpoint_id,
         std::unique_ptr<securegcm::UKey2Handshake> ukey2,
         const std::string& auth_token, const ByteArray& raw_auth_token);
+    // Swaps in the new channel for the endpoint, encrypted with `context`.
+    void OnChannelEncrypted(
+        const std::string& endpoint_id,
+        std::unique_ptr<securegcm::D2DConnectionContextV1> context);
     void OnEncryptionFailureRunnable(const std::string& endpoint_id,
                                      EndpointChannel* endpoint_channel);
     void ProcessSuccessfulReconnection(
@@ -201,6 +206,12 @@ class ReconnectManager {
     BluetoothSocket bluetooth_socket_;
   };
 
+  // Fails over to the endpoint's warm standby channel, if it has one. The
+  // channel is already connected to the endpoint, so only the encryption
+  // handshake (or session resumption) runs before it becomes active.
+  bool FailOverToStandbyChannel(ClientProxy* client,
+                                const std::string& endpoint_id,
+                                bool is_incoming);
   bool Start(bool is_incoming, ClientProxy* client_proxy,
              const std::string& endpoint_id,
              const std::string& reconnect_service_id, Medium medium);
@@ -16,23 +16,45 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "gtest/gtest.h"
+#include "securegcm/ukey2_handshake.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "connections/implementation/base_endpoint_channel.h"
+#include "connections/implementation/bwu_handler.h"
+#include "connections/implementation/bwu_manager.h"
 #include "connections/implementation/client_proxy.h"
+#include "connections/implementation/encryption_runner.h"
+#include "connections/implementation/endpoint_channel.h"
 #include "connections/implementation/endpoint_channel_manager.h"
+#include "connections/implementation/endpoint_manager.h"
+#include "connections/implementation/fake_bwu_handler.h"
 #include "connections/implementation/mediums/mediums.h"
+#include "connections/implementation/offline_frames.h"
 #include "connections/implementation/simulation_user.h"
 #include "connections/medium_selector.h"
+#include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/feature_flags.h"
+#include "internal/platform/input_stream.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/medium_environment.h"
+#include "internal/platform/output_stream.h"
+#include "internal/platform/pipe.h"
+#include "internal/platform/single_thread_executor.h"
+#include "internal/platform/system_clock.h"
 
 namespace nearby {
 namespace connections {
 namespace {
 
+using ::location::nearby::connections::OfflineFrame;
+using ::location::nearby::connections::V1Frame;
+
 constexpr absl::string_view kServiceId = "service-id";
 constexpr absl::string_view kDeviceA = "device-a";
 constexpr absl::string_view kDeviceB = "device-b";
@@ -62,6 +84,115 @@ class ReconnectSimulatorUser : public SimulationUser {
  protected:
 };
 
+// A channel over in-process pipes, standing in for the channel the devices
+// first connected over.
+class PipeEndpointChannel : public BaseEndpointChannel {
+ public:
+  PipeEndpointChannel(InputStream* input, OutputStream* output)
+      : BaseEndpointChannel(std::string(kServiceId), "pipe", input, output) {}
+
+  Medium GetMedium() const override { return Medium::BLE; }
+
+ private:
+  void CloseImpl() override {}
+};
+
+// One device's side of a bandwidth upgrade to a fake WIFI_LAN medium, run by
+// a real BwuManager over an encrypted prior channel.
+class UpgradingDevice {
+ public:
+  UpgradingDevice(ClientProxy* client, std::string endpoint_id,
+                  std::unique_ptr<PipeEndpointChannel> prior_channel)
+      : client_(client),
+        endpoint_id_(std::move(endpoint_id)),
+        prior_channel_(prior_channel.get()) {
+    auto handler = std::make_unique<FakeBwuHandler>(Medium::WIFI_LAN);
+    handler_ = handler.get();
+    absl::flat_hash_map<Medium, std::unique_ptr<BwuHandler>> handlers;
+    handlers.emplace(Medium::WIFI_LAN, std::move(handler));
+    BwuManager::Config config;
+    config.allow_upgrade_to = BooleanMediumSelector{.wifi_lan = true};
+    bwu_manager_ = std::make_unique<BwuManager>(mediums_, em_, ecm_,
+                                                std::move(handlers), config);
+    bwu_manager_->MakeSingleThreadedForTesting();
+    ecm_.RegisterChannelForEndpoint(client_, endpoint_id_,
+                                    std::move(prior_channel));
+  }
+  ~UpgradingDevice() { bwu_manager_->Shutdown(); }
+
+  EndpointChannelManager& GetEndpointChannelManager() { return ecm_; }
+  EndpointChannel* GetPriorChannel() const { return prior_channel_; }
+
+  // Runs the UKEY2 handshake over the prior channel, as the devices do when
+  // they first connect. The peer has to start its side as well.
+  void StartEncryption(bool is_incoming) {
+    EncryptionRunner::ResultListener listener = {
+        .on_success_cb =
+            [this](const std::string& endpoint_id,
+                   std::unique_ptr<securegcm::UKey2Handshake> ukey2,
+                   const std::string& auth_token,
+                   const ByteArray& raw_auth_token) {
+              if (ukey2 != nullptr && ukey2->VerifyHandshake()) {
+                ecm_.EncryptChannelForEndpoint(endpoint_id,
+                                               ukey2->ToConnectionContext());
+              }
+              encryption_latch_.CountDown();
+            },
+        .on_failure_cb =
+            [this](const std::string& endpoint_id, EndpointChannel* channel) {
+              encryption_latch_.CountDown();
+            },
+    };
+    if (is_incoming) {
+      encryption_runner_.StartServer(client_, endpoint_id_, prior_channel_,
+                                     std::move(listener));
+    } else {
+      encryption_runner_.StartClient(client_, endpoint_id_, prior_channel_,
+                                     std::move(listener));
+    }
+  }
+
+  bool AwaitEncryption() {
+    return encryption_latch_.Await(kDefaultTimeout).result() &&
+           prior_channel_->IsEncrypted();
+  }
+
+  // Proposes the upgrade over the prior channel and accepts the peer's
+  // connection over the new medium.
+  void InitiateUpgrade() {
+    bwu_manager_->InitiateBwuForEndpoint(client_, endpoint_id_,
+                                         Medium::WIFI_LAN);
+    handler_->NotifyBwuManagerOfIncomingConnection(
+        /*initialize_call_index=*/0u, bwu_manager_.get());
+  }
+
+  // Hands the frames the peer writes to the prior channel to the BwuManager,
+  // as EndpointManager does, until the upgrade protocol concludes.
+  void ProcessPriorChannelFrames() {
+    while (ecm_.GetStandbyChannelForEndpoint(endpoint_id_) == nullptr) {
+      ExceptionOr<ByteArray> bytes = prior_channel_->Read();
+      if (!bytes.ok()) return;
+      ExceptionOr<OfflineFrame> frame = parser::FromBytes(bytes.result());
+      if (!frame.ok()) return;
+      bwu_manager_->OnIncomingFrame(frame.result(), endpoint_id_, client_,
+                                    Medium::BLE, packet_meta_data_);
+    }
+  }
+
+ private:
+  ClientProxy* client_;
+  std::string endpoint_id_;
+  EndpointChannel* prior_channel_;
+  Mediums mediums_;
+  EndpointChannelManager ecm_;
+  EndpointManager em_{&ecm_};
+  FakeBwuHandler* handler_ = nullptr;
+  std::unique_ptr<BwuManager> bwu_manager_;
+  EncryptionRunner encryption_runner_;
+  CountDownLatch encryption_latch_{1};
+  PacketMetaData packet_meta_data_;
+};
+
 class ReconnectManagerTest
     : public ::testing::TestWithParam<BooleanMediumSelector> {
  protected:
@@ -139,6 +270,98 @@ TEST_P(ReconnectManagerTest, AllowReconnect) {
   env_.Stop();
 }
 
+TEST_P(ReconnectManagerTest, FailOverToWarmStandbyChannel) {
+  FeatureFlags::Flags& flags = FeatureFlags::GetMutableFlagsForTesting();
+  flags.enable_auto_reconnect_warm_standby = true;
+  auto pipe_a_to_b = CreatePipe();
+  auto pipe_b_to_a = CreatePipe();
+  env_.Start();
+  ReconnectSimulatorUser user_a(kDeviceA, GetParam());
+  ReconnectSimulatorUser user_b(kDeviceB, GetParam());
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+
+  const std::string& endpoint_a = user_a.GetDiscovered().endpoint_id;
+  const std::string& endpoint_b = user_b.GetDiscovered().endpoint_id;
+  UpgradingDevice device_a(&user_a.GetClient(), endpoint_a,
+                           std::make_unique<PipeEndpointChannel>(
+                               pipe_b_to_a.first.get(),
+                               pipe_a_to_b.second.get()));
+  UpgradingDevice device_b(&user_b.GetClient(), endpoint_b,
+                           std::make_unique<PipeEndpointChannel>(
+                               pipe_a_to_b.first.get(),
+                               pipe_b_to_a.second.get()));
+  EndpointChannel* prior_a = device_a.GetPriorChannel();
+  EndpointChannel* prior_b = device_b.GetPriorChannel();
+  EndpointChannelManager& ecm_a = device_a.GetEndpointChannelManager();
+  EndpointChannelManager& ecm_b = device_b.GetEndpointChannelManager();
+  device_a.StartEncryption(/*is_incoming=*/true);
+  device_b.StartEncryption(/*is_incoming=*/false);
+  ASSERT_TRUE(device_a.AwaitEncryption());
+  ASSERT_TRUE(device_b.AwaitEncryption());
+
+  // The advertiser upgrades; both sides then drain the prior channel, which
+  // the BwuManagers keep as the standby.
+  SingleThreadExecutor executor;
+  CountDownLatch upgrade_latch(1);
+  device_a.InitiateUpgrade();
+  executor.Execute([&]() {
+    device_a.ProcessPriorChannelFrames();
+    upgrade_latch.CountDown();
+  });
+  device_b.ProcessPriorChannelFrames();
+  ASSERT_TRUE(upgrade_latch.Await(kDefaultTimeout).result());
+  ASSERT_EQ(ecm_a.GetStandbyChannelForEndpoint(endpoint_a).get(), prior_a);
+  ASSERT_EQ(ecm_b.GetStandbyChannelForEndpoint(endpoint_b).get(), prior_b);
+  EXPECT_FALSE(prior_a->IsEncrypted());
+  EXPECT_FALSE(prior_b->IsEncrypted());
+
+  Mediums mediums;
+  ReconnectManager::AutoReconnectCallback callback_a;
+  ReconnectManager::AutoReconnectCallback callback_b;
+  ReconnectManager reconnect_manager_a(mediums, ecm_a);
+  ReconnectManager reconnect_manager_b(mediums, ecm_b);
+  CountDownLatch reconnect_latch(1);
+  bool reconnected_b = false;
+
+  // Both sides notice the drop at about the same time.
+  absl::Time start_time = SystemClock::ElapsedRealtime();
+  executor.Execute([&]() {
+    reconnected_b = reconnect_manager_b.AutoReconnect(
+        &user_b.GetClient(), endpoint_b, callback_b,
+        /*send_disconnection_notification=*/false,
+        DisconnectionReason::UNFINISHED);
+    reconnect_latch.CountDown();
+  });
+  EXPECT_TRUE(reconnect_manager_a.AutoReconnect(
+      &user_a.GetClient(), endpoint_a, callback_a,
+      /*send_disconnection_notification=*/false,
+      DisconnectionReason::UNFINISHED));
+  EXPECT_TRUE(reconnect_latch.Await(kDefaultTimeout).result());
+  absl::Duration failover_time = SystemClock::ElapsedRealtime() - start_time;
+  NEARBY_LOGS(INFO) << "Failover to the standby channel took "
+                    << failover_time;
+
+  EXPECT_TRUE(reconnected_b);
+  EXPECT_LT(failover_time, flags.auto_reconnect_retry_delay_millis);
+  EXPECT_EQ(ecm_a.GetChannelForEndpoint(endpoint_a).get(), prior_a);
+  EXPECT_EQ(ecm_b.GetChannelForEndpoint(endpoint_b).get(), prior_b);
+  EXPECT_EQ(ecm_a.GetStandbyChannelForEndpoint(endpoint_a), nullptr);
+  EXPECT_EQ(prior_a->GetType(), "ENCRYPTED_BLE");
+  EXPECT_EQ(prior_b->GetType(), "ENCRYPTED_BLE");
+
+  // The failover negotiated fresh keys that both sides agree on.
+  ASSERT_TRUE(prior_a->Write(parser::ForKeepAlive()).Ok());
+  ExceptionOr<ByteArray> bytes = prior_b->Read();
+  ASSERT_TRUE(bytes.ok());
+  ExceptionOr<OfflineFrame> frame = parser::FromBytes(bytes.result());
+  ASSERT_TRUE(frame.ok());
+  EXPECT_EQ(parser::GetFrameType(frame.result()), V1Frame::KEEP_ALIVE);
+
+  user_a.Stop();
+  user_b.Stop();
+  env_.Stop();
+}
+
 INSTANTIATE_TEST_SUITE_P(ParametrisedReconnectManagerTest, ReconnectManagerTest,
                          ::testing::ValuesIn(kTestCases));
 
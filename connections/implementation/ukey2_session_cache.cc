@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/ukey2_session_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "securegcm/d2d_connection_context_v1.h"
+#include "absl/time/time.h"
+#include "internal/crypto_cros/hkdf.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/platform/system_clock.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+constexpr char kTicketIdInfo[] = "UKEY2 resumption ticket id";
+constexpr char kSecretInfo[] = "UKEY2 resumption secret";
+
+}  // namespace
+
+Ukey2SessionCache::Ukey2SessionCache(int max_entries, absl::Duration lifetime)
+    : max_entries_(max_entries), lifetime_(lifetime) {}
+
+void Ukey2SessionCache::Put(const std::string& endpoint_id,
+                            securegcm::D2DConnectionContextV1& context) {
+  std::unique_ptr<std::string> session_unique = context.GetSessionUnique();
+  if (session_unique == nullptr || max_entries_ <= 0) return;
+  Entry entry{
+      .ticket =
+          {
+              .id = crypto::HkdfSha256(*session_unique, /*salt=*/"",
+                                       kTicketIdInfo, kTicketIdLength),
+              .secret = crypto::HkdfSha256(*session_unique, /*salt=*/"",
+                                           kSecretInfo, kSecretLength),
+          },
+      .expires_at = SystemClock::ElapsedRealtime() + lifetime_,
+  };
+
+  MutexLock lock(&mutex_);
+  entry.sequence = next_sequence_++;
+  if (!entries_.contains(endpoint_id) &&
+      entries_.size() >= static_cast<size_t>(max_entries_)) {
+    auto oldest = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->second.sequence < oldest->second.sequence) oldest = it;
+    }
+    entries_.erase(oldest);
+  }
+  entries_.insert_or_assign(endpoint_id, std::move(entry));
+}
+
+std::optional<Ukey2SessionCache::Ticket> Ukey2SessionCache::Get(
+    const std::string& endpoint_id) {
+  MutexLock lock(&mutex_);
+  auto it = entries_.find(endpoint_id);
+  if (it == entries_.end()) return std::nullopt;
+  if (SystemClock::ElapsedRealtime() >= it->second.expires_at) {
+    entries_.erase(it);
+    return std::nullopt;
+  }
+  return it->second.ticket;
+}
+
+void Ukey2SessionCache::Remove(const std::string& endpoint_id) {
+  MutexLock lock(&mutex_);
+  entries_.erase(endpoint_id);
+}
+
+}  // namespace connections
+}  // namespace nearby
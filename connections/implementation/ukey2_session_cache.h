@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_UKEY2_SESSION_CACHE_H_
+#define CORE_INTERNAL_UKEY2_SESSION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "securegcm/d2d_connection_context_v1.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/time/time.h"
+#include "internal/platform/mutex.h"
+
+namespace nearby {
+namespace connections {
+
+// Remembers a resumption ticket for recently encrypted endpoints, so that a
+// later channel to the same endpoint (e.g. after an auto-reconnect) can derive
+// fresh keys in one round trip instead of running a full UKEY2 handshake.
+//
+// Tickets are derived from the session's unique value, so both peers end up
+// with the same ticket without exchanging anything. A ticket expires after
+// `lifetime`; at most `max_entries` are kept, and the oldest one makes room
+// for a new one.
+class Ukey2SessionCache {
+ public:
+  static constexpr size_t kTicketIdLength = 16;
+  static constexpr size_t kSecretLength = 32;
+
+  struct Ticket {
+    // Names the session on the wire.
+    std::string id;
+    // Never leaves the device; resumed session keys are derived from it.
+    std::string secret;
+  };
+
+  Ukey2SessionCache(int max_entries, absl::Duration lifetime);
+
+  // Replaces the ticket for `endpoint_id` with one for `context`.
+  void Put(const std::string& endpoint_id,
+           securegcm::D2DConnectionContextV1& context)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Returns the ticket for `endpoint_id`, unless there is none or it expired.
+  std::optional<Ticket> Get(const std::string& endpoint_id)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  void Remove(const std::string& endpoint_id) ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    Ticket ticket;
+    absl::Time expires_at;
+    // Orders entries by age.
+    std::uint64_t sequence = 0;
+  };
+
+  const int max_entries_;
+  const absl::Duration lifetime_;
+  Mutex mutex_;
+  std::uint64_t next_sequence_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::flat_hash_map<std::string, Entry> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_UKEY2_SESSION_CACHE_H_
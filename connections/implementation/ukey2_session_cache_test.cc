@@ -0,0 +1,130 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/ukey2_session_cache.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "securegcm/d2d_connection_context_v1.h"
+#include "securegcm/ukey2_handshake.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+using ::securegcm::D2DConnectionContextV1;
+using ::securegcm::UKey2Handshake;
+
+constexpr absl::Duration kLifetime = absl::Minutes(10);
+constexpr UKey2Handshake::HandshakeCipher kCipher =
+    UKey2Handshake::HandshakeCipher::P256_SHA512;
+
+// Runs UKEY2 in memory and returns the initiator's and responder's contexts.
+std::pair<std::unique_ptr<D2DConnectionContextV1>,
+          std::unique_ptr<D2DConnectionContextV1>>
+Handshake() {
+  auto initiator = UKey2Handshake::ForInitiator(kCipher);
+  auto responder = UKey2Handshake::ForResponder(kCipher);
+  EXPECT_TRUE(
+      responder->ParseHandshakeMessage(*initiator->GetNextHandshakeMessage())
+          .success);
+  EXPECT_TRUE(
+      initiator->ParseHandshakeMessage(*responder->GetNextHandshakeMessage())
+          .success);
+  EXPECT_TRUE(
+      responder->ParseHandshakeMessage(*initiator->GetNextHandshakeMessage())
+          .success);
+  EXPECT_NE(initiator->GetVerificationString(32), nullptr);
+  EXPECT_NE(responder->GetVerificationString(32), nullptr);
+  EXPECT_TRUE(initiator->VerifyHandshake());
+  EXPECT_TRUE(responder->VerifyHandshake());
+  return {initiator->ToConnectionContext(), responder->ToConnectionContext()};
+}
+
+TEST(Ukey2SessionCacheTest, BothSidesGetTheSameTicket) {
+  auto [context_a, context_b] = Handshake();
+  Ukey2SessionCache cache_a(/*max_entries=*/4, kLifetime);
+  Ukey2SessionCache cache_b(/*max_entries=*/4, kLifetime);
+
+  cache_a.Put("B", *context_a);
+  cache_b.Put("A", *context_b);
+
+  std::optional<Ukey2SessionCache::Ticket> ticket_a = cache_a.Get("B");
+  std::optional<Ukey2SessionCache::Ticket> ticket_b = cache_b.Get("A");
+  ASSERT_TRUE(ticket_a.has_value());
+  ASSERT_TRUE(ticket_b.has_value());
+  EXPECT_EQ(ticket_a->id.size(), Ukey2SessionCache::kTicketIdLength);
+  EXPECT_EQ(ticket_a->secret.size(), Ukey2SessionCache::kSecretLength);
+  EXPECT_EQ(ticket_a->id, ticket_b->id);
+  EXPECT_EQ(ticket_a->secret, ticket_b->secret);
+  EXPECT_NE(ticket_a->id, ticket_a->secret.substr(0, ticket_a->id.size()));
+}
+
+TEST(Ukey2SessionCacheTest, NewSessionReplacesTicket) {
+  auto first = Handshake();
+  auto second = Handshake();
+  Ukey2SessionCache cache(/*max_entries=*/4, kLifetime);
+
+  cache.Put("A", *first.first);
+  std::optional<Ukey2SessionCache::Ticket> old_ticket = cache.Get("A");
+  cache.Put("A", *second.first);
+  std::optional<Ukey2SessionCache::Ticket> new_ticket = cache.Get("A");
+
+  ASSERT_TRUE(old_ticket.has_value());
+  ASSERT_TRUE(new_ticket.has_value());
+  EXPECT_NE(old_ticket->id, new_ticket->id);
+}
+
+TEST(Ukey2SessionCacheTest, ExpiredTicketIsDropped) {
+  auto [context, unused] = Handshake();
+  Ukey2SessionCache cache(/*max_entries=*/4, absl::ZeroDuration());
+
+  cache.Put("A", *context);
+
+  EXPECT_FALSE(cache.Get("A").has_value());
+}
+
+TEST(Ukey2SessionCacheTest, OldestTicketMakesRoom) {
+  auto first = Handshake();
+  auto second = Handshake();
+  auto third = Handshake();
+  Ukey2SessionCache cache(/*max_entries=*/2, kLifetime);
+
+  cache.Put("A", *first.first);
+  cache.Put("B", *second.first);
+  cache.Put("C", *third.first);
+
+  EXPECT_FALSE(cache.Get("A").has_value());
+  EXPECT_TRUE(cache.Get("B").has_value());
+  EXPECT_TRUE(cache.Get("C").has_value());
+}
+
+TEST(Ukey2SessionCacheTest, RemoveDropsTicket) {
+  auto [context, unused] = Handshake();
+  Ukey2SessionCache cache(/*max_entries=*/4, kLifetime);
+
+  cache.Put("A", *context);
+  cache.Remove("A");
+
+  EXPECT_FALSE(cache.Get("A").has_value());
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
@@ -96,6 +96,10 @@ static const uint8_t kSassRrdKey[] = {'S', 'A', 'S', 'S', '-', 'R',
 static AccountKeyList account_key_list;
 
 static uint8_t sha_buffer[32];
+// The account key followed by the salt, battery and random resolvable fields.
+// Each of the fields is at most 15 bytes plus its LT header.
+static uint8_t bloom_filter_input[ACCOUNT_KEY_SIZE_BYTES +
+                                  3 * (0x0F + LTV_HEADER_SIZE)];
 
 #define RETURN_IF_ERROR(X)                        \
   do {                                            \
@@ -401,6 +405,26 @@ size_t nearby_fp_SetBloomFilter(uint8_t* advertisement, bool use_sass_format,
       random_resolvable_field != NULL
           ? GetLtLength(*random_resolvable_field) + LTV_HEADER_SIZE
           : 0;
+  // The hash input is the account key followed by the fields above. The
+  // fields are the same for every key, so they are copied in once and only
+  // the key is replaced for each hash. The whole input is hashed with a single
+  // update, which saves the per-call overhead of hardware SHA engines. There
+  // is no SHA-256 midstate worth caching: a 16-byte key doesn't fill a 64-byte
+  // block, so nothing is compressed before the salt, and the salt changes on
+  // every rotation.
+  size_t input_length = ACCOUNT_KEY_SIZE_BYTES;
+  memcpy(bloom_filter_input + input_length, salt, salt_length);
+  input_length += salt_length;
+  if (battery_info_field != NULL) {
+    memcpy(bloom_filter_input + input_length, battery_info_field,
+           battery_info_field_length);
+    input_length += battery_info_field_length;
+  }
+  if (random_resolvable_field != NULL) {
+    memcpy(bloom_filter_input + input_length, random_resolvable_field,
+           random_resolvable_field_length);
+    input_length += random_resolvable_field_length;
+  }
   const size_t n = nearby_fp_GetUniqueAccountKeyCount();
   const size_t s = (6 * n + 15) / 5;
   NEARBY_ASSERT(s == GetLtLength(advertisement[ACCOUNT_KEY_DATA_OFFSET]));
@@ -410,26 +434,20 @@ size_t nearby_fp_SetBloomFilter(uint8_t* advertisement, bool use_sass_format,
     key_offset = nearby_fp_GetNextUniqueAccountKeyIndex(key_offset);
     NEARBY_ASSERT(key_offset >= 0);
     const uint8_t* key = nearby_fp_GetAccountKey(key_offset)->account_key;
-    uint8_t flags = key[0];
+    memcpy(bloom_filter_input, key, ACCOUNT_KEY_SIZE_BYTES);
     if (use_sass_format) {
       if (in_use_key != NULL) {
         if (!memcmp(key, in_use_key, ACCOUNT_KEY_SIZE_BYTES)) {
-          flags |= IN_USE_ACCOUNT_KEY_BIT;
+          bloom_filter_input[0] |= IN_USE_ACCOUNT_KEY_BIT;
         }
       } else if (k == 0) {
         // The first key is the most recently used one
-        flags |= MOST_RECENTLY_USED_ACCOUNT_KEY_BIT;
+        bloom_filter_input[0] |= MOST_RECENTLY_USED_ACCOUNT_KEY_BIT;
       }
     }
     key_offset++;
     nearby_platform_Sha256Start();
-    nearby_platform_Sha256Update(&flags, sizeof(flags));
-    nearby_platform_Sha256Update(key + sizeof(flags),
-                                 ACCOUNT_KEY_SIZE_BYTES - sizeof(flags));
-    nearby_platform_Sha256Update(salt, salt_length);
-    nearby_platform_Sha256Update(battery_info_field, battery_info_field_length);
-    nearby_platform_Sha256Update(random_resolvable_field,
-                                 random_resolvable_field_length);
+    nearby_platform_Sha256Update(bloom_filter_input, input_length);
     nearby_platform_Sha256Finish(sha_buffer);
     for (unsigned j = 0; j < 8; j++) {
       uint32_t x = nearby_utils_GetBigEndian32(sha_buffer + 4 * j);
@@ -70,7 +70,8 @@ FastPairService::FastPairService(
           authentication_manager_.get(), account_manager_.get(),
           http_client_.get(), &fast_pair_http_notifier_, device_info_.get())),
       fast_pair_repository_(
-          std::make_unique<FastPairRepositoryImpl>(fast_pair_client_.get())),
+          std::make_unique<FastPairRepositoryImpl>(fast_pair_client_.get(),
+                                                   account_manager_.get())),
       on_device_destroyed_callback_(
           [this](const FastPairDevice& device) { OnDeviceDestroyed(device); }) {
   NearbyFlags::GetInstance().OverrideBoolFlagValue(
@@ -14,6 +14,7 @@
 
 #include "fastpair/repository/fast_pair_repository_impl.h"
 
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
@@ -22,10 +23,13 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "fastpair/common/account_key.h"
 #include "fastpair/common/device_metadata.h"
 #include "fastpair/proto/data.proto.h"
 #include "fastpair/proto/enum.proto.h"
 #include "fastpair/proto/proto_builder.h"
+#include "internal/platform/clock.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/single_thread_executor.h"
 
@@ -70,16 +74,46 @@ bool IsDeviceSha256Matched(const proto::FastPairDevice& device,
          FastPairRepository::GenerateSha256OfAccountKeyAndMacAddress(
              AccountKey(device.account_key()), mac_address);
 }
+
+// How old the local copy of the user's saved devices may get before a lookup
+// triggers a background sync with the server.
+constexpr absl::Duration kSavedDevicesRefreshInterval = absl::Minutes(5);
 }  // namespace
 
-FastPairRepositoryImpl::FastPairRepositoryImpl(FastPairClient* fast_pair_client)
-    : fast_pair_client_(fast_pair_client) {}
+FastPairRepositoryImpl::FastPairRepositoryImpl(FastPairClient* fast_pair_client,
+                                               AccountManager* account_manager,
+                                               Clock* clock)
+    : fast_pair_client_(fast_pair_client),
+      account_manager_(account_manager),
+      clock_(clock != nullptr ? clock : &default_clock_) {
+  if (account_manager_ != nullptr) {
+    account_manager_->AddObserver(this);
+    // No login event comes for an account that is already signed in, so load
+    // its saved devices now, ahead of any lookup.
+    if (account_manager_->GetCurrentAccount().has_value()) {
+      executor_.Execute("Load saved devices", [this]() {
+        NEARBY_LOGS(INFO) << __func__ << ": Start to load saved devices.";
+        SyncSavedDevices().IgnoreError();
+      });
+    }
+  }
+}
+
+FastPairRepositoryImpl::~FastPairRepositoryImpl() {
+  if (account_manager_ != nullptr) {
+    account_manager_->RemoveObserver(this);
+  }
+  // Waits for queued tasks, which use the members below.
+  executor_.Shutdown();
+}
 
-void FastPairRepositoryImpl::AddObserver(Observer* observer) {
+void FastPairRepositoryImpl::AddObserver(
+    FastPairRepository::Observer* observer) {
   observers_.AddObserver(observer);
 }
 
-void FastPairRepositoryImpl::RemoveObserver(Observer* observer) {
+void FastPairRepositoryImpl::RemoveObserver(
+    FastPairRepository::Observer* observer) {
   observers_.RemoveObserver(observer);
 }
 
@@ -127,6 +161,10 @@ void FastPairRepositoryImpl::WriteAccountAssociationToFootprints(
         if (response.ok()) {
           NEARBY_LOGS(INFO)
               << __func__ << "Got GetWriteDeviceResponse from backend.";
+          if (request.fast_pair_info().has_device()) {
+            DropSavedDevicesOfOtherAccount();
+            AddSavedDevice(request.fast_pair_info().device());
+          }
           std::move(callback)(absl::OkStatus());
         } else {
           NEARBY_LOGS(WARNING)
@@ -143,7 +181,7 @@ void FastPairRepositoryImpl::DeleteAssociatedDeviceByAccountKey(
   absl::AsciiStrToUpper(&hex_string);
   executor_.Execute(
       "Delete associated device",
-      [this, hex_account_key = std::move(hex_string),
+      [this, account_key, hex_account_key = std::move(hex_string),
        callback = std::move(callback)]() mutable {
         NEARBY_LOGS(INFO)
             << __func__
@@ -156,6 +194,8 @@ void FastPairRepositoryImpl::DeleteAssociatedDeviceByAccountKey(
           if (response->success()) {
             NEARBY_LOGS(INFO)
                 << __func__ << "Successfully deleted associated device.";
+            DropSavedDevicesOfOtherAccount();
+            RemoveSavedDevice(account_key);
             std::move(callback)(absl::OkStatus());
           } else {
             NEARBY_LOGS(WARNING) << __func__ << "Failed to delete device.";
@@ -175,9 +215,8 @@ void FastPairRepositoryImpl::GetUserSavedDevices() {
   executor_.Execute("Get associated devices", [this]() mutable {
     NEARBY_LOGS(INFO) << __func__
                       << ": Start to get all account associated devices.";
-    proto::UserReadDevicesRequest request;
     absl::StatusOr<proto::UserReadDevicesResponse> response =
-        fast_pair_client_->UserReadDevices(request);
+        SyncSavedDevices();
     if (!response.ok()) {
       NEARBY_LOGS(WARNING)
           << __func__ << "Failed to get UserReadDevicesResponse from backend.";
@@ -218,26 +257,43 @@ void FastPairRepositoryImpl::CheckIfAssociatedWithCurrentAccount(
                                                  callback)]() mutable {
     NEARBY_LOGS(INFO) << __func__
                       << ": Start to check if associated with current account.";
-    proto::UserReadDevicesRequest request;
-    absl::StatusOr<proto::UserReadDevicesResponse> response =
-        fast_pair_client_->UserReadDevices(request);
-    if (response.ok()) {
-      for (const auto& info : response->fast_pair_info()) {
-        if (!info.has_device()) {
-          continue;
-        }
-        AccountKey account_key(info.device().account_key());
-        if (!account_key_filter.IsPossiblyInSet(account_key)) {
-          continue;
-        }
-        proto::StoredDiscoveryItem device;
-        if (device.ParseFromString(info.device().discovery_item_bytes())) {
-          NEARBY_LOGS(INFO)
-              << "Account key matched with a paired device: " << device.title();
-          std::move(callback)(account_key, device.id());
-          return;
+    DropSavedDevicesOfOtherAccount();
+    if (!saved_devices_.has_value()) {
+      // Until the first sync for the current account completes, ask the
+      // server, which also fills the local copy for later lookups.
+      absl::StatusOr<proto::UserReadDevicesResponse> response =
+          SyncSavedDevices();
+      if (response.ok()) {
+        for (const auto& info : response->fast_pair_info()) {
+          if (!info.has_device()) {
+            continue;
+          }
+          AccountKey account_key(info.device().account_key());
+          if (!account_key_filter.IsPossiblyInSet(account_key)) {
+            continue;
+          }
+          proto::StoredDiscoveryItem device;
+          if (device.ParseFromString(info.device().discovery_item_bytes())) {
+            NEARBY_LOGS(INFO) << "Account key matched with a paired device: "
+                              << device.title();
+            std::move(callback)(account_key, device.id());
+            return;
+          }
         }
       }
+      NEARBY_LOGS(INFO) << "Account key does not match any paired devices.";
+      std::move(callback)(std::nullopt, std::nullopt);
+      return;
+    }
+    // Later lookups answer from the local copy and don't wait for the server.
+    RefreshSavedDevicesIfStale();
+    for (const SavedDevice& saved_device : *saved_devices_) {
+      if (account_key_filter.IsPossiblyInSet(saved_device.account_key)) {
+        NEARBY_LOGS(INFO) << "Account key matched with a paired device: "
+                          << saved_device.model_id;
+        std::move(callback)(saved_device.account_key, saved_device.model_id);
+        return;
+      }
     }
     NEARBY_LOGS(INFO) << "Account key does not match any paired devices.";
     std::move(callback)(std::nullopt, std::nullopt);
@@ -252,9 +308,8 @@ void FastPairRepositoryImpl::IsDeviceSavedToAccount(
        callback = std::move(callback)]() mutable {
         NEARBY_LOGS(INFO) << __func__
                           << ": Start to check is device saved to account.";
-        proto::UserReadDevicesRequest request;
         absl::StatusOr<proto::UserReadDevicesResponse> response =
-            fast_pair_client_->UserReadDevices(request);
+            SyncSavedDevices();
         if (!response.ok()) {
           NEARBY_LOGS(WARNING)
               << __func__
@@ -277,5 +332,109 @@ void FastPairRepositoryImpl::IsDeviceSavedToAccount(
       });
 }
 
+void FastPairRepositoryImpl::OnLoginSucceeded(absl::string_view account_id) {
+  executor_.Execute("Account login", [this]() {
+    ClearSavedDevices();
+    // Have the new account's saved devices ready for the first lookup.
+    RefreshSavedDevicesIfStale();
+  });
+}
+
+void FastPairRepositoryImpl::OnLogoutSucceeded(absl::string_view account_id) {
+  executor_.Execute("Account logout", [this]() { ClearSavedDevices(); });
+}
+
+absl::StatusOr<proto::UserReadDevicesResponse>
+FastPairRepositoryImpl::SyncSavedDevices() {
+  saved_devices_sync_queued_ = false;
+  std::string account_id = GetCurrentAccountId();
+  proto::UserReadDevicesRequest request;
+  absl::StatusOr<proto::UserReadDevicesResponse> response =
+      fast_pair_client_->UserReadDevices(request);
+  // The account may have changed while the request was in flight.
+  if (account_id != GetCurrentAccountId()) {
+    return response;
+  }
+  if (account_id != saved_devices_account_id_) {
+    ClearSavedDevices();
+    saved_devices_account_id_ = account_id;
+  }
+  if (response.ok()) {
+    ReplaceSavedDevices(*response);
+  }
+  // Also after a failure, so that an unreachable server is not retried for
+  // every advertisement.
+  saved_devices_synced_at_ = clock_->Now();
+  return response;
+}
+
+void FastPairRepositoryImpl::ReplaceSavedDevices(
+    const proto::UserReadDevicesResponse& response) {
+  saved_devices_.emplace();
+  for (const auto& info : response.fast_pair_info()) {
+    if (info.has_device()) {
+      AddSavedDevice(info.device());
+    }
+  }
+}
+
+void FastPairRepositoryImpl::AddSavedDevice(
+    const proto::FastPairDevice& device) {
+  if (!saved_devices_.has_value()) {
+    // Nothing to add to yet; the first sync brings in this device too.
+    return;
+  }
+  proto::StoredDiscoveryItem discovery_item;
+  if (!discovery_item.ParseFromString(device.discovery_item_bytes())) {
+    return;
+  }
+  AccountKey account_key(device.account_key());
+  RemoveSavedDevice(account_key);
+  saved_devices_->push_back(SavedDevice{.account_key = std::move(account_key),
+                                        .model_id = discovery_item.id()});
+}
+
+void FastPairRepositoryImpl::RemoveSavedDevice(const AccountKey& account_key) {
+  if (!saved_devices_.has_value()) return;
+  saved_devices_->erase(
+      std::remove_if(saved_devices_->begin(), saved_devices_->end(),
+                     [&](const SavedDevice& saved_device) {
+                       return saved_device.account_key == account_key;
+                     }),
+      saved_devices_->end());
+}
+
+void FastPairRepositoryImpl::RefreshSavedDevicesIfStale() {
+  if (saved_devices_sync_queued_ ||
+      clock_->Now() - saved_devices_synced_at_ < kSavedDevicesRefreshInterval) {
+    return;
+  }
+  saved_devices_sync_queued_ = true;
+  executor_.Execute("Sync saved devices", [this]() {
+    NEARBY_LOGS(INFO) << __func__ << ": Start to sync saved devices.";
+    // A failed sync is retried once the local copy is stale again.
+    SyncSavedDevices().IgnoreError();
+  });
+}
+
+void FastPairRepositoryImpl::DropSavedDevicesOfOtherAccount() {
+  if (GetCurrentAccountId() != saved_devices_account_id_) {
+    ClearSavedDevices();
+  }
+}
+
+void FastPairRepositoryImpl::ClearSavedDevices() {
+  saved_devices_.reset();
+  saved_devices_account_id_.clear();
+  saved_devices_synced_at_ = absl::InfinitePast();
+}
+
+std::string FastPairRepositoryImpl::GetCurrentAccountId() {
+  if (account_manager_ == nullptr) return "";
+  std::optional<AccountManager::Account> account =
+      account_manager_->GetCurrentAccount();
+  return account.has_value() ? account->id : "";
+}
+
 }  // namespace fastpair
 }  // namespace nearby
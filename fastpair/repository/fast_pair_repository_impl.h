@@ -16,28 +16,45 @@
 #define THIRD_PARTY_NEARBY_FASTPAIR_REPOSITORY_FAST_PAIR_REPOSITORY_IMPL_H_
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "fastpair/common/account_key.h"
 #include "fastpair/common/device_metadata.h"
+#include "fastpair/proto/data.proto.h"
+#include "fastpair/proto/fastpair_rpcs.proto.h"
 #include "fastpair/repository/fast_pair_repository.h"
 #include "fastpair/server_access/fast_pair_client.h"
 #include "internal/base/observer_list.h"
+#include "internal/platform/clock.h"
+#include "internal/platform/clock_impl.h"
+#include "internal/platform/implementation/account_manager.h"
 #include "internal/platform/single_thread_executor.h"
 
 namespace nearby {
 namespace fastpair {
 
-class FastPairRepositoryImpl : public FastPairRepository {
+class FastPairRepositoryImpl : public FastPairRepository,
+                               public AccountManager::Observer {
  public:
-  explicit FastPairRepositoryImpl(FastPairClient* fast_pair_client);
+  // If `account_manager` is set, the local copy of the user's saved devices
+  // belongs to its current account and is dropped when the account changes.
+  // `clock` decides when the local copy is stale; the system clock is used if
+  // it isn't set.
+  explicit FastPairRepositoryImpl(FastPairClient* fast_pair_client,
+                                  AccountManager* account_manager = nullptr,
+                                  Clock* clock = nullptr);
 
   FastPairRepositoryImpl(const FastPairRepositoryImpl&) = delete;
   FastPairRepositoryImpl& operator=(const FastPairRepositoryImpl&) = delete;
-  ~FastPairRepositoryImpl() override = default;
+  ~FastPairRepositoryImpl() override;
 
-  void AddObserver(Observer* observer) override;
-  void RemoveObserver(Observer* observer) override;
+  void AddObserver(FastPairRepository::Observer* observer) override;
+  void RemoveObserver(FastPairRepository::Observer* observer) override;
 
   void GetDeviceMetadata(absl::string_view hex_model_id,
                          DeviceMetadataCallback callback) override;
@@ -57,10 +74,46 @@ class FastPairRepositoryImpl : public FastPairRepository {
   void IsDeviceSavedToAccount(absl::string_view mac_address,
                               OperationCallback callback) override;
 
+  // AccountManager::Observer:
+  void OnLoginSucceeded(absl::string_view account_id) override;
+  void OnLogoutSucceeded(absl::string_view account_id) override;
+
  private:
+  // A saved device, with what account key matching needs already parsed.
+  struct SavedDevice {
+    AccountKey account_key;
+    std::string model_id;
+  };
+
+  // The methods below run on |executor_|, which also owns |saved_devices_|.
+
+  // Reads the saved devices from the server and refreshes the local copy.
+  absl::StatusOr<proto::UserReadDevicesResponse> SyncSavedDevices();
+  void ReplaceSavedDevices(const proto::UserReadDevicesResponse& response);
+  void AddSavedDevice(const proto::FastPairDevice& device);
+  void RemoveSavedDevice(const AccountKey& account_key);
+  // Queues a background sync unless the local copy is recent or a sync is
+  // already queued, so a burst of advertisements costs one server call.
+  void RefreshSavedDevicesIfStale();
+  // Drops the local copy if it belongs to another account than the current
+  // one.
+  void DropSavedDevicesOfOtherAccount();
+  void ClearSavedDevices();
+  std::string GetCurrentAccountId();
+
   // A thread for running blocking tasks.
   SingleThreadExecutor executor_;
   FastPairClient* fast_pair_client_;
+  AccountManager* const account_manager_;
+  ClockImpl default_clock_;
+  Clock* const clock_;
+  // Local copy of the user's saved devices, kept in memory only since account
+  // key matching needs the raw keys. std::nullopt until the first sync for
+  // |saved_devices_account_id_| completes.
+  std::optional<std::vector<SavedDevice>> saved_devices_;
+  std::string saved_devices_account_id_;
+  absl::Time saved_devices_synced_at_ = absl::InfinitePast();
+  bool saved_devices_sync_queued_ = false;
   absl::flat_hash_map<std::string, std::unique_ptr<DeviceMetadata>>
       metadata_cache_;
   ObserverList<FastPairRepository::Observer> observers_;
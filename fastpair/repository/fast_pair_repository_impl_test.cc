@@ -14,6 +14,7 @@
 
 #include "fastpair/repository/fast_pair_repository_impl.h"
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -23,12 +24,16 @@
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "fastpair/common/device_metadata.h"
 #include "fastpair/proto/data.proto.h"
 #include "fastpair/proto/fast_pair_string.proto.h"
 #include "fastpair/proto/proto_builder.h"
 #include "fastpair/server_access/fake_fast_pair_client.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/implementation/account_manager.h"
+#include "internal/test/fake_account_manager.h"
+#include "internal/test/fake_clock.h"
 
 namespace nearby {
 namespace fastpair {
@@ -77,6 +82,54 @@ class FastPairRepositoryObserver : public FastPairRepository::Observer {
   std::vector<proto::FastPairDevice> devices_;
 };
 
+// Syncs the repository's local copy of the user's saved devices, which
+// account key lookups answer from.
+void SyncSavedDevices(FastPairRepositoryImpl& fast_pair_repository) {
+  CountDownLatch latch(1);
+  fast_pair_repository.IsDeviceSavedToAccount(
+      kBleAddress, [&](absl::Status status) { latch.CountDown(); });
+  latch.Await();
+}
+
+AccountManager::Account MakeAccount(absl::string_view id) {
+  AccountManager::Account account;
+  account.id = std::string(id);
+  return account;
+}
+
+proto::UserReadDevicesResponse MakeUserReadDevicesResponse(
+    const AccountKey& account_key) {
+  proto::UserReadDevicesResponse response_proto;
+  FastPairDevice device(kHexModelId, kBleAddress,
+                        Protocol::kFastPairInitialPairing);
+  device.SetAccountKey(account_key);
+  device.SetPublicAddress(kPublicAddress);
+  device.SetDisplayName(kDisplayName);
+  proto::GetObservedDeviceResponse get_observed_device_response;
+  DeviceMetadata device_metadata(get_observed_device_response);
+  device.SetMetadata(device_metadata);
+  BuildFastPairInfo(response_proto.add_fast_pair_info(), device);
+  return response_proto;
+}
+
+// Returns the account key that CheckIfAssociatedWithCurrentAccount() matched.
+std::optional<AccountKey> CheckIfAssociated(
+    FastPairRepositoryImpl& fast_pair_repository) {
+  AccountKeyFilter account_key_filter(
+      std::vector<uint8_t>{0x02, 0x0C, 0x80, 0x2A},
+      std::vector<uint8_t>{0xC7, 0xC8});
+  std::optional<AccountKey> matched_account_key;
+  CountDownLatch latch(1);
+  fast_pair_repository.CheckIfAssociatedWithCurrentAccount(
+      account_key_filter, [&](std::optional<AccountKey> cb_account_key,
+                              std::optional<absl::string_view> cb_model_id) {
+        matched_account_key = cb_account_key;
+        latch.CountDown();
+      });
+  latch.Await();
+  return matched_account_key;
+}
+
 TEST(FastPairRepositoryImplTest, MetadataDownloadSuccess) {
   FakeFastPairClient fake_fast_pair_client;
   auto fast_pair_repository =
@@ -411,6 +464,7 @@ TEST(FastPairRepositoryImplTest, DeviceAssociatedWithCurrentAccountSuccess) {
   BuildFastPairInfo(fast_pair_info_2, device_2);
 
   fake_fast_pair_client.SetUserReadDevicesResponse(response_proto);
+  SyncSavedDevices(*fast_pair_repository);
 
   AccountKeyFilter account_key_filter(filter, salt);
 
@@ -454,6 +508,7 @@ TEST(FastPairRepositoryImplTest, DeviceNotAssociatedWithCurrentAccount) {
   auto* fast_pair_info = response_proto.add_fast_pair_info();
   BuildFastPairInfo(fast_pair_info, device);
   fake_fast_pair_client.SetUserReadDevicesResponse(response_proto);
+  SyncSavedDevices(*fast_pair_repository);
 
   AccountKeyFilter account_key_filter(filter, salt);
 
@@ -469,6 +524,135 @@ TEST(FastPairRepositoryImplTest, DeviceNotAssociatedWithCurrentAccount) {
   latch.Await();
 }
 
+TEST(FastPairRepositoryImplTest,
+     DeviceAssociatedWithCurrentAccountWhenServerUnavailable) {
+  AccountKey account_key(std::vector<uint8_t>{0x11, 0x22, 0x33, 0x44, 0x55,
+                                              0x66, 0x77, 0x88, 0x99, 0x00,
+                                              0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                                              0xFF});
+  FakeFastPairClient fake_fast_pair_client;
+  auto fast_pair_repository =
+      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      MakeUserReadDevicesResponse(account_key));
+  SyncSavedDevices(*fast_pair_repository);
+
+  // The saved devices are kept locally, so the lookup does not need the
+  // server.
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      absl::InternalError("No response"));
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+}
+
+TEST(FastPairRepositoryImplTest, LookupBeforeFirstSyncAsksServer) {
+  AccountKey account_key(std::vector<uint8_t>{0x11, 0x22, 0x33, 0x44, 0x55,
+                                              0x66, 0x77, 0x88, 0x99, 0x00,
+                                              0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                                              0xFF});
+  FakeFastPairClient fake_fast_pair_client;
+  auto fast_pair_repository =
+      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      MakeUserReadDevicesResponse(account_key));
+
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+
+  // The first lookup also filled the local copy.
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      absl::InternalError("No response"));
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+}
+
+TEST(FastPairRepositoryImplTest, StaleSavedDevicesAreRefreshed) {
+  AccountKey account_key(std::vector<uint8_t>{0x11, 0x22, 0x33, 0x44, 0x55,
+                                              0x66, 0x77, 0x88, 0x99, 0x00,
+                                              0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                                              0xFF});
+  FakeClock clock;
+  FakeFastPairClient fake_fast_pair_client;
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, /*account_manager=*/nullptr, &clock);
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      MakeUserReadDevicesResponse(account_key));
+  SyncSavedDevices(*fast_pair_repository);
+
+  // The device is removed from the account on another device. A recent local
+  // copy is still trusted.
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      proto::UserReadDevicesResponse());
+  clock.FastForward(absl::Minutes(4));
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+
+  // Once stale, a lookup answers from the local copy and queues a sync, which
+  // later lookups see.
+  clock.FastForward(absl::Minutes(2));
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+  EXPECT_FALSE(CheckIfAssociated(*fast_pair_repository).has_value());
+}
+
+TEST(FastPairRepositoryImplTest, SavedDevicesLoadedForSignedInAccount) {
+  AccountKey account_key(std::vector<uint8_t>{0x11, 0x22, 0x33, 0x44, 0x55,
+                                              0x66, 0x77, 0x88, 0x99, 0x00,
+                                              0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                                              0xFF});
+  FakeAccountManager account_manager;
+  account_manager.SetAccount(MakeAccount("account_a"));
+  FakeFastPairClient fake_fast_pair_client;
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      MakeUserReadDevicesResponse(account_key));
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, &account_manager);
+
+  // The account was signed in before the repository was created, so no login
+  // event loads the saved devices; the first lookup must still match.
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+}
+
+TEST(FastPairRepositoryImplTest, SavedDevicesBelongToCurrentAccount) {
+  AccountKey account_key(std::vector<uint8_t>{0x11, 0x22, 0x33, 0x44, 0x55,
+                                              0x66, 0x77, 0x88, 0x99, 0x00,
+                                              0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                                              0xFF});
+  FakeAccountManager account_manager;
+  account_manager.SetAccount(MakeAccount("account_a"));
+  FakeFastPairClient fake_fast_pair_client;
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      MakeUserReadDevicesResponse(account_key));
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, &account_manager);
+  SyncSavedDevices(*fast_pair_repository);
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+
+  // Another account has no saved devices; the first account's copy must not
+  // answer for it, even before the switch is announced.
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      proto::UserReadDevicesResponse());
+  account_manager.SetAccount(MakeAccount("account_b"));
+  EXPECT_FALSE(CheckIfAssociated(*fast_pair_repository).has_value());
+  EXPECT_FALSE(CheckIfAssociated(*fast_pair_repository).has_value());
+}
+
+TEST(FastPairRepositoryImplTest, SavedDevicesClearedOnLogout) {
+  AccountKey account_key(std::vector<uint8_t>{0x11, 0x22, 0x33, 0x44, 0x55,
+                                              0x66, 0x77, 0x88, 0x99, 0x00,
+                                              0xAA, 0xBB, 0xCC, 0xDD, 0xEE,
+                                              0xFF});
+  FakeAccountManager account_manager;
+  account_manager.SetAccount(MakeAccount("account_a"));
+  FakeFastPairClient fake_fast_pair_client;
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      MakeUserReadDevicesResponse(account_key));
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, &account_manager);
+  SyncSavedDevices(*fast_pair_repository);
+  EXPECT_EQ(CheckIfAssociated(*fast_pair_repository), account_key);
+
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      absl::UnauthenticatedError("Signed out"));
+  account_manager.Logout([](absl::Status status) {});
+  EXPECT_FALSE(CheckIfAssociated(*fast_pair_repository).has_value());
+}
+
 TEST(FastPairRepositoryImplTest, DeviceIsSavedToCurrentAccount) {
   FakeFastPairClient fake_fast_pair_client;
   auto fast_pair_repository =
@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "absl/functional/any_invocable.h"
+#include "absl/strings/string_view.h"
 
 namespace nearby {
 namespace data {
@@ -52,8 +53,31 @@ class DataSet {
       absl::AnyInvocable<void(bool, std::unique_ptr<std::vector<T>>) &&>
           callback) = 0;
 
+  // Asynchronously loads the entry stored under |key| and invokes |callback|
+  // when complete. The entry is nullptr if there is no such key.
+  virtual void LoadEntry(
+      absl::string_view key,
+      absl::AnyInvocable<void(bool, std::unique_ptr<T>) &&> callback) = 0;
+
+  // Asynchronously loads the entries whose keys start with |prefix|, in key
+  // order, and invokes |callback| when complete. Only the matching entries
+  // are read and deserialized.
+  virtual void LoadEntriesWithPrefix(
+      absl::string_view prefix,
+      absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+          callback) = 0;
+
+  // Asynchronously loads the entries with keys in [|start_key|, |end_key|),
+  // in key order, and invokes |callback| when complete. An empty |end_key|
+  // reads to the end of the database.
+  virtual void LoadEntriesInRange(
+      absl::string_view start_key, absl::string_view end_key,
+      absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+          callback) = 0;
+
   // Asynchronously saves |entries_to_save| and deletes entries from
-  // |keys_to_remove| from the database. |callback| will be invoked on the
+  // |keys_to_remove| from the database as one atomic update: either all of
+  // the changes are applied or none are. |callback| will be invoked on the
   // calling thread when complete. |entries_to_save| and |keys_to_remove| must
   // be non-null.
   virtual void UpdateEntries(
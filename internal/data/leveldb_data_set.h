@@ -22,12 +22,14 @@
 #include <vector>
 
 #include "absl/functional/any_invocable.h"
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "third_party/leveldb/include/db.h"
 #include "third_party/leveldb/include/iterator.h"
 #include "third_party/leveldb/include/options.h"
 #include "third_party/leveldb/include/slice.h"
 #include "third_party/leveldb/include/status.h"
+#include "third_party/leveldb/include/write_batch.h"
 #include "internal/data/data_set.h"
 #include "internal/platform/logging.h"
 #include "google/protobuf/message_lite.h"
@@ -55,12 +57,31 @@ class LeveldbDataSet : public DataSet<T> {
           void(bool,
                std::unique_ptr<std::vector<std::pair<std::string, T>>>) &&>
           callback);
+  void LoadEntry(
+      absl::string_view key,
+      absl::AnyInvocable<void(bool, std::unique_ptr<T>) &&> callback) override;
+  void LoadEntriesWithPrefix(
+      absl::string_view prefix,
+      absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+          callback) override;
+  void LoadEntriesInRange(
+      absl::string_view start_key, absl::string_view end_key,
+      absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+          callback) override;
   void UpdateEntries(std::unique_ptr<KeyEntryVector> entries_to_save,
                      std::unique_ptr<std::vector<std::string>> keys_to_remove,
                      absl::AnyInvocable<void(bool) &&> callback) override;
   void Destroy(absl::AnyInvocable<void(bool) &&> callback) override;
 
  private:
+  // Loads the entries from |start_key| on, stopping at the first key that
+  // |in_range| rejects.
+  void LoadEntriesFrom(
+      absl::string_view start_key,
+      absl::AnyInvocable<bool(absl::string_view) const> in_range,
+      absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+          callback);
+
   void Serialize(T const& value, std::string& str);
   void Deserialize(absl::string_view str, T& value);
 
@@ -113,8 +134,9 @@ void LeveldbDataSet<T, isMessageLite>::LoadEntries(
 
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     T value;
-    Deserialize(it->value().ToString(), value);
-    result->push_back(value);
+    Deserialize(absl::string_view(it->value().data(), it->value().size()),
+                value);
+    result->push_back(std::move(value));
   }
 
   if (it->status().ok()) {
@@ -146,8 +168,108 @@ void LeveldbDataSet<T, isMessageLite>::LoadEntriesWithKeys(
 
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     T value;
-    Deserialize(it->value().ToString(), value);
-    result->push_back({it->key().ToString(), value});
+    Deserialize(absl::string_view(it->value().data(), it->value().size()),
+                value);
+    result->push_back({it->key().ToString(), std::move(value)});
+  }
+
+  if (it->status().ok()) {
+    NEARBY_LOGS(INFO) << "Loaded " << result->size()
+                      << " entries from database.";
+    std::move(callback)(true, std::move(result));
+  } else {
+    NEARBY_LOGS(INFO) << "Failed to load entries from database.";
+    result->clear();
+    std::move(callback)(false, std::move(result));
+  }
+}
+
+template <typename T,
+          std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value, bool>
+              isMessageLite>
+void LeveldbDataSet<T, isMessageLite>::LoadEntry(
+    absl::string_view key,
+    absl::AnyInvocable<void(bool, std::unique_ptr<T>) &&> callback) {
+  if (status_ != InitStatus::kOK) {
+    std::move(callback)(false, nullptr);
+    return;
+  }
+
+  std::string str;
+  leveldb::Status status = db_->Get(leveldb::ReadOptions(),
+                                    leveldb::Slice(key.data(), key.size()),
+                                    &str);
+  if (status.IsNotFound()) {
+    std::move(callback)(true, nullptr);
+    return;
+  }
+  if (!status.ok()) {
+    NEARBY_LOGS(INFO) << "Failed to load entry from database.";
+    std::move(callback)(false, nullptr);
+    return;
+  }
+
+  auto value = std::make_unique<T>();
+  Deserialize(str, *value);
+  std::move(callback)(true, std::move(value));
+}
+
+template <typename T,
+          std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value, bool>
+              isMessageLite>
+void LeveldbDataSet<T, isMessageLite>::LoadEntriesWithPrefix(
+    absl::string_view prefix,
+    absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+        callback) {
+  LoadEntriesFrom(
+      prefix,
+      [prefix](absl::string_view key) {
+        return absl::StartsWith(key, prefix);
+      },
+      std::move(callback));
+}
+
+template <typename T,
+          std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value, bool>
+              isMessageLite>
+void LeveldbDataSet<T, isMessageLite>::LoadEntriesInRange(
+    absl::string_view start_key, absl::string_view end_key,
+    absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+        callback) {
+  LoadEntriesFrom(
+      start_key,
+      [end_key](absl::string_view key) {
+        return end_key.empty() || key < end_key;
+      },
+      std::move(callback));
+}
+
+template <typename T,
+          std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value, bool>
+              isMessageLite>
+void LeveldbDataSet<T, isMessageLite>::LoadEntriesFrom(
+    absl::string_view start_key,
+    absl::AnyInvocable<bool(absl::string_view) const> in_range,
+    absl::AnyInvocable<void(bool, std::unique_ptr<KeyEntryVector>) &&>
+        callback) {
+  auto result = std::make_unique<KeyEntryVector>();
+  if (status_ != InitStatus::kOK) {
+    std::move(callback)(false, std::move(result));
+    return;
+  }
+
+  std::unique_ptr<leveldb::Iterator> it(
+      db_->NewIterator(leveldb::ReadOptions()));
+
+  // leveldb keeps keys sorted, so only the requested entries are read.
+  for (it->Seek(leveldb::Slice(start_key.data(), start_key.size()));
+       it->Valid(); it->Next()) {
+    absl::string_view key(it->key().data(), it->key().size());
+    if (!in_range(key)) break;
+    T value;
+    Deserialize(absl::string_view(it->value().data(), it->value().size()),
+                value);
+    result->push_back({std::string(key), std::move(value)});
   }
 
   if (it->status().ok()) {
@@ -174,21 +296,28 @@ void LeveldbDataSet<T, isMessageLite>::UpdateEntries(
     return;
   }
 
+  // Apply all of the changes in one write, so a refresh is never left half
+  // done.
+  leveldb::WriteBatch batch;
   if (entries_to_save != nullptr) {
+    std::string str;
     for (const auto& [key, value] : *entries_to_save) {
-      std::string str;
       Serialize(value, str);
-      db_->Put(leveldb::WriteOptions(), key, leveldb::Slice(str));
+      batch.Put(key, leveldb::Slice(str));
     }
   }
 
   if (keys_to_remove != nullptr) {
     for (const auto& it : *keys_to_remove) {
-      db_->Delete(leveldb::WriteOptions(), it);
+      batch.Delete(it);
     }
   }
 
-  std::move(callback)(true);
+  leveldb::Status status = db_->Write(leveldb::WriteOptions(), &batch);
+  if (!status.ok()) {
+    NEARBY_LOGS(INFO) << "Failed to update entries in database.";
+  }
+  std::move(callback)(status.ok());
 }
 
 template <typename T,
@@ -219,7 +348,7 @@ template <typename T,
               isMessageLite>
 void LeveldbDataSet<T, isMessageLite>::Deserialize(absl::string_view str,
                                                    T& value) {
-  value.ParseFromString(str);
+  value.ParseFromArray(str.data(), static_cast<int>(str.size()));
 }
 
 }  // namespace data
@@ -29,6 +29,7 @@
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "internal/data/data_set.h"
@@ -38,6 +39,8 @@ namespace nearby {
 namespace data {
 namespace {
 
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 using ::testing::SizeIs;
 
 // Generate a unique directory under temp directory for leveldb storage
@@ -128,6 +131,59 @@ absl::flat_hash_map<std::string, T> LoadEntriesWithKeysAndWait(
   return entry_map;
 }
 
+template <typename T>
+std::unique_ptr<T> LoadEntryAndWait(std::unique_ptr<LeveldbDataSet<T>>& dataset,
+                                    absl::string_view key) {
+  std::unique_ptr<T> result;
+  absl::Notification notification;
+  dataset->LoadEntry(
+      key, [&result, &notification](bool, std::unique_ptr<T> res) {
+        result = std::move(res);
+        notification.Notify();
+      });
+  notification.WaitForNotificationWithTimeout(absl::Seconds(5));
+  return result;
+}
+
+template <typename T>
+std::vector<std::string> LoadKeysWithPrefixAndWait(
+    std::unique_ptr<LeveldbDataSet<T>>& dataset, absl::string_view prefix) {
+  std::vector<std::string> keys;
+  absl::Notification notification;
+  dataset->LoadEntriesWithPrefix(
+      prefix,
+      [&keys, &notification](
+          bool,
+          std::unique_ptr<typename LeveldbDataSet<T>::KeyEntryVector> res) {
+        for (const auto& it : *res) {
+          keys.push_back(it.first);
+        }
+        notification.Notify();
+      });
+  notification.WaitForNotificationWithTimeout(absl::Seconds(5));
+  return keys;
+}
+
+template <typename T>
+std::vector<std::string> LoadKeysInRangeAndWait(
+    std::unique_ptr<LeveldbDataSet<T>>& dataset, absl::string_view start_key,
+    absl::string_view end_key) {
+  std::vector<std::string> keys;
+  absl::Notification notification;
+  dataset->LoadEntriesInRange(
+      start_key, end_key,
+      [&keys, &notification](
+          bool,
+          std::unique_ptr<typename LeveldbDataSet<T>::KeyEntryVector> res) {
+        for (const auto& it : *res) {
+          keys.push_back(it.first);
+        }
+        notification.Notify();
+      });
+  notification.WaitForNotificationWithTimeout(absl::Seconds(5));
+  return keys;
+}
+
 template <typename T>
 void WipeCleanAndWait(std::unique_ptr<LeveldbDataSet<T>>& dataset,
                       std::filesystem::path path) {
@@ -254,6 +310,90 @@ TEST(LeveldbDataSet, RemoveEntriesDiceRoll) {
   EXPECT_EQ(result["id4"].nickname(), diceroll4.nickname());
 }
 
+TEST(LeveldbDataSet, LoadEntryByKey) {
+  std::filesystem::path path = GenerateLeveldbPath();
+  std::unique_ptr<LeveldbDataSet<DiceRoll>> diceroll_set =
+      CreateDataSet<DiceRoll>(path);
+
+  InitializeAndWait(diceroll_set);
+
+  auto entries = LeveldbDataSet<DiceRoll>::KeyEntryVector(
+      {{"id1", GenerateDiceRoll(2)}, {"id2", GenerateDiceRoll(12)}});
+  EXPECT_TRUE(UpdateEntriesAndWait(
+      diceroll_set,
+      std::make_unique<LeveldbDataSet<DiceRoll>::KeyEntryVector>(entries),
+      std::make_unique<std::vector<std::string>>()));
+
+  std::unique_ptr<DiceRoll> found = LoadEntryAndWait(diceroll_set, "id2");
+  std::unique_ptr<DiceRoll> missing = LoadEntryAndWait(diceroll_set, "id3");
+  WipeCleanAndWait(diceroll_set, path);
+
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->value(), 12);
+  EXPECT_EQ(found->nickname(), "boxcars");
+  EXPECT_EQ(missing, nullptr);
+}
+
+TEST(LeveldbDataSet, LoadEntriesWithPrefixAndInRange) {
+  std::filesystem::path path = GenerateLeveldbPath();
+  std::unique_ptr<LeveldbDataSet<DiceRoll>> diceroll_set =
+      CreateDataSet<DiceRoll>(path);
+
+  InitializeAndWait(diceroll_set);
+
+  auto entries = LeveldbDataSet<DiceRoll>::KeyEntryVector(
+      {{"a:1", GenerateDiceRoll(1)},
+       {"b:1", GenerateDiceRoll(2)},
+       {"b:2", GenerateDiceRoll(3)},
+       {"b:3", GenerateDiceRoll(4)},
+       {"c:1", GenerateDiceRoll(5)}});
+  UpdateEntriesAndWait(
+      diceroll_set,
+      std::make_unique<LeveldbDataSet<DiceRoll>::KeyEntryVector>(entries),
+      nullptr);
+
+  auto prefix_keys = LoadKeysWithPrefixAndWait(diceroll_set, "b:");
+  auto no_prefix_keys = LoadKeysWithPrefixAndWait(diceroll_set, "d:");
+  auto range_keys = LoadKeysInRangeAndWait(diceroll_set, "a:5", "b:3");
+  auto open_range_keys = LoadKeysInRangeAndWait(diceroll_set, "b:3", "");
+  WipeCleanAndWait(diceroll_set, path);
+
+  EXPECT_THAT(prefix_keys, ElementsAre("b:1", "b:2", "b:3"));
+  EXPECT_THAT(no_prefix_keys, IsEmpty());
+  EXPECT_THAT(range_keys, ElementsAre("b:1", "b:2"));
+  EXPECT_THAT(open_range_keys, ElementsAre("b:3", "c:1"));
+}
+
+TEST(LeveldbDataSet, UpdateEntriesSavesAndRemovesTogether) {
+  std::filesystem::path path = GenerateLeveldbPath();
+  std::unique_ptr<LeveldbDataSet<DiceRoll>> diceroll_set =
+      CreateDataSet<DiceRoll>(path);
+
+  InitializeAndWait(diceroll_set);
+
+  UpdateEntriesAndWait(
+      diceroll_set,
+      std::make_unique<LeveldbDataSet<DiceRoll>::KeyEntryVector>(
+          LeveldbDataSet<DiceRoll>::KeyEntryVector(
+              {{"id1", GenerateDiceRoll(2)}})),
+      nullptr);
+  // Removals are applied after saves, so an entry saved and removed in the
+  // same update ends up removed.
+  EXPECT_TRUE(UpdateEntriesAndWait(
+      diceroll_set,
+      std::make_unique<LeveldbDataSet<DiceRoll>::KeyEntryVector>(
+          LeveldbDataSet<DiceRoll>::KeyEntryVector(
+              {{"id1", GenerateDiceRoll(12)}, {"id2", GenerateDiceRoll(5)}})),
+      std::make_unique<std::vector<std::string>>(
+          std::vector<std::string>({"id2"}))));
+
+  auto result = LoadEntriesWithKeysAndWait(diceroll_set);
+  WipeCleanAndWait(diceroll_set, path);
+
+  EXPECT_THAT(result, SizeIs(1));
+  EXPECT_EQ(result["id1"].value(), 12);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace nearby
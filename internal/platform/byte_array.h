@@ -79,6 +79,9 @@ class ByteArray {
 
   char* data() { return &data_[0]; }
   std::string string_data() const { return data_; }
+  // Returns the internal representation without copying it, for APIs that
+  // take a const std::string&.
+  const std::string& AsString() const { return data_; }
   const char* data() const { return data_.data(); }
   size_t size() const { return data_.size(); }
   bool Empty() const { return data_.empty(); }
@@ -33,6 +33,9 @@ class FeatureFlags {
     // If a scheduled runnable is already running, Cancel() will synchronously
     // wait for the task to complete.
     bool cancel_waits_for_running_tasks = true;
+    // Run ScheduledExecutor and TaskRunnerImpl delayed tasks off the shared
+    // TimerWheel instead of a platform timer per task.
+    bool enable_timer_wheel = false;
     // Keep Alive frame interval and timeout in millis.
     std::int32_t keep_alive_interval_millis = 5000;
     std::int32_t keep_alive_timeout_millis = 30000;
@@ -47,6 +50,16 @@ class FeatureFlags {
     // necessary to properly support multiple BWU mediums, multiple service, and
     // multiple endpionts.
     bool support_multiple_bwu_mediums = true;
+    // The number of upgrade mediums whose paths are set up concurrently when
+    // the initiator starts a bandwidth upgrade; the first path available wins.
+    // 1 tries the mediums one at a time. Requires support_multiple_bwu_mediums.
+    std::int32_t bwu_race_medium_count = 1;
+    // When an endpoint was discovered over several mediums, start connecting
+    // over the next medium if the previous ones haven't connected within
+    // staggered_connect_delay, and keep the first channel that connects.
+    // Otherwise the mediums are tried one at a time.
+    bool enable_staggered_connect = false;
+    absl::Duration staggered_connect_delay = absl::Milliseconds(300);
     // Allows the code to change the bluetooth radio state
     bool enable_set_radio_state = false;
     // If the feature is enabled, medium connection will timeout when cannot
@@ -77,10 +90,25 @@ class FeatureFlags {
     std::int32_t auto_reconnect_retry_attempts = 3;
     absl::Duration auto_reconnect_skip_duplicated_endpoint_duration =
         absl::Milliseconds(4000);
+    // Keep the channel a bandwidth upgrade moved away from as an idle
+    // standby, and let auto reconnect fail over to it instead of setting up a
+    // new connection. Both devices need this enabled.
+    bool enable_auto_reconnect_warm_standby = false;
     // Android code won't be able to launch "payload_received_ack" feature for
     // in near future, so change "payload_received_ack" version from "2" to "5"
     // after auto-reconnect and auto-resume.
     std::int32_t min_nc_version_supports_payload_received_ack = 5;
+    // Number of payload bytes the sender may have in flight without a
+    // cumulative payload ack. Raised to at least twice the receiver's fixed
+    // ack interval (PayloadManager::kPayloadAckIntervalBytes), so peers need
+    // not agree on it.
+    std::int64_t payload_ack_window_bytes = 512 * 1024;
+    // Number of outgoing BYTES and FILE payloads sent at the same time when
+    // the parallel payload scheduler is enabled.
+    std::int32_t max_concurrent_outgoing_payloads = 4;
+    // How many session resumption tickets are kept, and for how long.
+    std::int32_t max_ukey2_session_tickets = 32;
+    absl::Duration ukey2_session_ticket_lifetime = absl::Minutes(10);
     // If the other part doesn't ack the safe_to_disconnect request, the
     // initiator will end the connection in 30s.
     absl::Duration safe_to_disconnect_ack_delay_millis =
@@ -92,6 +120,10 @@ class FeatureFlags {
     // If the receiver doesn't ack with payload_received_ack frame in 1s, the
     // sender will timeout the waiting.
     absl::Duration wait_payload_received_ack_millis = absl::Milliseconds(1000);
+    // If the receiver's cumulative acks stop advancing for 30s while the
+    // sender's ack window is full, the sender fails the payload.
+    absl::Duration payload_ack_window_stall_timeout_millis =
+        absl::Milliseconds(30000);
 
     // Multiplex related flags
     // Timeout value for read frame operation in endpoint channel.
@@ -25,6 +25,7 @@
 
 #include <memory>
 
+#include "absl/types/span.h"
 #include "internal/platform/implementation/ble_v2.h"
 
 #import "internal/platform/implementation/apple/ble_peripheral.h"
@@ -72,6 +73,11 @@ class BleOutputStream : public OutputStream {
   // Returns Exception::kIo on error, otherwise Exception::kSuccess.
   Exception Write(const ByteArray &data) override;
 
+  // Writes the provided buffers to the output stream as a single packet.
+  //
+  // Returns Exception::kIo on error, otherwise Exception::kSuccess.
+  Exception WriteGathered(absl::Span<const ByteArray *const> buffers) override;
+
   // no-op
   //
   // Always returns Exception::kSuccess.
@@ -83,6 +89,9 @@ class BleOutputStream : public OutputStream {
   Exception Close() override;
 
  private:
+  // Sends |packet|, blocking until the completion handler is called.
+  Exception SendPacket(NSMutableData *packet);
+
   id<GNCMConnection> connection_;
   NSCondition *condition_;
 };
@@ -114,16 +114,27 @@ BleOutputStream::~BleOutputStream() {
 }
 
 Exception BleOutputStream::Write(const ByteArray &data) {
+  return SendPacket([NSMutableData dataWithData:NSDataFromByteArray(data)]);
+}
+
+Exception BleOutputStream::WriteGathered(absl::Span<const ByteArray *const> buffers) {
+  // Every send waits for its own completion, so the buffers go out as one packet.
+  NSMutableData *packet = [NSMutableData data];
+  for (const ByteArray *data : buffers) {
+    [packet appendBytes:data->data() length:data->size()];
+  }
+  return SendPacket(packet);
+}
+
+Exception BleOutputStream::SendPacket(NSMutableData *packet) {
   [condition_ lock];
-  NSLog(@"[NEARBY] Sending data of size: %lu", NSDataFromByteArray(data).length);
+  NSLog(@"[NEARBY] Sending data of size: %lu", packet.length);
 
   if (!connection_) {
     [condition_ unlock];
     return {Exception::kIo};
   }
 
-  NSMutableData *packet = [NSMutableData dataWithData:NSDataFromByteArray(data)];
-
   // Send the data, blocking until the completion handler is called.
   __block bool isComplete = NO;
   __block GNCMPayloadResult sendResult = GNCMPayloadResultFailure;
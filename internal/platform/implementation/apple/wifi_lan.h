@@ -21,6 +21,7 @@
 #include <string>
 #include <utility>
 
+#include "absl/types/span.h"
 #include "internal/platform/implementation/wifi_lan.h"
 #include "internal/platform/nsd_service_info.h"
 
@@ -57,6 +58,7 @@ class WifiLanOutputStream : public OutputStream {
   ~WifiLanOutputStream() override = default;
 
   Exception Write(const ByteArray& data) override;
+  Exception WriteGathered(absl::Span<const ByteArray* const> buffers) override;
   Exception Flush() override;
   Exception Close() override;
 
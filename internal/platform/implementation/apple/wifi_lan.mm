@@ -62,6 +62,20 @@ Exception WifiLanOutputStream::Write(const ByteArray& data) {
   return {Exception::kSuccess};
 }
 
+Exception WifiLanOutputStream::WriteGathered(absl::Span<const ByteArray* const> buffers) {
+  NSMutableData* packet = [NSMutableData data];
+  for (const ByteArray* data : buffers) {
+    [packet appendBytes:data->data() length:data->size()];
+  }
+  NSError* error = nil;
+  BOOL result = [socket_ write:packet error:&error];
+  if (!result) {
+    GTMLoggerError(@"Error writing socket: %@", error);
+    return {Exception::kIo};
+  }
+  return {Exception::kSuccess};
+}
+
 Exception WifiLanOutputStream::Flush() {
   // Write blocks until the data has successfully been written/received, so no more work is needed
   // to flush.
@@ -278,6 +278,42 @@ Exception BluetoothSocket::BluetoothOutputStream::Write(const ByteArray& data) {
   }
 }
 
+// Copies the buffers into the write buffer back to back, so they go out in a
+// single WriteAsync() instead of one per buffer.
+Exception BluetoothSocket::BluetoothOutputStream::WriteGathered(
+    absl::Span<const ByteArray* const> buffers) {
+  try {
+    size_t size = 0;
+    for (const ByteArray* data : buffers) size += data->size();
+    if (size > write_buffer_.Capacity()) {
+      NEARBY_LOGS(WARNING) << __func__
+                           << ": resize write buffer to packet size: " << size;
+      write_buffer_ = Buffer(size);
+    }
+
+    uint8_t* position = write_buffer_.data();
+    for (const ByteArray* data : buffers) {
+      std::memcpy(position, data->data(), data->size());
+      position += data->size();
+    }
+    write_buffer_.Length(size);
+
+    winrt::hresult hresult =
+        winrt_output_stream_.WriteAsync(write_buffer_).get();
+    return {Exception::kSuccess};
+  } catch (std::exception exception) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Exception: " << exception.what();
+    return {Exception::kIo};
+  } catch (const winrt::hresult_error& error) {
+    NEARBY_LOGS(ERROR) << __func__ << ": WinRT exception: " << error.code()
+                       << ": " << winrt::to_string(error.message());
+    return {Exception::kIo};
+  } catch (...) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Unknown exeption.";
+    return {Exception::kIo};
+  }
+}
+
 Exception BluetoothSocket::BluetoothOutputStream::Flush() {
   try {
     if (winrt_output_stream_ == nullptr) {
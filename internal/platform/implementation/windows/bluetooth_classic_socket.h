@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <memory>
 
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/implementation/bluetooth_classic.h"
@@ -93,6 +94,8 @@ class BluetoothSocket : public api::BluetoothSocket {
     ~BluetoothOutputStream() override = default;
 
     Exception Write(const ByteArray& data) override;
+    Exception WriteGathered(
+        absl::Span<const ByteArray* const> buffers) override;
     Exception Flush() override;
 
     Exception Close() override;
@@ -34,6 +34,7 @@
 
 // ABSL header
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 
 // WinRT headers
 #include "internal/platform/implementation/windows/generated/winrt/Windows.Devices.Enumeration.h"
@@ -146,6 +147,8 @@ class WifiDirectSocket : public api::WifiDirectSocket {
     ~SocketOutputStream() override = default;
 
     Exception Write(const ByteArray& data) override;
+    Exception WriteGathered(
+        absl::Span<const ByteArray* const> buffers) override;
     Exception Flush() override;
     Exception Close() override;
 
@@ -162,6 +162,36 @@ Exception WifiDirectSocket::SocketOutputStream::Write(const ByteArray& data) {
   }
 }
 
+// Copies the buffers into one WinRT buffer, so they go out in a single
+// WriteAsync() instead of one per buffer.
+Exception WifiDirectSocket::SocketOutputStream::WriteGathered(
+    absl::Span<const ByteArray* const> buffers) {
+  try {
+    size_t size = 0;
+    for (const ByteArray* data : buffers) size += data->size();
+    Buffer buffer = Buffer(size);
+    uint8_t* position = buffer.data();
+    for (const ByteArray* data : buffers) {
+      std::memcpy(position, data->data(), data->size());
+      position += data->size();
+    }
+    buffer.Length(size);
+
+    output_stream_.WriteAsync(buffer).get();
+    return {Exception::kSuccess};
+  } catch (std::exception exception) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Exception: " << exception.what();
+    return {Exception::kIo};
+  } catch (const winrt::hresult_error& error) {
+    NEARBY_LOGS(ERROR) << __func__ << ": WinRT exception: " << error.code()
+                       << ": " << winrt::to_string(error.message());
+    return {Exception::kIo};
+  } catch (...) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Unknown exeption.";
+    return {Exception::kIo};
+  }
+}
+
 Exception WifiDirectSocket::SocketOutputStream::Flush() {
   try {
     output_stream_.FlushAsync().get();
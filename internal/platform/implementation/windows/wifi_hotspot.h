@@ -34,6 +34,7 @@
 
 // WinRT headers
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "internal/platform/implementation/windows/generated/winrt/Windows.Devices.Enumeration.h"
 #include "internal/platform/implementation/windows/generated/winrt/Windows.Devices.WiFi.h"
 #include "internal/platform/implementation/windows/generated/winrt/Windows.Devices.WiFiDirect.h"
@@ -150,6 +151,8 @@ class WifiHotspotSocket : public api::WifiHotspotSocket {
     ~SocketOutputStream() override = default;
 
     Exception Write(const ByteArray& data) override;
+    Exception WriteGathered(
+        absl::Span<const ByteArray* const> buffers) override;
     Exception Flush() override;
     Exception Close() override;
 
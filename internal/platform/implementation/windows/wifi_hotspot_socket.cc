@@ -14,6 +14,7 @@
 
 #include <cstring>
 #include <exception>
+#include <vector>
 
 #include "internal/platform/implementation/windows/wifi_hotspot.h"
 #include "internal/platform/logging.h"
@@ -272,6 +273,55 @@ Exception WifiHotspotSocket::SocketOutputStream::Write(const ByteArray& data) {
   }
 }
 
+// WinRT sockets get the buffers copied into one WinRT buffer for a single
+// WriteAsync(). Win32 sockets send them in place with one WSASend().
+Exception WifiHotspotSocket::SocketOutputStream::WriteGathered(
+    absl::Span<const ByteArray* const> buffers) {
+  try {
+    if (socket_type_ == SocketType::kWinRTSocket) {
+      size_t size = 0;
+      for (const ByteArray* data : buffers) size += data->size();
+      Buffer buffer = Buffer(size);
+      uint8_t* position = buffer.data();
+      for (const ByteArray* data : buffers) {
+        std::memcpy(position, data->data(), data->size());
+        position += data->size();
+      }
+      buffer.Length(size);
+
+      output_stream_.WriteAsync(buffer).get();
+      return {Exception::kSuccess};
+    }
+    // When socket_type_ == SocketType::kWin32Socket
+    std::vector<WSABUF> wsa_buffers;
+    wsa_buffers.reserve(buffers.size());
+    for (const ByteArray* data : buffers) {
+      wsa_buffers.push_back(
+          {static_cast<ULONG>(data->size()), const_cast<char*>(data->data())});
+    }
+    DWORD sent_bytes = 0;
+    int result = WSASend(socket_, wsa_buffers.data(),
+                         static_cast<DWORD>(wsa_buffers.size()), &sent_bytes,
+                         0, nullptr, nullptr);
+    if (result == 0) {
+      return {Exception::kSuccess};
+    }
+    NEARBY_LOGS(INFO) << "WSASend failed: " << WSAGetLastError();
+
+    return {Exception::kIo};
+  } catch (std::exception exception) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Exception: " << exception.what();
+    return {Exception::kIo};
+  } catch (const winrt::hresult_error& error) {
+    NEARBY_LOGS(ERROR) << __func__ << ": WinRT exception: " << error.code()
+                       << ": " << winrt::to_string(error.message());
+    return {Exception::kIo};
+  } catch (...) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Unknown exeption.";
+    return {Exception::kIo};
+  }
+}
+
 Exception WifiHotspotSocket::SocketOutputStream::Flush() {
   try {
     if (socket_type_ == SocketType::kWinRTSocket) {
@@ -15,6 +15,7 @@
 #ifndef PLATFORM_BASE_OUTPUT_STREAM_H_
 #define PLATFORM_BASE_OUTPUT_STREAM_H_
 
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 
@@ -30,6 +31,21 @@ class OutputStream {
   virtual Exception Write(const ByteArray& data) = 0;  // throws Exception::kIo
   virtual Exception Flush() = 0;                       // throws Exception::kIo
   virtual Exception Close() = 0;                       // throws Exception::kIo
+
+  // Writes |buffers| back to back as one logical write, without first
+  // concatenating them. The default implementation calls Write() once per
+  // buffer. Streams that add per-write overhead (framing, a thread hand-off or
+  // a syscall) should override this to emit the buffers in one go.
+  //
+  // https://docs.oracle.com/javase/8/docs/api/java/nio/channels/GatheringByteChannel.html
+  virtual Exception WriteGathered(
+      absl::Span<const ByteArray* const> buffers) {  // throws Exception::kIo
+    for (const ByteArray* buffer : buffers) {
+      Exception exception = Write(*buffer);
+      if (exception.Raised()) return exception;
+    }
+    return {Exception::kSuccess};
+  }
 };
 
 }  // namespace nearby
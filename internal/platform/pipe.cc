@@ -14,13 +14,18 @@
 
 #include "internal/platform/pipe.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <memory>
 #include <utility>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/types/span.h"
 #include "internal/platform/base_mutex_lock.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
@@ -35,6 +40,48 @@ namespace nearby {
 namespace {
 using Platform = api::ImplementationPlatform;
 
+// Stream ends shared by both pipe kinds. `PipeT` provides Read(), Write(),
+// WriteGathered() and the Mark*Closed() methods.
+template <typename PipeT>
+class PipeInputStream : public InputStream {
+ public:
+  explicit PipeInputStream(std::shared_ptr<PipeT> pipe) : pipe_(pipe) {}
+  ~PipeInputStream() override { DoClose(); }
+
+  ExceptionOr<ByteArray> Read(std::int64_t size) override {
+    return pipe_->Read(size);
+  }
+  Exception Close() override { return DoClose(); }
+
+ private:
+  Exception DoClose() {
+    pipe_->MarkInputStreamClosed();
+    return {Exception::kSuccess};
+  }
+  std::shared_ptr<PipeT> pipe_;
+};
+
+template <typename PipeT>
+class PipeOutputStream : public OutputStream {
+ public:
+  explicit PipeOutputStream(std::shared_ptr<PipeT> pipe) : pipe_(pipe) {}
+  ~PipeOutputStream() override { DoClose(); }
+
+  Exception Write(const ByteArray& data) override { return pipe_->Write(data); }
+  Exception WriteGathered(absl::Span<const ByteArray* const> buffers) override {
+    return pipe_->WriteGathered(buffers);
+  }
+  Exception Flush() override { return {Exception::kSuccess}; }
+  Exception Close() override { return DoClose(); }
+
+ private:
+  Exception DoClose() {
+    pipe_->MarkOutputStreamClosed();
+    return {Exception::kSuccess};
+  }
+  std::shared_ptr<PipeT> pipe_;
+};
+
 class Pipe {
  public:
   Pipe() {
@@ -45,50 +92,15 @@ class Pipe {
     cond_ = Platform::CreateConditionVariable(mutex_.get());
   }
 
-  class PipeInputStream : public InputStream {
-   public:
-    explicit PipeInputStream(std::shared_ptr<Pipe> pipe) : pipe_(pipe) {}
-    ~PipeInputStream() override { DoClose(); }
-
-    ExceptionOr<ByteArray> Read(std::int64_t size) override {
-      return pipe_->Read(size);
-    }
-    Exception Close() override { return DoClose(); }
-
-   private:
-    Exception DoClose() {
-      pipe_->MarkInputStreamClosed();
-      return {Exception::kSuccess};
-    }
-    std::shared_ptr<Pipe> pipe_;
-  };
-
-  class PipeOutputStream : public OutputStream {
-   public:
-    explicit PipeOutputStream(std::shared_ptr<Pipe> pipe) : pipe_(pipe) {}
-    ~PipeOutputStream() override { DoClose(); }
-
-    Exception Write(const ByteArray& data) override {
-      return pipe_->Write(data);
-    }
-    Exception Flush() override { return {Exception::kSuccess}; }
-    Exception Close() override { return DoClose(); }
-
-   private:
-    Exception DoClose() {
-      pipe_->MarkOutputStreamClosed();
-      return {Exception::kSuccess};
-    }
-    std::shared_ptr<Pipe> pipe_;
-  };
-
- private:
   ExceptionOr<ByteArray> Read(size_t size) ABSL_LOCKS_EXCLUDED(mutex_);
   Exception Write(const ByteArray& data) ABSL_LOCKS_EXCLUDED(mutex_);
+  Exception WriteGathered(absl::Span<const ByteArray* const> buffers)
+      ABSL_LOCKS_EXCLUDED(mutex_);
 
   void MarkInputStreamClosed() ABSL_LOCKS_EXCLUDED(mutex_);
   void MarkOutputStreamClosed() ABSL_LOCKS_EXCLUDED(mutex_);
 
+ private:
   Exception WriteLocked(const ByteArray& data)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
@@ -97,6 +109,61 @@ class Pipe {
   bool read_all_chunks_ ABSL_GUARDED_BY(mutex_) = false;
 
   std::deque<ByteArray> ABSL_GUARDED_BY(mutex_) buffer_;
+  // Bytes at the front of buffer_.front() that have already been read, so a
+  // partial Read() doesn't have to copy what is left of the chunk.
+  size_t front_offset_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Order of declaration matters:
+  // - mutex must be defined before condvar;
+  std::unique_ptr<api::Mutex> mutex_;
+  std::unique_ptr<api::ConditionVariable> cond_;
+};
+
+// Bounded pipe for one reader thread and one writer thread.
+//
+// Bytes live in a fixed ring buffer. `read_pos_` is only advanced by the
+// reader and `write_pos_` only by the writer; both count bytes since the pipe
+// was created, so `write_pos_ - read_pos_` is the number of buffered bytes.
+// The mutex and condvar are only used to sleep: a side that has to wait sets
+// its `*_waiting_` flag first, and the other side only takes the lock to wake
+// it when that flag is set.
+class RingPipe {
+ public:
+  explicit RingPipe(size_t capacity)
+      : capacity_(std::max<size_t>(capacity, 1)),
+        ring_(std::make_unique<char[]>(capacity_)) {
+#pragma push_macro("CreateMutex")
+#undef CreateMutex
+    mutex_ = Platform::CreateMutex(api::Mutex::Mode::kRegular);
+#pragma pop_macro("CreateMutex")
+    cond_ = Platform::CreateConditionVariable(mutex_.get());
+  }
+
+  ExceptionOr<ByteArray> Read(size_t size);
+  Exception Write(const ByteArray& data);
+  Exception WriteGathered(absl::Span<const ByteArray* const> buffers);
+
+  void MarkInputStreamClosed();
+  void MarkOutputStreamClosed();
+
+ private:
+  bool Closed() const {
+    return input_stream_closed_.load(std::memory_order_acquire) ||
+           output_stream_closed_.load(std::memory_order_acquire);
+  }
+  // Sleeps until `ready` returns true. `waiting` is this side's flag.
+  Exception WaitUntil(std::atomic<bool>& waiting,
+                      absl::FunctionRef<bool()> ready);
+  // Wakes the other side if it is asleep. `waiting` is that side's flag.
+  void Wake(const std::atomic<bool>& waiting);
+
+  const size_t capacity_;
+  std::unique_ptr<char[]> ring_;
+  std::atomic<std::uint64_t> read_pos_{0};
+  std::atomic<std::uint64_t> write_pos_{0};
+  std::atomic<bool> input_stream_closed_{false};
+  std::atomic<bool> output_stream_closed_{false};
+  std::atomic<bool> reader_waiting_{false};
+  std::atomic<bool> writer_waiting_{false};
   // Order of declaration matters:
   // - mutex must be defined before condvar;
   std::unique_ptr<api::Mutex> mutex_;
@@ -129,23 +196,25 @@ ExceptionOr<ByteArray> Pipe::Read(size_t size) {
     return ExceptionOr<ByteArray>{ByteArray{}};
   }
 
-  ByteArray first_chunk{buffer_.front()};
-  buffer_.pop_front();
+  ByteArray& first_chunk = buffer_.front();
 
-  // If first_chunk is small enough to not overshoot the requested 'size', just
-  // return that.
-  if (first_chunk.size() <= size) {
-    return ExceptionOr<ByteArray>{first_chunk};
-  } else {
-    // Break first_chunk into 2 parts -- the first one of which (next_chunk)
-    // will be 'size' bytes long, and will be returned, and the second one of
-    // which (overflow_chunk) will be re-inserted into buffer_, at the head of
-    // the queue, to be served up in the next call to read().
-    ByteArray next_chunk(first_chunk.data(), size);
-    buffer_.push_front(
-        ByteArray(first_chunk.data() + size, first_chunk.size() - size));
-    return ExceptionOr<ByteArray>{next_chunk};
+  // If none of first_chunk has been read yet and it is small enough to not
+  // overshoot the requested 'size', hand it out as is.
+  if (front_offset_ == 0 && first_chunk.size() <= size) {
+    ByteArray next_chunk = std::move(first_chunk);
+    buffer_.pop_front();
+    return ExceptionOr<ByteArray>{std::move(next_chunk)};
   }
+  // Otherwise copy out up to 'size' of its unread bytes, and leave the rest at
+  // the head of the queue, to be served up in the next call to read().
+  size_t length = std::min(size, first_chunk.size() - front_offset_);
+  ByteArray next_chunk(first_chunk.data() + front_offset_, length);
+  front_offset_ += length;
+  if (front_offset_ == first_chunk.size()) {
+    buffer_.pop_front();
+    front_offset_ = 0;
+  }
+  return ExceptionOr<ByteArray>{std::move(next_chunk)};
 }
 
 Exception Pipe::Write(const ByteArray& data) {
@@ -154,6 +223,22 @@ Exception Pipe::Write(const ByteArray& data) {
   return WriteLocked(data);
 }
 
+// Queues all buffers under a single lock, so the reader is woken up once per
+// gathered write rather than once per buffer.
+Exception Pipe::WriteGathered(absl::Span<const ByteArray* const> buffers) {
+  BaseMutexLock lock(mutex_.get());
+
+  if (input_stream_closed_ || output_stream_closed_) {
+    return {Exception::kIo};
+  }
+  for (const ByteArray* buffer : buffers) {
+    // An empty chunk is the EOF sentinel, so never queue one here.
+    if (!buffer->Empty()) buffer_.push_back(*buffer);
+  }
+  cond_->Notify();
+  return {Exception::kSuccess};
+}
+
 void Pipe::MarkInputStreamClosed() {
   BaseMutexLock lock(mutex_.get());
   if (input_stream_closed_) return;
@@ -183,12 +268,140 @@ Exception Pipe::WriteLocked(const ByteArray& data) {
   return {Exception::kSuccess};
 }
 
+ExceptionOr<ByteArray> RingPipe::Read(size_t size) {
+  const std::uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  auto can_read = [&]() {
+    return write_pos_.load(std::memory_order_acquire) != read_pos || Closed();
+  };
+  if (!can_read()) {
+    Exception wait_exception = WaitUntil(reader_waiting_, can_read);
+    if (wait_exception.Raised()) {
+      return ExceptionOr<ByteArray>{wait_exception};
+    }
+  }
+
+  // Once the InputStream is closed nothing more is handed out, and an empty
+  // chunk serves as an EOF indication to callers.
+  if (input_stream_closed_.load(std::memory_order_acquire)) {
+    return ExceptionOr<ByteArray>{ByteArray{}};
+  }
+  // Only the OutputStream having been closed lets us get here with nothing
+  // buffered. Everything written before the close was published ahead of the
+  // flag, so re-reading `write_pos_` sees it and it is drained before EOF.
+  size_t available = write_pos_.load(std::memory_order_acquire) - read_pos;
+  if (available == 0) {
+    return ExceptionOr<ByteArray>{ByteArray{}};
+  }
+  size_t length = std::min(size, available);
+
+  ByteArray next_chunk(length);
+  size_t offset = read_pos % capacity_;
+  size_t first_part = std::min(length, capacity_ - offset);
+  std::memcpy(next_chunk.data(), &ring_[offset], first_part);
+  std::memcpy(next_chunk.data() + first_part, &ring_[0], length - first_part);
+  read_pos_.store(read_pos + length, std::memory_order_release);
+  Wake(writer_waiting_);
+  return ExceptionOr<ByteArray>{std::move(next_chunk)};
+}
+
+Exception RingPipe::Write(const ByteArray& data) {
+  if (Closed()) {
+    return {Exception::kIo};
+  }
+  std::uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+  auto can_write = [&]() {
+    return write_pos - read_pos_.load(std::memory_order_acquire) < capacity_ ||
+           Closed();
+  };
+  const char* next = data.data();
+  size_t remaining = data.size();
+  while (remaining > 0) {
+    if (!can_write()) {
+      Exception wait_exception = WaitUntil(writer_waiting_, can_write);
+      if (wait_exception.Raised()) return wait_exception;
+    }
+    if (Closed()) {
+      return {Exception::kIo};
+    }
+    size_t space =
+        capacity_ - (write_pos - read_pos_.load(std::memory_order_acquire));
+    size_t length = std::min(remaining, space);
+    size_t offset = write_pos % capacity_;
+    size_t first_part = std::min(length, capacity_ - offset);
+    std::memcpy(&ring_[offset], next, first_part);
+    std::memcpy(&ring_[0], next + first_part, length - first_part);
+    write_pos += length;
+    write_pos_.store(write_pos, std::memory_order_release);
+    Wake(reader_waiting_);
+    next += length;
+    remaining -= length;
+  }
+  return {Exception::kSuccess};
+}
+
+Exception RingPipe::WriteGathered(absl::Span<const ByteArray* const> buffers) {
+  if (Closed()) {
+    return {Exception::kIo};
+  }
+  for (const ByteArray* buffer : buffers) {
+    Exception exception = Write(*buffer);
+    if (exception.Raised()) return exception;
+  }
+  return {Exception::kSuccess};
+}
+
+void RingPipe::MarkInputStreamClosed() {
+  input_stream_closed_.store(true, std::memory_order_release);
+  // Unblock whichever side may be asleep; closing is rare, so don't bother
+  // checking the waiting flags.
+  BaseMutexLock lock(mutex_.get());
+  cond_->Notify();
+}
+
+void RingPipe::MarkOutputStreamClosed() {
+  output_stream_closed_.store(true, std::memory_order_release);
+  BaseMutexLock lock(mutex_.get());
+  cond_->Notify();
+}
+
+Exception RingPipe::WaitUntil(std::atomic<bool>& waiting,
+                              absl::FunctionRef<bool()> ready) {
+  BaseMutexLock lock(mutex_.get());
+  waiting.store(true, std::memory_order_relaxed);
+  // Pairs with the fence in Wake(): either the other side sees `waiting` and
+  // notifies under the lock, or `ready` sees what the other side published.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!ready()) {
+    Exception wait_exception = cond_->Wait();
+    if (wait_exception.Raised()) {
+      waiting.store(false, std::memory_order_relaxed);
+      return wait_exception;
+    }
+  }
+  waiting.store(false, std::memory_order_relaxed);
+  return {Exception::kSuccess};
+}
+
+void RingPipe::Wake(const std::atomic<bool>& waiting) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!waiting.load(std::memory_order_relaxed)) return;
+  BaseMutexLock lock(mutex_.get());
+  cond_->Notify();
+}
+
 }  // namespace
 
 std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
 CreatePipe() {
   auto pipe = std::make_shared<Pipe>();
-  return std::make_pair(std::make_unique<Pipe::PipeInputStream>(pipe),
-                        std::make_unique<Pipe::PipeOutputStream>(pipe));
+  return std::make_pair(std::make_unique<PipeInputStream<Pipe>>(pipe),
+                        std::make_unique<PipeOutputStream<Pipe>>(pipe));
+}
+
+std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
+CreatePipe(size_t capacity) {
+  auto pipe = std::make_shared<RingPipe>(capacity);
+  return std::make_pair(std::make_unique<PipeInputStream<RingPipe>>(pipe),
+                        std::make_unique<PipeOutputStream<RingPipe>>(pipe));
 }
 }  // namespace nearby
@@ -15,6 +15,7 @@
 #ifndef PLATFORM_PUBLIC_PIPE_H_
 #define PLATFORM_PUBLIC_PIPE_H_
 
+#include <cstddef>
 #include <memory>
 #include <utility>
 
@@ -33,6 +34,16 @@ namespace nearby {
 std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
 CreatePipe();
 
+// Creates a pipe that holds at most `capacity` bytes in a ring buffer, for use
+// by exactly one reader thread and one writer thread at a time.
+//
+// Write() blocks while the pipe is full, so a slow reader holds the writer
+// back instead of letting data pile up. Neither side takes a lock unless it
+// has to wait for the other, so a steady stream costs no mutex hand-off per
+// write.
+std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
+CreatePipe(size_t capacity);
+
 }  // namespace nearby
 
 #endif  // PLATFORM_PUBLIC_PIPE_H_
@@ -16,6 +16,7 @@
 
 #include <pthread.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstring>
@@ -26,6 +27,8 @@
 
 #include "gtest/gtest.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/input_stream.h"
@@ -54,6 +57,20 @@ TEST(PipeTest, SimpleWriteRead) {
   EXPECT_EQ(data, std::string(read_data.result()));
 }
 
+TEST(PipeTest, GatheredWriteRead) {
+  auto [input_stream, output_stream] = CreatePipe();
+  ByteArray header("AB");
+  ByteArray empty;
+  ByteArray body("CDEF");
+  const ByteArray* buffers[] = {&header, &empty, &body};
+  EXPECT_TRUE(output_stream->WriteGathered(buffers).Ok());
+
+  // The empty buffer must not be mistaken for the end of the stream.
+  ExceptionOr<ByteArray> read_data = input_stream->ReadExactly(6);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_EQ("ABCDEF", std::string(read_data.result()));
+}
+
 TEST(PipeTest, WriteEndClosedBeforeRead) {
   auto [input_stream, output_stream] = CreatePipe();
 
@@ -337,4 +354,125 @@ TEST(PipeTest, ConcurrentWriteAndRead) {
   reader_thread.Join();
 }
 
+TEST(PipeTest, RingPipeSimpleWriteRead) {
+  auto [input_stream, output_stream] = CreatePipe(/*capacity=*/16);
+  ByteArray header("AB");
+  ByteArray empty;
+  ByteArray body("CDEF");
+  const ByteArray* buffers[] = {&header, &empty, &body};
+  EXPECT_TRUE(output_stream->WriteGathered(buffers).Ok());
+
+  ExceptionOr<ByteArray> read_data = input_stream->Read(4);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_EQ("ABCD", std::string(read_data.result()));
+  read_data = input_stream->Read(kChunkSize);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_EQ("EF", std::string(read_data.result()));
+}
+
+TEST(PipeTest, RingPipeCloseSemantics) {
+  auto [input_stream, output_stream] = CreatePipe(/*capacity=*/16);
+  EXPECT_TRUE(output_stream->Write(ByteArray("ABCD")).Ok());
+  EXPECT_TRUE(output_stream->Close().Ok());
+  EXPECT_TRUE(output_stream->Write(ByteArray("EFGH")).Raised(Exception::kIo));
+
+  // What was written before the close is still readable, followed by EOF.
+  ExceptionOr<ByteArray> read_data = input_stream->Read(kChunkSize);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_EQ("ABCD", std::string(read_data.result()));
+  read_data = input_stream->Read(kChunkSize);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_TRUE(read_data.result().Empty());
+
+  EXPECT_TRUE(input_stream->Close().Ok());
+  read_data = input_stream->Read(kChunkSize);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_TRUE(read_data.result().Empty());
+}
+
+TEST(PipeTest, RingPipeDrainsFullRingAfterWriterCloses) {
+  constexpr size_t kCapacity = 16;
+  auto [input_stream, output_stream] = CreatePipe(kCapacity);
+  std::string expected_data = "0123456789ABCDEF";
+  ASSERT_EQ(expected_data.size(), kCapacity);
+
+  // The writer fills the ring exactly and closes its end while the reader is
+  // still asleep, so the close races with the reader's wake-up.
+  OutputStream* output = output_stream.get();
+  Thread writer_thread;
+  writer_thread.Start([output, &expected_data]() {
+    absl::SleepFor(absl::Milliseconds(100));
+    EXPECT_TRUE(output->Write(ByteArray(expected_data)).Ok());
+    EXPECT_TRUE(output->Close().Ok());
+  });
+
+  std::string actual_data;
+  while (true) {
+    ExceptionOr<ByteArray> read_data = input_stream->Read(3);
+    ASSERT_TRUE(read_data.ok());
+    if (read_data.result().Empty()) break;
+    actual_data += std::string(read_data.result());
+  }
+  writer_thread.Join();
+
+  EXPECT_EQ(expected_data, actual_data);
+  ExceptionOr<ByteArray> read_data = input_stream->Read(kChunkSize);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_TRUE(read_data.result().Empty());
+}
+
+TEST(PipeTest, RingPipeReaderCloseUnblocksWriter) {
+  auto [input_stream, output_stream] = CreatePipe(/*capacity=*/4);
+  OutputStream* output = output_stream.get();
+  Exception write_result{Exception::kSuccess};
+
+  // The write cannot fit, so it blocks until the read end goes away.
+  Thread writer_thread;
+  writer_thread.Start(
+      [output, &write_result]() { write_result = output->Write(ByteArray(8)); });
+  absl::SleepFor(absl::Milliseconds(100));
+  EXPECT_TRUE(input_stream->Close().Ok());
+  writer_thread.Join();
+
+  EXPECT_TRUE(write_result.Raised(Exception::kIo));
+}
+
+TEST(PipeTest, RingPipeStreamsMoreThanCapacity) {
+  constexpr size_t kCapacity = 7;
+  auto [input_stream, output_stream] = CreatePipe(kCapacity);
+  std::string expected_data;
+  for (int i = 0; i < 1000; ++i) {
+    expected_data += std::to_string(i);
+  }
+
+  // Writes of every size up to several times the capacity, so that copies
+  // wrap around the ring and the writer has to wait for the reader.
+  OutputStream* output = output_stream.get();
+  Thread writer_thread;
+  writer_thread.Start([output, &expected_data]() {
+    size_t offset = 0;
+    size_t length = 1;
+    while (offset < expected_data.size()) {
+      length = std::min(length, expected_data.size() - offset);
+      EXPECT_TRUE(
+          output->Write(ByteArray(expected_data.data() + offset, length)).Ok());
+      offset += length;
+      length = length % (4 * kCapacity) + 1;
+    }
+    EXPECT_TRUE(output->Close().Ok());
+  });
+
+  std::string actual_data;
+  while (true) {
+    ExceptionOr<ByteArray> read_data = input_stream->Read(5);
+    ASSERT_TRUE(read_data.ok());
+    if (read_data.result().Empty()) break;
+    EXPECT_LE(read_data.result().size(), 5);
+    actual_data += std::string(read_data.result());
+  }
+  writer_thread.Join();
+
+  EXPECT_EQ(expected_data, actual_data);
+}
+
 }  // namespace nearby
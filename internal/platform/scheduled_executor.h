@@ -22,6 +22,7 @@
 #include "absl/time/time.h"
 #include "internal/platform/cancelable.h"
 #include "internal/platform/cancellable_task.h"
+#include "internal/platform/feature_flags.h"
 #include "internal/platform/implementation/platform.h"
 #include "internal/platform/implementation/scheduled_executor.h"
 #include "internal/platform/lockable.h"
@@ -31,6 +32,7 @@
 #include "internal/platform/runnable.h"
 #include "internal/platform/thread_check_callable.h"
 #include "internal/platform/thread_check_runnable.h"
+#include "internal/platform/timer_wheel.h"
 
 namespace nearby {
 
@@ -42,7 +44,9 @@ class ABSL_LOCKABLE ScheduledExecutor final : public Lockable {
  public:
   using Platform = api::ImplementationPlatform;
 
-  ScheduledExecutor() : impl_(Platform::CreateScheduledExecutor()) {}
+  ScheduledExecutor()
+      : impl_(Platform::CreateScheduledExecutor()),
+        wheel_target_(std::make_shared<WheelTarget>(impl_.get())) {}
   ScheduledExecutor(ScheduledExecutor&& other) { *this = std::move(other); }
   ~ScheduledExecutor() { DoShutdown(); }
 
@@ -52,6 +56,7 @@ class ABSL_LOCKABLE ScheduledExecutor final : public Lockable {
     {
       MutexLock other_lock(&other.mutex_);
       impl_ = std::move(other.impl_);
+      wheel_target_ = std::move(other.wheel_target_);
     }
     return *this;
   }
@@ -76,6 +81,17 @@ class ABSL_LOCKABLE ScheduledExecutor final : public Lockable {
     if (impl_) {
       auto task = std::make_shared<CancellableTask>(
           ThreadCheckRunnable(this, std::move(runnable)));
+      if (FeatureFlags::GetInstance().GetFlags().enable_timer_wheel) {
+        TimerWheel& wheel = TimerWheel::GetDefault();
+        TimerWheel::TimerId id = wheel.Schedule(
+            duration, [target = wheel_target_, task]() {
+              MutexLock lock(&target->mutex);
+              if (target->executor)
+                target->executor->Execute([task]() { (*task)(); });
+            });
+        return Cancelable(task,
+                          std::make_shared<TimerWheelCancelable>(&wheel, id));
+      }
       return Cancelable(task,
                         impl_->Schedule([task]() { (*task)(); }, duration));
     } else {
@@ -84,7 +100,22 @@ class ABSL_LOCKABLE ScheduledExecutor final : public Lockable {
   }
 
  private:
+  // Lets timers on the TimerWheel hand their task to the platform executor
+  // for as long as it is running.
+  struct WheelTarget {
+    explicit WheelTarget(api::ScheduledExecutor* executor)
+        : executor(executor) {}
+
+    Mutex mutex;
+    api::ScheduledExecutor* executor ABSL_GUARDED_BY(mutex);
+  };
+
   void DoShutdown() ABSL_LOCKS_EXCLUDED(mutex_) {
+    std::shared_ptr<WheelTarget> wheel_target = ReleaseWheelTarget();
+    if (wheel_target) {
+      MutexLock lock(&wheel_target->mutex);
+      wheel_target->executor = nullptr;
+    }
     std::unique_ptr<api::ScheduledExecutor> executor = ReleaseExecutor();
     if (executor) {
       executor->Shutdown();
@@ -97,8 +128,15 @@ class ABSL_LOCKABLE ScheduledExecutor final : public Lockable {
     return std::move(impl_);
   }
 
+  std::shared_ptr<WheelTarget> ReleaseWheelTarget()
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    MutexLock lock(&mutex_);
+    return std::move(wheel_target_);
+  }
+
   mutable Mutex mutex_;
   std::unique_ptr<api::ScheduledExecutor> ABSL_GUARDED_BY(mutex_) impl_;
+  std::shared_ptr<WheelTarget> ABSL_GUARDED_BY(mutex_) wheel_target_;
 };
 
 }  // namespace nearby
@@ -22,11 +22,13 @@
 #include "absl/functional/any_invocable.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "internal/platform/feature_flags.h"
 #include "internal/platform/implementation/crypto.h"
 #include "internal/platform/multi_thread_executor.h"
 #include "internal/platform/single_thread_executor.h"
 #include "internal/platform/timer.h"
 #include "internal/platform/timer_impl.h"
+#include "internal/platform/timer_wheel.h"
 
 namespace nearby {
 
@@ -50,14 +52,19 @@ TaskRunnerImpl::~TaskRunnerImpl() {
 
 void TaskRunnerImpl::Shutdown() {
   absl::flat_hash_map<uint64_t, std::unique_ptr<Timer>> timers;
+  absl::flat_hash_map<uint64_t, TimerWheel::TimerId> wheel_timers;
   {
     absl::MutexLock lock(&mutex_);
     closed_ = true;
     timers = std::move(timers_map_);
+    wheel_timers = std::move(wheel_timers_);
   }
   for (auto& timer : timers) {
     timer.second->Stop();
   }
+  for (auto& wheel_timer : wheel_timers) {
+    TimerWheel::GetDefault().Cancel(wheel_timer.second);
+  }
   // We expect that all timers are stopped, no new timers will be added, and the
   // timer callbacks are not running.
   executor_->Shutdown();
@@ -88,6 +95,9 @@ bool TaskRunnerImpl::PostDelayedTask(absl::Duration delay,
   if (!task) {
     return true;
   }
+  if (FeatureFlags::GetInstance().GetFlags().enable_timer_wheel) {
+    return PostDelayedTaskOnTimerWheel(delay, std::move(task));
+  }
   uint64_t id = GenerateId();
   std::unique_ptr<Timer> timer = std::make_unique<TimerImpl>();
   if (timer->Start(absl::ToInt64Milliseconds(delay), 0,
@@ -114,6 +124,30 @@ bool TaskRunnerImpl::PostDelayedTask(absl::Duration delay,
   return false;
 }
 
+bool TaskRunnerImpl::PostDelayedTaskOnTimerWheel(
+    absl::Duration delay, absl::AnyInvocable<void()> task) {
+  uint64_t id = GenerateId();
+  // The callback can't run before the id is recorded because it needs
+  // mutex_, which is held here. Shutdown() cancels the timer, waiting for a
+  // running callback, before this object goes away.
+  TimerWheel::TimerId timer_id = TimerWheel::GetDefault().Schedule(
+      delay, [this, id, task = std::move(task)]() mutable {
+        {
+          absl::MutexLock lock(&mutex_);
+          if (closed_) {
+            return;
+          }
+          wheel_timers_.erase(id);
+        }
+        PostTask(std::move(task));
+      });
+  if (timer_id == TimerWheel::kInvalidTimerId) {
+    return false;
+  }
+  wheel_timers_.emplace(id, timer_id);
+  return true;
+}
+
 uint64_t TaskRunnerImpl::GenerateId() { return nearby::RandData<uint64_t>(); }
 
 }  // namespace nearby
@@ -34,6 +34,7 @@
 #include "internal/platform/submittable_executor.h"
 #include "internal/platform/task_runner.h"
 #include "internal/platform/timer.h"
+#include "internal/platform/timer_wheel.h"
 
 namespace nearby {
 
@@ -52,11 +53,17 @@ class TaskRunnerImpl : public TaskRunner {
 
  private:
   uint64_t GenerateId();
+  bool PostDelayedTaskOnTimerWheel(absl::Duration delay,
+                                   absl::AnyInvocable<void()> task)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   mutable absl::Mutex mutex_;
   std::unique_ptr<SubmittableExecutor> executor_;
   absl::flat_hash_map<uint64_t, std::unique_ptr<Timer>> timers_map_
       ABSL_GUARDED_BY(mutex_);
+  // Delayed tasks waiting on the TimerWheel, by the same kind of id.
+  absl::flat_hash_map<uint64_t, TimerWheel::TimerId> wheel_timers_
+      ABSL_GUARDED_BY(mutex_);
   bool closed_ ABSL_GUARDED_BY(mutex_) = false;
 };
 
@@ -23,6 +23,7 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/feature_flags.h"
 
 namespace nearby {
 namespace {
@@ -127,6 +128,31 @@ TEST_P(TaskRunnerImplTest, PostMultipleTasks) {
   EXPECT_TRUE(latch.Await());
 }
 
+TEST_P(TaskRunnerImplTest, PostDelayedTasksOnTimerWheel) {
+  FeatureFlags::GetMutableFlagsForTesting().enable_timer_wheel = true;
+  TaskRunnerImpl task_runner{GetParam()};
+  std::atomic_bool short_task_ran = false;
+  std::atomic_bool cancelled_task_ran = false;
+  CountDownLatch latch(2);
+
+  task_runner.PostDelayedTask(absl::Milliseconds(300), [&]() {
+    EXPECT_TRUE(short_task_ran);
+    latch.CountDown();
+  });
+  task_runner.PostDelayedTask(absl::Milliseconds(10), [&]() {
+    short_task_ran = true;
+    latch.CountDown();
+  });
+
+  latch.Await();
+  // Pending wheel timers are cancelled on shutdown.
+  task_runner.PostDelayedTask(absl::Milliseconds(10),
+                              [&]() { cancelled_task_ran = true; });
+  task_runner.Shutdown();
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_FALSE(cancelled_task_ran);
+}
+
 TEST_P(TaskRunnerImplTest, PostEmptyTask) {
   TaskRunnerImpl task_runner{GetParam()};
   EXPECT_TRUE(task_runner.PostTask(nullptr));
@@ -0,0 +1,224 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/timer_wheel.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "internal/platform/clock.h"
+#include "internal/platform/system_clock.h"
+
+namespace nearby {
+
+namespace {
+constexpr absl::Duration kTick = absl::Milliseconds(1);
+constexpr std::int64_t kNever = std::numeric_limits<std::int64_t>::max();
+}  // namespace
+
+// static
+TimerWheel& TimerWheel::GetDefault() {
+  static TimerWheel* wheel = new TimerWheel();
+  return *wheel;
+}
+
+TimerWheel::TimerWheel() : TimerWheel(nullptr) {}
+
+TimerWheel::TimerWheel(const Clock* clock) : clock_(clock), start_time_(Now()) {
+  thread_.Execute("timer-wheel", [this]() { Run(); });
+}
+
+TimerWheel::~TimerWheel() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutdown_ = true;
+    timers_.clear();
+    for (auto& level : wheel_) {
+      for (Slot& slot : level) slot.clear();
+    }
+    wake_up_.Signal();
+  }
+  thread_.Shutdown();
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(absl::Duration delay,
+                                         absl::AnyInvocable<void()> callback) {
+  // Round up, so a timer never fires early.
+  std::int64_t delay_ticks =
+      absl::ToInt64Milliseconds(absl::Ceil(std::max(delay, kTick), kTick));
+  std::int64_t now_tick = NowTick();
+  absl::MutexLock lock(&mutex_);
+  if (shutdown_) return kInvalidTimerId;
+  // The wheel doesn't advance while it is empty; catch up first so the timer
+  // isn't filed against a stale tick.
+  if (timers_.empty()) {
+    current_tick_ = std::max(current_tick_, now_tick);
+  }
+  TimerId id = next_id_++;
+  Timer& timer = timers_[id];
+  timer.expiry_tick = now_tick + delay_ticks;
+  timer.callback = std::move(callback);
+  Insert(id, timer, /*cascading=*/false);
+  if (timer.expiry_tick < next_wake_tick_) wake_up_.Signal();
+  return id;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+  absl::MutexLock lock(&mutex_);
+  auto it = timers_.find(id);
+  if (it != timers_.end()) {
+    if (it->second.slot != nullptr) {
+      it->second.slot->erase(it->second.position);
+    }
+    timers_.erase(it);
+    return true;
+  }
+  if (thread_id_ != std::this_thread::get_id()) {
+    while (running_id_ == id && id != kInvalidTimerId) {
+      callback_done_.Wait(&mutex_);
+    }
+  }
+  return false;
+}
+
+size_t TimerWheel::GetPendingCountForTesting() {
+  absl::MutexLock lock(&mutex_);
+  return timers_.size();
+}
+
+absl::Time TimerWheel::Now() const {
+  return clock_ != nullptr ? clock_->Now() : SystemClock::ElapsedRealtime();
+}
+
+std::int64_t TimerWheel::NowTick() const {
+  return (Now() - start_time_) / kTick;
+}
+
+void TimerWheel::Insert(TimerId id, Timer& timer, bool cascading) {
+  std::int64_t expiry =
+      std::max(timer.expiry_tick, current_tick_ + (cascading ? 0 : 1));
+  std::int64_t delta = expiry - current_tick_;
+  int level = 0;
+  while (level < kLevels - 1 &&
+         delta >= (std::int64_t{1} << (kSlotBits * (level + 1)))) {
+    ++level;
+  }
+  // Timers beyond the outermost level park in its last slot and are filed
+  // again from their real expiry tick when that slot cascades.
+  std::int64_t limit = std::int64_t{1} << (kSlotBits * kLevels);
+  if (delta >= limit) expiry = current_tick_ + limit - 1;
+  Slot& slot = wheel_[level][(expiry >> (kSlotBits * level)) & kSlotMask];
+  timer.slot = &slot;
+  timer.position = slot.insert(slot.end(), id);
+}
+
+void TimerWheel::Advance(std::int64_t now_tick, std::list<TimerId>& due) {
+  if (timers_.empty()) {
+    current_tick_ = std::max(current_tick_, now_tick);
+    return;
+  }
+  while (current_tick_ < now_tick) {
+    // Skip the ticks on which no slot holding timers is reached.
+    current_tick_ = std::min(now_tick, NextEventTick());
+    // When an inner wheel completes a turn, the matching slot of the next
+    // level out holds exactly the timers due during its next turn.
+    for (int level = kLevels - 1; level > 0; --level) {
+      std::int64_t turn_mask = (std::int64_t{1} << (kSlotBits * level)) - 1;
+      if ((current_tick_ & turn_mask) != 0) continue;
+      Slot cascading;
+      cascading.splice(
+          cascading.end(),
+          wheel_[level][(current_tick_ >> (kSlotBits * level)) & kSlotMask]);
+      for (TimerId id : cascading) {
+        Insert(id, timers_[id], /*cascading=*/true);
+      }
+    }
+    Slot& slot = wheel_[0][current_tick_ & kSlotMask];
+    for (TimerId id : slot) {
+      timers_[id].slot = nullptr;
+    }
+    due.splice(due.end(), slot);
+  }
+}
+
+std::int64_t TimerWheel::NextEventTick() const {
+  std::int64_t next = kNever;
+  // Level 0 only holds timers due within one turn of the current tick.
+  for (std::int64_t tick = current_tick_ + 1;
+       tick <= current_tick_ + kSlotsPerLevel; ++tick) {
+    if (!wheel_[0][tick & kSlotMask].empty()) {
+      next = tick;
+      break;
+    }
+  }
+  // Level n cascades one of its slots every 2^(kSlotBits * n) ticks; look at
+  // its next turn for the first slot holding timers.
+  for (int level = 1; level < kLevels; ++level) {
+    int shift = kSlotBits * level;
+    std::int64_t tick = ((current_tick_ >> shift) + 1) << shift;
+    for (int i = 0; i < kSlotsPerLevel && tick < next;
+         ++i, tick += std::int64_t{1} << shift) {
+      if (!wheel_[level][(tick >> shift) & kSlotMask].empty()) {
+        next = tick;
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+void TimerWheel::Run() {
+  absl::MutexLock lock(&mutex_);
+  thread_id_ = std::this_thread::get_id();
+  while (!shutdown_) {
+    std::list<TimerId> due;
+    Advance(NowTick(), due);
+    for (TimerId id : due) {
+      auto it = timers_.find(id);
+      // Cancelled while waiting to run.
+      if (it == timers_.end()) continue;
+      absl::AnyInvocable<void()> callback = std::move(it->second.callback);
+      timers_.erase(it);
+      running_id_ = id;
+      mutex_.Unlock();
+      callback();
+      callback = nullptr;
+      mutex_.Lock();
+      running_id_ = kInvalidTimerId;
+      callback_done_.SignalAll();
+      if (shutdown_) return;
+    }
+
+    next_wake_tick_ = NextEventTick();
+    if (next_wake_tick_ == kNever) {
+      wake_up_.Wait(&mutex_);
+    } else {
+      absl::Duration timeout = start_time_ + next_wake_tick_ * kTick - Now();
+      if (timeout > absl::ZeroDuration()) {
+        wake_up_.WaitWithTimeout(&mutex_, timeout);
+      }
+    }
+    next_wake_tick_ = 0;
+  }
+}
+
+}  // namespace nearby
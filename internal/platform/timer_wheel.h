@@ -0,0 +1,137 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_PUBLIC_TIMER_WHEEL_H_
+#define PLATFORM_PUBLIC_TIMER_WHEEL_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <thread>  // NOLINT
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "internal/platform/clock.h"
+#include "internal/platform/implementation/cancelable.h"
+#include "internal/platform/single_thread_executor.h"
+
+namespace nearby {
+
+// A hierarchical timing wheel that drives any number of timers from a single
+// thread. Scheduling and cancelling a timer are O(1). Timers have a resolution
+// of one tick (1 ms); the thread only wakes up when a timer is due or, while
+// timers are pending further out, when a slot of an outer wheel is due to be
+// cascaded.
+//
+// Callbacks run one at a time on the wheel's thread, so they must be short;
+// anything longer should be posted to an executor.
+class TimerWheel {
+ public:
+  using TimerId = std::uint64_t;
+  static constexpr TimerId kInvalidTimerId = 0;
+
+  // The wheel shared by TaskRunnerImpl and ScheduledExecutor. It is never
+  // destroyed.
+  static TimerWheel& GetDefault();
+
+  TimerWheel();
+  // Reads the time from |clock| instead of the system's elapsed realtime.
+  explicit TimerWheel(const Clock* clock);
+  // Drops all pending timers and stops the thread.
+  ~TimerWheel();
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Runs |callback| on the wheel's thread once |delay| has passed.
+  TimerId Schedule(absl::Duration delay, absl::AnyInvocable<void()> callback)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns true if the timer was pending and won't run. If its callback is
+  // running on the wheel's thread, waits for it to return first, unless called
+  // from the callback itself.
+  bool Cancel(TimerId id) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  size_t GetPendingCountForTesting() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  static constexpr int kLevels = 4;
+  static constexpr int kSlotBits = 8;
+  static constexpr int kSlotsPerLevel = 1 << kSlotBits;
+  static constexpr std::int64_t kSlotMask = kSlotsPerLevel - 1;
+
+  using Slot = std::list<TimerId>;
+
+  struct Timer {
+    std::int64_t expiry_tick = 0;
+    absl::AnyInvocable<void()> callback;
+    // The slot holding the timer, or nullptr once it is due.
+    Slot* slot = nullptr;
+    Slot::iterator position;
+  };
+
+  absl::Time Now() const;
+  std::int64_t NowTick() const;
+  // Files |timer| into the slot for its expiry tick relative to
+  // |current_tick_|. Timers that are already due go into the slot for the
+  // next tick, unless |cascading|, in which case the slot for the current
+  // tick hasn't been drained yet and they go there.
+  void Insert(TimerId id, Timer& timer, bool cascading)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Moves the wheel forward to |now_tick|, cascading timers down the levels,
+  // and appends the timers that are due to |due|.
+  void Advance(std::int64_t now_tick, std::list<TimerId>& due)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the next tick at which a level 0 slot holds timers or an outer
+  // slot holding timers cascades, or kNever if the wheel is empty. Advance()
+  // has nothing to do on the ticks in between.
+  std::int64_t NextEventTick() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void Run() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const Clock* const clock_ = nullptr;
+  const absl::Time start_time_;
+  absl::Mutex mutex_;
+  absl::CondVar wake_up_;
+  absl::CondVar callback_done_;
+  std::array<std::array<Slot, kSlotsPerLevel>, kLevels> wheel_
+      ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<TimerId, Timer> timers_ ABSL_GUARDED_BY(mutex_);
+  std::int64_t current_tick_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::int64_t next_wake_tick_ ABSL_GUARDED_BY(mutex_) = 0;
+  TimerId next_id_ ABSL_GUARDED_BY(mutex_) = 1;
+  TimerId running_id_ ABSL_GUARDED_BY(mutex_) = kInvalidTimerId;
+  std::thread::id thread_id_ ABSL_GUARDED_BY(mutex_);
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+  SingleThreadExecutor thread_;
+};
+
+// An api::Cancelable for a timer on a TimerWheel.
+class TimerWheelCancelable : public api::Cancelable {
+ public:
+  TimerWheelCancelable(TimerWheel* wheel, TimerWheel::TimerId id)
+      : wheel_(wheel), id_(id) {}
+
+  bool Cancel() override { return wheel_->Cancel(id_); }
+
+ private:
+  TimerWheel* wheel_;
+  TimerWheel::TimerId id_;
+};
+
+}  // namespace nearby
+
+#endif  // PLATFORM_PUBLIC_TIMER_WHEEL_H_
@@ -0,0 +1,186 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/timer_wheel.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/test/fake_clock.h"
+
+namespace nearby {
+namespace {
+
+TEST(TimerWheelTest, FiresAfterDelay) {
+  TimerWheel wheel;
+  absl::Notification fired;
+  absl::Time start = absl::Now();
+
+  wheel.Schedule(absl::Milliseconds(20), [&fired]() { fired.Notify(); });
+
+  ASSERT_TRUE(fired.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_GE(absl::Now() - start, absl::Milliseconds(20));
+}
+
+TEST(TimerWheelTest, FiresInExpiryOrder) {
+  TimerWheel wheel;
+  absl::Mutex mutex;
+  std::vector<int> order;
+  CountDownLatch latch(3);
+  auto record = [&](int value) {
+    return [&, value]() {
+      {
+        absl::MutexLock lock(&mutex);
+        order.push_back(value);
+      }
+      latch.CountDown();
+    };
+  };
+
+  wheel.Schedule(absl::Milliseconds(60), record(3));
+  wheel.Schedule(absl::Milliseconds(10), record(1));
+  wheel.Schedule(absl::Milliseconds(30), record(2));
+
+  latch.Await();
+  absl::MutexLock lock(&mutex);
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(TimerWheelTest, CascadesFromOuterLevel) {
+  TimerWheel wheel;
+  absl::Notification fired;
+  absl::Time start = absl::Now();
+
+  // Longer than one turn of the innermost wheel.
+  wheel.Schedule(absl::Milliseconds(600), [&fired]() { fired.Notify(); });
+
+  ASSERT_TRUE(fired.WaitForNotificationWithTimeout(absl::Seconds(2)));
+  EXPECT_GE(absl::Now() - start, absl::Milliseconds(600));
+}
+
+TEST(TimerWheelTest, CancelPreventsCallback) {
+  TimerWheel wheel;
+  std::atomic_bool fired = false;
+  absl::Notification later;
+
+  TimerWheel::TimerId id = wheel.Schedule(absl::Milliseconds(20),
+                                          [&fired]() { fired = true; });
+  wheel.Schedule(absl::Milliseconds(50), [&later]() { later.Notify(); });
+
+  EXPECT_TRUE(wheel.Cancel(id));
+  EXPECT_FALSE(wheel.Cancel(id));
+  ASSERT_TRUE(later.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_FALSE(fired);
+  EXPECT_EQ(wheel.GetPendingCountForTesting(), 0);
+}
+
+TEST(TimerWheelTest, CancelWaitsForRunningCallback) {
+  TimerWheel wheel;
+  absl::Notification started;
+  std::atomic_bool finished = false;
+
+  TimerWheel::TimerId id = wheel.Schedule(absl::Milliseconds(1), [&]() {
+    started.Notify();
+    absl::SleepFor(absl::Milliseconds(50));
+    finished = true;
+  });
+  started.WaitForNotification();
+
+  EXPECT_FALSE(wheel.Cancel(id));
+  EXPECT_TRUE(finished);
+}
+
+TEST(TimerWheelTest, CallbackCanScheduleAndCancelItself) {
+  TimerWheel wheel;
+  absl::Notification fired;
+  TimerWheel::TimerId id = TimerWheel::kInvalidTimerId;
+  absl::Mutex mutex;
+
+  {
+    absl::MutexLock lock(&mutex);
+    id = wheel.Schedule(absl::Milliseconds(1), [&]() {
+      absl::MutexLock lock(&mutex);
+      EXPECT_FALSE(wheel.Cancel(id));
+      wheel.Schedule(absl::Milliseconds(1), [&fired]() { fired.Notify(); });
+    });
+  }
+
+  EXPECT_TRUE(fired.WaitForNotificationWithTimeout(absl::Seconds(1)));
+}
+
+TEST(TimerWheelTest, HandlesManyTimers) {
+  TimerWheel wheel;
+  constexpr int kTimers = 5000;
+  CountDownLatch latch(kTimers / 2);
+  std::vector<TimerWheel::TimerId> ids;
+
+  for (int i = 0; i < kTimers; ++i) {
+    ids.push_back(wheel.Schedule(absl::Milliseconds(100 + i % 300),
+                                 [&latch]() { latch.CountDown(); }));
+  }
+  for (int i = 0; i < kTimers; i += 2) {
+    EXPECT_TRUE(wheel.Cancel(ids[i]));
+  }
+
+  EXPECT_TRUE(latch.Await(absl::Seconds(5)).result());
+  EXPECT_EQ(wheel.GetPendingCountForTesting(), 0);
+}
+
+TEST(TimerWheelTest, CatchesUpAfterIdlePeriod) {
+  FakeClock clock;
+  TimerWheel wheel(&clock);
+  absl::Notification fired;
+
+  clock.FastForward(absl::Hours(24 * 10));
+  wheel.Schedule(absl::Milliseconds(5), [&fired]() { fired.Notify(); });
+
+  EXPECT_FALSE(fired.WaitForNotificationWithTimeout(absl::Milliseconds(20)));
+  clock.FastForward(absl::Milliseconds(5));
+  EXPECT_TRUE(fired.WaitForNotificationWithTimeout(absl::Seconds(1)));
+}
+
+TEST(TimerWheelTest, SkipsIdleTicksWhileFarTimerIsPending) {
+  FakeClock clock;
+  TimerWheel wheel(&clock);
+  absl::Notification fired;
+
+  wheel.Schedule(absl::Hours(24 * 30), []() {});
+  clock.FastForward(absl::Hours(24 * 10));
+  wheel.Schedule(absl::Milliseconds(5), [&fired]() { fired.Notify(); });
+  clock.FastForward(absl::Milliseconds(5));
+
+  EXPECT_TRUE(fired.WaitForNotificationWithTimeout(absl::Seconds(1)));
+  EXPECT_EQ(wheel.GetPendingCountForTesting(), 1);
+}
+
+TEST(TimerWheelTest, CascadedTimerFiresOnItsExpiryTick) {
+  FakeClock clock;
+  TimerWheel wheel(&clock);
+  absl::Notification fired;
+
+  // Filed in the second level and cascaded on the tick it expires.
+  wheel.Schedule(absl::Milliseconds(256), [&fired]() { fired.Notify(); });
+  clock.FastForward(absl::Milliseconds(256));
+
+  EXPECT_TRUE(fired.WaitForNotificationWithTimeout(absl::Seconds(1)));
+}
+
+}  // namespace
+}  // namespace nearby
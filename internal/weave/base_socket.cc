@@ -14,7 +14,10 @@
 
 #include "internal/weave/base_socket.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <deque>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -77,6 +80,7 @@ BaseSocket::BaseSocket(const Connection& connection, SocketCallback&& callback)
            },
        .on_disconnected_cb = [this]() { DisconnectQuietly(); }});
   max_packet_size_ = connection_.GetMaxPacketSize();
+  max_in_flight_packets_ = std::max(1, connection_.GetMaxInFlightPackets());
 }
 
 BaseSocket::~BaseSocket() {
@@ -106,7 +110,12 @@ void BaseSocket::TryWriteNextControl() {
   // connection.
   current_message_ = nullptr;
   message_request_queue_.clear();
-  WritePacket(current_control_->NextPacket(max_packet_size_));
+  // Control packets don't wait for the write window; the data packets still
+  // in flight keep their place so transmit results stay matched up.
+  if (WritePacket(current_control_->NextPacket(max_packet_size_))) {
+    in_flight_packets_.push_back(
+        {.is_control = true, .finished_message = std::nullopt});
+  }
 }
 
 void BaseSocket::TryWriteNextMessage() {
@@ -122,26 +131,40 @@ void BaseSocket::TryWriteNextMessage() {
   }
   bool connected = IsConnected();
   MutexLock lock(&mutex_);
-  if (current_message_ == nullptr) {
-    if (!message_request_queue_.empty()) {
+  if (!connected) {
+    return;
+  }
+  // Keep up to max_in_flight_packets_ packets with the connection, moving on
+  // to the next queued message as soon as the current one is packetized.
+  while (in_flight_packets_.size() < max_in_flight_packets_) {
+    if (current_message_ == nullptr) {
+      if (message_request_queue_.empty()) {
+        return;
+      }
       current_message_ = &message_request_queue_.front();
     }
+    if (!WritePacket(current_message_->NextPacket(max_packet_size_))) {
+      return;
+    }
+    InFlightPacket in_flight;
+    if (current_message_->IsFinished()) {
+      in_flight.finished_message = std::move(*current_message_);
+      message_request_queue_.pop_front();
+      current_message_ = nullptr;
+    }
+    in_flight_packets_.push_back(std::move(in_flight));
   }
-  if (current_message_ == nullptr || current_message_->IsFinished() ||
-      !connected) {
-    return;
-  }
-  WritePacket(current_message_->NextPacket(max_packet_size_));
 }
 
-void BaseSocket::WritePacket(absl::StatusOr<Packet> packet) {
+bool BaseSocket::WritePacket(absl::StatusOr<Packet> packet) {
   if (!packet.ok()) {
     NEARBY_LOGS(WARNING) << "Packet status:" << packet.status();
-    return;
+    return false;
   }
   CHECK(packet->SetPacketCounter(packet_counter_generator_.Next()).ok());
   NEARBY_LOGS(INFO) << "transmitting packet";
-  connection_.Transmit(packet->GetBytes());
+  connection_.Transmit(std::move(*packet).GetBytes());
+  return true;
 }
 
 void BaseSocket::OnWriteRequestWriteComplete(absl::Status status) {
@@ -151,20 +174,18 @@ void BaseSocket::OnWriteRequestWriteComplete(absl::Status status) {
           ABSL_LOCKS_EXCLUDED(mutex_) mutable {
             {
               MutexLock lock(&mutex_);
-              if (current_control_ != nullptr) {
-                current_control_ = nullptr;
-                control_request_queue_.pop_front();
-              } else if (current_message_ != nullptr) {
-                NEARBY_LOGS(INFO) << "OnWriteResult current is not null";
-                if (current_message_->IsFinished()) {
-                  NEARBY_LOGS(INFO) << "OnWriteResult current finished";
-                  current_message_->SetWriteStatus(status);
-                  if (!message_request_queue_.empty() &&
-                      current_message_ == &message_request_queue_.front()) {
-                    NEARBY_LOGS(INFO) << "remove message";
-                    message_request_queue_.pop_front();
-                    current_message_ = nullptr;
+              // Nothing is in flight after a reset; late results are dropped.
+              if (!in_flight_packets_.empty()) {
+                InFlightPacket packet = std::move(in_flight_packets_.front());
+                in_flight_packets_.pop_front();
+                if (packet.is_control) {
+                  current_control_ = nullptr;
+                  if (!control_request_queue_.empty()) {
+                    control_request_queue_.pop_front();
                   }
+                } else if (packet.finished_message.has_value()) {
+                  NEARBY_LOGS(INFO) << "OnWriteResult message finished";
+                  packet.finished_message->SetWriteStatus(status);
                 }
               }
             }
@@ -227,6 +248,7 @@ void BaseSocket::DisconnectQuietly() {
                             MutexLock lock(&mutex_);
                             message_request_queue_.clear();
                             control_request_queue_.clear();
+                            in_flight_packets_.clear();
                             current_control_ = nullptr;
                             current_message_ = nullptr;
                             state_ = SocketConnectionState::kDisconnected;
@@ -251,7 +273,7 @@ void BaseSocket::OnReceiveDataPacket(Packet packet) {
 }
 
 nearby::Future<absl::Status> BaseSocket::Write(ByteArray message) {
-  MessageWriteRequest request = MessageWriteRequest(message.string_data());
+  MessageWriteRequest request = MessageWriteRequest(message.AsStringView());
   nearby::Future<absl::Status> ret = request.GetWriteStatusFuture();
 
   RunOnSocketThread(
@@ -15,7 +15,9 @@
 #ifndef THIRD_PARTY_NEARBY_INTERNAL_WEAVE_BASE_SOCKET_H_
 #define THIRD_PARTY_NEARBY_INTERNAL_WEAVE_BASE_SOCKET_H_
 
+#include <cstddef>
 #include <deque>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -79,6 +81,15 @@ class BaseSocket {
     kConnected
   };
 
+  // A packet passed to the connection whose transmit result hasn't arrived
+  // yet. Results arrive in the order the packets were transmitted.
+  struct InFlightPacket {
+    bool is_control = false;
+    // Set on the last packet of a message; the message's write status is set
+    // once this packet is transmitted.
+    std::optional<MessageWriteRequest> finished_message;
+  };
+
   bool IsRemotePacketCounterExpected(int counter);
   void TryWriteNextControl() ABSL_EXCLUSIVE_LOCKS_REQUIRED(executor_)
       ABSL_LOCKS_EXCLUDED(mutex_);
@@ -86,7 +97,9 @@ class BaseSocket {
       ABSL_LOCKS_EXCLUDED(mutex_);
   void OnWriteRequestWriteComplete(absl::Status status)
       ABSL_LOCKS_EXCLUDED(executor_);
-  void WritePacket(absl::StatusOr<Packet> packet);
+  // Returns true if |packet| was passed to the connection.
+  bool WritePacket(absl::StatusOr<Packet> packet)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   Mutex mutex_;
   // Messages and controls are in two separate queues to separate their control
@@ -96,10 +109,14 @@ class BaseSocket {
   std::deque<MessageWriteRequest> message_request_queue_
       ABSL_GUARDED_BY(mutex_);
   ControlPacketWriteRequest* current_control_ = nullptr;
+  // The message being packetized; always the front of the message queue. A
+  // message leaves the queue once its last packet is transmitted.
   MessageWriteRequest* current_message_ = nullptr;
+  std::deque<InFlightPacket> in_flight_packets_ ABSL_GUARDED_BY(mutex_);
   SocketConnectionState state_ ABSL_GUARDED_BY(mutex_) =
       SocketConnectionState::kDisconnected;
   int max_packet_size_;
+  size_t max_in_flight_packets_;
   Packetizer packetizer_;
   PacketSequenceNumberGenerator packet_counter_generator_;
   PacketSequenceNumberGenerator remote_packet_counter_generator_;
@@ -40,13 +40,15 @@ constexpr int kMaxPacketSize = 3;
 
 class FakeConnection : public Connection {
  public:
-  explicit FakeConnection(int max_packet_size)
-      : max_packet_size_(max_packet_size) {}
+  explicit FakeConnection(int max_packet_size, int max_in_flight_packets = 1)
+      : max_packet_size_(max_packet_size),
+        max_in_flight_packets_(max_in_flight_packets) {}
   void Initialize(ConnectionCallback callback) override {
     callback_ = std::move(callback);
   }
 
   int GetMaxPacketSize() const override { return max_packet_size_; }
+  int GetMaxInFlightPackets() const override { return max_in_flight_packets_; }
   void Transmit(std::string packet) override {
     absl::MutexLock lock(&mutex_);
     packets_written_.push_back(packet);
@@ -82,6 +84,7 @@ class FakeConnection : public Connection {
 
  protected:
   int max_packet_size_;
+  int max_in_flight_packets_;
   ConnectionCallback callback_;
   absl::Mutex mutex_;
   std::vector<std::string> packets_written_ ABSL_GUARDED_BY(mutex_);
@@ -359,6 +362,44 @@ TEST_F(BaseSocketTest, TestResetByControlPacket) {
   EXPECT_TRUE(connection_.NoMorePackets());
 }
 
+TEST(BaseSocketWindowTest, KeepsPacketsInFlightUpToWindow) {
+  FakeConnection connection(/*max_packet_size=*/20,
+                            /*max_in_flight_packets=*/3);
+  connection.SetInstantTransmit(false);
+  FakeSocket socket(connection, SocketCallback{
+                                    .on_connected_cb = []() {},
+                                    .on_disconnected_cb = []() {},
+                                    .on_receive_cb = [](std::string) {},
+                                    .on_error_cb = [](absl::Status) {},
+                                });
+  socket.OnConnectedProxy(kMaxPacketSize);
+  nearby::Future<absl::Status> first =
+      socket.Write(ByteArray("\x01\x02\x03\x04"));
+  nearby::Future<absl::Status> second = socket.Write(ByteArray("\x05\x06"));
+  // sleep for 10 ms to allow for packet population
+  absl::SleepFor(absl::Milliseconds(10));
+
+  // Both packets of the first message and the second message's only packet
+  // go out without waiting for a transmit result.
+  EXPECT_EQ(connection.PollWrittenPacket(),
+            CreateDataPacket(0, true, false, ByteArray("\x01\x02")).GetBytes());
+  EXPECT_EQ(connection.PollWrittenPacket(),
+            CreateDataPacket(1, false, true, ByteArray("\x03\x04")).GetBytes());
+  EXPECT_EQ(connection.PollWrittenPacket(),
+            CreateDataPacket(2, true, true, ByteArray("\x05\x06")).GetBytes());
+  EXPECT_TRUE(connection.NoMorePackets());
+
+  connection.OnTransmitProxy(absl::OkStatus());
+  absl::SleepFor(absl::Milliseconds(10));
+  EXPECT_FALSE(first.IsSet());
+  connection.OnTransmitProxy(absl::OkStatus());
+  absl::SleepFor(absl::Milliseconds(10));
+  EXPECT_OK(first.Get().GetResult());
+  EXPECT_FALSE(second.IsSet());
+  connection.OnTransmitProxy(absl::OkStatus());
+  EXPECT_OK(second.Get().GetResult());
+}
+
 TEST_F(BaseSocketTest, TestOnTransmitFailure) {
   connection_.SetInstantTransmit(false);
   socket_.OnConnectedProxy(kMaxPacketSize);
@@ -36,6 +36,11 @@ class Connection {
   virtual ~Connection() = default;
   virtual void Initialize(ConnectionCallback callback) = 0;
   virtual int GetMaxPacketSize() const = 0;
+  // The number of packets the socket may pass to Transmit() before the first
+  // of them is reported by on_transmit_cb. Transports that don't need a round
+  // trip per packet, such as GATT write-without-response, can return more
+  // than 1 to keep the link busy.
+  virtual int GetMaxInFlightPackets() const { return 1; }
   virtual void Transmit(std::string packet) = 0;
   virtual void Close() = 0;
 };
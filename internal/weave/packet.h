@@ -20,6 +20,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "internal/platform/byte_array.h"
 
 namespace nearby {
@@ -102,6 +103,8 @@ class Packet {
   }
   static Packet CreateDataPacket(bool is_first_packet, bool is_last_packet,
                                  ByteArray payload);
+  static Packet CreateDataPacket(bool is_first_packet, bool is_last_packet,
+                                 absl::string_view payload);
   static absl::StatusOr<Packet> CreateConnectionRequestPacket(
       int16_t min_protocol_version, int16_t max_protocol_version,
       int16_t max_packet_size, absl::string_view extra_data);
@@ -129,7 +132,8 @@ class Packet {
   int GetPacketCounter() const;
   ControlPacketType GetControlCommandNumber() const;
   std::string GetPayload() const { return bytes_.substr(kPacketHeaderLength); }
-  std::string GetBytes() const { return bytes_; }
+  std::string GetBytes() const& { return bytes_; }
+  std::string GetBytes() && { return std::move(bytes_); }
   absl::Status SetPacketCounter(int packetCounter);
   std::string ToString();
 
@@ -51,6 +51,22 @@ class AdvertisementDecoder {
   // misformatted or if it couldn't be decrypted.
   virtual absl::StatusOr<Advertisement> DecodeAdvertisement(
       absl::string_view advertisement) = 0;
+
+  // Decodes a batch of advertisements and returns one result per
+  // advertisement, in the same order. Decoding in batches lets callers move
+  // the work off latency-sensitive threads without paying a hand-off per
+  // advertisement. The default decodes them one by one, so a batch takes as
+  // long as decoding each advertisement on its own. A decoder must not be used
+  // from several threads at once, so parallel callers keep one per thread.
+  virtual std::vector<absl::StatusOr<Advertisement>> DecodeAdvertisements(
+      const std::vector<std::string>& advertisements) {
+    std::vector<absl::StatusOr<Advertisement>> results;
+    results.reserve(advertisements.size());
+    for (const std::string& advertisement : advertisements) {
+      results.push_back(DecodeAdvertisement(advertisement));
+    }
+    return results;
+  }
 };
 
 }  // namespace presence
@@ -173,24 +173,19 @@ void DecodeBaseAction(absl::string_view serialized_action,
 }
 
 absl::StatusOr<std::string> DecryptLdt(
-    const std::vector<internal::SharedCredential>& credentials,
+    std::vector<AdvertisementDecoderImpl::CredentialDecryptor>& decryptors,
     absl::string_view salt, absl::string_view encrypted_contents,
     Advertisement& decoded_advertisement) {
-  if (credentials.empty()) {
+  if (decryptors.empty()) {
     return absl::UnavailableError("No credentials");
   }
-  for (const auto& credential : credentials) {
-    absl::StatusOr<LdtEncryptor> encryptor = LdtEncryptor::Create(
-        credential.key_seed(), credential.metadata_encryption_key_tag_v0());
-    if (encryptor.ok()) {
-      absl::StatusOr<std::string> result =
-          encryptor->DecryptAndVerify(encrypted_contents, salt);
-      if (result.ok() && result->size() > kBaseMetadataSize) {
-        decoded_advertisement.public_credential = credential;
-        decoded_advertisement.metadata_key =
-            result->substr(0, kBaseMetadataSize);
-        return result->substr(kBaseMetadataSize);
-      }
+  for (auto& decryptor : decryptors) {
+    absl::StatusOr<std::string> result =
+        decryptor.decryptor.DecryptAndVerify(encrypted_contents, salt);
+    if (result.ok() && result->size() > kBaseMetadataSize) {
+      decoded_advertisement.public_credential = decryptor.credential;
+      decoded_advertisement.metadata_key = result->substr(0, kBaseMetadataSize);
+      return result->substr(kBaseMetadataSize);
     }
   }
   return absl::UnavailableError(
@@ -198,7 +193,7 @@ absl::StatusOr<std::string> DecryptLdt(
 }
 
 absl::Status DecryptDataElements(
-    const std::vector<internal::SharedCredential>& credentials,
+    std::vector<AdvertisementDecoderImpl::CredentialDecryptor>& decryptors,
     const DataElement& elem, Advertisement& decoded_advertisement) {
   if (elem.GetValue().size() <= kEncryptedIdentityAdditionalLength) {
     return absl::OutOfRangeError(absl::StrFormat(
@@ -210,7 +205,7 @@ absl::Status DecryptDataElements(
                                                    salt);
   absl::string_view encrypted = elem.GetValue().substr(kSaltSize);
   absl::StatusOr<std::string> decrypted =
-      DecryptLdt(credentials, salt, encrypted, decoded_advertisement);
+      DecryptLdt(decryptors, salt, encrypted, decoded_advertisement);
   if (!decrypted.ok()) {
     NEARBY_LOGS(WARNING) << "Failed to decrypt advertisement, status: "
                          << decrypted.status();
@@ -234,6 +229,31 @@ absl::Status DecryptDataElements(
   return absl::OkStatus();
 }
 
+AdvertisementDecoderImpl::AdvertisementDecoderImpl(
+    absl::flat_hash_map<nearby::internal::IdentityType,
+                        std::vector<internal::SharedCredential>>*
+        credentials_map)
+    : has_credentials_(credentials_map != nullptr) {
+  if (credentials_map == nullptr) return;
+  // Creating a decryptor derives keys and allocates handles in the LDT
+  // library, which is too costly to repeat for every advertisement seen.
+  for (const auto& [identity_type, credentials] : *credentials_map) {
+    std::vector<CredentialDecryptor>& decryptors = decryptors_[identity_type];
+    decryptors.reserve(credentials.size());
+    for (const auto& credential : credentials) {
+      absl::StatusOr<LdtEncryptor> decryptor = LdtEncryptor::Create(
+          credential.key_seed(), credential.metadata_encryption_key_tag_v0());
+      if (!decryptor.ok()) {
+        NEARBY_LOGS(WARNING) << "Skipping credential, status: "
+                             << decryptor.status();
+        continue;
+      }
+      decryptors.push_back(CredentialDecryptor{
+          .credential = credential, .decryptor = *std::move(decryptor)});
+    }
+  }
+}
+
 absl::StatusOr<Advertisement> AdvertisementDecoderImpl::DecodeAdvertisement(
     absl::string_view advertisement) {
   Advertisement decoded_advertisement = Advertisement{};
@@ -263,13 +283,12 @@ absl::StatusOr<Advertisement> AdvertisementDecoderImpl::DecodeAdvertisement(
       decoded_advertisement.identity_type = GetIdentityType(elem->GetType());
     }
     if (IsEncryptedIdentity(elem->GetType())) {
-      if (credentials_map_ == nullptr) {
+      if (!has_credentials_) {
         return absl::FailedPreconditionError("Missing credentials");
       }
-      auto identity_type_specific_creds =
-          (*credentials_map_)[decoded_advertisement.identity_type];
-      absl::Status status = DecryptDataElements(identity_type_specific_creds,
-                                                *elem, decoded_advertisement);
+      absl::Status status = DecryptDataElements(
+          decryptors_[decoded_advertisement.identity_type], *elem,
+          decoded_advertisement);
       if (!status.ok()) {
         return status;
       }
@@ -22,6 +22,7 @@
 #include "absl/strings/string_view.h"
 #include "internal/proto/credential.pb.h"
 #include "presence/implementation/advertisement_decoder.h"
+#include "presence/implementation/ldt.h"
 
 namespace nearby {
 namespace presence {
@@ -29,20 +30,28 @@ namespace presence {
 // Implements the C++ backed parsing and decrypting of advertisement bytes
 class AdvertisementDecoderImpl : public AdvertisementDecoder {
  public:
+  // A credential together with the LDT decryptor derived from its key seed.
+  struct CredentialDecryptor {
+    internal::SharedCredential credential;
+    LdtEncryptor decryptor;
+  };
+
   AdvertisementDecoderImpl() = default;
+  // Derives the LDT decryptors for all of `credentials_map` up front, so that
+  // decoding an encrypted advertisement only has to try them. The decoder
+  // does not see later changes to `credentials_map`; create a new one instead.
   explicit AdvertisementDecoderImpl(
       absl::flat_hash_map<nearby::internal::IdentityType,
                           std::vector<internal::SharedCredential>>*
-          credentials_map)
-      : credentials_map_(credentials_map) {}
+          credentials_map);
 
   absl::StatusOr<Advertisement> DecodeAdvertisement(
       absl::string_view advertisement) override;
 
  private:
-  absl::flat_hash_map<internal::IdentityType,
-                      std::vector<internal::SharedCredential>>*
-      credentials_map_ = nullptr;
+  bool has_credentials_ = false;
+  absl::flat_hash_map<internal::IdentityType, std::vector<CredentialDecryptor>>
+      decryptors_;
 };
 
 }  // namespace presence
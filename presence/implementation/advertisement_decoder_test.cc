@@ -162,6 +162,24 @@ TEST(AdvertisementDecoderImpl, DecodeBaseNpPrivateAdvertisement) {
                                       absl::HexStringToBytes("08"))));
 }
 
+TEST(AdvertisementDecoderImpl, DecodesRepeatedlyWithPrebuiltDecryptors) {
+  absl::flat_hash_map<IdentityType, std::vector<internal::SharedCredential>>
+      credentials;
+  credentials[IdentityType::IDENTITY_TYPE_PRIVATE_GROUP].push_back(
+      GetPublicCredential());
+  AdvertisementDecoderImpl decoder(&credentials);
+  // The decoder keeps its own decryptors; the map is no longer needed.
+  credentials.clear();
+
+  for (int i = 0; i < 3; ++i) {
+    absl::StatusOr<Advertisement> result =
+        decoder.DecodeAdvertisement(absl::HexStringToBytes(
+            "00514142b8412efb0bc657ba514baf4d1b50ddc842cd1c"));
+    ASSERT_OK(result);
+    EXPECT_EQ(result->identity_type, IdentityType::IDENTITY_TYPE_PRIVATE_GROUP);
+  }
+}
+
 TEST(AdvertisementDecoderImpl, InvalidEncryptedContent) {
   std::string salt = "AB";
   ByteArray metadata_key(
@@ -213,6 +231,22 @@ TEST(AdvertisementDecoderImpl, EmptyAdvertisement) {
               StatusIs(absl::StatusCode::kOutOfRange));
 }
 
+TEST(AdvertisementDecoderImpl, DecodeBatchKeepsOrder) {
+  AdvertisementDecoderImpl decoder;
+
+  std::vector<absl::StatusOr<Advertisement>> results =
+      decoder.DecodeAdvertisements(
+          {absl::HexStringToBytes("000A"), "",
+           absl::HexStringToBytes("002041420337C1C2C31BEE")});
+
+  ASSERT_EQ(results.size(), 3);
+  ASSERT_OK(results[0]);
+  EXPECT_THAT(results[0]->data_elements, ElementsAre(DataElement(0xA, "")));
+  EXPECT_THAT(results[1], StatusIs(absl::StatusCode::kOutOfRange));
+  ASSERT_OK(results[2]);
+  EXPECT_EQ(results[2]->identity_type, IdentityType::IDENTITY_TYPE_PUBLIC);
+}
+
 TEST(AdvertisementDecoderImpl, UnsupportedAdvertisementVersion) {
   AdvertisementDecoderImpl decoder;
 
@@ -16,8 +16,11 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,6 +28,7 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "internal/platform/count_down_latch.h"
 #include "internal/platform/future.h"
 #include "internal/platform/implementation/ble_v2.h"
 #include "internal/platform/implementation/credential_callbacks.h"
@@ -89,7 +93,7 @@ ScanSessionId ScanManager::StartScan(ScanRequest scan_request,
             {id, ScanSessionState{
                      .request = scan_request,
                      .callback = std::move(scan_callback),
-                     .decoder = AdvertisementDecoderImpl(),
+                     .decoders = CreateDecoders(nullptr),
                      .advertisement_filter = AdvertisementFilter(scan_request),
                      .scanning_session = mediums_->GetBle().StartScanning(
                          scan_request, std::move(callback))}});
@@ -121,29 +125,168 @@ void ScanManager::NotifyFoundBle(ScanSessionId id, BleAdvertisementData data,
     return;
   }
 
-  auto advertisement_data =
-      data.service_data[kPresenceServiceUuid].AsStringView();
+  EnqueueAdvertisement(PendingAdvertisement{
+      .id = id,
+      .remote_address = std::string(remote_address),
+      .decoders = it->second.decoders,
+      .advertisement =
+          std::string(data.service_data[kPresenceServiceUuid].AsStringView()),
+  });
+}
+
+void ScanManager::NotifyLostBle(ScanSessionId id,
+                                absl::string_view remote_address) {
+  EnqueueAdvertisement(
+      PendingAdvertisement{.id = id,
+                           .remote_address = std::string(remote_address),
+                           .decoders = nullptr,
+                           .advertisement = {}});
+}
 
-  auto advert = it->second.decoder.DecodeAdvertisement(advertisement_data);
-  if (!advert.ok()) {
-    // This advertisement is not relevant to the current element, skip.
+void ScanManager::EnqueueAdvertisement(PendingAdvertisement advertisement) {
+  MutexLock lock(&pending_mutex_);
+  // Only the latest event queued for a device matters, so the queue holds at
+  // most a lost event followed by a found event per device.
+  auto find_latest = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(pending_mutex_) {
+    return std::find_if(pending_advertisements_.rbegin(),
+                        pending_advertisements_.rend(),
+                        [&](const PendingAdvertisement& pending) {
+                          return pending.id == advertisement.id &&
+                                 pending.remote_address ==
+                                     advertisement.remote_address;
+                        });
+  };
+  bool is_lost = advertisement.decoders == nullptr;
+  auto latest = find_latest();
+  if (latest != pending_advertisements_.rend() && latest->decoders != nullptr) {
+    if (!is_lost) {
+      // A newer advertisement supersedes one that hasn't been decoded yet.
+      *latest = std::move(advertisement);
+      return;
+    }
+    // The device went away before its advertisement was decoded.
+    pending_advertisements_.erase(std::next(latest).base());
+    latest = find_latest();
+  }
+  if (latest != pending_advertisements_.rend()) {
+    // The device is already queued as lost.
+    if (is_lost) return;
+  } else if (!is_lost &&
+             pending_advertisements_.size() >= kMaxPendingAdvertisements) {
+    NEARBY_LOGS(WARNING) << "Dropping advertisement from "
+                         << advertisement.remote_address
+                         << "; the decode queue is full";
     return;
   }
+  pending_advertisements_.push_back(std::move(advertisement));
+  if (decode_scheduled_) return;
+  decode_scheduled_ = true;
+  decode_executor_.Execute("decode-advertisements",
+                           [this]() { DecodePendingAdvertisements(); });
+}
+
+void ScanManager::DecodePendingAdvertisements() {
+  std::vector<PendingAdvertisement> pending;
+  {
+    MutexLock lock(&pending_mutex_);
+    pending.swap(pending_advertisements_);
+    decode_scheduled_ = false;
+  }
 
-  if (it->second.advertisement_filter.MatchesScanFilter(*advert)) {
+  // Each worker decodes one slice of the queue, in batches of advertisements
+  // that share decoders. Worker `i` uses decoder `i` of every set, so no
+  // decoder is used by two workers at once.
+  std::vector<std::optional<absl::StatusOr<Advertisement>>> adverts(
+      pending.size());
+  size_t slice_size = (pending.size() + kDecodeWorkers - 1) / kDecodeWorkers;
+  int num_slices =
+      slice_size == 0 ? 0 : (pending.size() + slice_size - 1) / slice_size;
+  CountDownLatch slices_decoded(num_slices);
+  for (int worker = 0; worker < num_slices; ++worker) {
+    size_t slice_begin = worker * slice_size;
+    size_t slice_end = std::min(slice_begin + slice_size, pending.size());
+    decode_workers_.Execute("decode-advertisements", [&pending, &adverts,
+                                                      &slices_decoded, worker,
+                                                      slice_begin,
+                                                      slice_end]() {
+      size_t begin = slice_begin;
+      while (begin < slice_end) {
+        // Lost advertisements have nothing to decode.
+        if (pending[begin].decoders == nullptr) {
+          ++begin;
+          continue;
+        }
+        size_t end = begin;
+        std::vector<std::string> batch;
+        while (end < slice_end &&
+               pending[end].decoders == pending[begin].decoders) {
+          batch.push_back(std::move(pending[end].advertisement));
+          ++end;
+        }
+        std::vector<absl::StatusOr<Advertisement>> decoded =
+            (*pending[begin].decoders)[worker]->DecodeAdvertisements(batch);
+        for (size_t i = begin; i < end; ++i) {
+          adverts[i] = std::move(decoded[i - begin]);
+        }
+        begin = end;
+      }
+      slices_decoded.CountDown();
+    });
+  }
+  slices_decoded.Await();
+
+  std::vector<DecodedAdvertisement> results;
+  results.reserve(pending.size());
+  for (size_t i = 0; i < pending.size(); ++i) {
+    results.push_back(DecodedAdvertisement{
+        .id = pending[i].id,
+        .remote_address = std::move(pending[i].remote_address),
+        .advertisement = std::move(adverts[i])});
+  }
+
+  RunOnServiceControllerThread(
+      "deliver-decoded-ble",
+      [this, results = std::move(results)]()
+          ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_) mutable {
+            DeliverDecodedAdvertisements(std::move(results));
+          });
+}
+
+void ScanManager::DeliverDecodedAdvertisements(
+    std::vector<DecodedAdvertisement> results) {
+  for (const DecodedAdvertisement& result : results) {
+    if (!result.advertisement.has_value()) {
+      HandleLostAdvertisement(result.id, result.remote_address);
+    } else if (result.advertisement->ok()) {
+      HandleFoundAdvertisement(result.id, **result.advertisement,
+                               result.remote_address);
+    }
+    // Otherwise the advertisement is not relevant to this scan; skip it.
+  }
+}
+
+void ScanManager::HandleFoundAdvertisement(ScanSessionId id,
+                                           const Advertisement& advert,
+                                           absl::string_view remote_address) {
+  auto it = scan_sessions_.find(id);
+  if (it == scan_sessions_.end()) {
+    return;
+  }
+
+  if (it->second.advertisement_filter.MatchesScanFilter(advert)) {
     internal::DeviceIdentityMetaData device_identity_metadata;
     device_identity_metadata.set_bluetooth_mac_address(
         std::string(remote_address));
 
     if (!device_address_to_endpoint_id_map_.contains(remote_address)) {
       PresenceDevice device(DeviceMotion(), device_identity_metadata,
-                            advert->identity_type);
+                            advert.identity_type);
       // Ok if the advertisement is for trusted/private identity.
-      if (advert->public_credential.ok()) {
-        device.SetDecryptSharedCredential(*(advert->public_credential));
+      if (advert.public_credential.ok()) {
+        device.SetDecryptSharedCredential(*(advert.public_credential));
       }
-      device.AddExtendedProperties(advert->data_elements);
-      for (const auto& data_element : advert->data_elements) {
+      device.AddExtendedProperties(advert.data_elements);
+      for (const auto& data_element : advert.data_elements) {
         if (data_element.GetType() == DataElement::kActionFieldType) {
           device.AddAction(PresenceAction(static_cast<int>(
               static_cast<uint8_t>(data_element.GetValue()[0]))));
@@ -159,11 +302,11 @@ void ScanManager::NotifyFoundBle(ScanSessionId id, BleAdvertisementData data,
           device_address_to_endpoint_id_map_.at(remote_address));
       device.SetDeviceIdentityMetaData(device_identity_metadata);
       // Ok if the advertisement is for trusted/private identity.
-      if (advert->public_credential.ok()) {
-        device.SetDecryptSharedCredential(*(advert->public_credential));
+      if (advert.public_credential.ok()) {
+        device.SetDecryptSharedCredential(*(advert.public_credential));
       }
-      device.AddExtendedProperties(advert->data_elements);
-      for (const auto& data_element : advert->data_elements) {
+      device.AddExtendedProperties(advert.data_elements);
+      for (const auto& data_element : advert.data_elements) {
         if (data_element.GetType() == DataElement::kActionFieldType) {
           device.AddAction(PresenceAction(static_cast<int>(
               static_cast<uint8_t>(data_element.GetValue()[0]))));
@@ -175,8 +318,8 @@ void ScanManager::NotifyFoundBle(ScanSessionId id, BleAdvertisementData data,
   }
 }
 
-void ScanManager::NotifyLostBle(ScanSessionId id,
-                                absl::string_view remote_address) {
+void ScanManager::HandleLostAdvertisement(ScanSessionId id,
+                                          absl::string_view remote_address) {
   auto it = scan_sessions_.find(id);
   if (it == scan_sessions_.end()) {
     return;
@@ -266,7 +409,23 @@ void ScanManager::UpdateCredentials(ScanSessionId id,
 
   ScanSessionState& session = it->second;
   session.credentials[identity_type] = std::move(credentials);
-  session.decoder = AdvertisementDecoderImpl(&session.credentials);
+  // The decoders prepare their decryptors here, once per credential update,
+  // rather than for every advertisement they decode.
+  session.decoders = CreateDecoders(&session.credentials);
+}
+
+std::shared_ptr<ScanManager::Decoders> ScanManager::CreateDecoders(
+    absl::flat_hash_map<IdentityType, std::vector<SharedCredential>>*
+        credentials) {
+  auto decoders = std::make_shared<Decoders>();
+  decoders->reserve(kDecodeWorkers);
+  for (int i = 0; i < kDecodeWorkers; ++i) {
+    decoders->push_back(
+        credentials == nullptr
+            ? std::make_unique<AdvertisementDecoderImpl>()
+            : std::make_unique<AdvertisementDecoderImpl>(credentials));
+  }
+  return decoders;
 }
 
 int ScanManager::ScanningCallbacksLengthForTest() {
@@ -278,5 +437,11 @@ int ScanManager::ScanningCallbacksLengthForTest() {
   return count.Get().GetResult();
 }
 
+void ScanManager::WaitForDecodingForTest() {
+  ::nearby::Future<bool> done;
+  decode_executor_.Execute("wait-for-decoding", [&]() { done.Set(true); });
+  done.Get();
+}
+
 }  // namespace presence
 }  // namespace nearby
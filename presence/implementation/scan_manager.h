@@ -15,21 +15,26 @@
 #ifndef THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_SCAN_MANAGER_H_
 #define THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_SCAN_MANAGER_H_
 
+#include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "internal/platform/implementation/ble_v2.h"
+#include "internal/platform/multi_thread_executor.h"
 #include "internal/platform/mutex.h"
 #include "internal/platform/mutex_lock.h"
 #include "internal/platform/runnable.h"
 #include "internal/platform/single_thread_executor.h"
 #include "internal/proto/credential.pb.h"
 #include "presence/data_types.h"
+#include "presence/implementation/advertisement_decoder.h"
 #include "presence/implementation/advertisement_filter.h"
 #include "presence/implementation/credential_manager.h"
 #include "presence/implementation/mediums/mediums.h"
@@ -70,27 +75,75 @@ class ScanManager {
   // Below functions are test only.
   // Reference: go/totw/135#augmenting-the-public-api-for-tests
   int ScanningCallbacksLengthForTest();
+  // Returns once the advertisements queued so far are decoded and their
+  // delivery is queued on the service controller thread.
+  void WaitForDecodingForTest();
 
  private:
+  // Number of threads that decode advertisements in parallel.
+  static constexpr int kDecodeWorkers = 4;
+  // One decoder per decode worker, all built from the same credentials. The
+  // LDT decryptors of a decoder are not safe for concurrent use, so worker `i`
+  // only ever uses decoder `i`.
+  using Decoders = std::vector<std::unique_ptr<AdvertisementDecoderImpl>>;
   struct ScanSessionState {
     ScanRequest request;
     ScanCallback callback;
     absl::flat_hash_map<IdentityType, std::vector<SharedCredential>>
         credentials;
-    AdvertisementDecoderImpl decoder;
+    // Shared with the decode threads, which may still be using the previous
+    // decoders after the credentials change.
+    std::shared_ptr<Decoders> decoders;
     AdvertisementFilter advertisement_filter;
     std::unique_ptr<ScanningSession> scanning_session;
   };
+  // A found or lost advertisement waiting for the decode thread. Lost events
+  // go through the same queue so that they are never reported ahead of an
+  // earlier found event for the same device.
+  struct PendingAdvertisement {
+    ScanSessionId id;
+    std::string remote_address;
+    // Null for a lost advertisement.
+    std::shared_ptr<Decoders> decoders;
+    std::string advertisement;
+  };
+  // The outcome of a pending advertisement, delivered on the service
+  // controller thread.
+  struct DecodedAdvertisement {
+    ScanSessionId id;
+    std::string remote_address;
+    // std::nullopt for a lost advertisement.
+    std::optional<absl::StatusOr<Advertisement>> advertisement;
+  };
   void NotifyFoundBle(ScanSessionId id, BleAdvertisementData data,
                       absl::string_view remote_address)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
   void NotifyLostBle(ScanSessionId id, absl::string_view remote_address)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
+  // Queues `advertisement` for the decode thread, folding it into an event
+  // already queued for the same device where that doesn't change the outcome.
+  void EnqueueAdvertisement(PendingAdvertisement advertisement)
+      ABSL_LOCKS_EXCLUDED(pending_mutex_);
+  // Runs on the decode thread. Decodes everything queued so far, split across
+  // the decode workers, and hands the results back to the service controller
+  // thread in order.
+  void DecodePendingAdvertisements() ABSL_LOCKS_EXCLUDED(pending_mutex_);
+  void DeliverDecodedAdvertisements(std::vector<DecodedAdvertisement> results)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
+  void HandleFoundAdvertisement(ScanSessionId id, const Advertisement& advert,
+                                absl::string_view remote_address)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
+  void HandleLostAdvertisement(ScanSessionId id,
+                               absl::string_view remote_address)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
   void FetchCredentials(ScanSessionId id, const ScanRequest& scan_request)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
   void UpdateCredentials(ScanSessionId id, IdentityType identity_type,
                          std::vector<SharedCredential> credentials)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
+  static std::shared_ptr<Decoders> CreateDecoders(
+      absl::flat_hash_map<IdentityType, std::vector<SharedCredential>>*
+          credentials);
   void RunOnServiceControllerThread(absl::string_view name, Runnable runnable) {
     executor_->Execute(std::string(name), std::move(runnable));
   }
@@ -102,6 +155,19 @@ class ScanManager {
       device_address_to_endpoint_id_map_
       ABSL_GUARDED_BY(*executor_);
   SingleThreadExecutor* executor_;
+  // Found advertisements for new devices are dropped once this many events
+  // are waiting; the device advertises again and is picked up later.
+  static constexpr size_t kMaxPendingAdvertisements = 256;
+  Mutex pending_mutex_;
+  std::vector<PendingAdvertisement> pending_advertisements_
+      ABSL_GUARDED_BY(pending_mutex_);
+  bool decode_scheduled_ ABSL_GUARDED_BY(pending_mutex_) = false;
+  // Trial decryption of advertisements runs here rather than on the service
+  // controller thread, so a crowded scan doesn't hold up other Presence work.
+  MultiThreadExecutor decode_workers_{kDecodeWorkers};
+  // Drains the queue and waits for |decode_workers_|. Declared last so that it
+  // finishes before the rest of the manager goes.
+  SingleThreadExecutor decode_executor_;
 };
 
 }  // namespace presence
@@ -32,6 +32,8 @@
 #include "internal/platform/implementation/credential_callbacks.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/medium_environment.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/mutex_lock.h"
 #include "internal/platform/single_thread_executor.h"
 #include "internal/proto/credential.proto.h"
 #include "presence/data_element.h"
@@ -57,6 +59,7 @@ using ::nearby::SingleThreadExecutor;
 
 using CountDownLatch = ::nearby::CountDownLatch;
 using ::testing::Contains;
+using ::testing::ElementsAre;
 
 class ScanManagerTest : public testing::Test {
  protected:
@@ -279,6 +282,87 @@ TEST_F(ScanManagerTest, DiscoverThenLoseAdvertisement) {
   EXPECT_EQ(manager.ScanningCallbacksLengthForTest(), 0);
 }
 
+// Advertisements found while the service controller thread is busy are
+// decoded on their own thread and delivered once it frees up.
+TEST_F(ScanManagerTest, DeliversAdvertisementsQueuedWhileControllerBusy) {
+  Mediums mediums;
+  ScanManager manager(mediums, credential_manager_, executor_);
+  CountDownLatch found_latch{2};
+  ScanCallback callback = MakeDefaultScanCallback();
+  callback.on_discovered_cb = [&found_latch](PresenceDevice pd) {
+    found_latch.CountDown();
+  };
+  ScanSessionId scan_session =
+      manager.StartScan(MakeDefaultScanRequest(), std::move(callback));
+  EXPECT_TRUE(start_latch_.Await().Ok());
+
+  CountDownLatch release_latch{1};
+  executor_.Execute([&release_latch]() { release_latch.Await(); });
+  nearby::BluetoothAdapter server_adapter1;
+  Ble ble1(server_adapter1);
+  std::unique_ptr<AdvertisingSession> advertising_session1 =
+      StartAdvertisingOn(ble1);
+  nearby::BluetoothAdapter server_adapter2;
+  Ble ble2(server_adapter2);
+  std::unique_ptr<AdvertisingSession> advertising_session2 =
+      StartAdvertisingOn(ble2);
+  release_latch.CountDown();
+
+  EXPECT_TRUE(found_latch.Await().Ok());
+  manager.StopScan(scan_session);
+  EXPECT_EQ(manager.ScanningCallbacksLengthForTest(), 0);
+}
+
+// A device found and then lost while the service controller thread is busy is
+// reported as found and then lost once it frees up.
+TEST_F(ScanManagerTest, LostWhileControllerBusyIsNotReportedBeforeFound) {
+  Mediums mediums;
+  ScanManager manager(mediums, credential_manager_, executor_);
+  Mutex events_mutex;
+  std::vector<std::string> events;
+  ScanCallback callback = MakeDefaultScanCallback();
+  callback.on_discovered_cb = [&](PresenceDevice pd) {
+    MutexLock lock(&events_mutex);
+    events.push_back("found");
+    found_latch_.CountDown();
+  };
+  callback.on_lost_cb = [&](PresenceDevice pd) {
+    MutexLock lock(&events_mutex);
+    events.push_back("lost");
+    lost_latch_.CountDown();
+  };
+  ScanSessionId scan_session =
+      manager.StartScan(MakeDefaultScanRequest(), std::move(callback));
+  EXPECT_TRUE(start_latch_.Await().Ok());
+
+  CountDownLatch release_latch{1};
+  executor_.Execute([&release_latch]() { release_latch.Await(); });
+  nearby::BluetoothAdapter server_adapter;
+  Ble ble2(server_adapter);
+  std::unique_ptr<AdvertisingSession> advertising_session =
+      StartAdvertisingOn(ble2);
+  // Let the advertisement be decoded before the device is lost, so that the
+  // lost event can't replace it in the decode queue.
+  manager.WaitForDecodingForTest();
+  EXPECT_OK(advertising_session->stop_advertising());
+  env_.Sync();
+  manager.WaitForDecodingForTest();
+  {
+    MutexLock lock(&events_mutex);
+    EXPECT_TRUE(events.empty());
+  }
+  release_latch.CountDown();
+
+  EXPECT_TRUE(found_latch_.Await().Ok());
+  EXPECT_TRUE(lost_latch_.Await().Ok());
+  {
+    MutexLock lock(&events_mutex);
+    EXPECT_THAT(events, ElementsAre("found", "lost"));
+  }
+  manager.StopScan(scan_session);
+  EXPECT_EQ(manager.ScanningCallbacksLengthForTest(), 0);
+}
+
 TEST_F(ScanManagerTest, StopOneSessionFromAnotherDeadlock) {
   Mediums mediums;
   ScanManager manager(mediums, credential_manager_, executor_);
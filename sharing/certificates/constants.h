@@ -111,6 +111,14 @@ constexpr size_t kNearbyShareCertificateStorageMaxNumInitializeAttempts = 3;
 constexpr absl::Duration kNearbySharePublicCertificateDownloadPeriod =
     absl::Hours(12);
 
+// The maximum number of advertised metadata keys whose decryption result,
+// including a failure to match any public certificate, is remembered.
+constexpr size_t kNearbyShareDecryptedCertificateCacheSize = 64;
+
+// How long the decryption result of an advertised metadata key is remembered.
+constexpr absl::Duration kNearbyShareDecryptedCertificateCacheLifetime =
+    absl::Minutes(5);
+
 }  // namespace sharing
 }  // namespace nearby
 
@@ -34,6 +34,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -43,6 +44,7 @@
 #include "sharing/certificates/nearby_share_certificate_manager.h"
 #include "sharing/certificates/nearby_share_certificate_storage.h"
 #include "sharing/certificates/nearby_share_certificate_storage_impl.h"
+#include "sharing/certificates/nearby_share_decrypted_certificate_cache.h"
 #include "sharing/certificates/nearby_share_decrypted_public_certificate.h"
 #include "sharing/certificates/nearby_share_encrypted_metadata_key.h"
 #include "sharing/certificates/nearby_share_private_certificate.h"
@@ -132,18 +134,11 @@ std::optional<EncryptedMetadata> BuildMetadata(
   return metadata;
 }
 
-void TryDecryptPublicCertificates(
+std::optional<NearbyShareDecryptedPublicCertificate>
+TryDecryptPublicCertificates(
     const NearbyShareEncryptedMetadataKey& encrypted_metadata_key,
-    NearbyShareCertificateManager::CertDecryptedCallback callback, bool success,
-    std::unique_ptr<std::vector<PublicCertificate>> public_certificates) {
-  if (!success || !public_certificates) {
-    NL_LOG(ERROR) << __func__
-                  << ": Failed to read public certificates from storage.";
-    std::move(callback)(std::nullopt);
-    return;
-  }
-
-  for (const auto& cert : *public_certificates) {
+    const std::vector<PublicCertificate>& public_certificates) {
+  for (const auto& cert : public_certificates) {
     std::optional<NearbyShareDecryptedPublicCertificate> decrypted =
         NearbyShareDecryptedPublicCertificate::DecryptPublicCertificate(
             cert, encrypted_metadata_key);
@@ -151,13 +146,12 @@ void TryDecryptPublicCertificates(
       NL_VLOG(1) << __func__
                  << ": Successfully decrypted public certificate with ID "
                  << nearby::utils::HexEncode(decrypted->id());
-      std::move(callback)(std::move(decrypted));
-      return;
+      return decrypted;
     }
   }
   NL_VLOG(1) << __func__
              << ": Metadata key could not decrypt any public certificates.";
-  std::move(callback)(std::nullopt);
+  return std::nullopt;
 }
 
 void DumpCertificateId(std::stringstream& sstream, absl::string_view cert_id,
@@ -272,7 +266,10 @@ NearbyShareCertificateManagerImpl::NearbyShareCertificateManagerImpl(
                     << ": Download public certificates scheduler is called.";
                 DownloadPublicCertificates();
               })),
-      executor_(context->CreateSequencedTaskRunner()) {
+      executor_(context->CreateSequencedTaskRunner()),
+      decrypted_certificate_cache_(
+          context->GetClock(), kNearbyShareDecryptedCertificateCacheSize,
+          kNearbyShareDecryptedCertificateCacheLifetime) {
   local_device_data_manager_->AddObserver(this);
   contact_manager_->AddObserver(this);
 }
@@ -330,6 +327,7 @@ void NearbyShareCertificateManagerImpl::OnPublicCertificatesDownloadSuccess(
         notification.Notify();
       });
   notification.WaitForNotification();
+  InvalidatePublicCertificates();
   if (!is_added_to_store) {
     NL_LOG(ERROR) << __func__ << ": Failed to add certificates to store.";
     OnPublicCertificatesDownloadFailure();
@@ -437,20 +435,82 @@ NearbyShareCertificateManagerImpl::GetPrivateCertificatesAsPublicCertificates(
 void NearbyShareCertificateManagerImpl::GetDecryptedPublicCertificate(
     NearbyShareEncryptedMetadataKey encrypted_metadata_key,
     CertDecryptedCallback callback) {
+  std::optional<NearbyShareDecryptedCertificateCache::Result> cached =
+      decrypted_certificate_cache_.Get(encrypted_metadata_key);
+  if (cached.has_value()) {
+    std::move(callback)(*std::move(cached));
+    return;
+  }
+
+  std::shared_ptr<const std::vector<PublicCertificate>> public_certificates;
+  int64_t generation;
+  {
+    absl::MutexLock lock(&public_certificates_mutex_);
+    public_certificates = public_certificates_;
+    generation = public_certificates_generation_;
+  }
+  if (public_certificates) {
+    std::move(callback)(DecryptAndCachePublicCertificate(
+        encrypted_metadata_key, *public_certificates, generation));
+    return;
+  }
+
   certificate_storage_->GetPublicCertificates(
-      [encrypted_metadata_key = std::move(encrypted_metadata_key),
+      [this, generation,
+       encrypted_metadata_key = std::move(encrypted_metadata_key),
        callback = std::move(callback)](
           bool success,
-          std::unique_ptr<std::vector<PublicCertificate>> result) {
-        TryDecryptPublicCertificates(encrypted_metadata_key,
-                                     std::move(callback), success,
-                                     std::move(result));
+          std::unique_ptr<std::vector<PublicCertificate>> result) mutable {
+        if (!success || !result) {
+          NL_LOG(ERROR) << __func__
+                        << ": Failed to read public certificates from storage.";
+          std::move(callback)(std::nullopt);
+          return;
+        }
+        std::shared_ptr<const std::vector<PublicCertificate>> loaded =
+            std::move(result);
+        {
+          absl::MutexLock lock(&public_certificates_mutex_);
+          // Don't cache a snapshot that was read before the last change.
+          if (generation == public_certificates_generation_) {
+            public_certificates_ = loaded;
+          }
+        }
+        std::move(callback)(DecryptAndCachePublicCertificate(
+            encrypted_metadata_key, *loaded, generation));
       });
 }
 
+std::optional<NearbyShareDecryptedPublicCertificate>
+NearbyShareCertificateManagerImpl::DecryptAndCachePublicCertificate(
+    const NearbyShareEncryptedMetadataKey& encrypted_metadata_key,
+    const std::vector<PublicCertificate>& public_certificates,
+    int64_t generation) {
+  std::optional<NearbyShareDecryptedPublicCertificate> decrypted =
+      TryDecryptPublicCertificates(encrypted_metadata_key,
+                                   public_certificates);
+  absl::MutexLock lock(&public_certificates_mutex_);
+  if (generation == public_certificates_generation_) {
+    decrypted_certificate_cache_.Put(encrypted_metadata_key, decrypted);
+  }
+  return decrypted;
+}
+
 void NearbyShareCertificateManagerImpl::ClearPublicCertificates(
     std::function<void(bool)> callback) {
-  certificate_storage_->ClearPublicCertificates(std::move(callback));
+  InvalidatePublicCertificates();
+  certificate_storage_->ClearPublicCertificates(
+      [this, callback = std::move(callback)](bool success) {
+        InvalidatePublicCertificates();
+        callback(success);
+      });
+}
+
+void NearbyShareCertificateManagerImpl::InvalidatePublicCertificates() {
+  absl::MutexLock lock(&public_certificates_mutex_);
+  public_certificates_.reset();
+  ++public_certificates_generation_;
+  decrypted_certificate_cache_.Clear();
 }
 
 void NearbyShareCertificateManagerImpl::OnStart() {
@@ -553,6 +613,10 @@ std::string NearbyShareCertificateManagerImpl::Dump() const {
   for (const auto& id : ids) {
     DumpCertificateId(sstream, id, true);
   }
+  sstream << "  Decryption cache hits:"
+          << decrypted_certificate_cache_.hit_count()
+          << " misses:" << decrypted_certificate_cache_.miss_count()
+          << std::endl;
   sstream << std::endl;
 
   sstream << "Private Certificates" << std::endl;
@@ -704,6 +768,7 @@ void NearbyShareCertificateManagerImpl::OnPublicCertificateExpiration() {
           notification.Notify();
         });
     notification.WaitForNotification();
+    InvalidatePublicCertificates();
     if (!result) {
       NL_LOG(ERROR) << __func__
                     << ": Failed to remove expired public certificates.";
@@ -24,13 +24,17 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "internal/platform/implementation/account_manager.h"
 #include "internal/platform/task_runner.h"
 #include "sharing/certificates/nearby_share_certificate_manager.h"
 #include "sharing/certificates/nearby_share_certificate_storage.h"
+#include "sharing/certificates/nearby_share_decrypted_certificate_cache.h"
+#include "sharing/certificates/nearby_share_decrypted_public_certificate.h"
 #include "sharing/certificates/nearby_share_encrypted_metadata_key.h"
 #include "sharing/certificates/nearby_share_private_certificate.h"
 #include "sharing/contacts/nearby_share_contact_manager.h"
@@ -194,6 +198,20 @@ class NearbyShareCertificateManagerImpl
           certificates);
   void OnPublicCertificatesDownloadFailure();
 
+  // Drops the in-memory copy of the public certificates and the cached
+  // decryption results after the stored set changed. The next lookup reloads
+  // the certificates from storage.
+  void InvalidatePublicCertificates();
+
+  // Tries |encrypted_metadata_key| against |public_certificates| and caches
+  // the result, unless the certificates changed since |generation|.
+  std::optional<NearbyShareDecryptedPublicCertificate>
+  DecryptAndCachePublicCertificate(
+      const NearbyShareEncryptedMetadataKey& encrypted_metadata_key,
+      const std::vector<nearby::sharing::proto::PublicCertificate>&
+          public_certificates,
+      int64_t generation);
+
   Context* const context_;
   AccountManager& account_manager_;
   NearbyShareLocalDeviceDataManager* const local_device_data_manager_;
@@ -210,6 +228,20 @@ class NearbyShareCertificateManagerImpl
   std::unique_ptr<NearbyShareScheduler> download_public_certificates_scheduler_;
 
   std::unique_ptr<TaskRunner> executor_;
+
+  // Public certificates as last read from storage. Resolving an advertisement
+  // tries every certificate, so this saves reloading and reparsing the whole
+  // database for each advertisement seen during discovery.
+  absl::Mutex public_certificates_mutex_;
+  std::shared_ptr<const std::vector<nearby::sharing::proto::PublicCertificate>>
+      public_certificates_ ABSL_GUARDED_BY(public_certificates_mutex_);
+  // Bumped on every invalidation, so that a load which raced with a change is
+  // not cached.
+  int64_t public_certificates_generation_
+      ABSL_GUARDED_BY(public_certificates_mutex_) = 0;
+  // Results of recent lookups, so that a device rebroadcasting the same
+  // metadata key during a scan is resolved without decrypting again.
+  NearbyShareDecryptedCertificateCache decrypted_certificate_cache_;
 };
 
 }  // namespace sharing
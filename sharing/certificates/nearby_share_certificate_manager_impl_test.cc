@@ -665,6 +665,59 @@ TEST_F(NearbyShareCertificateManagerImplTest,
   EXPECT_FALSE(decrypted_pub_cert);
 }
 
+TEST_F(NearbyShareCertificateManagerImplTest,
+       GetDecryptedPublicCertificateReusesLoadedCertificates) {
+  std::optional<NearbyShareDecryptedPublicCertificate> decrypted_pub_cert;
+  auto capture =
+      [&](std::optional<NearbyShareDecryptedPublicCertificate> cert) {
+        CaptureDecryptedPublicCertificateCallback(&decrypted_pub_cert, cert);
+      };
+  cert_manager_->GetDecryptedPublicCertificate(metadata_encryption_keys_[0],
+                                               capture);
+  GetPublicCertificatesCallback(true, public_certificates_);
+  ASSERT_TRUE(decrypted_pub_cert);
+
+  // The second lookup is answered without reading storage again.
+  decrypted_pub_cert.reset();
+  cert_manager_->GetDecryptedPublicCertificate(metadata_encryption_keys_[1],
+                                               capture);
+  EXPECT_TRUE(cert_store_->get_public_certificates_callbacks().empty());
+  ASSERT_TRUE(decrypted_pub_cert);
+  std::vector<uint8_t> id(public_certificates_[1].secret_id().begin(),
+                          public_certificates_[1].secret_id().end());
+  EXPECT_EQ(decrypted_pub_cert->id(), id);
+
+  // Clearing the store drops the loaded copy.
+  cert_manager_->ClearPublicCertificates([](bool result) {});
+  decrypted_pub_cert.reset();
+  cert_manager_->GetDecryptedPublicCertificate(metadata_encryption_keys_[0],
+                                               capture);
+  GetPublicCertificatesCallback(true, {});
+  EXPECT_FALSE(decrypted_pub_cert);
+}
+
+TEST_F(NearbyShareCertificateManagerImplTest,
+       GetDecryptedPublicCertificateCachesNoMatch) {
+  auto private_cert = NearbySharePrivateCertificate(
+      DeviceVisibility::DEVICE_VISIBILITY_ALL_CONTACTS, t0,
+      GetNearbyShareTestMetadata());
+  auto metadata_key = private_cert.EncryptMetadataKey();
+  ASSERT_TRUE(metadata_key);
+  std::optional<NearbyShareDecryptedPublicCertificate> decrypted_pub_cert;
+  auto capture =
+      [&](std::optional<NearbyShareDecryptedPublicCertificate> cert) {
+        CaptureDecryptedPublicCertificateCallback(&decrypted_pub_cert, cert);
+      };
+
+  cert_manager_->GetDecryptedPublicCertificate(*metadata_key, capture);
+  GetPublicCertificatesCallback(true, public_certificates_);
+  cert_manager_->GetDecryptedPublicCertificate(*metadata_key, capture);
+
+  EXPECT_FALSE(decrypted_pub_cert);
+  EXPECT_THAT(cert_manager_->Dump(),
+              ::testing::HasSubstr("Decryption cache hits:1 misses:1"));
+}
+
 TEST_F(NearbyShareCertificateManagerImplTest,
        DownloadPublicCertificatesSuccess) {
   ASSERT_NO_FATAL_FAILURE(DownloadPublicCertificatesFlow(
@@ -0,0 +1,102 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sharing/certificates/nearby_share_decrypted_certificate_cache.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "internal/platform/clock.h"
+#include "sharing/certificates/nearby_share_encrypted_metadata_key.h"
+
+namespace nearby {
+namespace sharing {
+
+NearbyShareDecryptedCertificateCache::NearbyShareDecryptedCertificateCache(
+    Clock* clock, size_t max_entries, absl::Duration lifetime)
+    : clock_(clock), max_entries_(max_entries), lifetime_(lifetime) {}
+
+std::optional<NearbyShareDecryptedCertificateCache::Result>
+NearbyShareDecryptedCertificateCache::Get(
+    const NearbyShareEncryptedMetadataKey& encrypted_metadata_key) {
+  absl::MutexLock lock(&mutex_);
+  auto it = index_.find(MakeKey(encrypted_metadata_key));
+  if (it == index_.end()) {
+    ++miss_count_;
+    return std::nullopt;
+  }
+  if (clock_->Now() >= it->second->expires_at) {
+    entries_.erase(it->second);
+    index_.erase(it);
+    ++miss_count_;
+    return std::nullopt;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  ++hit_count_;
+  return it->second->result;
+}
+
+void NearbyShareDecryptedCertificateCache::Put(
+    const NearbyShareEncryptedMetadataKey& encrypted_metadata_key,
+    Result result) {
+  if (max_entries_ == 0) return;
+  std::string key = MakeKey(encrypted_metadata_key);
+  absl::MutexLock lock(&mutex_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    entries_.erase(it->second);
+    index_.erase(it);
+  } else if (entries_.size() >= max_entries_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+  entries_.push_front(
+      Entry{key, std::move(result), clock_->Now() + lifetime_});
+  index_[std::move(key)] = entries_.begin();
+}
+
+void NearbyShareDecryptedCertificateCache::Clear() {
+  absl::MutexLock lock(&mutex_);
+  entries_.clear();
+  index_.clear();
+}
+
+int64_t NearbyShareDecryptedCertificateCache::hit_count() const {
+  absl::MutexLock lock(&mutex_);
+  return hit_count_;
+}
+
+int64_t NearbyShareDecryptedCertificateCache::miss_count() const {
+  absl::MutexLock lock(&mutex_);
+  return miss_count_;
+}
+
+// static
+std::string NearbyShareDecryptedCertificateCache::MakeKey(
+    const NearbyShareEncryptedMetadataKey& encrypted_metadata_key) {
+  std::string key(encrypted_metadata_key.salt().begin(),
+                  encrypted_metadata_key.salt().end());
+  key.append(encrypted_metadata_key.encrypted_key().begin(),
+             encrypted_metadata_key.encrypted_key().end());
+  return key;
+}
+
+}  // namespace sharing
+}  // namespace nearby
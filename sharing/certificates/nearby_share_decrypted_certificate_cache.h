@@ -0,0 +1,93 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_SHARING_CERTIFICATES_NEARBY_SHARE_DECRYPTED_CERTIFICATE_CACHE_H_
+#define THIRD_PARTY_NEARBY_SHARING_CERTIFICATES_NEARBY_SHARE_DECRYPTED_CERTIFICATE_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <optional>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "internal/platform/clock.h"
+#include "sharing/certificates/nearby_share_decrypted_public_certificate.h"
+#include "sharing/certificates/nearby_share_encrypted_metadata_key.h"
+
+namespace nearby {
+namespace sharing {
+
+// Remembers the outcome of resolving an advertised encrypted metadata key
+// against the stored public certificates, so that a nearby device
+// rebroadcasting the same key does not cost a full decryption pass each time.
+// Both matches and misses are kept. Entries expire after |lifetime| and the
+// least recently used entry is evicted once |max_entries| is reached. The
+// owner must call Clear() whenever the stored public certificates change.
+//
+// This class is thread-safe.
+class NearbyShareDecryptedCertificateCache {
+ public:
+  // The result of a lookup. A cached miss is an entry with no certificate.
+  using Result = std::optional<NearbyShareDecryptedPublicCertificate>;
+
+  NearbyShareDecryptedCertificateCache(Clock* clock, size_t max_entries,
+                                       absl::Duration lifetime);
+
+  // Returns the cached result for |encrypted_metadata_key|, or std::nullopt
+  // if there is no live entry for it.
+  std::optional<Result> Get(
+      const NearbyShareEncryptedMetadataKey& encrypted_metadata_key)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  void Put(const NearbyShareEncryptedMetadataKey& encrypted_metadata_key,
+           Result result) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Drops all entries. Hit and miss counts are kept.
+  void Clear() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  int64_t hit_count() const ABSL_LOCKS_EXCLUDED(mutex_);
+  int64_t miss_count() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    std::string key;
+    Result result;
+    absl::Time expires_at;
+  };
+
+  static std::string MakeKey(
+      const NearbyShareEncryptedMetadataKey& encrypted_metadata_key);
+
+  Clock* const clock_;
+  const size_t max_entries_;
+  const absl::Duration lifetime_;
+
+  mutable absl::Mutex mutex_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, std::list<Entry>::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t hit_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t miss_count_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace sharing
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_SHARING_CERTIFICATES_NEARBY_SHARE_DECRYPTED_CERTIFICATE_CACHE_H_
@@ -0,0 +1,112 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sharing/certificates/nearby_share_decrypted_certificate_cache.h"
+
+#include <stdint.h>
+
+#include <optional>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+#include "internal/test/fake_clock.h"
+#include "sharing/certificates/nearby_share_encrypted_metadata_key.h"
+#include "sharing/certificates/test_util.h"
+
+namespace nearby {
+namespace sharing {
+namespace {
+
+constexpr absl::Duration kLifetime = absl::Minutes(5);
+
+NearbyShareEncryptedMetadataKey MakeKey(uint8_t value) {
+  return NearbyShareEncryptedMetadataKey(
+      /*salt=*/{0x00, 0x01}, /*encrypted_key=*/std::vector<uint8_t>(14, value));
+}
+
+TEST(NearbyShareDecryptedCertificateCacheTest, ReturnsCachedMatch) {
+  FakeClock clock;
+  NearbyShareDecryptedCertificateCache cache(&clock, /*max_entries=*/4,
+                                             kLifetime);
+  cache.Put(MakeKey(1), GetNearbyShareTestDecryptedPublicCertificate());
+
+  std::optional<NearbyShareDecryptedCertificateCache::Result> result =
+      cache.Get(MakeKey(1));
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result->has_value());
+  EXPECT_EQ((*result)->id(),
+            GetNearbyShareTestDecryptedPublicCertificate().id());
+  EXPECT_EQ(cache.hit_count(), 1);
+  EXPECT_EQ(cache.miss_count(), 0);
+}
+
+TEST(NearbyShareDecryptedCertificateCacheTest, ReturnsCachedNoMatch) {
+  FakeClock clock;
+  NearbyShareDecryptedCertificateCache cache(&clock, /*max_entries=*/4,
+                                             kLifetime);
+  EXPECT_FALSE(cache.Get(MakeKey(1)).has_value());
+  cache.Put(MakeKey(1), std::nullopt);
+
+  std::optional<NearbyShareDecryptedCertificateCache::Result> result =
+      cache.Get(MakeKey(1));
+  ASSERT_TRUE(result.has_value());
+  EXPECT_FALSE(result->has_value());
+  EXPECT_EQ(cache.hit_count(), 1);
+  EXPECT_EQ(cache.miss_count(), 1);
+}
+
+TEST(NearbyShareDecryptedCertificateCacheTest, EntriesExpire) {
+  FakeClock clock;
+  NearbyShareDecryptedCertificateCache cache(&clock, /*max_entries=*/4,
+                                             kLifetime);
+  cache.Put(MakeKey(1), std::nullopt);
+
+  clock.FastForward(kLifetime - absl::Seconds(1));
+  EXPECT_TRUE(cache.Get(MakeKey(1)).has_value());
+  clock.FastForward(absl::Seconds(1));
+  EXPECT_FALSE(cache.Get(MakeKey(1)).has_value());
+}
+
+TEST(NearbyShareDecryptedCertificateCacheTest, EvictsLeastRecentlyUsed) {
+  FakeClock clock;
+  NearbyShareDecryptedCertificateCache cache(&clock, /*max_entries=*/2,
+                                             kLifetime);
+  cache.Put(MakeKey(1), std::nullopt);
+  cache.Put(MakeKey(2), std::nullopt);
+  // Touch the first key so that the second one is the oldest.
+  EXPECT_TRUE(cache.Get(MakeKey(1)).has_value());
+  cache.Put(MakeKey(3), std::nullopt);
+
+  EXPECT_TRUE(cache.Get(MakeKey(1)).has_value());
+  EXPECT_FALSE(cache.Get(MakeKey(2)).has_value());
+  EXPECT_TRUE(cache.Get(MakeKey(3)).has_value());
+}
+
+TEST(NearbyShareDecryptedCertificateCacheTest, ClearDropsEntries) {
+  FakeClock clock;
+  NearbyShareDecryptedCertificateCache cache(&clock, /*max_entries=*/4,
+                                             kLifetime);
+  cache.Put(MakeKey(1), GetNearbyShareTestDecryptedPublicCertificate());
+  cache.Put(MakeKey(2), std::nullopt);
+
+  cache.Clear();
+
+  EXPECT_FALSE(cache.Get(MakeKey(1)).has_value());
+  EXPECT_FALSE(cache.Get(MakeKey(2)).has_value());
+}
+
+}  // namespace
+}  // namespace sharing
+}  // namespace nearby